@@ -274,6 +274,8 @@ gdk_pre_parse_libgtk_only (void)
         _gdk_rendering_mode = GDK_RENDERING_MODE_IMAGE;
       else if (g_str_equal (rendering_mode, "recording"))
         _gdk_rendering_mode = GDK_RENDERING_MODE_RECORDING;
+      else if (g_str_equal (rendering_mode, "tiled"))
+        _gdk_rendering_mode = GDK_RENDERING_MODE_TILED;
     }
 }
 
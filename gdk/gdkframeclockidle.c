@@ -35,7 +35,18 @@
 #include <windows.h>
 #endif
 
-#define FRAME_INTERVAL 16667 /* microseconds */
+#define FRAME_INTERVAL 16667 /* microseconds, until the backend reports the real one */
+
+/* Frames are started as late as possible while still meeting the next
+ * presentation: the predicted cost of a frame is the largest cost of
+ * the last FRAME_COST_HISTORY frames, plus FRAME_DEADLINE_MARGIN of
+ * slack. After a frame misses its presentation, the next
+ * MISSED_FRAME_FALLBACK frames are started half a refresh interval
+ * after the previous presentation, like without a deadline.
+ */
+#define FRAME_COST_HISTORY 8
+#define FRAME_DEADLINE_MARGIN 2000 /* microseconds */
+#define MISSED_FRAME_FALLBACK 8
 
 struct _GdkFrameClockIdlePrivate
 {
@@ -46,6 +57,18 @@ struct _GdkFrameClockIdlePrivate
   gint64 min_next_frame_time;
   gint64 sleep_serial;
 
+  gint64 refresh_interval;
+  gint64 frame_start_time;
+  gint64 frame_costs[FRAME_COST_HISTORY];
+  guint frame_cost_index;
+
+  /* The presentation time the next frame is scheduled for, and the
+   * frame we are waiting to see presented to check for a miss */
+  gint64 next_target_time;
+  gint64 deadline_frame;
+  gint64 deadline_target_time;
+  guint missed_frames;
+
   guint flush_idle_id;
   guint paint_idle_id;
   guint freeze_count;
@@ -128,6 +151,7 @@ gdk_frame_clock_idle_init (GdkFrameClockIdle *frame_clock_idle)
   priv = frame_clock_idle->priv;
 
   priv->freeze_count = 0;
+  priv->refresh_interval = FRAME_INTERVAL;
 }
 
 static void
@@ -197,12 +221,12 @@ gdk_frame_clock_idle_get_frame_time (GdkFrameClock *clock)
   /* Outside a paint, pick something close to "now" */
   computed_frame_time = compute_frame_time (GDK_FRAME_CLOCK_IDLE (clock));
 
-  /* 16ms is 60fps. We only update frame time that often because we'd
+  /* Once per refresh interval. We only update frame time that often because we'd
    * like to try to keep animations on the same start times.
    * get_frame_time() would normally be used outside of a paint to
    * record an animation start time for example.
    */
-  if ((computed_frame_time - priv->frame_time) > FRAME_INTERVAL)
+  if ((computed_frame_time - priv->frame_time) > priv->refresh_interval)
     priv->frame_time = computed_frame_time;
 
   return priv->frame_time;
@@ -277,21 +301,103 @@ maybe_stop_idle (GdkFrameClockIdle *clock_idle)
     }
 }
 
+static void
+record_frame_cost (GdkFrameClockIdle *clock_idle)
+{
+  GdkFrameClockIdlePrivate *priv = clock_idle->priv;
+
+  if (priv->frame_start_time == 0)
+    return;
+
+  priv->frame_costs[priv->frame_cost_index] = g_get_monotonic_time () - priv->frame_start_time;
+  priv->frame_cost_index = (priv->frame_cost_index + 1) % FRAME_COST_HISTORY;
+  priv->frame_start_time = 0;
+}
+
+static gint64
+predict_frame_cost (GdkFrameClockIdle *clock_idle)
+{
+  GdkFrameClockIdlePrivate *priv = clock_idle->priv;
+  gint64 cost = 0;
+  guint i;
+
+  for (i = 0; i < FRAME_COST_HISTORY; i++)
+    cost = MAX (cost, priv->frame_costs[i]);
+
+  return cost + FRAME_DEADLINE_MARGIN;
+}
+
+static void
+check_missed_frame (GdkFrameClockIdle *clock_idle)
+{
+  GdkFrameClockIdlePrivate *priv = clock_idle->priv;
+  GdkFrameTimings *timings;
+
+  if (priv->deadline_frame == 0)
+    return;
+
+  timings = gdk_frame_clock_get_timings (GDK_FRAME_CLOCK (clock_idle),
+                                         priv->deadline_frame);
+  if (timings == NULL)
+    {
+      priv->deadline_frame = 0;
+      return;
+    }
+
+  if (timings->presentation_time == 0)
+    return;
+
+  if (timings->presentation_time > priv->deadline_target_time + priv->refresh_interval / 2)
+    {
+      priv->missed_frames = MISSED_FRAME_FALLBACK;
+
+#ifdef G_ENABLE_DEBUG
+      if ((_gdk_debug_flags & GDK_DEBUG_FRAMES) != 0)
+        g_message ("frame %" G_GINT64_FORMAT " missed its deadline by %.1fms",
+                   priv->deadline_frame,
+                   (timings->presentation_time - priv->deadline_target_time) / 1000.);
+#endif /* G_ENABLE_DEBUG */
+    }
+
+  priv->deadline_frame = 0;
+}
+
 static gint64
 compute_min_next_frame_time (GdkFrameClockIdle *clock_idle,
                              gint64             last_frame_time)
 {
+  GdkFrameClockIdlePrivate *priv = clock_idle->priv;
   gint64 presentation_time;
   gint64 refresh_interval;
+  gint64 cost;
 
   gdk_frame_clock_get_refresh_info (GDK_FRAME_CLOCK (clock_idle),
                                     last_frame_time,
                                     &refresh_interval, &presentation_time);
 
+  priv->refresh_interval = refresh_interval;
+  priv->next_target_time = 0;
+
   if (presentation_time == 0)
     return last_frame_time + refresh_interval;
-  else
-    return presentation_time + refresh_interval / 2;
+
+  check_missed_frame (clock_idle);
+
+  if (priv->missed_frames > 0)
+    {
+      priv->missed_frames--;
+      return presentation_time + refresh_interval / 2;
+    }
+
+  /* The last frame is shown at presentation_time, so the next one is
+   * due a refresh interval later. Start it just early enough.
+   */
+  priv->next_target_time = presentation_time + refresh_interval;
+  cost = predict_frame_cost (clock_idle);
+  if (cost >= refresh_interval)
+    return presentation_time;
+
+  return priv->next_target_time - cost;
 }
 
 static gboolean
@@ -360,6 +466,18 @@ gdk_frame_clock_paint_idle (void *data)
               timings->frame_time = priv->frame_time;
               timings->slept_before = priv->sleep_serial != get_sleep_serial ();
 
+              priv->frame_start_time = g_get_monotonic_time ();
+              /* After an idle gap the frame starts past the presentation
+               * it was scheduled for, so there is no deadline to miss
+               */
+              if (priv->frame_start_time >= priv->next_target_time)
+                priv->next_target_time = 0;
+              if (priv->next_target_time != 0 && priv->deadline_frame == 0)
+                {
+                  priv->deadline_frame = timings->frame_counter;
+                  priv->deadline_target_time = priv->next_target_time;
+                }
+
               priv->phase = GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT;
 
               /* We always emit ::before-paint and ::after-paint if
@@ -431,6 +549,7 @@ gdk_frame_clock_paint_idle (void *data)
               /* the ::after-paint phase doesn't get repeated on freeze/thaw,
                */
               priv->phase = GDK_FRAME_CLOCK_PHASE_NONE;
+              record_frame_cost (clock_idle);
 
 #ifdef G_ENABLE_DEBUG
               if ((_gdk_debug_flags & GDK_DEBUG_FRAMES) != 0)
@@ -550,6 +669,15 @@ gdk_frame_clock_idle_thaw (GdkFrameClock *clock)
   priv->freeze_count--;
   if (priv->freeze_count == 0)
     {
+      /* A clock frozen from ::after-paint skipped scheduling the next
+       * frame at the end of the paint idle, so do it now
+       */
+      if (priv->min_next_frame_time == 0 &&
+          priv->phase == GDK_FRAME_CLOCK_PHASE_NONE &&
+          gdk_frame_clock_get_current_timings (clock) != NULL)
+        priv->min_next_frame_time = compute_min_next_frame_time (clock_idle,
+                                                                 priv->frame_time);
+
       maybe_start_idle (clock_idle);
       /* If nothing is requested so we didn't start an idle, we need
        * to skip to the end of the state chain, since the idle won't
@@ -90,7 +90,8 @@ typedef enum {
 typedef enum {
   GDK_RENDERING_MODE_SIMILAR = 0,
   GDK_RENDERING_MODE_IMAGE,
-  GDK_RENDERING_MODE_RECORDING
+  GDK_RENDERING_MODE_RECORDING,
+  GDK_RENDERING_MODE_TILED
 } GdkRenderingMode;
 
 extern GList            *_gdk_default_filters;
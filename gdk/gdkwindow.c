@@ -182,6 +182,8 @@ typedef enum {
   CLEAR_BG_ALL
 } ClearBg;
 
+typedef struct _GdkPaintTile GdkPaintTile;
+
 struct _GdkWindowPaint
 {
   cairo_region_t *region;
@@ -189,6 +191,9 @@ struct _GdkWindowPaint
   cairo_region_t *flushed;
   guint8 alpha;
   guint uses_implicit : 1;
+  guint tiled : 1; /* surface is a recording, see gdk_window_paint_tiled() */
+  GdkPaintTile *tiles;
+  guint n_tiles;
 };
 
 typedef struct {
@@ -2758,6 +2763,306 @@ gdk_window_get_content (GdkWindow *window)
   return content;
 }
 
+/* In GDK_RENDERING=tiled mode, large implicit paints draw into a
+ * recording surface. When the paint ends, the recording is rasterized
+ * into image tiles by the main thread and a pool of worker threads,
+ * and the tiles are copied to the window. Replaying a recording uses
+ * scratch state in the recording, so before any worker starts, the
+ * main thread gives each worker a copy of its own; the main thread
+ * itself replays the original. Paints smaller than
+ * TILED_PAINT_MIN_TILES tiles are not worth the overhead and are drawn
+ * as usual.
+ */
+#define TILED_PAINT_TILE_SIZE 256
+#define TILED_PAINT_MIN_TILES 4
+
+typedef struct {
+  GMutex mutex;
+  GCond cond;
+  guint pending;
+  GdkPaintTile **tiles;
+  guint n_tiles;
+  volatile gint next_tile;
+} GdkTiledPaint;
+
+typedef struct {
+  GdkTiledPaint *paint;
+  cairo_surface_t *recording;
+} GdkPaintWorker;
+
+struct _GdkPaintTile {
+  GdkRectangle area;              /* in window coordinates */
+  cairo_rectangle_int_t pixels;   /* in device pixels of the paint */
+  cairo_surface_t *surface;
+};
+
+static GThreadPool *tile_pool = NULL;
+
+/* Rasterizes tiles of @worker's paint until none are left. The tiles
+ * have the device transform of the paint surface, so the recording
+ * can be painted as is.
+ */
+static void
+gdk_paint_worker_run (GdkPaintWorker *worker)
+{
+  GdkTiledPaint *paint = worker->paint;
+  guint i;
+
+  while ((i = g_atomic_int_add (&paint->next_tile, 1)) < paint->n_tiles)
+    {
+      cairo_t *cr;
+
+      cr = cairo_create (paint->tiles[i]->surface);
+      cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+      cairo_set_source_surface (cr, worker->recording, 0, 0);
+      cairo_paint (cr);
+      cairo_destroy (cr);
+    }
+}
+
+static void
+gdk_paint_worker_thread (gpointer data,
+                         gpointer user_data)
+{
+  GdkPaintWorker *worker = data;
+  GdkTiledPaint *paint = worker->paint;
+
+  gdk_paint_worker_run (worker);
+
+  g_mutex_lock (&paint->mutex);
+  if (--paint->pending == 0)
+    g_cond_signal (&paint->cond);
+  g_mutex_unlock (&paint->mutex);
+}
+
+/* Returns a copy of @recording that can be replayed independently of
+ * it. Painting a recording into another recording takes a snapshot of
+ * it; flushing the original detaches the snapshot again, so that the
+ * next copy takes a snapshot of its own instead of sharing this one.
+ */
+static cairo_surface_t *
+gdk_paint_copy_recording (cairo_surface_t *recording)
+{
+  cairo_surface_t *copy;
+  cairo_rectangle_t extents;
+#ifdef HAVE_CAIRO_SURFACE_SET_DEVICE_SCALE
+  double sx, sy;
+#endif
+  double ox, oy;
+  cairo_t *cr;
+
+  cairo_recording_surface_get_extents (recording, &extents);
+  copy = cairo_recording_surface_create (cairo_surface_get_content (recording), &extents);
+#ifdef HAVE_CAIRO_SURFACE_SET_DEVICE_SCALE
+  cairo_surface_get_device_scale (recording, &sx, &sy);
+  cairo_surface_set_device_scale (copy, sx, sy);
+#endif
+  cairo_surface_get_device_offset (recording, &ox, &oy);
+  cairo_surface_set_device_offset (copy, ox, oy);
+
+  cr = cairo_create (copy);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface (cr, recording, 0, 0);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+
+  cairo_surface_flush (recording);
+
+  return copy;
+}
+
+/* Creates the recording surface for a tiled paint. Its extents are in
+ * device pixels, the device transform of the paint goes on top.
+ */
+static cairo_surface_t *
+gdk_window_create_tiled_paint_surface (GdkWindow       *window,
+                                       cairo_content_t  content,
+                                       int              width,
+                                       int              height)
+{
+  cairo_surface_t *window_surface, *surface;
+  cairo_rectangle_t extents;
+  double sx, sy;
+
+  window_surface = gdk_window_ref_impl_surface (window);
+  sx = sy = 1;
+#ifdef HAVE_CAIRO_SURFACE_SET_DEVICE_SCALE
+  cairo_surface_get_device_scale (window_surface, &sx, &sy);
+#endif
+  cairo_surface_destroy (window_surface);
+
+  extents.x = 0;
+  extents.y = 0;
+  extents.width = width * sx;
+  extents.height = height * sy;
+  surface = cairo_recording_surface_create (content, &extents);
+#ifdef HAVE_CAIRO_SURFACE_SET_DEVICE_SCALE
+  cairo_surface_set_device_scale (surface, sx, sy);
+#endif
+
+  return surface;
+}
+
+/* Splits @rect into the tiles of @paint. Must be called after the
+ * device offset of the paint surface is set.
+ */
+static void
+gdk_window_paint_init_tiles (GdkWindowPaint *paint,
+                             GdkRectangle   *rect)
+{
+  double sx, sy, ox, oy;
+  guint n_tiles;
+  int x, y;
+
+  sx = sy = 1;
+#ifdef HAVE_CAIRO_SURFACE_SET_DEVICE_SCALE
+  cairo_surface_get_device_scale (paint->surface, &sx, &sy);
+#endif
+  cairo_surface_get_device_offset (paint->surface, &ox, &oy);
+
+  paint->tiles = g_new (GdkPaintTile,
+                        ((rect->width + TILED_PAINT_TILE_SIZE - 1) / TILED_PAINT_TILE_SIZE) *
+                        ((rect->height + TILED_PAINT_TILE_SIZE - 1) / TILED_PAINT_TILE_SIZE));
+  n_tiles = 0;
+
+  for (y = rect->y; y < rect->y + rect->height; y += TILED_PAINT_TILE_SIZE)
+    for (x = rect->x; x < rect->x + rect->width; x += TILED_PAINT_TILE_SIZE)
+      {
+        GdkPaintTile *tile = &paint->tiles[n_tiles++];
+
+        tile->area.x = x;
+        tile->area.y = y;
+        tile->area.width = MIN (TILED_PAINT_TILE_SIZE, rect->x + rect->width - x);
+        tile->area.height = MIN (TILED_PAINT_TILE_SIZE, rect->y + rect->height - y);
+        tile->pixels.x = floor (tile->area.x * sx + ox);
+        tile->pixels.y = floor (tile->area.y * sy + oy);
+        tile->pixels.width = ceil ((tile->area.x + tile->area.width) * sx + ox) - tile->pixels.x;
+        tile->pixels.height = ceil ((tile->area.y + tile->area.height) * sy + oy) - tile->pixels.y;
+        tile->surface = NULL;
+      }
+
+  paint->n_tiles = n_tiles;
+}
+
+static void
+gdk_window_paint_free_tiles (GdkWindowPaint *paint)
+{
+  g_free (paint->tiles);
+  paint->tiles = NULL;
+  paint->n_tiles = 0;
+}
+
+/* Rasterizes the recording of @paint in tiles and copies them to @cr,
+ * which is clipped to the paint region already.
+ */
+static void
+gdk_window_paint_tiled (GdkWindowPaint *paint,
+                        cairo_t        *cr)
+{
+  GdkTiledPaint tiled;
+  GdkPaintWorker *workers;
+  cairo_format_t format;
+  double sx, sy, ox, oy;
+  guint n_workers, i;
+
+  sx = sy = 1;
+#ifdef HAVE_CAIRO_SURFACE_SET_DEVICE_SCALE
+  cairo_surface_get_device_scale (paint->surface, &sx, &sy);
+#endif
+  cairo_surface_get_device_offset (paint->surface, &ox, &oy);
+  format = cairo_surface_get_content (paint->surface) == CAIRO_CONTENT_COLOR ?
+           CAIRO_FORMAT_RGB24 : CAIRO_FORMAT_ARGB32;
+
+  cairo_surface_flush (paint->surface);
+
+  g_mutex_init (&tiled.mutex);
+  g_cond_init (&tiled.cond);
+  tiled.pending = 0;
+  tiled.tiles = g_new (GdkPaintTile *, paint->n_tiles);
+  tiled.n_tiles = 0;
+  tiled.next_tile = 0;
+
+  for (i = 0; i < paint->n_tiles; i++)
+    {
+      GdkPaintTile *tile = &paint->tiles[i];
+
+      if (cairo_region_contains_rectangle (paint->region, &tile->area) == CAIRO_REGION_OVERLAP_OUT)
+        continue;
+
+      /* Give the tile the device transform of the paint surface,
+       * shifted to the tile's pixels
+       */
+      tile->surface = cairo_image_surface_create (format,
+                                                  tile->pixels.width,
+                                                  tile->pixels.height);
+#ifdef HAVE_CAIRO_SURFACE_SET_DEVICE_SCALE
+      cairo_surface_set_device_scale (tile->surface, sx, sy);
+#endif
+      cairo_surface_set_device_offset (tile->surface, ox - tile->pixels.x, oy - tile->pixels.y);
+      tiled.tiles[tiled.n_tiles++] = tile;
+    }
+
+  if (tile_pool == NULL)
+    tile_pool = g_thread_pool_new (gdk_paint_worker_thread, NULL,
+                                   MAX (g_get_num_processors () - 1, 1),
+                                   FALSE, NULL);
+
+  /* Worker 0 is the main thread, which replays the original. All the
+   * copies are made before the first worker starts.
+   */
+  n_workers = MIN (tiled.n_tiles, (guint) g_thread_pool_get_max_threads (tile_pool) + 1);
+  n_workers = MAX (n_workers, 1);
+  workers = g_new (GdkPaintWorker, n_workers);
+  for (i = 0; i < n_workers; i++)
+    {
+      workers[i].paint = &tiled;
+      workers[i].recording = i == 0 ? cairo_surface_reference (paint->surface)
+                                    : gdk_paint_copy_recording (paint->surface);
+    }
+
+  tiled.pending = n_workers - 1;
+  for (i = 1; i < n_workers; i++)
+    g_thread_pool_push (tile_pool, &workers[i], NULL);
+
+  gdk_paint_worker_run (&workers[0]);
+
+  g_mutex_lock (&tiled.mutex);
+  while (tiled.pending > 0)
+    g_cond_wait (&tiled.cond, &tiled.mutex);
+  g_mutex_unlock (&tiled.mutex);
+
+  for (i = 0; i < n_workers; i++)
+    cairo_surface_destroy (workers[i].recording);
+  g_free (workers);
+
+  if (paint->alpha == 255)
+    cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  else
+    cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+
+  for (i = 0; i < tiled.n_tiles; i++)
+    {
+      GdkPaintTile *tile = tiled.tiles[i];
+
+      cairo_save (cr);
+      gdk_cairo_rectangle (cr, &tile->area);
+      cairo_clip (cr);
+      cairo_set_source_surface (cr, tile->surface, 0, 0);
+      if (paint->alpha == 255)
+        cairo_paint (cr);
+      else
+        cairo_paint_with_alpha (cr, paint->alpha / 255.0);
+      cairo_restore (cr);
+
+      cairo_surface_destroy (tile->surface);
+      tile->surface = NULL;
+    }
+
+  g_free (tiled.tiles);
+  g_cond_clear (&tiled.cond);
+  g_mutex_clear (&tiled.mutex);
+}
+
 /* This creates an empty "implicit" paint region for the impl window.
  * By itself this does nothing, but real paints to this window
  * or children of it can use this surface as backing to avoid allocating
@@ -2796,11 +3101,25 @@ gdk_window_begin_implicit_paint (GdkWindow *window, GdkRectangle *rect,
   paint->uses_implicit = FALSE;
   paint->flushed = NULL;
   paint->alpha = alpha;
-  paint->surface = gdk_window_create_similar_surface (window,
-						      with_alpha ? CAIRO_CONTENT_COLOR_ALPHA : gdk_window_get_content (window),
-		                                      MAX (rect->width, 1),
-                                                      MAX (rect->height, 1));
+  paint->tiles = NULL;
+  paint->n_tiles = 0;
+  paint->tiled = (_gdk_rendering_mode == GDK_RENDERING_MODE_TILED &&
+                  window->implicit_paint == NULL &&
+                  rect->width * rect->height >=
+                  TILED_PAINT_MIN_TILES * TILED_PAINT_TILE_SIZE * TILED_PAINT_TILE_SIZE);
+  if (paint->tiled)
+    paint->surface = gdk_window_create_tiled_paint_surface (window,
+                                                            with_alpha ? CAIRO_CONTENT_COLOR_ALPHA : gdk_window_get_content (window),
+                                                            rect->width,
+                                                            rect->height);
+  else
+    paint->surface = gdk_window_create_similar_surface (window,
+                                                        with_alpha ? CAIRO_CONTENT_COLOR_ALPHA : gdk_window_get_content (window),
+                                                        MAX (rect->width, 1),
+                                                        MAX (rect->height, 1));
   cairo_surface_set_device_offset (paint->surface, -rect->x, -rect->y);
+  if (paint->tiled)
+    gdk_window_paint_init_tiles (paint, rect);
 
   window->implicit_paint = g_slist_prepend (window->implicit_paint, paint);
 
@@ -2944,17 +3263,22 @@ gdk_window_end_implicit_paint (GdkWindow *window)
 
       gdk_cairo_region (cr, paint->region);
       cairo_clip (cr);
-      cairo_set_source_surface (cr, paint->surface, 0, 0);
-      if (paint->alpha == 255)
-	{
-	  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
-	  cairo_paint (cr);
-	}
+      if (paint->tiled)
+        gdk_window_paint_tiled (paint, cr);
       else
-	{
-	  cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
-	  cairo_paint_with_alpha (cr, paint->alpha / 255.0);
-	}
+        {
+          cairo_set_source_surface (cr, paint->surface, 0, 0);
+          if (paint->alpha == 255)
+            {
+              cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+              cairo_paint (cr);
+            }
+          else
+            {
+              cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+              cairo_paint_with_alpha (cr, paint->alpha / 255.0);
+            }
+        }
 
       cairo_destroy (cr);
 
@@ -2965,6 +3289,8 @@ gdk_window_end_implicit_paint (GdkWindow *window)
   cairo_region_destroy (paint->region);
   if (paint->flushed)
     cairo_region_destroy (paint->flushed);
+  if (paint->tiled)
+    gdk_window_paint_free_tiles (paint);
   cairo_surface_destroy (paint->surface);
   g_free (paint);
 }
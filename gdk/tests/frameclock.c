@@ -0,0 +1,133 @@
+/* The frame timings and the freeze/thaw vfuncs are internal to GDK */
+#define GDK_COMPILATION
+
+#include <gdk/gdk.h>
+#include "gdk/gdkframeclockidle.h"
+
+/* A long refresh interval keeps the scheduling differences we check
+ * for well above the timer resolution
+ */
+#define REFRESH_INTERVAL 100000 /* microseconds */
+#define N_FRAMES 3
+
+typedef struct {
+  GdkFrameClock *clock;
+  gboolean freeze;
+  guint n_frames;
+  gint64 start_time[N_FRAMES];
+  gint64 frame_time[N_FRAMES];
+} FrameTest;
+
+static void
+before_paint (GdkFrameClock *clock,
+              FrameTest     *test)
+{
+  test->start_time[test->n_frames] = g_get_monotonic_time ();
+}
+
+/* Plays the backend: the frame is presented right away, and the clock
+ * is frozen until the frame is drawn if requested, like X11 does
+ */
+static void
+after_paint (GdkFrameClock *clock,
+             FrameTest     *test)
+{
+  GdkFrameTimings *timings;
+
+  timings = gdk_frame_clock_get_current_timings (clock);
+  timings->presentation_time = timings->frame_time;
+  timings->refresh_interval = REFRESH_INTERVAL;
+  timings->complete = TRUE;
+
+  test->frame_time[test->n_frames] = timings->frame_time;
+  test->n_frames++;
+
+  if (test->freeze)
+    GDK_FRAME_CLOCK_GET_CLASS (clock)->freeze (clock);
+}
+
+static void
+frame_test_init (FrameTest *test)
+{
+  test->clock = g_object_new (GDK_TYPE_FRAME_CLOCK_IDLE, NULL);
+  test->freeze = FALSE;
+  test->n_frames = 0;
+
+  g_signal_connect (test->clock, "before-paint", G_CALLBACK (before_paint), test);
+  g_signal_connect (test->clock, "after-paint", G_CALLBACK (after_paint), test);
+}
+
+static void
+frame_test_wait (FrameTest *test,
+                 guint      n_frames)
+{
+  while (test->n_frames < n_frames)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+frame_test_run_frame (FrameTest *test)
+{
+  guint n_frames = test->n_frames;
+
+  gdk_frame_clock_request_phase (test->clock, GDK_FRAME_CLOCK_PHASE_PAINT);
+  frame_test_wait (test, n_frames + 1);
+}
+
+static void
+test_thaw (void)
+{
+  FrameTest test;
+
+  frame_test_init (&test);
+
+  test.freeze = TRUE;
+  frame_test_run_frame (&test);
+  test.freeze = FALSE;
+
+  /* The next frame is due a refresh interval after the first one was
+   * presented, thawing must not start it right away
+   */
+  gdk_frame_clock_request_phase (test.clock, GDK_FRAME_CLOCK_PHASE_PAINT);
+  GDK_FRAME_CLOCK_GET_CLASS (test.clock)->thaw (test.clock);
+  frame_test_wait (&test, 2);
+
+  g_assert_cmpint (test.start_time[1] - test.frame_time[0], >=, REFRESH_INTERVAL / 2);
+
+  g_object_unref (test.clock);
+}
+
+static void
+test_idle_gap (void)
+{
+  FrameTest test;
+
+  frame_test_init (&test);
+
+  frame_test_run_frame (&test);
+
+  /* Sleep past the presentation the next frame would have been
+   * scheduled for. Starting late after an idle gap is not a missed
+   * frame, so the frame after it is still scheduled just before its
+   * presentation, not half an interval after the previous one.
+   */
+  g_usleep (REFRESH_INTERVAL * 5 / 2);
+
+  frame_test_run_frame (&test);
+  frame_test_run_frame (&test);
+
+  g_assert_cmpint (test.start_time[2] - test.frame_time[1], >=, REFRESH_INTERVAL * 3 / 4);
+
+  g_object_unref (test.clock);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/frame-clock/thaw", test_thaw);
+  g_test_add_func ("/frame-clock/idle-gap", test_idle_gap);
+
+  return g_test_run ();
+}
@@ -897,7 +897,7 @@ gtk_icon_view_accessible_get_n_children (AtkObject *accessible)
 
   icon_view = GTK_ICON_VIEW (widget);
 
-  return g_list_length (icon_view->priv->items);
+  return icon_view->priv->items->len;
 }
 
 static AtkObject *
@@ -927,7 +927,6 @@ gtk_icon_view_accessible_ref_child (AtkObject *accessible,
 {
   GtkIconView *icon_view;
   GtkWidget *widget;
-  GList *icons;
   AtkObject *obj;
   GtkIconViewItemAccessible *a11y_item;
 
@@ -936,11 +935,10 @@ gtk_icon_view_accessible_ref_child (AtkObject *accessible,
     return NULL;
 
   icon_view = GTK_ICON_VIEW (widget);
-  icons = g_list_nth (icon_view->priv->items, index);
   obj = NULL;
-  if (icons)
+  if (index >= 0 && index < icon_view->priv->items->len)
     {
-      GtkIconViewItem *item = icons->data;
+      GtkIconViewItem *item = g_ptr_array_index (icon_view->priv->items, index);
 
       g_return_val_if_fail (item->index == index, NULL);
       obj = gtk_icon_view_accessible_find_child (accessible, index);
@@ -1189,7 +1187,7 @@ gtk_icon_view_accessible_model_rows_reordered (GtkTreeModel *tree_model,
       info = items->data;
       item = GTK_ICON_VIEW_ITEM_ACCESSIBLE (info->item);
       info->index = order[info->index];
-      item->item = g_list_nth_data (icon_view->priv->items, info->index);
+      item->item = g_ptr_array_index (icon_view->priv->items, info->index);
       items = items->next;
     }
   g_free (order);
@@ -1392,10 +1390,11 @@ gtk_icon_view_accessible_add_selection (AtkSelection *selection,
 
   icon_view = GTK_ICON_VIEW (widget);
 
-  item = g_list_nth_data (icon_view->priv->items, i);
-  if (!item)
+  if (i < 0 || i >= icon_view->priv->items->len)
     return FALSE;
 
+  item = g_ptr_array_index (icon_view->priv->items, i);
+
   _gtk_icon_view_select_item (icon_view, item);
 
   return TRUE;
@@ -1421,10 +1420,10 @@ static AtkObject*
 gtk_icon_view_accessible_ref_selection (AtkSelection *selection,
                                         gint          i)
 {
-  GList *l;
   GtkWidget *widget;
   GtkIconView *icon_view;
   GtkIconViewItem *item;
+  guint n;
 
   widget = gtk_accessible_get_widget (GTK_ACCESSIBLE (selection));
   if (widget == NULL)
@@ -1432,10 +1431,9 @@ gtk_icon_view_accessible_ref_selection (AtkSelection *selection,
 
   icon_view = GTK_ICON_VIEW (widget);
 
-  l = icon_view->priv->items;
-  while (l)
+  for (n = 0; n < icon_view->priv->items->len; n++)
     {
-      item = l->data;
+      item = g_ptr_array_index (icon_view->priv->items, n);
       if (item->selected)
         {
           if (i == 0)
@@ -1443,7 +1441,6 @@ gtk_icon_view_accessible_ref_selection (AtkSelection *selection,
           else
             i--;
         }
-      l = l->next;
     }
 
   return NULL;
@@ -1455,7 +1452,7 @@ gtk_icon_view_accessible_get_selection_count (AtkSelection *selection)
   GtkWidget *widget;
   GtkIconView *icon_view;
   GtkIconViewItem *item;
-  GList *l;
+  guint n;
   gint count;
 
   widget = gtk_accessible_get_widget (GTK_ACCESSIBLE (selection));
@@ -1464,16 +1461,13 @@ gtk_icon_view_accessible_get_selection_count (AtkSelection *selection)
 
   icon_view = GTK_ICON_VIEW (widget);
 
-  l = icon_view->priv->items;
   count = 0;
-  while (l)
+  for (n = 0; n < icon_view->priv->items->len; n++)
     {
-      item = l->data;
+      item = g_ptr_array_index (icon_view->priv->items, n);
 
       if (item->selected)
         count++;
-
-      l = l->next;
     }
 
   return count;
@@ -1493,10 +1487,11 @@ gtk_icon_view_accessible_is_child_selected (AtkSelection *selection,
 
   icon_view = GTK_ICON_VIEW (widget);
 
-  item = g_list_nth_data (icon_view->priv->items, i);
-  if (!item)
+  if (i < 0 || i >= icon_view->priv->items->len)
     return FALSE;
 
+  item = g_ptr_array_index (icon_view->priv->items, i);
+
   return item->selected;
 }
 
@@ -1507,7 +1502,7 @@ gtk_icon_view_accessible_remove_selection (AtkSelection *selection,
   GtkWidget *widget;
   GtkIconView *icon_view;
   GtkIconViewItem *item;
-  GList *l;
+  guint n;
   gint count;
 
   widget = gtk_accessible_get_widget (GTK_ACCESSIBLE (selection));
@@ -1515,11 +1510,10 @@ gtk_icon_view_accessible_remove_selection (AtkSelection *selection,
     return FALSE;
 
   icon_view = GTK_ICON_VIEW (widget);
-  l = icon_view->priv->items;
   count = 0;
-  while (l)
+  for (n = 0; n < icon_view->priv->items->len; n++)
     {
-      item = l->data;
+      item = g_ptr_array_index (icon_view->priv->items, n);
       if (item->selected)
         {
           if (count == i)
@@ -1529,7 +1523,6 @@ gtk_icon_view_accessible_remove_selection (AtkSelection *selection,
             }
           count++;
         }
-      l = l->next;
     }
 
   return FALSE;
@@ -25,7 +25,7 @@
  */
 
 #include "config.h"
-#include "gtkadjustment.h"
+#include "gtkadjustmentprivate.h"
 #include "gtkmarshalers.h"
 #include "gtkprivate.h"
 #include "gtkintl.h"
@@ -59,6 +59,15 @@ struct _GtkAdjustmentPrivate {
   gdouble step_increment;
   gdouble page_increment;
   gdouble page_size;
+
+  /* Value queued with _gtk_adjustment_queue_value(), applied
+   * from the frame clock's update phase */
+  GdkFrameClock *clock;
+  gulong update_id;
+  gdouble source;
+  gdouble target;
+  gint64 start_time;
+  gint64 end_time;
 };
 
 enum
@@ -91,6 +100,9 @@ static void gtk_adjustment_set_property                (GObject      *object,
 static void gtk_adjustment_dispatch_properties_changed (GObject      *object,
                                                         guint         n_pspecs,
                                                         GParamSpec  **pspecs);
+static void gtk_adjustment_dispose                     (GObject      *object);
+static void gtk_adjustment_end_queued_value            (GtkAdjustment *adjustment);
+static void gtk_adjustment_clamp_queued_value          (GtkAdjustment *adjustment);
 
 static guint adjustment_signals[LAST_SIGNAL] = { 0 };
 
@@ -103,6 +115,7 @@ gtk_adjustment_class_init (GtkAdjustmentClass *class)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (class);
 
+  gobject_class->dispose                     = gtk_adjustment_dispose;
   gobject_class->set_property                = gtk_adjustment_set_property;
   gobject_class->get_property                = gtk_adjustment_get_property;
   gobject_class->dispatch_properties_changed = gtk_adjustment_dispatch_properties_changed;
@@ -260,6 +273,14 @@ gtk_adjustment_init (GtkAdjustment *adjustment)
                                                   GtkAdjustmentPrivate);
 }
 
+static void
+gtk_adjustment_dispose (GObject *object)
+{
+  gtk_adjustment_end_queued_value (GTK_ADJUSTMENT (object));
+
+  G_OBJECT_CLASS (gtk_adjustment_parent_class)->dispose (object);
+}
+
 static void
 gtk_adjustment_get_property (GObject    *object,
                              guint       prop_id,
@@ -357,6 +378,8 @@ gtk_adjustment_dispatch_properties_changed (GObject     *object,
 
   if (changed)
     {
+      gtk_adjustment_clamp_queued_value (GTK_ADJUSTMENT (object));
+
       adjustment_changed_stamp++;
       gtk_adjustment_changed (GTK_ADJUSTMENT (object));
     }
@@ -410,6 +433,26 @@ gtk_adjustment_get_value (GtkAdjustment *adjustment)
   return adjustment->priv->value;
 }
 
+static void
+gtk_adjustment_set_value_internal (GtkAdjustment *adjustment,
+                                   gdouble        value)
+{
+  GtkAdjustmentPrivate *priv = adjustment->priv;
+
+  /* don't use CLAMP() so we don't end up below lower if upper - page_size
+   * is smaller than lower
+   */
+  value = MIN (value, priv->upper - priv->page_size);
+  value = MAX (value, priv->lower);
+
+  if (value != priv->value)
+    {
+      priv->value = value;
+
+      gtk_adjustment_value_changed (adjustment);
+    }
+}
+
 /**
  * gtk_adjustment_set_value:
  * @adjustment: a #GtkAdjustment.
@@ -425,27 +468,177 @@ gtk_adjustment_get_value (GtkAdjustment *adjustment)
 void
 gtk_adjustment_set_value (GtkAdjustment *adjustment,
 			  gdouble        value)
+{
+  g_return_if_fail (GTK_IS_ADJUSTMENT (adjustment));
+
+  /* an explicit value overrides any queued scrolling */
+  gtk_adjustment_end_queued_value (adjustment);
+
+  gtk_adjustment_set_value_internal (adjustment, value);
+}
+
+static void
+gtk_adjustment_end_queued_value (GtkAdjustment *adjustment)
+{
+  GtkAdjustmentPrivate *priv = adjustment->priv;
+
+  if (priv->clock == NULL)
+    return;
+
+  g_signal_handler_disconnect (priv->clock, priv->update_id);
+  priv->update_id = 0;
+  gdk_frame_clock_end_updating (priv->clock);
+  g_clear_object (&priv->clock);
+}
+
+/* Keeps a queued value within new bounds, so that queued scrolling
+ * carries on towards the nearest value still in range
+ */
+static void
+gtk_adjustment_clamp_queued_value (GtkAdjustment *adjustment)
+{
+  GtkAdjustmentPrivate *priv = adjustment->priv;
+
+  if (priv->clock == NULL)
+    return;
+
+  priv->source = MIN (priv->source, priv->upper - priv->page_size);
+  priv->source = MAX (priv->source, priv->lower);
+  priv->target = MIN (priv->target, priv->upper - priv->page_size);
+  priv->target = MAX (priv->target, priv->lower);
+}
+
+static gdouble
+ease_out_cubic (gdouble t)
+{
+  gdouble p = t - 1;
+
+  return p * p * p + 1;
+}
+
+static void
+gtk_adjustment_on_frame_clock_update (GdkFrameClock *clock,
+                                      GtkAdjustment *adjustment)
+{
+  GtkAdjustmentPrivate *priv = adjustment->priv;
+  gint64 now;
+
+  now = gdk_frame_clock_get_frame_time (clock);
+
+  if (now < priv->end_time)
+    {
+      gdouble t;
+
+      t = (now - priv->start_time) / (gdouble) (priv->end_time - priv->start_time);
+      gtk_adjustment_set_value_internal (adjustment,
+                                         priv->source + (priv->target - priv->source) * ease_out_cubic (t));
+    }
+  else
+    {
+      gdouble target = priv->target;
+
+      gtk_adjustment_end_queued_value (adjustment);
+      gtk_adjustment_set_value_internal (adjustment, target);
+    }
+}
+
+/*
+ * _gtk_adjustment_queue_value:
+ * @adjustment: a #GtkAdjustment
+ * @clock: (allow-none): the frame clock of the widget being scrolled
+ * @value: the new value
+ * @duration: time in milliseconds to animate the change over, or 0
+ *
+ * Sets the value of @adjustment on the next update phase of @clock
+ * instead of right away, so that many scroll events arriving within
+ * one frame cause a single ::value-changed emission. If @duration is
+ * not 0, the value moves to @value over that time, one step per frame.
+ *
+ * Queueing another value before the previous one was applied replaces
+ * it; use _gtk_adjustment_get_target_value() to accumulate deltas.
+ * If @clock is %NULL, the value is set immediately.
+ *
+ * New bounds clamp the queued value, while gtk_adjustment_set_value()
+ * and gtk_adjustment_clamp_page() drop it.
+ */
+void
+_gtk_adjustment_queue_value (GtkAdjustment *adjustment,
+                             GdkFrameClock *clock,
+                             gdouble        value,
+                             guint          duration)
 {
   GtkAdjustmentPrivate *priv;
-  
+
   g_return_if_fail (GTK_IS_ADJUSTMENT (adjustment));
+  g_return_if_fail (clock == NULL || GDK_IS_FRAME_CLOCK (clock));
 
   priv = adjustment->priv;
 
-  /* don't use CLAMP() so we don't end up below lower if upper - page_size
-   * is smaller than lower
-   */
+  if (clock != priv->clock)
+    gtk_adjustment_end_queued_value (adjustment);
+
+  if (clock == NULL)
+    {
+      gtk_adjustment_set_value_internal (adjustment, value);
+      return;
+    }
+
   value = MIN (value, priv->upper - priv->page_size);
   value = MAX (value, priv->lower);
 
-  if (value != priv->value)
-    {
-      priv->value = value;
+  priv->source = priv->value;
+  priv->target = value;
+  priv->start_time = gdk_frame_clock_get_frame_time (clock);
+  priv->end_time = priv->start_time + duration * 1000;
 
-      gtk_adjustment_value_changed (adjustment);
+  if (priv->clock == NULL)
+    {
+      priv->clock = g_object_ref (clock);
+      priv->update_id = g_signal_connect (clock, "update",
+                                          G_CALLBACK (gtk_adjustment_on_frame_clock_update),
+                                          adjustment);
+      gdk_frame_clock_begin_updating (clock);
     }
 }
 
+/*
+ * _gtk_adjustment_get_target_value:
+ * @adjustment: a #GtkAdjustment
+ *
+ * Returns the value queued with _gtk_adjustment_queue_value() if
+ * it hasn't been reached yet, or the current value otherwise.
+ */
+gdouble
+_gtk_adjustment_get_target_value (GtkAdjustment *adjustment)
+{
+  g_return_val_if_fail (GTK_IS_ADJUSTMENT (adjustment), 0.0);
+
+  if (adjustment->priv->clock != NULL)
+    return adjustment->priv->target;
+
+  return adjustment->priv->value;
+}
+
+/*
+ * _gtk_adjustment_cancel_queued_value:
+ * @adjustment: a #GtkAdjustment
+ * @clock: a frame clock
+ *
+ * Drops a value queued with _gtk_adjustment_queue_value() on @clock
+ * that hasn't been reached yet, and the reference to @clock with it.
+ * Widgets call this when they are unrealized.
+ */
+void
+_gtk_adjustment_cancel_queued_value (GtkAdjustment *adjustment,
+                                     GdkFrameClock *clock)
+{
+  g_return_if_fail (GTK_IS_ADJUSTMENT (adjustment));
+  g_return_if_fail (GDK_IS_FRAME_CLOCK (clock));
+
+  if (adjustment->priv->clock == clock)
+    gtk_adjustment_end_queued_value (adjustment);
+}
+
 /**
  * gtk_adjustment_get_lower:
  * @adjustment: a #GtkAdjustment
@@ -790,6 +983,8 @@ gtk_adjustment_clamp_page (GtkAdjustment *adjustment,
 
   priv = adjustment->priv;
 
+  gtk_adjustment_end_queued_value (adjustment);
+
   lower = CLAMP (lower, priv->lower, priv->upper);
   upper = CLAMP (upper, priv->lower, priv->upper);
 
@@ -0,0 +1,43 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 1995-1997 Peter Mattis, Spencer Kimball and Josh MacDonald
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GTK_ADJUSTMENT_PRIVATE_H__
+#define __GTK_ADJUSTMENT_PRIVATE_H__
+
+
+#if !defined (__GTK_H_INSIDE__) && !defined (GTK_COMPILATION)
+#error "Only <gtk/gtk.h> can be included directly."
+#endif
+
+#include <gtk/gtkadjustment.h>
+
+G_BEGIN_DECLS
+
+void            _gtk_adjustment_queue_value      (GtkAdjustment *adjustment,
+                                                  GdkFrameClock *clock,
+                                                  gdouble        value,
+                                                  guint          duration);
+gdouble         _gtk_adjustment_get_target_value (GtkAdjustment *adjustment);
+void            _gtk_adjustment_cancel_queued_value
+                                                 (GtkAdjustment *adjustment,
+                                                  GdkFrameClock *clock);
+
+G_END_DECLS
+
+#endif /* __GTK_ADJUSTMENT_PRIVATE_H__ */
@@ -22,12 +22,15 @@
 #include "gtkcellrenderertext.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "gtkeditable.h"
 #include "gtkentry.h"
 #include "gtksizerequest.h"
 #include "gtkmarshalers.h"
+#include "gtkdebug.h"
 #include "gtkintl.h"
+#include "gtkpango.h"
 #include "gtkprivate.h"
 #include "gtktreeprivate.h"
 #include "a11y/gtktextcellaccessible.h"
@@ -1573,10 +1576,10 @@ add_attr (PangoAttrList  *attr_list,
 }
 
 static PangoLayout*
-get_layout (GtkCellRendererText *celltext,
-            GtkWidget           *widget,
-            const GdkRectangle  *cell_area,
-            GtkCellRendererState flags)
+create_layout (GtkCellRendererText *celltext,
+               GtkWidget           *widget,
+               const GdkRectangle  *cell_area,
+               GtkCellRendererState flags)
 {
   GtkCellRendererTextPrivate *priv = celltext->priv;
   PangoAttrList *attr_list;
@@ -1727,6 +1730,203 @@ get_layout (GtkCellRendererText *celltext,
   return layout;
 }
 
+/* Layout cache
+ *
+ * Shaping the text is the expensive part of measuring and rendering a
+ * cell, and tree views measure and render the same cells over and over,
+ * for example while scrolling. So the layouts are kept in a cache that
+ * is shared by all text renderers of a widget, and looked up by a key
+ * made of everything create_layout() depends on. Stale entries, like
+ * the ones from before a font change, simply age out of the cache.
+ */
+
+#define LAYOUT_CACHE_SIZE 512
+
+typedef struct
+{
+  GHashTable *layouts;  /* key => link in lru */
+  GQueue lru;           /* CachedLayouts, most recently used first */
+  guint hits;
+  guint misses;
+} LayoutCache;
+
+typedef struct
+{
+  gchar *key;
+  PangoLayout *layout;
+  gint width;
+} CachedLayout;
+
+static void
+cached_layout_free (CachedLayout *cached)
+{
+  g_free (cached->key);
+  g_object_unref (cached->layout);
+  g_slice_free (CachedLayout, cached);
+}
+
+static void
+layout_cache_free (LayoutCache *cache)
+{
+  GTK_NOTE (TREE,
+            g_print ("text renderer layout cache: %u hits, %u misses\n",
+                     cache->hits, cache->misses));
+
+  g_hash_table_unref (cache->layouts);
+  g_queue_foreach (&cache->lru, (GFunc) cached_layout_free, NULL);
+  g_queue_clear (&cache->lru);
+  g_slice_free (LayoutCache, cache);
+}
+
+static LayoutCache *
+get_layout_cache (GtkWidget *widget)
+{
+  static GQuark quark_layout_cache = 0;
+  LayoutCache *cache;
+
+  if (G_UNLIKELY (quark_layout_cache == 0))
+    quark_layout_cache = g_quark_from_static_string ("gtk-cell-renderer-text-layout-cache");
+
+  cache = g_object_get_qdata (G_OBJECT (widget), quark_layout_cache);
+  if (cache == NULL)
+    {
+      cache = g_slice_new0 (LayoutCache);
+      cache->layouts = g_hash_table_new (g_str_hash, g_str_equal);
+      g_object_set_qdata_full (G_OBJECT (widget), quark_layout_cache,
+                               cache, (GDestroyNotify) layout_cache_free);
+    }
+
+  return cache;
+}
+
+static gchar *
+get_layout_key (GtkCellRendererText *celltext,
+                GtkWidget           *widget,
+                const GdkRectangle  *cell_area,
+                GtkCellRendererState flags)
+{
+  GtkCellRendererTextPrivate *priv = celltext->priv;
+  GString *key;
+  gchar *font;
+  gint xpad;
+
+  gtk_cell_renderer_get_padding (GTK_CELL_RENDERER (celltext), &xpad, NULL);
+
+  key = g_string_sized_new (64);
+
+  /* changes whenever the font, direction or resolution of the widget do */
+  g_string_append_printf (key, "%u %d",
+                          pango_context_get_serial (gtk_widget_get_pango_context (widget)),
+                          priv->single_paragraph);
+
+  if (cell_area)
+    {
+      if (priv->foreground_set && (flags & GTK_CELL_RENDERER_SELECTED) == 0)
+        g_string_append_printf (key, " fg%u,%u,%u",
+                                (guint16) (priv->foreground.red * 65535),
+                                (guint16) (priv->foreground.green * 65535),
+                                (guint16) (priv->foreground.blue * 65535));
+      if (priv->strikethrough_set)
+        g_string_append_printf (key, " s%d", priv->strikethrough);
+    }
+
+  if (priv->scale_set && priv->font_scale != 1.0)
+    g_string_append_printf (key, " x%g", priv->font_scale);
+
+  if (priv->underline_set)
+    g_string_append_printf (key, " u%d", priv->underline_style);
+  if ((flags & GTK_CELL_RENDERER_PRELIT) == GTK_CELL_RENDERER_PRELIT)
+    g_string_append (key, " p");
+
+  if (priv->language_set)
+    g_string_append_printf (key, " l%s", pango_language_to_string (priv->language));
+
+  if (priv->rise_set)
+    g_string_append_printf (key, " r%d", priv->rise);
+
+  if (priv->ellipsize_set)
+    g_string_append_printf (key, " e%d", priv->ellipsize);
+
+  if (priv->wrap_width != -1)
+    g_string_append_printf (key, " w%d,%d",
+                            cell_area ? cell_area->width - xpad * 2 : priv->wrap_width,
+                            priv->wrap_mode);
+
+  if (priv->align_set)
+    g_string_append_printf (key, " a%d", priv->align);
+  else
+    g_string_append_printf (key, " d%d", gtk_widget_get_direction (widget));
+
+  font = pango_font_description_to_string (priv->font);
+  g_string_append_printf (key, " %" G_GSIZE_FORMAT ":%s ", strlen (font), font);
+  g_free (font);
+
+  if (priv->text)
+    g_string_append (key, priv->text);
+
+  return g_string_free (key, FALSE);
+}
+
+static PangoLayout*
+get_layout (GtkCellRendererText *celltext,
+            GtkWidget           *widget,
+            const GdkRectangle  *cell_area,
+            GtkCellRendererState flags)
+{
+  GtkCellRendererTextPrivate *priv = celltext->priv;
+  LayoutCache *cache;
+  CachedLayout *cached;
+  PangoLayout *layout;
+  GList *link;
+  gchar *key;
+
+  /* Attribute lists can't be compared, and placeholders are rare */
+  if (priv->extra_attrs || show_placeholder_text (celltext))
+    return create_layout (celltext, widget, cell_area, flags);
+
+  cache = get_layout_cache (widget);
+  key = get_layout_key (celltext, widget, cell_area, flags);
+
+  link = g_hash_table_lookup (cache->layouts, key);
+  if (link)
+    {
+      cache->hits++;
+      g_free (key);
+
+      g_queue_unlink (&cache->lru, link);
+      g_queue_push_head_link (&cache->lru, link);
+
+      /* Callers change the width of the layout to their liking */
+      cached = link->data;
+      pango_layout_set_width (cached->layout, cached->width);
+
+      return g_object_ref (cached->layout);
+    }
+
+  cache->misses++;
+
+  layout = create_layout (celltext, widget, cell_area, flags);
+
+  cached = g_slice_new (CachedLayout);
+  cached->key = key;
+  cached->layout = g_object_ref (layout);
+  cached->width = pango_layout_get_width (layout);
+
+  g_queue_push_head (&cache->lru, cached);
+  g_hash_table_insert (cache->layouts, cached->key, cache->lru.head);
+
+  if (cache->lru.length > LAYOUT_CACHE_SIZE)
+    {
+      link = g_queue_pop_tail_link (&cache->lru);
+      cached = link->data;
+      g_hash_table_remove (cache->layouts, cached->key);
+      cached_layout_free (cached);
+      g_list_free_1 (link);
+    }
+
+  return layout;
+}
+
 
 static void
 get_size (GtkCellRenderer    *cell,
@@ -1767,9 +1967,9 @@ get_size (GtkCellRenderer    *cell,
 
       context = gtk_widget_get_pango_context (widget);
 
-      metrics = pango_context_get_metrics (context,
-					   font_desc,
-					   pango_context_get_language (context));
+      metrics = _gtk_pango_context_get_metrics (context,
+						font_desc,
+						pango_context_get_language (context));
       row_height = (pango_font_metrics_get_ascent (metrics) +
 		    pango_font_metrics_get_descent (metrics));
       pango_font_metrics_unref (metrics);
@@ -2178,9 +2378,9 @@ gtk_cell_renderer_text_get_preferred_width (GtkCellRenderer *cell,
 
   /* Fetch the average size of a charachter */
   context = pango_layout_get_context (layout);
-  metrics = pango_context_get_metrics (context,
-                                       pango_context_get_font_description (context),
-                                       pango_context_get_language (context));
+  metrics = _gtk_pango_context_get_metrics (context,
+                                            pango_context_get_font_description (context),
+                                            pango_context_get_language (context));
 
   char_width = pango_font_metrics_get_approximate_char_width (metrics);
 
@@ -34,6 +34,7 @@
 #include "gtkmain.h"
 #include "gtkmenuprivate.h"
 #include "gtkmenushellprivate.h"
+#include "gtkpango.h"
 #include "gtkscrolledwindow.h"
 #include "gtkseparatormenuitem.h"
 #include "gtktearoffmenuitem.h"
@@ -2192,6 +2193,17 @@ tree_column_row_is_sensitive (GtkComboBox *combo_box,
   return TRUE;
 }
 
+static void update_menu_sensitivity (GtkComboBox *combo_box,
+                                     GtkWidget   *menu);
+
+static void
+submenu_show_cb (GtkWidget   *submenu,
+                 GtkComboBox *combo_box)
+{
+  /* Submenu items are only created when the submenu pops up */
+  update_menu_sensitivity (combo_box, submenu);
+}
+
 static void
 update_menu_sensitivity (GtkComboBox *combo_box,
                          GtkWidget   *menu)
@@ -2220,6 +2232,10 @@ update_menu_sensitivity (GtkComboBox *combo_box,
         {
           gtk_widget_set_sensitive (item, TRUE);
           update_menu_sensitivity (combo_box, submenu);
+
+          g_signal_handlers_disconnect_by_func (submenu, submenu_show_cb, combo_box);
+          g_signal_connect (submenu, "show",
+                            G_CALLBACK (submenu_show_cb), combo_box);
         }
       else
         {
@@ -5484,9 +5500,9 @@ gtk_combo_box_get_preferred_width (GtkWidget *widget,
   get_widget_padding (widget, &padding);
 
   context = gtk_widget_get_pango_context (GTK_WIDGET (widget));
-  metrics = pango_context_get_metrics (context,
-                                       pango_context_get_font_description (context),
-                                        pango_context_get_language (context));
+  metrics = _gtk_pango_context_get_metrics (context,
+                                            pango_context_get_font_description (context),
+                                            pango_context_get_language (context));
                                         
   font_size = PANGO_PIXELS (pango_font_metrics_get_ascent (metrics) +
                             pango_font_metrics_get_descent (metrics));
@@ -38,6 +38,7 @@
 
 #include "gtkbuildable.h"
 #include "gtkbuilderprivate.h"
+#include "gtkdebug.h"
 #include "gtktypebuiltins.h"
 #include "gtkprivate.h"
 #include "gtkmain.h"
@@ -247,6 +248,12 @@ struct _GtkContainerPrivate
   guint restyle_pending    : 1;
   guint resize_mode        : 2;
   guint request_mode       : 2;
+  guint layout_boundary    : 1;
+  guint boundary_size_valid : 1;
+
+  /* the size we had when a resize was stopped at us */
+  GtkRequisition boundary_minimum;
+  GtkRequisition boundary_natural;
 };
 
 enum {
@@ -1635,6 +1642,118 @@ gtk_container_set_reallocate_redraws (GtkContainer *container,
   container->priv->reallocate_redraws = needs_redraws ? TRUE : FALSE;
 }
 
+static void
+gtk_container_start_idle_sizer (GtkContainer *container);
+
+/* A layout boundary is a container whose size request does not
+ * depend on the size of its children, like a scrolled window with
+ * scrollbars in both directions. A resize queued below it does not
+ * need to be propagated any further: we only check whether our size
+ * changed after all, and otherwise allocate our children again.
+ */
+static gboolean
+gtk_container_queue_boundary_resize (GtkContainer *container,
+                                     gboolean      from_child)
+{
+  GtkContainerPrivate *priv = container->priv;
+  GtkWidget *widget = GTK_WIDGET (container);
+  SizeRequestCache *cache;
+
+  if (!priv->layout_boundary ||
+      GTK_IS_RESIZE_CONTAINER (container) ||
+      !gtk_widget_get_visible (widget) ||
+      !gtk_widget_get_realized (widget) ||
+      gtk_widget_get_frame_clock (widget) == NULL)
+    return FALSE;
+
+  cache = _gtk_widget_peek_request_cache (widget);
+
+  /* remember the size our parent allocated us for, unless we
+   * already did for a resize that has not been handled yet
+   */
+  if (!priv->resize_pending)
+    {
+      priv->boundary_size_valid =
+        _gtk_size_request_cache_lookup (cache, GTK_ORIENTATION_HORIZONTAL, -1,
+                                        &priv->boundary_minimum.width,
+                                        &priv->boundary_natural.width) &&
+        _gtk_size_request_cache_lookup (cache, GTK_ORIENTATION_VERTICAL, -1,
+                                        &priv->boundary_minimum.height,
+                                        &priv->boundary_natural.height);
+    }
+
+  /* a direct child being shown, hidden or added can change our
+   * size, which we can only notice if we know what it used to be
+   */
+  if (from_child && !priv->boundary_size_valid)
+    return FALSE;
+
+  _gtk_widget_set_alloc_needed (widget, TRUE);
+  _gtk_size_request_cache_clear (cache);
+
+  if (!priv->resize_pending)
+    {
+      priv->resize_pending = TRUE;
+      gtk_container_start_idle_sizer (container);
+    }
+
+  return TRUE;
+}
+
+static void
+gtk_container_check_boundary_resize (GtkContainer *container)
+{
+  GtkContainerPrivate *priv = container->priv;
+  GtkWidget *widget = GTK_WIDGET (container);
+  GtkRequisition minimum, natural;
+  GtkAllocation allocation;
+
+  if (!gtk_widget_get_visible (widget))
+    return;
+
+  if (priv->boundary_size_valid)
+    {
+      gtk_widget_get_preferred_width (widget, &minimum.width, &natural.width);
+      gtk_widget_get_preferred_height (widget, &minimum.height, &natural.height);
+
+      priv->boundary_size_valid = FALSE;
+
+      if (minimum.width != priv->boundary_minimum.width ||
+          minimum.height != priv->boundary_minimum.height ||
+          natural.width != priv->boundary_natural.width ||
+          natural.height != priv->boundary_natural.height)
+        {
+          gtk_widget_queue_resize (widget);
+          return;
+        }
+    }
+
+  /* our allocation already went through the margin adjustments
+   * of gtk_widget_size_allocate(), so we don't go through it again
+   */
+  gtk_widget_get_allocation (widget, &allocation);
+  _gtk_widget_set_alloc_needed (widget, FALSE);
+  g_signal_emit_by_name (widget, "size-allocate", &allocation);
+}
+
+/*
+ * _gtk_container_set_layout_boundary:
+ * @container: a #GtkContainer
+ * @layout_boundary: whether the size request of @container is
+ *   independent of the size of its children
+ *
+ * Lets resizes queued inside @container stop at @container, instead
+ * of being propagated up to the toplevel.
+ */
+void
+_gtk_container_set_layout_boundary (GtkContainer *container,
+                                    gboolean      layout_boundary)
+{
+  g_return_if_fail (GTK_IS_CONTAINER (container));
+
+  container->priv->layout_boundary = layout_boundary != FALSE;
+}
+
 static void
 gtk_container_idle_sizer (GdkFrameClock *clock,
 			  GtkContainer  *container)
@@ -1651,19 +1770,21 @@ gtk_container_idle_sizer (GdkFrameClock *clock,
    */
   if (container->priv->restyle_pending)
     {
-      GtkBitmask *empty;
+      GtkCssPropertySet empty;
       gint64 current_time;
+      G_GNUC_UNUSED guint n_visited;
 
-      empty = _gtk_bitmask_new ();
+      _gtk_css_property_set_init (&empty);
       current_time = g_get_monotonic_time ();
 
       container->priv->restyle_pending = FALSE;
-      _gtk_style_context_validate (gtk_widget_get_style_context (GTK_WIDGET (container)),
-                                   current_time,
-                                   0,
-                                   empty);
+      n_visited = _gtk_style_context_validate (gtk_widget_get_style_context (GTK_WIDGET (container)),
+                                               current_time,
+                                               0,
+                                               &empty);
 
-      _gtk_bitmask_free (empty);
+      GTK_NOTE (MISC, g_print ("%s %p: validated %u style contexts\n",
+                               G_OBJECT_TYPE_NAME (container), container, n_visited));
     }
 
   /* we may be invoked with a container_resize_queue of NULL, because
@@ -1674,8 +1795,19 @@ gtk_container_idle_sizer (GdkFrameClock *clock,
    */
   if (container->priv->resize_pending)
     {
+      G_GNUC_UNUSED guint n_measured;
+
+      n_measured = _gtk_size_request_get_n_measured ();
+
       container->priv->resize_pending = FALSE;
-      gtk_container_check_resize (container);
+      if (GTK_IS_RESIZE_CONTAINER (container))
+        gtk_container_check_resize (container);
+      else
+        gtk_container_check_boundary_resize (container);
+
+      GTK_NOTE (MISC, g_print ("%s %p: measured %u widgets\n",
+                               G_OBJECT_TYPE_NAME (container), container,
+                               _gtk_size_request_get_n_measured () - n_measured));
     }
 
   if (!container->priv->restyle_pending && !container->priv->resize_pending)
@@ -1767,6 +1899,12 @@ _gtk_container_queue_resize_internal (GtkContainer *container,
 
   do
     {
+      if (!invalidate_only &&
+          GTK_IS_CONTAINER (widget) &&
+          gtk_container_queue_boundary_resize (GTK_CONTAINER (widget),
+                                               widget == GTK_WIDGET (container)))
+        return;
+
       _gtk_widget_set_alloc_needed (widget, TRUE);
       _gtk_size_request_cache_clear (_gtk_widget_peek_request_cache (widget));
 
@@ -41,6 +41,8 @@ gboolean _gtk_container_get_reallocate_redraws (GtkContainer *container);
 
 void      _gtk_container_stop_idle_sizer        (GtkContainer *container);
 void      _gtk_container_maybe_start_idle_sizer (GtkContainer *container);
+void      _gtk_container_set_layout_boundary    (GtkContainer *container,
+                                                 gboolean      layout_boundary);
 
 G_END_DECLS
 
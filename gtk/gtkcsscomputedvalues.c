@@ -20,6 +20,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "gtkprivate.h"
 #include "gtkcsscomputedvaluesprivate.h"
 
@@ -38,17 +40,209 @@
 #include "gtkstylepropertyprivate.h"
 #include "gtkstyleproviderprivate.h"
 
+struct _GtkCssValuesGroup
+{
+  guint ref_count;
+  guint n_values;
+  GtkCssValue *values[1];
+};
+
+#define GROUP_SIZE(n_values) (G_STRUCT_OFFSET (GtkCssValuesGroup, values) + (n_values) * sizeof (GtkCssValue *))
+
+/* Inherited, so these are nearly always equal to the parent's */
+static const guint font_properties[] = {
+  GTK_CSS_PROPERTY_COLOR,
+  GTK_CSS_PROPERTY_FONT_SIZE,
+  GTK_CSS_PROPERTY_FONT_FAMILY,
+  GTK_CSS_PROPERTY_FONT_STYLE,
+  GTK_CSS_PROPERTY_FONT_VARIANT,
+  GTK_CSS_PROPERTY_FONT_WEIGHT,
+  GTK_CSS_PROPERTY_TEXT_SHADOW,
+  GTK_CSS_PROPERTY_ICON_SHADOW,
+  GTK_CSS_PROPERTY_GTK_IMAGE_EFFECT
+};
+
+static const guint box_properties[] = {
+  GTK_CSS_PROPERTY_MARGIN_TOP,
+  GTK_CSS_PROPERTY_MARGIN_LEFT,
+  GTK_CSS_PROPERTY_MARGIN_BOTTOM,
+  GTK_CSS_PROPERTY_MARGIN_RIGHT,
+  GTK_CSS_PROPERTY_PADDING_TOP,
+  GTK_CSS_PROPERTY_PADDING_LEFT,
+  GTK_CSS_PROPERTY_PADDING_BOTTOM,
+  GTK_CSS_PROPERTY_PADDING_RIGHT
+};
+
+static const guint border_properties[] = {
+  GTK_CSS_PROPERTY_BORDER_TOP_STYLE,
+  GTK_CSS_PROPERTY_BORDER_TOP_WIDTH,
+  GTK_CSS_PROPERTY_BORDER_LEFT_STYLE,
+  GTK_CSS_PROPERTY_BORDER_LEFT_WIDTH,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_STYLE,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_WIDTH,
+  GTK_CSS_PROPERTY_BORDER_RIGHT_STYLE,
+  GTK_CSS_PROPERTY_BORDER_RIGHT_WIDTH,
+  GTK_CSS_PROPERTY_BORDER_TOP_LEFT_RADIUS,
+  GTK_CSS_PROPERTY_BORDER_TOP_RIGHT_RADIUS,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_RIGHT_RADIUS,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_LEFT_RADIUS,
+  GTK_CSS_PROPERTY_OUTLINE_STYLE,
+  GTK_CSS_PROPERTY_OUTLINE_WIDTH,
+  GTK_CSS_PROPERTY_OUTLINE_OFFSET,
+  GTK_CSS_PROPERTY_BORDER_TOP_COLOR,
+  GTK_CSS_PROPERTY_BORDER_RIGHT_COLOR,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_COLOR,
+  GTK_CSS_PROPERTY_BORDER_LEFT_COLOR,
+  GTK_CSS_PROPERTY_OUTLINE_COLOR,
+  GTK_CSS_PROPERTY_BORDER_IMAGE_SOURCE,
+  GTK_CSS_PROPERTY_BORDER_IMAGE_REPEAT,
+  GTK_CSS_PROPERTY_BORDER_IMAGE_SLICE,
+  GTK_CSS_PROPERTY_BORDER_IMAGE_WIDTH
+};
+
+static const guint background_properties[] = {
+  GTK_CSS_PROPERTY_BACKGROUND_COLOR,
+  GTK_CSS_PROPERTY_BOX_SHADOW,
+  GTK_CSS_PROPERTY_BACKGROUND_CLIP,
+  GTK_CSS_PROPERTY_BACKGROUND_ORIGIN,
+  GTK_CSS_PROPERTY_BACKGROUND_SIZE,
+  GTK_CSS_PROPERTY_BACKGROUND_POSITION,
+  GTK_CSS_PROPERTY_BACKGROUND_REPEAT,
+  GTK_CSS_PROPERTY_BACKGROUND_IMAGE
+};
+
+static const guint animation_properties[] = {
+  GTK_CSS_PROPERTY_TRANSITION_PROPERTY,
+  GTK_CSS_PROPERTY_TRANSITION_DURATION,
+  GTK_CSS_PROPERTY_TRANSITION_TIMING_FUNCTION,
+  GTK_CSS_PROPERTY_TRANSITION_DELAY,
+  GTK_CSS_PROPERTY_ANIMATION_NAME,
+  GTK_CSS_PROPERTY_ANIMATION_DURATION,
+  GTK_CSS_PROPERTY_ANIMATION_TIMING_FUNCTION,
+  GTK_CSS_PROPERTY_ANIMATION_ITERATION_COUNT,
+  GTK_CSS_PROPERTY_ANIMATION_DIRECTION,
+  GTK_CSS_PROPERTY_ANIMATION_PLAY_STATE,
+  GTK_CSS_PROPERTY_ANIMATION_DELAY,
+  GTK_CSS_PROPERTY_ANIMATION_FILL_MODE
+};
+
+/* Rarely equal to the parent's, so not worth a group */
+static const guint inline_properties[GTK_CSS_VALUES_N_INLINE] = {
+  GTK_CSS_PROPERTY_OPACITY,
+  GTK_CSS_PROPERTY_ENGINE,
+  GTK_CSS_PROPERTY_GTK_KEY_BINDINGS
+};
+
+static const struct {
+  const guint *properties;
+  guint        n_properties;
+} group_properties[GTK_CSS_VALUES_N_GROUPS] = {
+  { font_properties,       G_N_ELEMENTS (font_properties) },
+  { box_properties,        G_N_ELEMENTS (box_properties) },
+  { border_properties,     G_N_ELEMENTS (border_properties) },
+  { background_properties, G_N_ELEMENTS (background_properties) },
+  { animation_properties,  G_N_ELEMENTS (animation_properties) }
+};
+
+/* Group (or GTK_CSS_VALUES_N_GROUPS for inline values) and slot
+ * of every property, filled in from the tables above */
+static guint8 property_group[GTK_CSS_PROPERTY_N_PROPERTIES];
+static guint8 property_slot[GTK_CSS_PROPERTY_N_PROPERTIES];
+
 G_DEFINE_TYPE (GtkCssComputedValues, _gtk_css_computed_values, G_TYPE_OBJECT)
 
+static GtkCssValuesGroup *
+gtk_css_values_group_new (guint n_values)
+{
+  GtkCssValuesGroup *group;
+
+  group = g_slice_alloc0 (GROUP_SIZE (n_values));
+  group->ref_count = 1;
+  group->n_values = n_values;
+
+  return group;
+}
+
+static GtkCssValuesGroup *
+gtk_css_values_group_ref (GtkCssValuesGroup *group)
+{
+  group->ref_count++;
+
+  return group;
+}
+
+static void
+gtk_css_values_group_unref (GtkCssValuesGroup *group)
+{
+  guint i;
+
+  group->ref_count--;
+  if (group->ref_count > 0)
+    return;
+
+  for (i = 0; i < group->n_values; i++)
+    {
+      if (group->values[i])
+        _gtk_css_value_unref (group->values[i]);
+    }
+
+  g_slice_free1 (GROUP_SIZE (group->n_values), group);
+}
+
+/* Returns the group for writing, copying it first if it is shared */
+static GtkCssValuesGroup *
+gtk_css_computed_values_get_writable_group (GtkCssComputedValues *values,
+                                            guint                 index)
+{
+  GtkCssValuesGroup *group, *copy;
+  guint i;
+
+  group = values->groups[index];
+
+  if (group == NULL)
+    {
+      group = gtk_css_values_group_new (group_properties[index].n_properties);
+      values->groups[index] = group;
+    }
+  else if (group->ref_count > 1)
+    {
+      copy = gtk_css_values_group_new (group->n_values);
+      for (i = 0; i < group->n_values; i++)
+        copy->values[i] = group->values[i] ? _gtk_css_value_ref (group->values[i]) : NULL;
+
+      gtk_css_values_group_unref (group);
+      values->groups[index] = group = copy;
+    }
+
+  return group;
+}
+
 static void
 gtk_css_computed_values_dispose (GObject *object)
 {
   GtkCssComputedValues *values = GTK_CSS_COMPUTED_VALUES (object);
+  guint i;
 
-  if (values->values)
+  for (i = 0; i < GTK_CSS_VALUES_N_GROUPS; i++)
+    {
+      if (values->groups[i])
+        {
+          gtk_css_values_group_unref (values->groups[i]);
+          values->groups[i] = NULL;
+        }
+    }
+  for (i = 0; i < GTK_CSS_VALUES_N_INLINE; i++)
+    {
+      if (values->inline_values[i])
+        {
+          _gtk_css_value_unref (values->inline_values[i]);
+          values->inline_values[i] = NULL;
+        }
+    }
+  if (values->custom_values)
     {
-      g_ptr_array_unref (values->values);
-      values->values = NULL;
+      g_ptr_array_unref (values->custom_values);
+      values->custom_values = NULL;
     }
   if (values->sections)
     {
@@ -67,35 +261,39 @@ gtk_css_computed_values_dispose (GObject *object)
   G_OBJECT_CLASS (_gtk_css_computed_values_parent_class)->dispose (object);
 }
 
-static void
-gtk_css_computed_values_finalize (GObject *object)
-{
-  GtkCssComputedValues *values = GTK_CSS_COMPUTED_VALUES (object);
-
-  _gtk_bitmask_free (values->depends_on_parent);
-  _gtk_bitmask_free (values->equals_parent);
-  _gtk_bitmask_free (values->depends_on_color);
-  _gtk_bitmask_free (values->depends_on_font_size);
-
-  G_OBJECT_CLASS (_gtk_css_computed_values_parent_class)->finalize (object);
-}
-
 static void
 _gtk_css_computed_values_class_init (GtkCssComputedValuesClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  guint i, j;
 
   object_class->dispose = gtk_css_computed_values_dispose;
-  object_class->finalize = gtk_css_computed_values_finalize;
+
+  memset (property_group, G_MAXUINT8, sizeof (property_group));
+  for (i = 0; i < GTK_CSS_VALUES_N_GROUPS; i++)
+    {
+      for (j = 0; j < group_properties[i].n_properties; j++)
+        {
+          /* every property lives in exactly one place */
+          g_assert (property_group[group_properties[i].properties[j]] == G_MAXUINT8);
+          property_group[group_properties[i].properties[j]] = i;
+          property_slot[group_properties[i].properties[j]] = j;
+        }
+    }
+  for (j = 0; j < GTK_CSS_VALUES_N_INLINE; j++)
+    {
+      g_assert (property_group[inline_properties[j]] == G_MAXUINT8);
+      property_group[inline_properties[j]] = GTK_CSS_VALUES_N_GROUPS;
+      property_slot[inline_properties[j]] = j;
+    }
+
+  for (i = 0; i < GTK_CSS_PROPERTY_N_PROPERTIES; i++)
+    g_assert (property_group[i] != G_MAXUINT8);
 }
 
 static void
 _gtk_css_computed_values_init (GtkCssComputedValues *values)
 {
-  values->depends_on_parent = _gtk_bitmask_new ();
-  values->equals_parent = _gtk_bitmask_new ();
-  values->depends_on_color = _gtk_bitmask_new ();
-  values->depends_on_font_size = _gtk_bitmask_new ();
 }
 
 GtkCssComputedValues *
@@ -178,26 +376,44 @@ _gtk_css_computed_values_set_value (GtkCssComputedValues *values,
                                     GtkCssDependencies    dependencies,
                                     GtkCssSection        *section)
 {
+  GtkCssValue **slot;
+
   gtk_internal_return_if_fail (GTK_IS_CSS_COMPUTED_VALUES (values));
 
-  if (values->values == NULL)
-    values->values = g_ptr_array_new_full (_gtk_css_style_property_get_n_properties (),
-					   (GDestroyNotify)_gtk_css_value_unref);
-  if (id >= values->values->len)
-   g_ptr_array_set_size (values->values, id + 1);
+  if (G_LIKELY (id < GTK_CSS_PROPERTY_N_PROPERTIES))
+    {
+      guint index = property_group[id];
+
+      if (index < GTK_CSS_VALUES_N_GROUPS)
+        slot = &gtk_css_computed_values_get_writable_group (values, index)->values[property_slot[id]];
+      else
+        slot = &values->inline_values[property_slot[id]];
+    }
+  else
+    {
+      guint custom_id = id - GTK_CSS_PROPERTY_N_PROPERTIES;
 
-  if (g_ptr_array_index (values->values, id))
-    _gtk_css_value_unref (g_ptr_array_index (values->values, id));
-  g_ptr_array_index (values->values, id) = _gtk_css_value_ref (value);
+      if (values->custom_values == NULL)
+        values->custom_values = g_ptr_array_new_with_free_func ((GDestroyNotify)_gtk_css_value_unref);
+      if (custom_id >= values->custom_values->len)
+        g_ptr_array_set_size (values->custom_values, custom_id + 1);
+
+      slot = (GtkCssValue **) &g_ptr_array_index (values->custom_values, custom_id);
+    }
+
+  _gtk_css_value_ref (value);
+  if (*slot)
+    _gtk_css_value_unref (*slot);
+  *slot = value;
 
   if (dependencies & (GTK_CSS_DEPENDS_ON_PARENT | GTK_CSS_EQUALS_PARENT))
-    values->depends_on_parent = _gtk_bitmask_set (values->depends_on_parent, id, TRUE);
+    _gtk_css_property_set_add (&values->depends_on_parent, id);
   if (dependencies & (GTK_CSS_EQUALS_PARENT))
-    values->equals_parent = _gtk_bitmask_set (values->equals_parent, id, TRUE);
+    _gtk_css_property_set_add (&values->equals_parent, id);
   if (dependencies & (GTK_CSS_DEPENDS_ON_COLOR))
-    values->depends_on_color = _gtk_bitmask_set (values->depends_on_color, id, TRUE);
+    _gtk_css_property_set_add (&values->depends_on_color, id);
   if (dependencies & (GTK_CSS_DEPENDS_ON_FONT_SIZE))
-    values->depends_on_font_size = _gtk_bitmask_set (values->depends_on_font_size, id, TRUE);
+    _gtk_css_property_set_add (&values->depends_on_font_size, id);
 
   if (values->sections && values->sections->len > id && g_ptr_array_index (values->sections, id))
     {
@@ -236,11 +452,24 @@ _gtk_css_computed_values_get_intrinsic_value (GtkCssComputedValues *values,
 {
   gtk_internal_return_val_if_fail (GTK_IS_CSS_COMPUTED_VALUES (values), NULL);
 
-  if (values->values == NULL ||
-      id >= values->values->len)
+  if (G_LIKELY (id < GTK_CSS_PROPERTY_N_PROPERTIES))
+    {
+      GtkCssValuesGroup *group;
+
+      if (property_group[id] == GTK_CSS_VALUES_N_GROUPS)
+        return values->inline_values[property_slot[id]];
+
+      group = values->groups[property_group[id]];
+
+      return group ? group->values[property_slot[id]] : NULL;
+    }
+
+  id -= GTK_CSS_PROPERTY_N_PROPERTIES;
+  if (values->custom_values == NULL ||
+      id >= values->custom_values->len)
     return NULL;
 
-  return g_ptr_array_index (values->values, id);
+  return g_ptr_array_index (values->custom_values, id);
 }
 
 GtkCssSection *
@@ -256,26 +485,91 @@ _gtk_css_computed_values_get_section (GtkCssComputedValues *values,
   return g_ptr_array_index (values->sections, id);
 }
 
-GtkBitmask *
+void
 _gtk_css_computed_values_get_difference (GtkCssComputedValues *values,
-                                         GtkCssComputedValues *other)
+                                         GtkCssComputedValues *other,
+                                         GtkCssPropertySet    *differences)
 {
-  GtkBitmask *result;
-  guint i, len;
+  guint i, j, id, n;
 
-  len = MIN (values->values->len, other->values->len);
-  result = _gtk_bitmask_new ();
-  if (values->values->len != other->values->len)
-    result = _gtk_bitmask_invert_range (result, len, MAX (values->values->len, other->values->len));
-  
-  for (i = 0; i < len; i++)
+  _gtk_css_property_set_init (differences);
+
+  for (i = 0; i < GTK_CSS_VALUES_N_GROUPS; i++)
     {
-      if (!_gtk_css_value_equal (g_ptr_array_index (values->values, i),
-                                 g_ptr_array_index (other->values, i)))
-        result = _gtk_bitmask_set (result, i, TRUE);
+      /* A shared group can't contain differences */
+      if (values->groups[i] == other->groups[i])
+        continue;
+
+      for (j = 0; j < group_properties[i].n_properties; j++)
+        {
+          id = group_properties[i].properties[j];
+          if (!_gtk_css_value_equal0 (_gtk_css_computed_values_get_intrinsic_value (values, id),
+                                      _gtk_css_computed_values_get_intrinsic_value (other, id)))
+            _gtk_css_property_set_add (differences, id);
+        }
     }
 
-  return result;
+  for (j = 0; j < GTK_CSS_VALUES_N_INLINE; j++)
+    {
+      if (!_gtk_css_value_equal0 (values->inline_values[j], other->inline_values[j]))
+        _gtk_css_property_set_add (differences, inline_properties[j]);
+    }
+
+  n = MAX (values->custom_values ? values->custom_values->len : 0,
+           other->custom_values ? other->custom_values->len : 0);
+  for (i = GTK_CSS_PROPERTY_N_PROPERTIES; i < GTK_CSS_PROPERTY_N_PROPERTIES + n; i++)
+    {
+      if (!_gtk_css_value_equal0 (_gtk_css_computed_values_get_intrinsic_value (values, i),
+                                  _gtk_css_computed_values_get_intrinsic_value (other, i)))
+        {
+          /* all custom properties share one bit */
+          _gtk_css_property_set_add (differences, i);
+          break;
+        }
+    }
+}
+
+/**
+ * _gtk_css_computed_values_share_with_parent:
+ * @values: values that were just computed
+ * @parent_values: the values @values were computed from
+ *
+ * Replaces every group of values in @values that is equal to the
+ * corresponding group in @parent_values with a reference to the
+ * parent's group. The font group is inherited and the other groups
+ * mostly hold initial values, so this frees most of each style's
+ * groups.
+ **/
+void
+_gtk_css_computed_values_share_with_parent (GtkCssComputedValues *values,
+                                            GtkCssComputedValues *parent_values)
+{
+  GtkCssValuesGroup *group, *parent_group;
+  guint i, j;
+
+  gtk_internal_return_if_fail (GTK_IS_CSS_COMPUTED_VALUES (values));
+  gtk_internal_return_if_fail (GTK_IS_CSS_COMPUTED_VALUES (parent_values));
+
+  for (i = 0; i < GTK_CSS_VALUES_N_GROUPS; i++)
+    {
+      group = values->groups[i];
+      parent_group = parent_values->groups[i];
+
+      if (group == NULL || parent_group == NULL || group == parent_group)
+        continue;
+
+      for (j = 0; j < group->n_values; j++)
+        {
+          if (!_gtk_css_value_equal0 (group->values[j], parent_group->values[j]))
+            break;
+        }
+
+      if (j < group->n_values)
+        continue;
+
+      values->groups[i] = gtk_css_values_group_ref (parent_group);
+      gtk_css_values_group_unref (group);
+    }
 }
 
 /* TRANSITIONS */
@@ -525,17 +819,17 @@ _gtk_css_computed_values_create_animations (GtkCssComputedValues    *values,
   gtk_css_computed_values_create_css_animations (values, parent_values, timestamp, provider, scale, source);
 }
 
-GtkBitmask *
+void
 _gtk_css_computed_values_advance (GtkCssComputedValues *values,
-                                  gint64                timestamp)
+                                  gint64                timestamp,
+                                  GtkCssPropertySet    *changes)
 {
-  GtkBitmask *changed;
   GPtrArray *old_computed_values;
   GSList *list;
   guint i;
 
-  gtk_internal_return_val_if_fail (GTK_IS_CSS_COMPUTED_VALUES (values), NULL);
-  gtk_internal_return_val_if_fail (timestamp >= values->current_time, NULL);
+  gtk_internal_return_if_fail (GTK_IS_CSS_COMPUTED_VALUES (values));
+  gtk_internal_return_if_fail (timestamp >= values->current_time);
 
   values->current_time = timestamp;
   old_computed_values = values->animated_values;
@@ -560,8 +854,6 @@ _gtk_css_computed_values_advance (GtkCssComputedValues *values,
     }
 
   /* figure out changes */
-  changed = _gtk_bitmask_new ();
-
   for (i = 0; i < GTK_CSS_PROPERTY_N_PROPERTIES; i++)
     {
       GtkCssValue *old_animated, *new_animated;
@@ -570,13 +862,11 @@ _gtk_css_computed_values_advance (GtkCssComputedValues *values,
       new_animated = values->animated_values && i < values->animated_values->len ? g_ptr_array_index (values->animated_values, i) : NULL;
 
       if (!_gtk_css_value_equal0 (old_animated, new_animated))
-        changed = _gtk_bitmask_set (changed, i, TRUE);
+        _gtk_css_property_set_add (changes, i);
     }
 
   if (old_computed_values)
     g_ptr_array_unref (old_computed_values);
-
-  return changed;
 }
 
 gboolean
@@ -610,21 +900,20 @@ _gtk_css_computed_values_cancel_animations (GtkCssComputedValues *values)
   values->animations = NULL;
 }
 
-GtkBitmask *
-_gtk_css_computed_values_compute_dependencies (GtkCssComputedValues *values,
-                                               const GtkBitmask     *parent_changes)
+void
+_gtk_css_computed_values_compute_dependencies (GtkCssComputedValues    *values,
+                                               const GtkCssPropertySet *parent_changes,
+                                               GtkCssPropertySet       *changes)
 {
-  GtkBitmask *changes;
+  _gtk_css_property_set_init (changes);
 
-  gtk_internal_return_val_if_fail (GTK_IS_CSS_COMPUTED_VALUES (values), _gtk_bitmask_new ());
-
-  changes = _gtk_bitmask_copy (parent_changes);
-  changes = _gtk_bitmask_intersect (changes, values->depends_on_parent);
-  if (_gtk_bitmask_get (changes, GTK_CSS_PROPERTY_COLOR))
-    changes = _gtk_bitmask_union (changes, values->depends_on_color);
-  if (_gtk_bitmask_get (changes, GTK_CSS_PROPERTY_FONT_SIZE))
-    changes = _gtk_bitmask_union (changes, values->depends_on_font_size);
+  gtk_internal_return_if_fail (GTK_IS_CSS_COMPUTED_VALUES (values));
 
-  return changes;
+  _gtk_css_property_set_union (changes, parent_changes);
+  _gtk_css_property_set_intersect (changes, &values->depends_on_parent);
+  if (_gtk_css_property_set_get (changes, GTK_CSS_PROPERTY_COLOR))
+    _gtk_css_property_set_union (changes, &values->depends_on_color);
+  if (_gtk_css_property_set_get (changes, GTK_CSS_PROPERTY_FONT_SIZE))
+    _gtk_css_property_set_union (changes, &values->depends_on_font_size);
 }
 
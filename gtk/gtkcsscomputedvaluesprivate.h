@@ -23,8 +23,9 @@
 
 #include <glib-object.h>
 
-#include "gtk/gtkbitmaskprivate.h"
+#include "gtk/gtkcsspropertysetprivate.h"
 #include "gtk/gtkcsssection.h"
+#include "gtk/gtkcsstypesprivate.h"
 #include "gtk/gtkcssvalueprivate.h"
 
 G_BEGIN_DECLS
@@ -36,24 +37,42 @@ G_BEGIN_DECLS
 #define GTK_IS_CSS_COMPUTED_VALUES_CLASS(obj)  (G_TYPE_CHECK_CLASS_TYPE (obj, GTK_TYPE_CSS_COMPUTED_VALUES))
 #define GTK_CSS_COMPUTED_VALUES_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), GTK_TYPE_CSS_COMPUTED_VALUES, GtkCssComputedValuesClass))
 
+/* The values of related properties are kept together in groups,
+ * which can be shared with the parent's values when they are all equal.
+ * The few properties that are in no group are kept inline.
+ */
+typedef enum {
+  GTK_CSS_VALUES_GROUP_FONT,
+  GTK_CSS_VALUES_GROUP_BOX,
+  GTK_CSS_VALUES_GROUP_BORDER,
+  GTK_CSS_VALUES_GROUP_BACKGROUND,
+  GTK_CSS_VALUES_GROUP_ANIMATION,
+  GTK_CSS_VALUES_N_GROUPS
+} GtkCssValuesGroupId;
+
+#define GTK_CSS_VALUES_N_INLINE 3
+
 /* typedef struct _GtkCssComputedValues           GtkCssComputedValues; */
 typedef struct _GtkCssComputedValuesClass      GtkCssComputedValuesClass;
+typedef struct _GtkCssValuesGroup              GtkCssValuesGroup;
 
 struct _GtkCssComputedValues
 {
   GObject parent;
 
-  GPtrArray             *values;               /* the unanimated (aka intrinsic) values */
+  GtkCssValuesGroup     *groups[GTK_CSS_VALUES_N_GROUPS]; /* the unanimated (aka intrinsic) values */
+  GtkCssValue           *inline_values[GTK_CSS_VALUES_N_INLINE]; /* dito, for properties in no group */
+  GPtrArray             *custom_values;        /* NULL or intrinsic values of custom properties */
   GPtrArray             *sections;             /* sections the values are defined in */
 
   GPtrArray             *animated_values;      /* NULL or array of animated values/NULL if not animated */
   gint64                 current_time;         /* the current time in our world */
   GSList                *animations;           /* the running animations, least important one first */
 
-  GtkBitmask            *depends_on_parent;    /* for intrinsic values */
-  GtkBitmask            *equals_parent;        /* dito */
-  GtkBitmask            *depends_on_color;     /* dito */
-  GtkBitmask            *depends_on_font_size; /* dito */
+  GtkCssPropertySet      depends_on_parent;    /* for intrinsic values */
+  GtkCssPropertySet      equals_parent;        /* dito */
+  GtkCssPropertySet      depends_on_color;     /* dito */
+  GtkCssPropertySet      depends_on_font_size; /* dito */
 };
 
 struct _GtkCssComputedValuesClass
@@ -87,10 +106,14 @@ GtkCssSection *         _gtk_css_computed_values_get_section          (GtkCssCom
                                                                        guint                     id);
 GtkCssValue *           _gtk_css_computed_values_get_intrinsic_value  (GtkCssComputedValues     *values,
                                                                        guint                     id);
-GtkBitmask *            _gtk_css_computed_values_get_difference       (GtkCssComputedValues     *values,
-                                                                       GtkCssComputedValues     *other);
-GtkBitmask *            _gtk_css_computed_values_compute_dependencies (GtkCssComputedValues     *values,
-                                                                       const GtkBitmask         *parent_changes);
+void                    _gtk_css_computed_values_get_difference       (GtkCssComputedValues     *values,
+                                                                       GtkCssComputedValues     *other,
+                                                                       GtkCssPropertySet        *differences);
+void                    _gtk_css_computed_values_compute_dependencies (GtkCssComputedValues     *values,
+                                                                       const GtkCssPropertySet  *parent_changes,
+                                                                       GtkCssPropertySet        *changes);
+void                    _gtk_css_computed_values_share_with_parent    (GtkCssComputedValues     *values,
+                                                                       GtkCssComputedValues     *parent_values);
 
 void                    _gtk_css_computed_values_create_animations    (GtkCssComputedValues     *values,
                                                                        GtkCssComputedValues     *parent_values,
@@ -98,8 +121,9 @@ void                    _gtk_css_computed_values_create_animations    (GtkCssCom
                                                                        GtkStyleProviderPrivate  *provider,
 								       int                       scale,
                                                                        GtkCssComputedValues     *source);
-GtkBitmask *            _gtk_css_computed_values_advance              (GtkCssComputedValues     *values,
-                                                                       gint64                    timestamp);
+void                    _gtk_css_computed_values_advance              (GtkCssComputedValues     *values,
+                                                                       gint64                    timestamp,
+                                                                       GtkCssPropertySet        *changes);
 void                    _gtk_css_computed_values_cancel_animations    (GtkCssComputedValues     *values);
 gboolean                _gtk_css_computed_values_is_static            (GtkCssComputedValues     *values);
 
@@ -149,8 +149,14 @@ gtk_css_image_url_print (GtkCssImage *image,
                          GString     *string)
 {
   GtkCssImageUrl *url = GTK_CSS_IMAGE_URL (image);
-
-  _gtk_css_image_print (gtk_css_image_url_load_image (url), string);
+  gchar *uri;
+
+  /* Print the file and not the image, so that parsing the printed
+   * form reads the same file again. The URI is escaped already.
+   */
+  uri = g_file_get_uri (url->file);
+  g_string_append_printf (string, "url(\"%s\")", uri);
+  g_free (uri);
 }
 
 static void
@@ -27,7 +27,7 @@
 #include "gtkstylepropertiesprivate.h"
 
 GtkCssLookup *
-_gtk_css_lookup_new (const GtkBitmask *relevant)
+_gtk_css_lookup_new (const GtkCssPropertySet *relevant)
 {
   GtkCssLookup *lookup;
   guint n = _gtk_css_style_property_get_n_properties ();
@@ -36,7 +36,7 @@ _gtk_css_lookup_new (const GtkBitmask *relevant)
 
   if (relevant)
     {
-      lookup->missing = _gtk_bitmask_copy (relevant);
+      lookup->missing = _gtk_css_property_set_to_bitmask (relevant, n);
     }
   else
     {
@@ -174,4 +174,7 @@ _gtk_css_lookup_resolve (GtkCssLookup            *lookup,
                                                 lookup->values[i].section);
       /* else not a relevant property */
     }
+
+  if (parent_values)
+    _gtk_css_computed_values_share_with_parent (values, parent_values);
 }
@@ -41,7 +41,7 @@ struct _GtkCssLookup {
   GtkCssLookupValue  values[1];
 };
 
-GtkCssLookup *          _gtk_css_lookup_new                     (const GtkBitmask           *relevant);
+GtkCssLookup *          _gtk_css_lookup_new                     (const GtkCssPropertySet    *relevant);
 void                    _gtk_css_lookup_free                    (GtkCssLookup               *lookup);
 
 static inline const GtkBitmask *_gtk_css_lookup_get_missing     (const GtkCssLookup         *lookup);
@@ -0,0 +1,203 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2013 Red Hat Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_CSS_PROPERTY_SET_PRIVATE_H__
+#define __GTK_CSS_PROPERTY_SET_PRIVATE_H__
+
+#include <glib.h>
+#include "gtk/gtkbitmaskprivate.h"
+#include "gtk/gtkcsstypesprivate.h"
+
+G_BEGIN_DECLS
+
+/* A set of CSS style properties, used to pass changes around while
+ * restyling. Unlike GtkBitmask it has a fixed size and is meant to
+ * live on the stack or inside other structures, so no allocations
+ * happen when combining sets.
+ *
+ * Every builtin property has its own bit. All custom properties
+ * registered at runtime share the last bit, so a set containing one
+ * of them contains all of them. That is good enough for deciding
+ * what needs to be updated and keeps the set small.
+ */
+
+#define GTK_CSS_PROPERTY_SET_CUSTOM     GTK_CSS_PROPERTY_N_PROPERTIES
+#define GTK_CSS_PROPERTY_SET_N_BITS     (GTK_CSS_PROPERTY_N_PROPERTIES + 1)
+#define GTK_CSS_PROPERTY_SET_WORD_BITS  (sizeof (gsize) * 8)
+#define GTK_CSS_PROPERTY_SET_N_WORDS    ((GTK_CSS_PROPERTY_SET_N_BITS + GTK_CSS_PROPERTY_SET_WORD_BITS - 1) / GTK_CSS_PROPERTY_SET_WORD_BITS)
+
+typedef struct _GtkCssPropertySet GtkCssPropertySet;
+
+struct _GtkCssPropertySet {
+  gsize bits[GTK_CSS_PROPERTY_SET_N_WORDS];
+};
+
+static inline void      _gtk_css_property_set_init              (GtkCssPropertySet       *set);
+static inline void      _gtk_css_property_set_init_all          (GtkCssPropertySet       *set);
+
+static inline gboolean  _gtk_css_property_set_get               (const GtkCssPropertySet *set,
+                                                                 guint                    id);
+static inline void      _gtk_css_property_set_add               (GtkCssPropertySet       *set,
+                                                                 guint                    id);
+
+static inline void      _gtk_css_property_set_union             (GtkCssPropertySet       *set,
+                                                                 const GtkCssPropertySet *other);
+static inline void      _gtk_css_property_set_intersect         (GtkCssPropertySet       *set,
+                                                                 const GtkCssPropertySet *other);
+static inline void      _gtk_css_property_set_subtract          (GtkCssPropertySet       *set,
+                                                                 const GtkCssPropertySet *other);
+
+static inline gboolean  _gtk_css_property_set_is_empty          (const GtkCssPropertySet *set);
+static inline gboolean  _gtk_css_property_set_intersects        (const GtkCssPropertySet *set,
+                                                                 const GtkCssPropertySet *other);
+
+static inline GtkBitmask *_gtk_css_property_set_to_bitmask      (const GtkCssPropertySet *set,
+                                                                 guint                    n_properties);
+
+/* The loops below all run over a compile-time constant number of
+ * words, so the compiler unrolls or vectorizes them.
+ */
+
+static inline guint
+gtk_css_property_set_bit (guint id)
+{
+  return MIN (id, GTK_CSS_PROPERTY_SET_CUSTOM);
+}
+
+static inline void
+_gtk_css_property_set_init (GtkCssPropertySet *set)
+{
+  guint i;
+
+  for (i = 0; i < GTK_CSS_PROPERTY_SET_N_WORDS; i++)
+    set->bits[i] = 0;
+}
+
+static inline void
+_gtk_css_property_set_init_all (GtkCssPropertySet *set)
+{
+  guint i;
+
+  for (i = 0; i < GTK_CSS_PROPERTY_SET_N_WORDS; i++)
+    set->bits[i] = G_MAXSIZE;
+
+  /* keep the unused bits of the last word cleared */
+  if (GTK_CSS_PROPERTY_SET_N_BITS % GTK_CSS_PROPERTY_SET_WORD_BITS)
+    set->bits[GTK_CSS_PROPERTY_SET_N_WORDS - 1] = (((gsize) 1) << (GTK_CSS_PROPERTY_SET_N_BITS % GTK_CSS_PROPERTY_SET_WORD_BITS)) - 1;
+}
+
+static inline gboolean
+_gtk_css_property_set_get (const GtkCssPropertySet *set,
+                           guint                    id)
+{
+  guint bit = gtk_css_property_set_bit (id);
+
+  return (set->bits[bit / GTK_CSS_PROPERTY_SET_WORD_BITS] >> (bit % GTK_CSS_PROPERTY_SET_WORD_BITS)) & 1;
+}
+
+static inline void
+_gtk_css_property_set_add (GtkCssPropertySet *set,
+                           guint              id)
+{
+  guint bit = gtk_css_property_set_bit (id);
+
+  set->bits[bit / GTK_CSS_PROPERTY_SET_WORD_BITS] |= ((gsize) 1) << (bit % GTK_CSS_PROPERTY_SET_WORD_BITS);
+}
+
+static inline void
+_gtk_css_property_set_union (GtkCssPropertySet       *set,
+                             const GtkCssPropertySet *other)
+{
+  guint i;
+
+  for (i = 0; i < GTK_CSS_PROPERTY_SET_N_WORDS; i++)
+    set->bits[i] |= other->bits[i];
+}
+
+static inline void
+_gtk_css_property_set_intersect (GtkCssPropertySet       *set,
+                                 const GtkCssPropertySet *other)
+{
+  guint i;
+
+  for (i = 0; i < GTK_CSS_PROPERTY_SET_N_WORDS; i++)
+    set->bits[i] &= other->bits[i];
+}
+
+static inline void
+_gtk_css_property_set_subtract (GtkCssPropertySet       *set,
+                                const GtkCssPropertySet *other)
+{
+  guint i;
+
+  for (i = 0; i < GTK_CSS_PROPERTY_SET_N_WORDS; i++)
+    set->bits[i] &= ~other->bits[i];
+}
+
+static inline gboolean
+_gtk_css_property_set_is_empty (const GtkCssPropertySet *set)
+{
+  gsize result = 0;
+  guint i;
+
+  for (i = 0; i < GTK_CSS_PROPERTY_SET_N_WORDS; i++)
+    result |= set->bits[i];
+
+  return result == 0;
+}
+
+static inline gboolean
+_gtk_css_property_set_intersects (const GtkCssPropertySet *set,
+                                  const GtkCssPropertySet *other)
+{
+  gsize result = 0;
+  guint i;
+
+  for (i = 0; i < GTK_CSS_PROPERTY_SET_N_WORDS; i++)
+    result |= set->bits[i] & other->bits[i];
+
+  return result != 0;
+}
+
+/* Expands the custom bit again, over every property from
+ * GTK_CSS_PROPERTY_N_PROPERTIES up to @n_properties
+ */
+static inline GtkBitmask *
+_gtk_css_property_set_to_bitmask (const GtkCssPropertySet *set,
+                                  guint                    n_properties)
+{
+  GtkBitmask *mask;
+  guint i;
+
+  mask = _gtk_bitmask_new ();
+
+  for (i = 0; i < MIN (n_properties, GTK_CSS_PROPERTY_N_PROPERTIES); i++)
+    {
+      if (_gtk_css_property_set_get (set, i))
+        mask = _gtk_bitmask_set (mask, i, TRUE);
+    }
+
+  if (n_properties > GTK_CSS_PROPERTY_N_PROPERTIES &&
+      _gtk_css_property_set_get (set, GTK_CSS_PROPERTY_SET_CUSTOM))
+    mask = _gtk_bitmask_invert_range (mask, GTK_CSS_PROPERTY_N_PROPERTIES, n_properties);
+
+  return mask;
+}
+
+G_END_DECLS
+
+#endif /* __GTK_CSS_PROPERTY_SET_PRIVATE_H__ */
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include <glib/gstdio.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <cairo-gobject.h>
 
@@ -42,8 +43,10 @@
 #include "gtkstylepropertyprivate.h"
 #include "gtkstyleproviderprivate.h"
 #include "gtkbindings.h"
+#include "gtkdebug.h"
 #include "gtkmarshalers.h"
 #include "gtkprivate.h"
+#include "gtkversion.h"
 #include "gtkintl.h"
 
 /**
@@ -73,6 +76,12 @@
  * is the prefix configured when GTK+ was compiled, unless overridden by the
  * <envar>GTK_DATA_PREFIX</envar> environment variable.
  * </para>
+ * <para>
+ * Themes loaded from files are cached in
+ * <filename><envar>$XDG_CACHE_HOME</envar>/gtk-3.0/themes</filename>.
+ * The cache is ignored whenever one of the theme's files changes, so
+ * it is safe to remove it at any time.
+ * </para>
  * </refsect2>
  * <refsect2 id="gtkcssprovider-stylesheets">
  * <title>Style sheets</title>
@@ -1011,6 +1020,17 @@ struct _GtkCssProviderPrivate
   GArray *rulesets;
   GtkCssSelectorTree *tree;
   GResource *resource;
+
+  /* Files the current contents were parsed from, and whether
+   * printing those contents reproduces them for the theme cache
+   */
+  GPtrArray *loaded_files;
+  gboolean cacheable;
+
+  /* The async load in progress, not owned. Any newer load
+   * supersedes it, see gtk_css_provider_supersede_load().
+   */
+  GTask *load_task;
 };
 
 enum {
@@ -1293,6 +1313,9 @@ gtk_css_provider_emit_error (GtkCssProvider *provider,
                              GtkCssScanner  *scanner,
                              const GError   *error)
 {
+  /* Whatever failed to parse won't be in the printed theme */
+  provider->priv->cacheable = FALSE;
+
   g_signal_emit (provider, css_provider_signals[PARSING_ERROR], 0,
                  scanner != NULL ? scanner->section : NULL, error);
 }
@@ -1393,6 +1416,8 @@ gtk_css_provider_init (GtkCssProvider *css_provider)
                                                            GtkCssProviderPrivate);
 
   priv->rulesets = g_array_new (FALSE, FALSE, sizeof (GtkCssRuleset));
+  priv->loaded_files = g_ptr_array_new_with_free_func (g_object_unref);
+  priv->cacheable = TRUE;
 
   priv->symbolic_colors = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                  (GDestroyNotify) g_free,
@@ -1728,6 +1753,7 @@ gtk_css_provider_finalize (GObject *object)
 
   g_hash_table_destroy (priv->symbolic_colors);
   g_hash_table_destroy (priv->keyframes);
+  g_ptr_array_unref (priv->loaded_files);
 
   if (priv->resource)
     {
@@ -1841,6 +1867,15 @@ css_provider_commit (GtkCssProvider *css_provider,
   g_slist_free (selectors);
 }
 
+/* Makes a pending async load fail with %G_IO_ERROR_CANCELLED instead
+ * of replacing the contents of a later load when it completes
+ */
+static void
+gtk_css_provider_supersede_load (GtkCssProvider *css_provider)
+{
+  css_provider->priv->load_task = NULL;
+}
+
 static void
 gtk_css_provider_reset (GtkCssProvider *css_provider)
 {
@@ -1865,6 +1900,8 @@ gtk_css_provider_reset (GtkCssProvider *css_provider)
   _gtk_css_selector_tree_free (priv->tree);
   priv->tree = NULL;
 
+  g_ptr_array_set_size (priv->loaded_files, 0);
+  priv->cacheable = TRUE;
 }
 
 static void
@@ -2035,6 +2072,9 @@ parse_binding_set (GtkCssScanner *scanner)
       return FALSE;
     }
 
+  /* Binding sets are not kept in the provider, so they can't be printed */
+  scanner->provider->priv->cacheable = FALSE;
+
   name = _gtk_css_parser_try_ident (scanner->parser, TRUE);
   if (name == NULL)
     {
@@ -2461,6 +2501,16 @@ parse_statement (GtkCssScanner *scanner)
     parse_ruleset (scanner);
 }
 
+static void
+parse_stylesheet_statement (GtkCssScanner *scanner)
+{
+  if (_gtk_css_parser_try (scanner->parser, "<!--", TRUE) ||
+      _gtk_css_parser_try (scanner->parser, "-->", TRUE))
+    return;
+
+  parse_statement (scanner);
+}
+
 static void
 parse_stylesheet (GtkCssScanner *scanner)
 {
@@ -2469,13 +2519,7 @@ parse_stylesheet (GtkCssScanner *scanner)
   _gtk_css_parser_skip_whitespace (scanner->parser);
 
   while (!_gtk_css_parser_is_eof (scanner->parser))
-    {
-      if (_gtk_css_parser_try (scanner->parser, "<!--", TRUE) ||
-          _gtk_css_parser_try (scanner->parser, "-->", TRUE))
-        continue;
-
-      parse_statement (scanner);
-    }
+    parse_stylesheet_statement (scanner);
 
   gtk_css_scanner_pop_section (scanner, GTK_CSS_SECTION_DOCUMENT);
 }
@@ -2549,6 +2593,7 @@ gtk_css_provider_load_internal (GtkCssProvider *css_provider,
                                 NULL, &load_error))
         {
           text = free_data;
+          g_ptr_array_add (css_provider->priv->loaded_files, g_object_ref (file));
         }
       else
         {
@@ -2643,6 +2688,7 @@ gtk_css_provider_load_from_data (GtkCssProvider  *css_provider,
       data = free_data;
     }
 
+  gtk_css_provider_supersede_load (css_provider);
   gtk_css_provider_reset (css_provider);
 
   ret = gtk_css_provider_load_internal (css_provider, NULL, NULL, data, error);
@@ -2678,6 +2724,7 @@ gtk_css_provider_load_from_file (GtkCssProvider  *css_provider,
   g_return_val_if_fail (GTK_IS_CSS_PROVIDER (css_provider), FALSE);
   g_return_val_if_fail (G_IS_FILE (file), FALSE);
 
+  gtk_css_provider_supersede_load (css_provider);
   gtk_css_provider_reset (css_provider);
 
   success = gtk_css_provider_load_internal (css_provider, NULL, file, NULL, error);
@@ -2687,6 +2734,270 @@ gtk_css_provider_load_from_file (GtkCssProvider  *css_provider,
   return success;
 }
 
+/* Parsing happens in slices of this many microseconds from an idle
+ * handler, so that a slice still fits into a frame
+ */
+#define ASYNC_PARSE_SLICE 4000
+
+typedef struct
+{
+  GFile *file;
+  gchar *data;
+  GtkCssProvider *staging;
+  GtkCssScanner *scanner;
+  gulong error_handler;
+} GtkCssProviderAsyncLoad;
+
+static void
+gtk_css_provider_async_load_free (GtkCssProviderAsyncLoad *load)
+{
+  if (load->scanner)
+    gtk_css_scanner_destroy (load->scanner);
+  if (load->staging)
+    {
+      g_signal_handler_disconnect (load->staging, load->error_handler);
+      g_object_unref (load->staging);
+    }
+  g_object_unref (load->file);
+  g_free (load->data);
+
+  g_slice_free (GtkCssProviderAsyncLoad, load);
+}
+
+static void
+gtk_css_provider_forward_error (GtkCssProvider *staging,
+                                GtkCssSection  *section,
+                                const GError   *error,
+                                GtkCssProvider *provider)
+{
+  g_signal_emit (provider, css_provider_signals[PARSING_ERROR], 0,
+                 section, error);
+}
+
+static void
+gtk_css_provider_take_contents (GtkCssProvider *css_provider,
+                                GtkCssProvider *other)
+{
+  GtkCssProviderPrivate *priv = css_provider->priv;
+  GtkCssProviderPrivate *other_priv = other->priv;
+
+  gtk_css_provider_reset (css_provider);
+
+#define SWAP(type, field) G_STMT_START { \
+  type tmp = priv->field; \
+  priv->field = other_priv->field; \
+  other_priv->field = tmp; \
+} G_STMT_END
+
+  SWAP (GHashTable *, symbolic_colors);
+  SWAP (GHashTable *, keyframes);
+  SWAP (GArray *, rulesets);
+  SWAP (GtkCssSelectorTree *, tree);
+  SWAP (GPtrArray *, loaded_files);
+  SWAP (gboolean, cacheable);
+
+#undef SWAP
+}
+
+static gboolean
+gtk_css_provider_async_load_superseded (GTask *task)
+{
+  GtkCssProvider *css_provider = g_task_get_source_object (task);
+
+  if (css_provider->priv->load_task == task)
+    return FALSE;
+
+  g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                           "Superseded by another load");
+
+  return TRUE;
+}
+
+static gboolean
+gtk_css_provider_async_load_step (gpointer data)
+{
+  GTask *task = data;
+  GtkCssProviderAsyncLoad *load = g_task_get_task_data (task);
+  GtkCssProvider *css_provider = g_task_get_source_object (task);
+  gint64 end_time;
+
+  if (gtk_css_provider_async_load_superseded (task))
+    return G_SOURCE_REMOVE;
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      css_provider->priv->load_task = NULL;
+      return G_SOURCE_REMOVE;
+    }
+
+  end_time = g_get_monotonic_time () + ASYNC_PARSE_SLICE;
+
+  while (!_gtk_css_parser_is_eof (load->scanner->parser))
+    {
+      parse_stylesheet_statement (load->scanner);
+
+      if (g_get_monotonic_time () >= end_time)
+        return G_SOURCE_CONTINUE;
+    }
+
+  gtk_css_scanner_pop_section (load->scanner, GTK_CSS_SECTION_DOCUMENT);
+  gtk_css_scanner_destroy (load->scanner);
+  load->scanner = NULL;
+
+  gtk_css_provider_postprocess (load->staging);
+  gtk_css_provider_take_contents (css_provider, load->staging);
+  css_provider->priv->load_task = NULL;
+
+  _gtk_style_provider_private_changed (GTK_STYLE_PROVIDER_PRIVATE (css_provider));
+
+  g_task_return_boolean (task, TRUE);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gtk_css_provider_async_load_contents (GObject      *source,
+                                      GAsyncResult *result,
+                                      gpointer      data)
+{
+  GTask *task = data;
+  GtkCssProviderAsyncLoad *load = g_task_get_task_data (task);
+  GtkCssProvider *css_provider = g_task_get_source_object (task);
+  GError *error = NULL;
+
+  if (!g_file_load_contents_finish (load->file, result,
+                                    &load->data, NULL,
+                                    NULL, &error))
+    {
+      if (gtk_css_provider_async_load_superseded (task))
+        {
+          g_error_free (error);
+          g_object_unref (task);
+          return;
+        }
+
+      css_provider->priv->load_task = NULL;
+
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        gtk_css_provider_error (css_provider,
+                                NULL,
+                                GTK_CSS_PROVIDER_ERROR,
+                                GTK_CSS_PROVIDER_ERROR_IMPORT,
+                                "Failed to import: %s",
+                                error->message);
+
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  if (gtk_css_provider_async_load_superseded (task))
+    {
+      g_object_unref (task);
+      return;
+    }
+
+  /* Parse into a provider of our own, so the old contents stay
+   * in use until the new ones are complete
+   */
+  load->staging = gtk_css_provider_new ();
+  load->error_handler = g_signal_connect (load->staging, "parsing-error",
+                                          G_CALLBACK (gtk_css_provider_forward_error),
+                                          css_provider);
+  g_ptr_array_add (load->staging->priv->loaded_files, g_object_ref (load->file));
+
+  load->scanner = gtk_css_scanner_new (load->staging, NULL, NULL,
+                                       load->file, load->data);
+  gtk_css_scanner_push_section (load->scanner, GTK_CSS_SECTION_DOCUMENT);
+  _gtk_css_parser_skip_whitespace (load->scanner->parser);
+
+  g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                   gtk_css_provider_async_load_step,
+                   task,
+                   g_object_unref);
+}
+
+/**
+ * gtk_css_provider_load_from_file_async:
+ * @css_provider: a #GtkCssProvider
+ * @file: #GFile pointing to a file to load
+ * @cancellable: (allow-none): optional #GCancellable object,
+ *     %NULL to ignore
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *     file has been loaded
+ * @user_data: (closure): the data to pass to callback function
+ *
+ * Asynchronously loads the data contained in @file into @css_provider,
+ * replacing any previously loaded information.
+ *
+ * The file is read without blocking and parsed in small steps from
+ * the main loop, so that large style sheets don't freeze the user
+ * interface. Files imported with @import are still read when they
+ * are reached. @css_provider keeps its previous contents until the
+ * new ones are complete, and keeps them if the load is cancelled.
+ *
+ * Loading anything else into @css_provider before the load completes,
+ * asynchronously or not, supersedes it: it fails with
+ * %G_IO_ERROR_CANCELLED and the contents of the newer load are kept.
+ *
+ * Errors in the style sheet are reported with the
+ * #GtkCssProvider::parsing-error signal while parsing, as with
+ * gtk_css_provider_load_from_file().
+ *
+ * Since: 3.12
+ **/
+void
+gtk_css_provider_load_from_file_async (GtkCssProvider      *css_provider,
+                                       GFile               *file,
+                                       GCancellable        *cancellable,
+                                       GAsyncReadyCallback  callback,
+                                       gpointer             user_data)
+{
+  GtkCssProviderAsyncLoad *load;
+  GTask *task;
+
+  g_return_if_fail (GTK_IS_CSS_PROVIDER (css_provider));
+  g_return_if_fail (G_IS_FILE (file));
+
+  load = g_slice_new0 (GtkCssProviderAsyncLoad);
+  load->file = g_object_ref (file);
+
+  task = g_task_new (css_provider, cancellable, callback, user_data);
+  g_task_set_task_data (task, load, (GDestroyNotify) gtk_css_provider_async_load_free);
+
+  css_provider->priv->load_task = task;
+
+  g_file_load_contents_async (file, cancellable,
+                              gtk_css_provider_async_load_contents,
+                              task);
+}
+
+/**
+ * gtk_css_provider_load_from_file_finish:
+ * @css_provider: a #GtkCssProvider
+ * @result: a #GAsyncResult
+ * @error: (allow-none): location to store error information on failure,
+ *     or %NULL.
+ *
+ * Finishes an asynchronous load started with
+ * gtk_css_provider_load_from_file_async().
+ *
+ * Returns: %TRUE if the file was loaded, %FALSE if it could not be
+ *     read or the load was cancelled
+ *
+ * Since: 3.12
+ **/
+gboolean
+gtk_css_provider_load_from_file_finish (GtkCssProvider  *css_provider,
+                                        GAsyncResult    *result,
+                                        GError         **error)
+{
+  g_return_val_if_fail (GTK_IS_CSS_PROVIDER (css_provider), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, css_provider), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 /**
  * gtk_css_provider_load_from_path:
  * @css_provider: a #GtkCssProvider
@@ -2782,6 +3093,217 @@ _gtk_css_provider_get_theme_dir (void)
   return path;
 }
 
+/* The theme cache keeps the printed form of a theme that was parsed
+ * from files, so that loading it again is a single parse of one file
+ * without comments, imports or lookups. It starts with a comment
+ * naming the GTK+ version and the files the theme came from, with
+ * their modification times and sizes. Any change to those makes the
+ * header differ and the theme gets parsed from its files again.
+ * Images are printed as url()s of the files they were loaded from,
+ * so they are read again from there and don't need to be listed.
+ */
+static gchar *
+gtk_css_provider_get_cache_header (gchar **paths)
+{
+  GString *header;
+  GStatBuf buf;
+  guint i;
+
+  header = g_string_new (NULL);
+  g_string_append_printf (header, "/* GTK+ %d.%d.%d theme cache\n",
+                          GTK_MAJOR_VERSION, GTK_MINOR_VERSION, GTK_MICRO_VERSION);
+
+  for (i = 0; paths[i] != NULL; i++)
+    {
+      if (strchr (paths[i], '\n') != NULL ||
+          strstr (paths[i], "*/") != NULL ||
+          g_stat (paths[i], &buf) != 0)
+        {
+          g_string_free (header, TRUE);
+          return NULL;
+        }
+
+      g_string_append_printf (header, " * %" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %s\n",
+                              (gint64) buf.st_mtime, (gint64) buf.st_size, paths[i]);
+    }
+
+  g_string_append (header, " */\n");
+
+  return g_string_free (header, FALSE);
+}
+
+static gchar *
+gtk_css_provider_get_cache_file (const gchar *name,
+                                 const gchar *variant)
+{
+  gchar *basename, *path;
+
+  if (variant)
+    basename = g_strdup_printf ("%s-%s.css", name, variant);
+  else
+    basename = g_strdup_printf ("%s.css", name);
+
+  path = g_build_filename (g_get_user_cache_dir (), "gtk-3.0", "themes", basename, NULL);
+  g_free (basename);
+
+  return path;
+}
+
+/* Loads the theme from @cache_file if it is a cache of the theme
+ * in @path that is still up to date.
+ */
+static gboolean
+gtk_css_provider_load_cache (GtkCssProvider *provider,
+                             const gchar    *cache_file,
+                             const gchar    *path)
+{
+  GPtrArray *paths;
+  GError *error = NULL;
+  GFile *file, *main_file;
+  gchar *data, *end, *line, *next;
+  gchar *header;
+  gboolean result;
+
+  if (!g_file_get_contents (cache_file, &data, NULL, NULL))
+    return FALSE;
+
+  end = strstr (data, "\n */\n");
+  if (end == NULL)
+    {
+      g_free (data);
+      return FALSE;
+    }
+  end += strlen ("\n */\n");
+
+  /* Collect the paths from the " * mtime size path" lines */
+  paths = g_ptr_array_new_with_free_func (g_free);
+  for (line = strchr (data, '\n') + 1; line < end; line = next + 1)
+    {
+      gchar *path;
+
+      next = strchr (line, '\n');
+      if (!g_str_has_prefix (line, " * "))
+        continue;
+
+      path = strchr (line + 3, ' ');
+      if (path != NULL)
+        path = strchr (path + 1, ' ');
+      if (path == NULL || path > next)
+        continue;
+
+      g_ptr_array_add (paths, g_strndup (path + 1, next - path - 1));
+    }
+  g_ptr_array_add (paths, NULL);
+
+  /* The first file is the one the theme was loaded from */
+  if (paths->pdata[0] == NULL)
+    {
+      g_ptr_array_unref (paths);
+      g_free (data);
+      return FALSE;
+    }
+
+  file = g_file_new_for_path (path);
+  main_file = g_file_new_for_path (paths->pdata[0]);
+  result = g_file_equal (file, main_file);
+  g_object_unref (main_file);
+  g_object_unref (file);
+
+  if (!result)
+    {
+      g_ptr_array_unref (paths);
+      g_free (data);
+      return FALSE;
+    }
+
+  header = gtk_css_provider_get_cache_header ((gchar **) paths->pdata);
+  g_ptr_array_unref (paths);
+
+  result = header != NULL &&
+           strlen (header) == (gsize) (end - data) &&
+           strncmp (header, data, end - data) == 0;
+  g_free (header);
+
+  if (result)
+    {
+      result = gtk_css_provider_load_internal (provider, NULL, NULL, end, &error);
+      if (error)
+        {
+          g_warning ("Ignoring theme cache %s: %s", cache_file, error->message);
+          g_error_free (error);
+        }
+      else
+        {
+          GTK_NOTE (MISC, g_print ("Loaded theme from %s\n", cache_file));
+          _gtk_style_provider_private_changed (GTK_STYLE_PROVIDER_PRIVATE (provider));
+        }
+    }
+
+  g_free (data);
+
+  return result;
+}
+
+static void
+gtk_css_provider_save_cache (GtkCssProvider *provider,
+                             const gchar    *cache_file)
+{
+  GtkCssProviderPrivate *priv = provider->priv;
+  GPtrArray *paths;
+  gchar *header, *contents, *dir;
+  guint i;
+
+  if (!priv->cacheable || priv->loaded_files->len == 0)
+    return;
+
+  paths = g_ptr_array_new_with_free_func (g_free);
+  for (i = 0; i < priv->loaded_files->len; i++)
+    {
+      gchar *path = g_file_get_path (g_ptr_array_index (priv->loaded_files, i));
+
+      if (path == NULL)
+        {
+          g_ptr_array_unref (paths);
+          return;
+        }
+
+      g_ptr_array_add (paths, path);
+    }
+  g_ptr_array_add (paths, NULL);
+
+  header = gtk_css_provider_get_cache_header ((gchar **) paths->pdata);
+  g_ptr_array_unref (paths);
+  if (header == NULL)
+    return;
+
+  contents = gtk_css_provider_to_string (provider);
+
+  /* Images that don't remember their file, like those of pattern
+   * style properties, print as data: URIs that can't be loaded back
+   */
+  if (strstr (contents, "url(\"data:") != NULL)
+    {
+      g_free (contents);
+      g_free (header);
+      return;
+    }
+
+  dir = g_path_get_dirname (cache_file);
+  if (g_mkdir_with_parents (dir, 0700) == 0)
+    {
+      gchar *data = g_strconcat (header, contents, NULL);
+
+      if (g_file_set_contents (cache_file, data, -1, NULL))
+        GTK_NOTE (MISC, g_print ("Saved theme to %s\n", cache_file));
+
+      g_free (data);
+    }
+
+  g_free (dir);
+  g_free (contents);
+  g_free (header);
+}
+
 /**
  * _gtk_css_provider_load_named:
  * @provider: a #GtkCssProvider
@@ -2805,6 +3327,7 @@ _gtk_css_provider_load_named (GtkCssProvider *provider,
   g_return_if_fail (GTK_IS_CSS_PROVIDER (provider));
   g_return_if_fail (name != NULL);
 
+  gtk_css_provider_supersede_load (provider);
   gtk_css_provider_reset (provider);
 
   /* try loading the resource for the theme. This is mostly meant for built-in
@@ -2863,7 +3386,7 @@ _gtk_css_provider_load_named (GtkCssProvider *provider,
 
   if (path)
     {
-      char *dir, *resource_file;
+      char *dir, *resource_file, *cache_file;
       GResource *resource;
 
       dir = g_path_get_dirname (path);
@@ -2874,7 +3397,13 @@ _gtk_css_provider_load_named (GtkCssProvider *provider,
       if (resource != NULL)
         g_resources_register (resource);
 
-      gtk_css_provider_load_from_path (provider, path, NULL);
+      cache_file = gtk_css_provider_get_cache_file (name, variant);
+      if (!gtk_css_provider_load_cache (provider, cache_file, path))
+        {
+          gtk_css_provider_load_from_path (provider, path, NULL);
+          gtk_css_provider_save_cache (provider, cache_file);
+        }
+      g_free (cache_file);
 
       /* Only set this after load, as load_from_path will clear it */
       provider->priv->resource = resource;
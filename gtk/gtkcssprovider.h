@@ -86,6 +86,14 @@ gboolean         gtk_css_provider_load_from_file (GtkCssProvider  *css_provider,
 gboolean         gtk_css_provider_load_from_path (GtkCssProvider  *css_provider,
                                                   const gchar     *path,
                                                   GError         **error);
+void             gtk_css_provider_load_from_file_async  (GtkCssProvider      *css_provider,
+                                                         GFile               *file,
+                                                         GCancellable        *cancellable,
+                                                         GAsyncReadyCallback  callback,
+                                                         gpointer             user_data);
+gboolean         gtk_css_provider_load_from_file_finish (GtkCssProvider      *css_provider,
+                                                         GAsyncResult        *result,
+                                                         GError             **error);
 
 GtkCssProvider * gtk_css_provider_get_default (void);
 
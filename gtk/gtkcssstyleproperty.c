@@ -48,8 +48,8 @@ enum {
 
 G_DEFINE_TYPE (GtkCssStyleProperty, _gtk_css_style_property, GTK_TYPE_STYLE_PROPERTY)
 
-static GtkBitmask *_properties_affecting_size = NULL;
-static GtkBitmask *_properties_affecting_font = NULL;
+static GtkCssPropertySet _properties_affecting_size;
+static GtkCssPropertySet _properties_affecting_font;
 
 static GtkCssStylePropertyClass *gtk_css_style_property_class = NULL;
 
@@ -63,10 +63,10 @@ gtk_css_style_property_constructed (GObject *object)
   g_ptr_array_add (klass->style_properties, property);
 
   if (property->affects_size)
-    _properties_affecting_size = _gtk_bitmask_set (_properties_affecting_size, property->id, TRUE);
+    _gtk_css_property_set_add (&_properties_affecting_size, property->id);
 
   if (property->affects_font)
-    _properties_affecting_font = _gtk_bitmask_set (_properties_affecting_font, property->id, TRUE);
+    _gtk_css_property_set_add (&_properties_affecting_font, property->id);
 
   G_OBJECT_CLASS (_gtk_css_style_property_parent_class)->constructed (object);
 }
@@ -319,9 +319,6 @@ _gtk_css_style_property_class_init (GtkCssStylePropertyClass *klass)
 
   klass->style_properties = g_ptr_array_new ();
 
-  _properties_affecting_size = _gtk_bitmask_new ();
-  _properties_affecting_font = _gtk_bitmask_new ();
-
   gtk_css_style_property_class = klass;
 }
 
@@ -492,13 +489,13 @@ _gtk_css_style_property_get_initial_value (GtkCssStyleProperty *property)
 }
 
 gboolean
-_gtk_css_style_property_changes_affect_size (const GtkBitmask *changes)
+_gtk_css_style_property_changes_affect_size (const GtkCssPropertySet *changes)
 {
-  return _gtk_bitmask_intersects (changes, _properties_affecting_size);
+  return _gtk_css_property_set_intersects (changes, &_properties_affecting_size);
 }
 
 gboolean
-_gtk_css_style_property_changes_affect_font (const GtkBitmask *changes)
+_gtk_css_style_property_changes_affect_font (const GtkCssPropertySet *changes)
 {
-  return _gtk_bitmask_intersects (changes, _properties_affecting_font);
+  return _gtk_css_property_set_intersects (changes, &_properties_affecting_font);
 }
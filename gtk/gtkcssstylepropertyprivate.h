@@ -21,6 +21,7 @@
 #ifndef __GTK_CSS_STYLE_PROPERTY_PRIVATE_H__
 #define __GTK_CSS_STYLE_PROPERTY_PRIVATE_H__
 
+#include "gtk/gtkcsspropertysetprivate.h"
 #include "gtk/gtkstylepropertyprivate.h"
 
 G_BEGIN_DECLS
@@ -85,9 +86,9 @@ void                    _gtk_css_style_property_print_value     (GtkCssStyleProp
                                                                  GString                *string);
 
 gboolean                _gtk_css_style_property_changes_affect_size
-                                                                (const GtkBitmask       *changes);
+                                                                (const GtkCssPropertySet *changes);
 gboolean                _gtk_css_style_property_changes_affect_font
-                                                                (const GtkBitmask       *changes);
+                                                                (const GtkCssPropertySet *changes);
 
 G_END_DECLS
 
@@ -65,6 +65,10 @@ typedef enum { /*< skip >*/
                                    GTK_CSS_CHANGE_PARENT_NAME | GTK_CSS_CHANGE_PARENT_SIBLING_NAME | \
                                    GTK_CSS_CHANGE_PARENT_POSITION | GTK_CSS_CHANGE_PARENT_SIBLING_POSITION | \
                                    GTK_CSS_CHANGE_PARENT_STATE | GTK_CSS_CHANGE_PARENT_SIBLING_STATE)
+/* Changes that can alter a widget's GtkWidgetPath */
+#define GTK_CSS_CHANGE_PATH (GTK_CSS_CHANGE_ANY & ~(GTK_CSS_CHANGE_STATE | GTK_CSS_CHANGE_SIBLING_STATE | \
+                                                GTK_CSS_CHANGE_PARENT_STATE | GTK_CSS_CHANGE_PARENT_SIBLING_STATE | \
+                                                GTK_CSS_CHANGE_SOURCE | GTK_CSS_CHANGE_ANIMATE))
 
 typedef enum /*< skip >*/ {
   GTK_CSS_DEPENDS_ON_PARENT = (1 << 0),
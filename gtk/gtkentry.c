@@ -49,6 +49,7 @@
 #include "gtkmarshalers.h"
 #include "gtkmenu.h"
 #include "gtkmenuitem.h"
+#include "gtkpango.h"
 #include "gtkseparatormenuitem.h"
 #include "gtkselection.h"
 #include "gtksettings.h"
@@ -3140,9 +3141,9 @@ gtk_entry_get_preferred_width (GtkWidget *widget,
 
   context = gtk_widget_get_pango_context (widget);
 
-  metrics = pango_context_get_metrics (context,
-                                       pango_context_get_font_description (context),
-                                       pango_context_get_language (context));
+  metrics = _gtk_pango_context_get_metrics (context,
+                                            pango_context_get_font_description (context),
+                                            pango_context_get_language (context));
 
   _gtk_entry_get_borders (entry, &borders);
   _gtk_entry_effective_inner_border (entry, &inner_border);
@@ -3193,9 +3194,9 @@ gtk_entry_get_preferred_height (GtkWidget *widget,
   layout = gtk_entry_ensure_layout (entry, TRUE);
   context = gtk_widget_get_pango_context (widget);
 
-  metrics = pango_context_get_metrics (context,
-                                       pango_context_get_font_description (context),
-				       pango_context_get_language (context));
+  metrics = _gtk_pango_context_get_metrics (context,
+                                            pango_context_get_font_description (context),
+					    pango_context_get_language (context));
 
   priv->ascent = pango_font_metrics_get_ascent (metrics);
   priv->descent = pango_font_metrics_get_descent (metrics);
@@ -6272,10 +6273,11 @@ gtk_entry_move_adjustments (GtkEntry *entry)
   /* Approximate width of a char, so user can see what is ahead/behind */
   context = gtk_widget_get_pango_context (widget);
 
-  metrics = pango_context_get_metrics (context,
-                                       pango_context_get_font_description (context),
-				       pango_context_get_language (context));
+  metrics = _gtk_pango_context_get_metrics (context,
+                                            pango_context_get_font_description (context),
+					    pango_context_get_language (context));
   char_width = pango_font_metrics_get_approximate_char_width (metrics) / PANGO_SCALE;
+  pango_font_metrics_unref (metrics);
 
   /* Scroll it */
   gtk_adjustment_clamp_page (adjustment, 
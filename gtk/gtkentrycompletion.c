@@ -69,6 +69,8 @@
 #include "gtkentrycompletion.h"
 
 #include "gtkentryprivate.h"
+#include "gtkliststore.h"
+#include "gtktreemodelfilterprivate.h"
 #include "gtkcelllayout.h"
 #include "gtkcellareabox.h"
 
@@ -117,6 +119,51 @@ enum
   PROP_CELL_AREA
 };
 
+/* The completion index
+ *
+ * Matching every row of the model against the key with the default match
+ * function means normalizing and casefolding the text of each row, on
+ * every keystroke. For #GtkListStore models we instead keep the casefolded
+ * text of each row in an index, which is kept up to date through the
+ * model signals, and sorted by key on demand. The rows matching a key
+ * then form a range in the sorted array, which is found with a binary
+ * search, and which is narrowed down when the new key extends the
+ * previous one.
+ *
+ * A row matches the current key if its serial equals the serial of the
+ * index, which is bumped every time the key changes.
+ */
+typedef struct
+{
+  gpointer row;
+  gchar *key;
+  guint serial;
+} IndexEntry;
+
+struct _GtkEntryCompletionIndex
+{
+  GtkTreeModel *model;
+  gint column;
+
+  gulong inserted_id;
+  gulong changed_id;
+  gulong deleted_id;
+  gulong reordered_id;
+
+  GHashTable *entries;  /* row => IndexEntry, owns the entries */
+  GSequence *rows;      /* IndexEntries in model order */
+  GPtrArray *sorted;    /* IndexEntries sorted by key */
+
+  gchar *match_key;
+  guint match_start;
+  guint match_end;
+  guint serial;
+
+  guint populated    : 1;
+  guint sorted_valid : 1;
+  guint match_valid  : 1;
+};
+
 
 static void     gtk_entry_completion_cell_layout_init    (GtkCellLayoutIface      *iface);
 static GtkCellArea* gtk_entry_completion_get_area        (GtkCellLayout           *cell_layout);
@@ -135,6 +182,14 @@ static void     gtk_entry_completion_get_property        (GObject      *object,
 static void     gtk_entry_completion_finalize            (GObject      *object);
 static void     gtk_entry_completion_dispose             (GObject      *object);
 
+static void     gtk_entry_completion_index_free          (GtkEntryCompletionIndex *index);
+static guint    gtk_entry_completion_index_search        (GtkEntryCompletionIndex *index,
+                                                          guint                    start,
+                                                          guint                    end,
+                                                          const gchar             *key,
+                                                          gsize                    key_len,
+                                                          gboolean                 prefix);
+
 static gboolean gtk_entry_completion_visible_func        (GtkTreeModel       *model,
                                                           GtkTreeIter        *iter,
                                                           gpointer            data);
@@ -777,6 +832,12 @@ gtk_entry_completion_dispose (GObject *object)
   GtkEntryCompletion *completion = GTK_ENTRY_COMPLETION (object);
   GtkEntryCompletionPrivate *priv = completion->priv;
 
+  if (priv->index)
+    {
+      gtk_entry_completion_index_free (priv->index);
+      priv->index = NULL;
+    }
+
   if (priv->tree_view)
     {
       gtk_widget_destroy (priv->tree_view);
@@ -830,6 +891,437 @@ gtk_entry_completion_get_area (GtkCellLayout *cell_layout)
   return priv->cell_area;
 }
 
+/* completion index */
+static gchar *
+gtk_entry_completion_fold_string (const gchar *string)
+{
+  gchar *normalized_string;
+  gchar *case_normalized_string;
+
+  if (string == NULL)
+    return NULL;
+
+  normalized_string = g_utf8_normalize (string, -1, G_NORMALIZE_ALL);
+  if (normalized_string == NULL)
+    return NULL;
+
+  case_normalized_string = g_utf8_casefold (normalized_string, -1);
+  g_free (normalized_string);
+
+  return case_normalized_string;
+}
+
+static void
+index_entry_free (IndexEntry *entry)
+{
+  g_free (entry->key);
+  g_slice_free (IndexEntry, entry);
+}
+
+static inline gboolean
+index_entry_matches (GtkEntryCompletionIndex *index,
+                     IndexEntry              *entry)
+{
+  return index->match_key && entry->key &&
+         !strncmp (index->match_key, entry->key, strlen (index->match_key));
+}
+
+static void
+index_entry_update (GtkEntryCompletionIndex *index,
+                    IndexEntry              *entry,
+                    GtkTreeIter             *iter)
+{
+  gchar *item = NULL;
+
+  g_free (entry->key);
+
+  gtk_tree_model_get (index->model, iter, index->column, &item, -1);
+  entry->key = gtk_entry_completion_fold_string (item);
+  g_free (item);
+
+  /* The match range is stale now, but the serial keeps the row
+   * visible or hidden correctly until the next search.
+   */
+  entry->serial = index_entry_matches (index, entry) ? index->serial : 0;
+  index->sorted_valid = FALSE;
+  index->match_valid = FALSE;
+}
+
+static IndexEntry *
+index_entry_new (GtkEntryCompletionIndex *index,
+                 GtkTreeIter             *iter)
+{
+  IndexEntry *entry;
+
+  entry = g_slice_new0 (IndexEntry);
+  entry->row = iter->user_data;
+  index_entry_update (index, entry, iter);
+
+  g_hash_table_insert (index->entries, entry->row, entry);
+
+  return entry;
+}
+
+static void
+gtk_entry_completion_index_row_inserted (GtkTreeModel *model,
+                                         GtkTreePath  *path,
+                                         GtkTreeIter  *iter,
+                                         gpointer      data)
+{
+  GtkEntryCompletionIndex *index = data;
+  IndexEntry *entry;
+
+  if (!index->populated)
+    return;
+
+  entry = index_entry_new (index, iter);
+  g_sequence_insert_before (g_sequence_get_iter_at_pos (index->rows,
+                                                        gtk_tree_path_get_indices (path)[0]),
+                            entry);
+}
+
+static void
+gtk_entry_completion_index_row_changed (GtkTreeModel *model,
+                                        GtkTreePath  *path,
+                                        GtkTreeIter  *iter,
+                                        gpointer      data)
+{
+  GtkEntryCompletionIndex *index = data;
+  IndexEntry *entry;
+
+  if (!index->populated)
+    return;
+
+  entry = g_hash_table_lookup (index->entries, iter->user_data);
+  if (entry)
+    index_entry_update (index, entry, iter);
+}
+
+static void
+gtk_entry_completion_index_row_deleted (GtkTreeModel *model,
+                                        GtkTreePath  *path,
+                                        gpointer      data)
+{
+  GtkEntryCompletionIndex *index = data;
+  GSequenceIter *siter;
+  IndexEntry *entry;
+
+  if (!index->populated)
+    return;
+
+  siter = g_sequence_get_iter_at_pos (index->rows,
+                                      gtk_tree_path_get_indices (path)[0]);
+  if (g_sequence_iter_is_end (siter))
+    return;
+
+  entry = g_sequence_get (siter);
+  g_sequence_remove (siter);
+
+  /* Don't leave a dangling pointer behind in the sorted array. If it
+   * is up to date, take out just this entry, so it stays sorted.
+   */
+  if (index->sorted_valid)
+    {
+      guint i;
+
+      if (entry->key)
+        i = gtk_entry_completion_index_search (index, 0, index->sorted->len,
+                                               entry->key, strlen (entry->key), FALSE);
+      else
+        i = 0;
+
+      while (i < index->sorted->len && g_ptr_array_index (index->sorted, i) != entry)
+        i++;
+
+      g_assert (i < index->sorted->len);
+      g_ptr_array_remove_index (index->sorted, i);
+
+      if (i < index->match_start)
+        {
+          index->match_start--;
+          index->match_end--;
+        }
+      else if (i < index->match_end)
+        index->match_end--;
+    }
+  else
+    g_ptr_array_set_size (index->sorted, 0);
+
+  g_hash_table_remove (index->entries, entry->row);
+}
+
+static void
+gtk_entry_completion_index_rows_reordered (GtkTreeModel *model,
+                                           GtkTreePath  *path,
+                                           GtkTreeIter  *iter,
+                                           gint         *new_order,
+                                           gpointer      data)
+{
+  GtkEntryCompletionIndex *index = data;
+  GSequenceIter *siter;
+  IndexEntry **old_rows;
+  gint i, length;
+
+  if (!index->populated)
+    return;
+
+  length = g_sequence_get_length (index->rows);
+  old_rows = g_new (IndexEntry *, length);
+
+  siter = g_sequence_get_begin_iter (index->rows);
+  for (i = 0; i < length; i++, siter = g_sequence_iter_next (siter))
+    old_rows[i] = g_sequence_get (siter);
+
+  siter = g_sequence_get_begin_iter (index->rows);
+  for (i = 0; i < length; i++, siter = g_sequence_iter_next (siter))
+    g_sequence_set (siter, old_rows[new_order[i]]);
+
+  g_free (old_rows);
+}
+
+static GtkEntryCompletionIndex *
+gtk_entry_completion_index_new (GtkTreeModel *model)
+{
+  GtkEntryCompletionIndex *index;
+
+  index = g_slice_new0 (GtkEntryCompletionIndex);
+  index->model = g_object_ref (model);
+  index->column = -1;
+  index->entries = g_hash_table_new_full (NULL, NULL, NULL,
+                                          (GDestroyNotify) index_entry_free);
+  index->rows = g_sequence_new (NULL);
+  index->sorted = g_ptr_array_new ();
+  index->serial = 1;
+
+  /* These need to run before the handlers of the filter model, which
+   * ask for the visibility of the rows.
+   */
+  index->inserted_id =
+    g_signal_connect (model, "row-inserted",
+                      G_CALLBACK (gtk_entry_completion_index_row_inserted), index);
+  index->changed_id =
+    g_signal_connect (model, "row-changed",
+                      G_CALLBACK (gtk_entry_completion_index_row_changed), index);
+  index->deleted_id =
+    g_signal_connect (model, "row-deleted",
+                      G_CALLBACK (gtk_entry_completion_index_row_deleted), index);
+  index->reordered_id =
+    g_signal_connect (model, "rows-reordered",
+                      G_CALLBACK (gtk_entry_completion_index_rows_reordered), index);
+
+  return index;
+}
+
+static void
+gtk_entry_completion_index_clear (GtkEntryCompletionIndex *index)
+{
+  if (!index->populated)
+    return;
+
+  g_ptr_array_set_size (index->sorted, 0);
+  g_sequence_remove_range (g_sequence_get_begin_iter (index->rows),
+                           g_sequence_get_end_iter (index->rows));
+  g_hash_table_remove_all (index->entries);
+
+  g_free (index->match_key);
+  index->match_key = NULL;
+  index->column = -1;
+  index->populated = FALSE;
+  index->sorted_valid = FALSE;
+  index->match_valid = FALSE;
+}
+
+static void
+gtk_entry_completion_index_free (GtkEntryCompletionIndex *index)
+{
+  g_signal_handler_disconnect (index->model, index->inserted_id);
+  g_signal_handler_disconnect (index->model, index->changed_id);
+  g_signal_handler_disconnect (index->model, index->deleted_id);
+  g_signal_handler_disconnect (index->model, index->reordered_id);
+
+  gtk_entry_completion_index_clear (index);
+
+  g_ptr_array_unref (index->sorted);
+  g_sequence_free (index->rows);
+  g_hash_table_unref (index->entries);
+  g_object_unref (index->model);
+
+  g_slice_free (GtkEntryCompletionIndex, index);
+}
+
+static void
+gtk_entry_completion_index_populate (GtkEntryCompletionIndex *index,
+                                     gint                     column)
+{
+  GtkTreeIter iter;
+  gboolean valid;
+
+  gtk_entry_completion_index_clear (index);
+
+  index->column = column;
+  index->populated = TRUE;
+
+  valid = gtk_tree_model_get_iter_first (index->model, &iter);
+  while (valid)
+    {
+      g_sequence_append (index->rows, index_entry_new (index, &iter));
+      valid = gtk_tree_model_iter_next (index->model, &iter);
+    }
+}
+
+static gint
+index_entry_compare (gconstpointer a,
+                     gconstpointer b)
+{
+  const IndexEntry *entry_a = *(const IndexEntry **) a;
+  const IndexEntry *entry_b = *(const IndexEntry **) b;
+
+  /* Rows without text sort first, and never match */
+  if (entry_a->key == NULL)
+    return entry_b->key == NULL ? 0 : -1;
+  if (entry_b->key == NULL)
+    return 1;
+
+  return strcmp (entry_a->key, entry_b->key);
+}
+
+/* Returns the first position in [start, end) whose key is not
+ * smaller than @key, or, if @prefix is %TRUE, the first position
+ * whose key is greater than @key and does not start with it.
+ */
+static guint
+gtk_entry_completion_index_search (GtkEntryCompletionIndex *index,
+                                   guint                    start,
+                                   guint                    end,
+                                   const gchar             *key,
+                                   gsize                    key_len,
+                                   gboolean                 prefix)
+{
+  while (start < end)
+    {
+      guint mid = start + (end - start) / 2;
+      IndexEntry *entry = g_ptr_array_index (index->sorted, mid);
+      gboolean before;
+
+      if (entry->key == NULL)
+        before = TRUE;
+      else if (prefix)
+        before = strncmp (entry->key, key, key_len) <= 0;
+      else
+        before = strcmp (entry->key, key) < 0;
+
+      if (before)
+        start = mid + 1;
+      else
+        end = mid;
+    }
+
+  return start;
+}
+
+static void
+gtk_entry_completion_index_match (GtkEntryCompletionIndex *index,
+                                  const gchar             *key)
+{
+  guint start, end, i;
+  gsize key_len;
+
+  if (!index->sorted_valid)
+    {
+      GHashTableIter iter;
+      gpointer entry;
+
+      g_ptr_array_set_size (index->sorted, 0);
+      g_hash_table_iter_init (&iter, index->entries);
+      while (g_hash_table_iter_next (&iter, NULL, &entry))
+        g_ptr_array_add (index->sorted, entry);
+      g_ptr_array_sort (index->sorted, index_entry_compare);
+
+      index->sorted_valid = TRUE;
+      index->match_valid = FALSE;
+    }
+
+  /* Rows matching a key which extends the previous key are a subset
+   * of the previous matches.
+   */
+  if (index->match_valid && key &&
+      g_str_has_prefix (key, index->match_key))
+    {
+      start = index->match_start;
+      end = index->match_end;
+    }
+  else
+    {
+      start = 0;
+      end = index->sorted->len;
+    }
+
+  if (key)
+    {
+      key_len = strlen (key);
+      start = gtk_entry_completion_index_search (index, start, end, key, key_len, FALSE);
+      end = gtk_entry_completion_index_search (index, start, end, key, key_len, TRUE);
+    }
+  else
+    end = start;
+
+  if (G_UNLIKELY (++index->serial == 0))
+    {
+      for (i = 0; i < index->sorted->len; i++)
+        ((IndexEntry *) g_ptr_array_index (index->sorted, i))->serial = 0;
+      index->serial = 1;
+    }
+
+  for (i = start; i < end; i++)
+    ((IndexEntry *) g_ptr_array_index (index->sorted, i))->serial = index->serial;
+
+  g_free (index->match_key);
+  index->match_key = g_strdup (key);
+  index->match_start = start;
+  index->match_end = end;
+  index->match_valid = key != NULL;
+}
+
+/* Brings the index up to date with the current key, returns %FALSE
+ * if the index can't be used for the current settings.
+ */
+static gboolean
+gtk_entry_completion_update_index (GtkEntryCompletion *completion)
+{
+  GtkEntryCompletionPrivate *priv = completion->priv;
+
+  if (!priv->index)
+    return FALSE;
+
+  if (priv->match_func || priv->text_column < 0 ||
+      gtk_tree_model_get_column_type (priv->index->model,
+                                      priv->text_column) != G_TYPE_STRING)
+    {
+      gtk_entry_completion_index_clear (priv->index);
+      return FALSE;
+    }
+
+  if (!priv->index->populated || priv->index->column != priv->text_column)
+    gtk_entry_completion_index_populate (priv->index, priv->text_column);
+
+  gtk_entry_completion_index_match (priv->index, priv->case_normalized_key);
+
+  return TRUE;
+}
+
+static IndexEntry *
+gtk_entry_completion_index_lookup (GtkEntryCompletion *completion,
+                                   GtkTreeIter        *iter)
+{
+  GtkEntryCompletionIndex *index = completion->priv->index;
+
+  if (!index || !index->populated ||
+      index->column != completion->priv->text_column)
+    return NULL;
+
+  return g_hash_table_lookup (index->entries, iter->user_data);
+}
+
 /* all those callbacks */
 static gboolean
 gtk_entry_completion_default_completion_func (GtkEntryCompletion *completion,
@@ -892,10 +1384,18 @@ gtk_entry_completion_visible_func (GtkTreeModel *model,
                                             iter,
                                             completion->priv->match_data);
   else if (completion->priv->text_column >= 0)
-    ret = gtk_entry_completion_default_completion_func (completion,
-                                                        completion->priv->case_normalized_key,
-                                                        iter,
-                                                        NULL);
+    {
+      IndexEntry *entry;
+
+      entry = gtk_entry_completion_index_lookup (completion, iter);
+      if (entry)
+        ret = entry->serial == completion->priv->index->serial;
+      else
+        ret = gtk_entry_completion_default_completion_func (completion,
+                                                            completion->priv->case_normalized_key,
+                                                            iter,
+                                                            NULL);
+    }
 
   return ret;
 }
@@ -1128,6 +1628,12 @@ gtk_entry_completion_set_model (GtkEntryCompletion *completion,
   g_return_if_fail (GTK_IS_ENTRY_COMPLETION (completion));
   g_return_if_fail (model == NULL || GTK_IS_TREE_MODEL (model));
 
+  if (completion->priv->index)
+    {
+      gtk_entry_completion_index_free (completion->priv->index);
+      completion->priv->index = NULL;
+    }
+
   if (!model)
     {
       gtk_tree_view_set_model (GTK_TREE_VIEW (completion->priv->tree_view),
@@ -1137,6 +1643,10 @@ gtk_entry_completion_set_model (GtkEntryCompletion *completion,
       return;
     }
 
+  /* The index has to see model changes before the filter model does */
+  if (GTK_IS_LIST_STORE (model))
+    completion->priv->index = gtk_entry_completion_index_new (model);
+
   /* code will unref the old filter model (if any) */
   completion->priv->filter_model =
     GTK_TREE_MODEL_FILTER (gtk_tree_model_filter_new (model, NULL));
@@ -1280,7 +1790,16 @@ gtk_entry_completion_complete (GtkEntryCompletion *completion)
   completion->priv->case_normalized_key = g_utf8_casefold (tmp, -1);
   g_free (tmp);
 
-  gtk_tree_model_filter_refilter (completion->priv->filter_model);
+  if (gtk_entry_completion_update_index (completion))
+    {
+      /* Only rows which appear or disappear are signalled, so make
+       * sure that the ones which stay get redrawn for the new key.
+       */
+      _gtk_tree_model_filter_refilter_changed (completion->priv->filter_model);
+      gtk_widget_queue_draw (completion->priv->tree_view);
+    }
+  else
+    gtk_tree_model_filter_refilter (completion->priv->filter_model);
 
   if (gtk_widget_get_visible (completion->priv->popup_window))
     _gtk_entry_completion_resize_popup (completion);
@@ -28,6 +28,8 @@
 
 G_BEGIN_DECLS
 
+typedef struct _GtkEntryCompletionIndex GtkEntryCompletionIndex;
+
 struct _GtkEntryCompletionPrivate
 {
   GtkWidget *entry;
@@ -49,6 +51,8 @@ struct _GtkEntryCompletionPrivate
 
   gchar *case_normalized_key;
 
+  GtkEntryCompletionIndex *index;
+
   /* only used by GtkEntry when attached: */
   GtkWidget *popup_window;
   GtkWidget *vbox;
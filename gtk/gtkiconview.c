@@ -34,6 +34,7 @@
 #include "gtkmarshalers.h"
 #include "gtkbindings.h"
 #include "gtkdnd.h"
+#include "gtkdebug.h"
 #include "gtkmain.h"
 #include "gtkintl.h"
 #include "gtkaccessible.h"
@@ -112,12 +113,14 @@ enum
   PROP_VADJUSTMENT,
   PROP_HSCROLL_POLICY,
   PROP_VSCROLL_POLICY,
-  PROP_ACTIVATE_ON_SINGLE_CLICK
+  PROP_ACTIVATE_ON_SINGLE_CLICK,
+  PROP_FIXED_SIZE_MODE
 };
 
 /* GObject vfuncs */
 static void             gtk_icon_view_cell_layout_init          (GtkCellLayoutIface *iface);
 static void             gtk_icon_view_dispose                   (GObject            *object);
+static void             gtk_icon_view_finalize                  (GObject            *object);
 static GObject         *gtk_icon_view_constructor               (GType               type,
 								 guint               n_construct_properties,
 								 GObjectConstructParam *construct_properties);
@@ -346,6 +349,7 @@ gtk_icon_view_class_init (GtkIconViewClass *klass)
 
   gobject_class->constructor = gtk_icon_view_constructor;
   gobject_class->dispose = gtk_icon_view_dispose;
+  gobject_class->finalize = gtk_icon_view_finalize;
   gobject_class->set_property = gtk_icon_view_set_property;
   gobject_class->get_property = gtk_icon_view_get_property;
 
@@ -660,6 +664,24 @@ gtk_icon_view_class_init (GtkIconViewClass *klass)
 							 FALSE,
 							 GTK_PARAM_READWRITE));
 
+  /**
+   * GtkIconView:fixed-size-mode:
+   *
+   * Setting the ::fixed-size-mode property to %TRUE speeds up 
+   * #GtkIconView by assuming that all items have the same size. 
+   * Only the first item is measured and its size is used for all
+   * other items.
+   *
+   * Since: 3.12
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_FIXED_SIZE_MODE,
+                                   g_param_spec_boolean ("fixed-size-mode",
+							 P_("Fixed Size Mode"),
+							 P_("Speeds up GtkIconView by assuming that all items have the same size"),
+							 FALSE,
+							 GTK_PARAM_READWRITE));
+
   /* Scrollable interface properties */
   g_object_class_override_property (gobject_class, PROP_HADJUSTMENT,    "hadjustment");
   g_object_class_override_property (gobject_class, PROP_VADJUSTMENT,    "vadjustment");
@@ -988,6 +1010,10 @@ gtk_icon_view_init (GtkIconView *icon_view)
   icon_view->priv->margin = 6;
   icon_view->priv->item_padding = 6;
   icon_view->priv->activate_on_single_click = FALSE;
+  icon_view->priv->fixed_size_mode = FALSE;
+
+  icon_view->priv->items = g_ptr_array_new ();
+  icon_view->priv->n_columns = 0;
 
   icon_view->priv->draw_focus = TRUE;
 
@@ -1054,6 +1080,16 @@ gtk_icon_view_dispose (GObject *object)
   G_OBJECT_CLASS (gtk_icon_view_parent_class)->dispose (object);
 }
 
+static void
+gtk_icon_view_finalize (GObject *object)
+{
+  GtkIconView *icon_view = GTK_ICON_VIEW (object);
+
+  g_ptr_array_free (icon_view->priv->items, TRUE);
+
+  G_OBJECT_CLASS (gtk_icon_view_parent_class)->finalize (object);
+}
+
 static void
 gtk_icon_view_set_property (GObject      *object,
 			    guint         prop_id,
@@ -1119,6 +1155,10 @@ gtk_icon_view_set_property (GObject      *object,
       gtk_icon_view_set_activate_on_single_click (icon_view, g_value_get_boolean (value));
       break;
 
+    case PROP_FIXED_SIZE_MODE:
+      gtk_icon_view_set_fixed_size_mode (icon_view, g_value_get_boolean (value));
+      break;
+
     case PROP_CELL_AREA:
       /* Construct-only, can only be assigned once */
       area = g_value_get_object (value);
@@ -1219,6 +1259,10 @@ gtk_icon_view_get_property (GObject      *object,
       g_value_set_boolean (value, icon_view->priv->activate_on_single_click);
       break;
 
+    case PROP_FIXED_SIZE_MODE:
+      g_value_set_boolean (value, icon_view->priv->fixed_size_mode);
+      break;
+
     case PROP_CELL_AREA:
       g_value_set_object (value, icon_view->priv->cell_area);
       break;
@@ -1395,7 +1439,7 @@ adjust_wrap_width (GtkIconView *icon_view)
     {
       gint pixbuf_width, wrap_width;
 
-      if (icon_view->priv->items && icon_view->priv->pixbuf_cell)
+      if (icon_view->priv->items->len > 0 && icon_view->priv->pixbuf_cell)
         {
           gtk_cell_renderer_get_preferred_width (icon_view->priv->pixbuf_cell,
                                                  GTK_WIDGET (icon_view),
@@ -1424,7 +1468,7 @@ adjust_wrap_width (GtkIconView *icon_view)
           wrap_width = MAX (pixbuf_width * 2, 50);
         }
 
-      if (icon_view->priv->items && icon_view->priv->pixbuf_cell)
+      if (icon_view->priv->items->len > 0 && icon_view->priv->pixbuf_cell)
 	{
           /* Here we go with the same old guess, try the icon size and set double
            * the size of the first icon found in the list, naive but works much
@@ -1504,7 +1548,77 @@ cell_area_get_preferred_size (GtkIconView        *icon_view,
 static gboolean
 gtk_icon_view_is_empty (GtkIconView *icon_view)
 {
-  return icon_view->priv->items == NULL;
+  return icon_view->priv->items->len == 0;
+}
+
+static inline GtkIconViewItem *
+gtk_icon_view_get_item (GtkIconView *icon_view,
+                        gint         index)
+{
+  GPtrArray *items = icon_view->priv->items;
+
+  if (index < 0 || (guint) index >= items->len)
+    return NULL;
+
+  return g_ptr_array_index (items, index);
+}
+
+/* Returns the range [*first, *last) of item indices whose rows
+ * intersect the vertical band [y1, y2] in bin window coordinates.
+ *
+ * Rows are laid out top to bottom in model order, so a binary search
+ * on the first item of each row is enough to find the visible ones.
+ */
+static void
+gtk_icon_view_get_item_range (GtkIconView *icon_view,
+                              gint         y1,
+                              gint         y2,
+                              gint        *first,
+                              gint        *last)
+{
+  GtkIconViewPrivate *priv = icon_view->priv;
+  GtkIconViewItem *item;
+  gint n_items, n_rows, pad;
+  gint lo, hi, mid;
+
+  n_items = priv->items->len;
+
+  if (priv->n_columns <= 0 || n_items == 0)
+    {
+      *first = 0;
+      *last = n_items;
+      return;
+    }
+
+  pad = priv->item_padding + priv->row_spacing;
+  n_rows = (n_items + priv->n_columns - 1) / priv->n_columns;
+
+  /* first row whose bottom edge is below y1 */
+  lo = 0;
+  hi = n_rows;
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      item = g_ptr_array_index (priv->items, mid * priv->n_columns);
+      if (item->cell_area.y + item->cell_area.height + pad < y1)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  *first = lo * priv->n_columns;
+
+  /* first row whose top edge is below y2 */
+  hi = n_rows;
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      item = g_ptr_array_index (priv->items, mid * priv->n_columns);
+      if (item->cell_area.y - pad <= y2)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  *last = MIN (lo * priv->n_columns, n_items);
 }
 
 static void
@@ -1516,7 +1630,7 @@ gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
 {
   GtkIconViewPrivate *priv = icon_view->priv;
   GtkCellAreaContext *context;
-  GList *items;
+  gint i, n_items;
 
   g_assert (!gtk_icon_view_is_empty (icon_view));
 
@@ -1524,24 +1638,27 @@ gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
 
   for_size -= 2 * priv->item_padding;
 
+  /* In fixed size mode all items are assumed to be as large as the first one */
+  n_items = priv->fixed_size_mode ? 1 : priv->items->len;
+
   if (for_size > 0)
     {
       /* This is necessary for the context to work properly */
-      for (items = priv->items; items; items = items->next)
+      for (i = 0; i < n_items; i++)
         {
-          GtkIconViewItem *item = items->data;
+          GtkIconViewItem *item = g_ptr_array_index (priv->items, i);
 
           _gtk_icon_view_set_cell_data (icon_view, item);
           cell_area_get_preferred_size (icon_view, context, 1 - orientation, -1, NULL, NULL);
         }
     }
 
-  for (items = priv->items; items; items = items->next)
+  for (i = 0; i < n_items; i++)
     {
-      GtkIconViewItem *item = items->data;
+      GtkIconViewItem *item = g_ptr_array_index (priv->items, i);
 
       _gtk_icon_view_set_cell_data (icon_view, item);
-      if (items == priv->items)
+      if (i == 0)
         adjust_wrap_width (icon_view);
       cell_area_get_preferred_size (icon_view, context, orientation, for_size, NULL, NULL);
     }
@@ -1863,12 +1980,13 @@ gtk_icon_view_draw (GtkWidget *widget,
                     cairo_t   *cr)
 {
   GtkIconView *icon_view;
-  GList *icons;
   GtkTreePath *path;
   gint dest_index;
   GtkIconViewDropPosition dest_pos;
   GtkIconViewItem *dest_item = NULL;
   GtkStyleContext *context;
+  GdkRectangle clip;
+  gint i, first, last;
 
   icon_view = GTK_ICON_VIEW (widget);
 
@@ -1897,9 +2015,16 @@ gtk_icon_view_draw (GtkWidget *widget,
   else
     dest_index = -1;
 
-  for (icons = icon_view->priv->items; icons; icons = icons->next)
+  /* Only walk the rows intersecting the exposed area */
+  if (gdk_cairo_get_clip_rectangle (cr, &clip))
+    gtk_icon_view_get_item_range (icon_view, clip.y, clip.y + clip.height,
+                                  &first, &last);
+  else
+    first = last = 0;
+
+  for (i = first; i < last; i++)
     {
-      GtkIconViewItem *item = icons->data;
+      GtkIconViewItem *item = g_ptr_array_index (icon_view->priv->items, i);
       GdkRectangle paint_area;
 
       paint_area.x      = item->cell_area.x      - icon_view->priv->item_padding;
@@ -2213,8 +2338,7 @@ gtk_icon_view_set_cursor (GtkIconView     *icon_view,
     gtk_cell_area_stop_editing (icon_view->priv->cell_area, TRUE);
 
   if (gtk_tree_path_get_depth (path) == 1)
-    item = g_list_nth_data (icon_view->priv->items,
-			    gtk_tree_path_get_indices(path)[0]);
+    item = gtk_icon_view_get_item (icon_view, gtk_tree_path_get_indices(path)[0]);
   
   if (!item)
     return;
@@ -2579,14 +2703,14 @@ gtk_icon_view_start_rubberbanding (GtkIconView  *icon_view,
 				   gint          x,
 				   gint          y)
 {
-  GList *items;
+  guint i;
 
   if (icon_view->priv->rubberband_device)
     return;
 
-  for (items = icon_view->priv->items; items; items = items->next)
+  for (i = 0; i < icon_view->priv->items->len; i++)
     {
-      GtkIconViewItem *item = items->data;
+      GtkIconViewItem *item = g_ptr_array_index (icon_view->priv->items, i);
 
       item->selected_before_rubberbanding = item->selected;
     }
@@ -2620,7 +2744,7 @@ gtk_icon_view_stop_rubberbanding (GtkIconView *icon_view)
 static void
 gtk_icon_view_update_rubberband_selection (GtkIconView *icon_view)
 {
-  GList *items;
+  guint i;
   gint x, y, width, height;
   gboolean dirty = FALSE;
   
@@ -2633,9 +2757,9 @@ gtk_icon_view_update_rubberband_selection (GtkIconView *icon_view)
   height = ABS (icon_view->priv->rubberband_y1 - 
 		icon_view->priv->rubberband_y2);
   
-  for (items = icon_view->priv->items; items; items = items->next)
+  for (i = 0; i < icon_view->priv->items->len; i++)
     {
-      GtkIconViewItem *item = items->data;
+      GtkIconViewItem *item = g_ptr_array_index (icon_view->priv->items, i);
       gboolean is_in;
       gboolean selected;
       
@@ -2708,14 +2832,14 @@ static gboolean
 gtk_icon_view_unselect_all_internal (GtkIconView  *icon_view)
 {
   gboolean dirty = FALSE;
-  GList *items;
+  guint i;
 
   if (icon_view->priv->selection_mode == GTK_SELECTION_NONE)
     return FALSE;
 
-  for (items = icon_view->priv->items; items; items = items->next)
+  for (i = 0; i < icon_view->priv->items->len; i++)
     {
-      GtkIconViewItem *item = items->data;
+      GtkIconViewItem *item = g_ptr_array_index (icon_view->priv->items, i);
 
       if (item->selected)
 	{
@@ -2960,10 +3084,9 @@ gtk_icon_view_layout (GtkIconView *icon_view)
 {
   GtkIconViewPrivate *priv = icon_view->priv;
   GtkWidget *widget = GTK_WIDGET (icon_view);
-  GList *items;
   gint item_width; /* this doesn't include item_padding */
-  gint n_columns, n_rows, n_items;
-  gint col, row;
+  gint n_columns, n_rows, n_items, n_measured;
+  gint col, row, i;
   GtkRequestedSize *sizes;
   gboolean rtl;
 
@@ -2979,6 +3102,7 @@ gtk_icon_view_layout (GtkIconView *icon_view)
                                           NULL, NULL,
                                           &n_columns, &item_width);
   n_rows = (n_items + n_columns - 1) / n_columns;
+  priv->n_columns = n_columns;
 
   priv->width = n_columns * (item_width + 2 * priv->item_padding + priv->column_spacing) - priv->column_spacing;
   priv->width += 2 * priv->margin;
@@ -2991,28 +3115,43 @@ gtk_icon_view_layout (GtkIconView *icon_view)
   /* because layouting is complicated. We designed an API
    * that is O(N²) and nonsensical.
    * And we're proud of it. */
-  for (items = priv->items; items; items = items->next)
+  n_measured = priv->fixed_size_mode ? 1 : n_items;
+  for (i = 0; i < n_measured; i++)
     {
-      _gtk_icon_view_set_cell_data (icon_view, items->data);
+      _gtk_icon_view_set_cell_data (icon_view, g_ptr_array_index (priv->items, i));
       gtk_cell_area_get_preferred_width (priv->cell_area,
                                          priv->cell_area_context,
                                          widget,
                                          NULL, NULL);
     }
 
-  sizes = g_newa (GtkRequestedSize, n_rows);
-  items = priv->items;
+  sizes = g_new (GtkRequestedSize, n_rows);
+  i = 0;
   priv->height = priv->margin;
 
   /* Collect the heights for all rows */
   for (row = 0; row < n_rows; row++)
     {
-      GtkCellAreaContext *context = gtk_cell_area_copy_context (priv->cell_area, priv->cell_area_context);
+      GtkCellAreaContext *context;
+
+      if (priv->fixed_size_mode && row > 0)
+        {
+          /* All rows are as high as the first one */
+          context = g_ptr_array_index (priv->row_contexts, 0);
+          g_ptr_array_add (priv->row_contexts, g_object_ref (context));
+
+          sizes[row] = sizes[0];
+          sizes[row].data = GINT_TO_POINTER (row);
+          priv->height += sizes[row].minimum_size + 2 * priv->item_padding + priv->row_spacing;
+          continue;
+        }
+
+      context = gtk_cell_area_copy_context (priv->cell_area, priv->cell_area_context);
       g_ptr_array_add (priv->row_contexts, context);
 
-      for (col = 0; col < n_columns && items; col++, items = items->next)
+      for (col = 0; col < n_columns && i < n_measured; col++, i++)
         {
-          GtkIconViewItem *item = items->data;
+          GtkIconViewItem *item = g_ptr_array_index (priv->items, i);
 
           _gtk_icon_view_set_cell_data (icon_view, item);
           gtk_cell_area_get_preferred_height_for_width (priv->cell_area,
@@ -3041,7 +3180,7 @@ gtk_icon_view_layout (GtkIconView *icon_view)
   /* Actually allocate the rows */
   g_qsort_with_data (sizes, n_rows, sizeof (GtkRequestedSize), compare_sizes, NULL);
   
-  items = priv->items;
+  i = 0;
   priv->height = priv->margin;
 
   for (row = 0; row < n_rows; row++)
@@ -3051,9 +3190,9 @@ gtk_icon_view_layout (GtkIconView *icon_view)
 
       priv->height += priv->item_padding;
 
-      for (col = 0; col < n_columns && items; col++, items = items->next)
+      for (col = 0; col < n_columns && i < n_items; col++, i++)
         {
-          GtkIconViewItem *item = items->data;
+          GtkIconViewItem *item = g_ptr_array_index (priv->items, i);
 
           item->cell_area.x = priv->margin + (col * 2 + 1) * priv->item_padding + col * (priv->column_spacing + item_width);
           item->cell_area.width = item_width;
@@ -3071,6 +3210,8 @@ gtk_icon_view_layout (GtkIconView *icon_view)
       priv->height += sizes[row].minimum_size + priv->item_padding + priv->row_spacing;
     }
 
+  g_free (sizes);
+
   priv->height -= priv->row_spacing;
   priv->height += priv->margin;
   priv->height = MAX (priv->height, gtk_widget_get_allocated_height (widget));
@@ -3080,8 +3221,8 @@ static void
 gtk_icon_view_invalidate_sizes (GtkIconView *icon_view)
 {
   /* Clear all item sizes */
-  g_list_foreach (icon_view->priv->items,
-		  (GFunc)gtk_icon_view_item_invalidate_size, NULL);
+  g_ptr_array_foreach (icon_view->priv->items,
+		       (GFunc)gtk_icon_view_item_invalidate_size, NULL);
 
   /* Re-layout the items */
   gtk_widget_queue_resize (GTK_WIDGET (icon_view));
@@ -3205,21 +3346,11 @@ static void
 gtk_icon_view_queue_draw_path (GtkIconView *icon_view,
 			       GtkTreePath *path)
 {
-  GList *l;
-  gint index;
-
-  index = gtk_tree_path_get_indices (path)[0];
-
-  for (l = icon_view->priv->items; l; l = l->next) 
-    {
-      GtkIconViewItem *item = l->data;
+  GtkIconViewItem *item;
 
-      if (item->index == index)
-	{
-	  gtk_icon_view_queue_draw_item (icon_view, item);
-	  break;
-	}
-    }
+  item = gtk_icon_view_get_item (icon_view, gtk_tree_path_get_indices (path)[0]);
+  if (item)
+    gtk_icon_view_queue_draw_item (icon_view, item);
 }
 
 static void
@@ -3320,14 +3451,16 @@ _gtk_icon_view_get_item_at_coords (GtkIconView          *icon_view,
                                    gboolean              only_in_cell,
                                    GtkCellRenderer     **cell_at_pos)
 {
-  GList *items;
+  gint i, first, last;
 
   if (cell_at_pos)
     *cell_at_pos = NULL;
 
-  for (items = icon_view->priv->items; items; items = items->next)
+  gtk_icon_view_get_item_range (icon_view, y, y, &first, &last);
+
+  for (i = first; i < last; i++)
     {
-      GtkIconViewItem *item = items->data;
+      GtkIconViewItem *item = g_ptr_array_index (icon_view->priv->items, i);
       GdkRectangle    *item_area = &item->cell_area;
 
       if (x >= item_area->x - icon_view->priv->column_spacing/2 && 
@@ -3410,23 +3543,22 @@ _gtk_icon_view_unselect_item (GtkIconView      *icon_view,
   gtk_icon_view_queue_draw_item (icon_view, item);
 }
 
+#ifdef G_ENABLE_DEBUG
 static void
 verify_items (GtkIconView *icon_view)
 {
-  GList *items;
-  int i = 0;
+  guint i;
 
-  for (items = icon_view->priv->items; items; items = items->next)
+  for (i = 0; i < icon_view->priv->items->len; i++)
     {
-      GtkIconViewItem *item = items->data;
+      GtkIconViewItem *item = g_ptr_array_index (icon_view->priv->items, i);
 
       if (item->index != i)
 	g_error ("List item does not match its index: "
 		 "item index %d and list index %d\n", item->index, i);
-
-      i++;
     }
 }
+#endif
 
 static void
 gtk_icon_view_row_changed (GtkTreeModel *model,
@@ -3457,7 +3589,7 @@ gtk_icon_view_row_changed (GtkTreeModel *model,
    */
   gtk_icon_view_invalidate_sizes (icon_view);
 
-  verify_items (icon_view);
+  GTK_NOTE (TREE, verify_items (icon_view));
 }
 
 static void
@@ -3467,9 +3599,9 @@ gtk_icon_view_row_inserted (GtkTreeModel *model,
 			    gpointer      data)
 {
   GtkIconView *icon_view = GTK_ICON_VIEW (data);
-  gint index;
+  GPtrArray *items = icon_view->priv->items;
+  gint index, i;
   GtkIconViewItem *item;
-  GList *list;
 
   /* ignore changes in branches */
   if (gtk_tree_path_get_depth (path) > 1)
@@ -3481,22 +3613,22 @@ gtk_icon_view_row_inserted (GtkTreeModel *model,
 
   item->index = index;
 
-  /* FIXME: We can be more efficient here,
-     we can store a tail pointer and use that when
-     appending (which is a rather common operation)
-  */
-  icon_view->priv->items = g_list_insert (icon_view->priv->items,
-					 item, index);
-  
-  list = g_list_nth (icon_view->priv->items, index + 1);
-  for (; list; list = list->next)
+  /* Appending, the common case, doesn't need to move anything */
+  g_ptr_array_add (items, item);
+  if (index < items->len - 1)
     {
-      item = list->data;
+      memmove (&items->pdata[index + 1], &items->pdata[index],
+               (items->len - 1 - index) * sizeof (gpointer));
+      items->pdata[index] = item;
 
-      item->index++;
+      for (i = index + 1; i < items->len; i++)
+        {
+          item = g_ptr_array_index (items, i);
+          item->index++;
+        }
     }
     
-  verify_items (icon_view);
+  GTK_NOTE (TREE, verify_items (icon_view));
 
   gtk_widget_queue_resize (GTK_WIDGET (icon_view));
 }
@@ -3507,9 +3639,9 @@ gtk_icon_view_row_deleted (GtkTreeModel *model,
 			   gpointer      data)
 {
   GtkIconView *icon_view = GTK_ICON_VIEW (data);
-  gint index;
+  GPtrArray *items = icon_view->priv->items;
+  gint index, i;
   GtkIconViewItem *item;
-  GList *list, *next;
   gboolean emit = FALSE;
 
   /* ignore changes in branches */
@@ -3518,8 +3650,7 @@ gtk_icon_view_row_deleted (GtkTreeModel *model,
 
   index = gtk_tree_path_get_indices(path)[0];
 
-  list = g_list_nth (icon_view->priv->items, index);
-  item = list->data;
+  item = g_ptr_array_index (items, index);
 
   if (icon_view->priv->cell_area)
     gtk_cell_area_stop_editing (icon_view->priv->cell_area, TRUE);
@@ -3538,16 +3669,16 @@ gtk_icon_view_row_deleted (GtkTreeModel *model,
   
   gtk_icon_view_item_free (item);
 
-  for (next = list->next; next; next = next->next)
+  g_ptr_array_remove_index (items, index);
+
+  for (i = index; i < items->len; i++)
     {
-      item = next->data;
+      item = g_ptr_array_index (items, i);
 
       item->index--;
     }
-  
-  icon_view->priv->items = g_list_delete_link (icon_view->priv->items, list);
 
-  verify_items (icon_view);  
+  GTK_NOTE (TREE, verify_items (icon_view));
   
   gtk_widget_queue_resize (GTK_WIDGET (icon_view));
 
@@ -3565,7 +3696,6 @@ gtk_icon_view_rows_reordered (GtkTreeModel *model,
   GtkIconView *icon_view = GTK_ICON_VIEW (data);
   int i;
   int length;
-  GList *items = NULL, *list;
   GtkIconViewItem **item_array;
   gint *order;
 
@@ -3583,23 +3713,21 @@ gtk_icon_view_rows_reordered (GtkTreeModel *model,
     order [new_order[i]] = i;
 
   item_array = g_new (GtkIconViewItem *, length);
-  for (i = 0, list = icon_view->priv->items; list != NULL; list = list->next, i++)
-    item_array[order[i]] = list->data;
+  for (i = 0; i < length; i++)
+    item_array[order[i]] = g_ptr_array_index (icon_view->priv->items, i);
   g_free (order);
 
-  for (i = length - 1; i >= 0; i--)
+  for (i = 0; i < length; i++)
     {
       item_array[i]->index = i;
-      items = g_list_prepend (items, item_array[i]);
+      icon_view->priv->items->pdata[i] = item_array[i];
     }
   
   g_free (item_array);
-  g_list_free (icon_view->priv->items);
-  icon_view->priv->items = items;
 
   gtk_widget_queue_resize (GTK_WIDGET (icon_view));
 
-  verify_items (icon_view);  
+  GTK_NOTE (TREE, verify_items (icon_view));
 }
 
 static void
@@ -3607,7 +3735,6 @@ gtk_icon_view_build_items (GtkIconView *icon_view)
 {
   GtkTreeIter iter;
   int i;
-  GList *items = NULL;
 
   if (!gtk_tree_model_get_iter_first (icon_view->priv->model,
 				      &iter))
@@ -3623,11 +3750,9 @@ gtk_icon_view_build_items (GtkIconView *icon_view)
       
       i++;
 
-      items = g_list_prepend (items, item);
+      g_ptr_array_add (icon_view->priv->items, item);
       
     } while (gtk_tree_model_iter_next (icon_view->priv->model, &iter));
-
-  icon_view->priv->items = g_list_reverse (items);
 }
 
 static void
@@ -3734,18 +3859,37 @@ find_item (GtkIconView     *icon_view,
 	   gint             row_ofs,
 	   gint             col_ofs)
 {
-  gint row, col;
-  GList *items;
+  GtkIconViewPrivate *priv = icon_view->priv;
+  gint row, col, index;
+  guint i;
   GtkIconViewItem *item;
 
-  /* FIXME: this could be more efficient 
-   */
   row = current->row + row_ofs;
   col = current->col + col_ofs;
 
-  for (items = icon_view->priv->items; items; items = items->next)
+  if (row < 0 || col < 0)
+    return NULL;
+
+  /* Items are stored row by row, with columns mirrored in RTL */
+  if (priv->n_columns > 0)
     {
-      item = items->data;
+      if (col >= priv->n_columns)
+        return NULL;
+
+      if (gtk_widget_get_direction (GTK_WIDGET (icon_view)) == GTK_TEXT_DIR_RTL)
+        index = row * priv->n_columns + priv->n_columns - 1 - col;
+      else
+        index = row * priv->n_columns + col;
+
+      item = gtk_icon_view_get_item (icon_view, index);
+      if (item == NULL || (item->row == row && item->col == col))
+        return item;
+    }
+
+  /* The layout is not up to date, fall back to searching */
+  for (i = 0; i < priv->items->len; i++)
+    {
+      item = g_ptr_array_index (priv->items, i);
       if (item->row == row && item->col == col)
 	return item;
     }
@@ -3758,48 +3902,33 @@ find_item_page_up_down (GtkIconView     *icon_view,
 			GtkIconViewItem *current,
 			gint             count)
 {
-  GList *item, *next;
-  gint y, col;
+  GtkIconViewItem *item, *next;
+  gint y, col, step;
   
   col = current->col;
   y = current->cell_area.y + count * gtk_adjustment_get_page_size (icon_view->priv->vadjustment);
 
-  item = g_list_find (icon_view->priv->items, current);
-  if (count > 0)
-    {
-      while (item)
-	{
-	  for (next = item->next; next; next = next->next)
-	    {
-	      if (((GtkIconViewItem *)next->data)->col == col)
-		break;
-	    }
-	  if (!next || ((GtkIconViewItem *)next->data)->cell_area.y > y)
-	    break;
+  if (icon_view->priv->n_columns <= 0)
+    return current;
 
-	  item = next;
-	}
-    }
-  else 
+  /* The item in the same column of the next or previous row
+   * is always n_columns away */
+  step = count > 0 ? icon_view->priv->n_columns : - icon_view->priv->n_columns;
+
+  item = current;
+  while (TRUE)
     {
-      while (item)
-	{
-	  for (next = item->prev; next; next = next->prev)
-	    {
-	      if (((GtkIconViewItem *)next->data)->col == col)
-		break;
-	    }
-	  if (!next || ((GtkIconViewItem *)next->data)->cell_area.y < y)
-	    break;
+      next = gtk_icon_view_get_item (icon_view, item->index + step);
 
-	  item = next;
-	}
-    }
+      if (!next || next->col != col)
+        break;
+      if (count > 0 ? next->cell_area.y > y : next->cell_area.y < y)
+        break;
 
-  if (item)
-    return item->data;
+      item = next;
+    }
 
-  return NULL;
+  return item;
 }
 
 static gboolean
@@ -3807,9 +3936,9 @@ gtk_icon_view_select_all_between (GtkIconView     *icon_view,
 				  GtkIconViewItem *anchor,
 				  GtkIconViewItem *cursor)
 {
-  GList *items;
   GtkIconViewItem *item;
   gint row1, row2, col1, col2;
+  gint i, first, last;
   gboolean dirty = FALSE;
   
   if (anchor->row < cursor->row)
@@ -3834,9 +3963,22 @@ gtk_icon_view_select_all_between (GtkIconView     *icon_view,
       col2 = anchor->col;
     }
 
-  for (items = icon_view->priv->items; items; items = items->next)
+  /* Only the rows between anchor and cursor need to be looked at */
+  if (icon_view->priv->n_columns > 0)
+    {
+      first = MAX (row1, 0) * icon_view->priv->n_columns;
+      last = MIN ((row2 + 1) * icon_view->priv->n_columns,
+                  (gint) icon_view->priv->items->len);
+    }
+  else
+    {
+      first = 0;
+      last = icon_view->priv->items->len;
+    }
+
+  for (i = first; i < last; i++)
     {
-      item = items->data;
+      item = g_ptr_array_index (icon_view->priv->items, i);
 
       if (row1 <= item->row && item->row <= row2 &&
 	  col1 <= item->col && item->col <= col2)
@@ -3871,17 +4013,13 @@ gtk_icon_view_move_cursor_up_down (GtkIconView *icon_view,
 
   if (!icon_view->priv->cursor_item)
     {
-      GList *list;
-
       if (count > 0)
-	list = icon_view->priv->items;
+	item = gtk_icon_view_get_item (icon_view, 0);
       else
-	list = g_list_last (icon_view->priv->items);
+	item = gtk_icon_view_get_item (icon_view, icon_view->priv->items->len - 1);
 
-      if (list)
+      if (item)
         {
-          item = list->data;
-
           /* Give focus to the first cell initially */
           _gtk_icon_view_set_cell_data (icon_view, item);
           gtk_cell_area_focus (icon_view->priv->cell_area, direction);
@@ -3963,14 +4101,10 @@ gtk_icon_view_move_cursor_page_up_down (GtkIconView *icon_view,
   
   if (!icon_view->priv->cursor_item)
     {
-      GList *list;
-
       if (count > 0)
-	list = icon_view->priv->items;
+	item = gtk_icon_view_get_item (icon_view, 0);
       else
-	list = g_list_last (icon_view->priv->items);
-
-      item = list ? list->data : NULL;
+	item = gtk_icon_view_get_item (icon_view, icon_view->priv->items->len - 1);
     }
   else
     item = find_item_page_up_down (icon_view, 
@@ -4023,17 +4157,13 @@ gtk_icon_view_move_cursor_left_right (GtkIconView *icon_view,
 
   if (!icon_view->priv->cursor_item)
     {
-      GList *list;
-
       if (count > 0)
-	list = icon_view->priv->items;
+	item = gtk_icon_view_get_item (icon_view, 0);
       else
-	list = g_list_last (icon_view->priv->items);
+	item = gtk_icon_view_get_item (icon_view, icon_view->priv->items->len - 1);
 
-      if (list)
+      if (item)
         {
-          item = list->data;
-
           /* Give focus to the first cell initially */
           _gtk_icon_view_set_cell_data (icon_view, item);
           gtk_cell_area_focus (icon_view->priv->cell_area, direction);
@@ -4108,18 +4238,15 @@ gtk_icon_view_move_cursor_start_end (GtkIconView *icon_view,
 				     gint         count)
 {
   GtkIconViewItem *item;
-  GList *list;
   gboolean dirty = FALSE;
   
   if (!gtk_widget_has_focus (GTK_WIDGET (icon_view)))
     return;
   
   if (count < 0)
-    list = icon_view->priv->items;
+    item = gtk_icon_view_get_item (icon_view, 0);
   else
-    list = g_list_last (icon_view->priv->items);
-  
-  item = list ? list->data : NULL;
+    item = gtk_icon_view_get_item (icon_view, icon_view->priv->items->len - 1);
 
   if (item == icon_view->priv->cursor_item)
     gtk_widget_error_bell (GTK_WIDGET (icon_view));
@@ -4193,8 +4320,7 @@ gtk_icon_view_scroll_to_path (GtkIconView *icon_view,
   widget = GTK_WIDGET (icon_view);
 
   if (gtk_tree_path_get_depth (path) > 0)
-    item = g_list_nth_data (icon_view->priv->items,
-			    gtk_tree_path_get_indices(path)[0]);
+    item = gtk_icon_view_get_item (icon_view, gtk_tree_path_get_indices(path)[0]);
   
   if (!item || item->cell_area.width < 0 ||
       !gtk_widget_get_realized (widget))
@@ -4558,8 +4684,7 @@ gtk_icon_view_get_cell_rect (GtkIconView     *icon_view,
   g_return_val_if_fail (cell == NULL || GTK_IS_CELL_RENDERER (cell), FALSE);
 
   if (gtk_tree_path_get_depth (path) > 0)
-    item = g_list_nth_data (icon_view->priv->items,
-			    gtk_tree_path_get_indices(path)[0]);
+    item = gtk_icon_view_get_item (icon_view, gtk_tree_path_get_indices(path)[0]);
 
   if (!item)
     return FALSE;
@@ -4850,7 +4975,7 @@ gtk_icon_view_get_visible_range (GtkIconView  *icon_view,
 {
   gint start_index = -1;
   gint end_index = -1;
-  GList *icons;
+  gint i, first, last, y;
 
   g_return_val_if_fail (GTK_IS_ICON_VIEW (icon_view), FALSE);
 
@@ -4860,10 +4985,15 @@ gtk_icon_view_get_visible_range (GtkIconView  *icon_view,
 
   if (start_path == NULL && end_path == NULL)
     return FALSE;
+
+  y = gtk_adjustment_get_value (icon_view->priv->vadjustment);
+  gtk_icon_view_get_item_range (icon_view,
+                                y, y + gtk_adjustment_get_page_size (icon_view->priv->vadjustment),
+                                &first, &last);
   
-  for (icons = icon_view->priv->items; icons; icons = icons->next) 
+  for (i = first; i < last; i++)
     {
-      GtkIconViewItem *item = icons->data;
+      GtkIconViewItem *item = g_ptr_array_index (icon_view->priv->items, i);
       GdkRectangle    *item_area = &item->cell_area;
 
       if ((item_area->x + item_area->width >= (int)gtk_adjustment_get_value (icon_view->priv->hadjustment)) &&
@@ -4905,11 +5035,11 @@ gtk_icon_view_selected_foreach (GtkIconView           *icon_view,
 				GtkIconViewForeachFunc func,
 				gpointer               data)
 {
-  GList *list;
+  guint i;
   
-  for (list = icon_view->priv->items; list; list = list->next)
+  for (i = 0; i < icon_view->priv->items->len; i++)
     {
-      GtkIconViewItem *item = list->data;
+      GtkIconViewItem *item = g_ptr_array_index (icon_view->priv->items, i);
       GtkTreePath *path = gtk_tree_path_new_from_indices (item->index, -1);
 
       if (item->selected)
@@ -5047,8 +5177,9 @@ gtk_icon_view_set_model (GtkIconView *icon_view,
 
       g_object_unref (icon_view->priv->model);
       
-      g_list_free_full (icon_view->priv->items, (GDestroyNotify) gtk_icon_view_item_free);
-      icon_view->priv->items = NULL;
+      g_ptr_array_foreach (icon_view->priv->items, (GFunc) gtk_icon_view_item_free, NULL);
+      g_ptr_array_set_size (icon_view->priv->items, 0);
+      icon_view->priv->n_columns = 0;
       icon_view->priv->anchor_item = NULL;
       icon_view->priv->cursor_item = NULL;
       icon_view->priv->last_single_clicked = NULL;
@@ -5412,8 +5543,7 @@ gtk_icon_view_select_path (GtkIconView *icon_view,
   g_return_if_fail (path != NULL);
 
   if (gtk_tree_path_get_depth (path) > 0)
-    item = g_list_nth_data (icon_view->priv->items,
-			    gtk_tree_path_get_indices(path)[0]);
+    item = gtk_icon_view_get_item (icon_view, gtk_tree_path_get_indices(path)[0]);
 
   if (item)
     _gtk_icon_view_select_item (icon_view, item);
@@ -5438,8 +5568,7 @@ gtk_icon_view_unselect_path (GtkIconView *icon_view,
   g_return_if_fail (icon_view->priv->model != NULL);
   g_return_if_fail (path != NULL);
 
-  item = g_list_nth_data (icon_view->priv->items,
-			  gtk_tree_path_get_indices(path)[0]);
+  item = gtk_icon_view_get_item (icon_view, gtk_tree_path_get_indices(path)[0]);
 
   if (!item)
     return;
@@ -5468,14 +5597,14 @@ gtk_icon_view_unselect_path (GtkIconView *icon_view,
 GList *
 gtk_icon_view_get_selected_items (GtkIconView *icon_view)
 {
-  GList *list;
   GList *selected = NULL;
+  guint i;
   
   g_return_val_if_fail (GTK_IS_ICON_VIEW (icon_view), NULL);
   
-  for (list = icon_view->priv->items; list != NULL; list = list->next)
+  for (i = 0; i < icon_view->priv->items->len; i++)
     {
-      GtkIconViewItem *item = list->data;
+      GtkIconViewItem *item = g_ptr_array_index (icon_view->priv->items, i);
 
       if (item->selected)
 	{
@@ -5500,17 +5629,17 @@ gtk_icon_view_get_selected_items (GtkIconView *icon_view)
 void
 gtk_icon_view_select_all (GtkIconView *icon_view)
 {
-  GList *items;
   gboolean dirty = FALSE;
+  guint i;
   
   g_return_if_fail (GTK_IS_ICON_VIEW (icon_view));
 
   if (icon_view->priv->selection_mode != GTK_SELECTION_MULTIPLE)
     return;
 
-  for (items = icon_view->priv->items; items; items = items->next)
+  for (i = 0; i < icon_view->priv->items->len; i++)
     {
-      GtkIconViewItem *item = items->data;
+      GtkIconViewItem *item = g_ptr_array_index (icon_view->priv->items, i);
       
       if (!item->selected)
 	{
@@ -5570,8 +5699,7 @@ gtk_icon_view_path_is_selected (GtkIconView *icon_view,
   g_return_val_if_fail (icon_view->priv->model != NULL, FALSE);
   g_return_val_if_fail (path != NULL, FALSE);
   
-  item = g_list_nth_data (icon_view->priv->items,
-			  gtk_tree_path_get_indices(path)[0]);
+  item = gtk_icon_view_get_item (icon_view, gtk_tree_path_get_indices(path)[0]);
 
   if (!item)
     return FALSE;
@@ -5601,8 +5729,7 @@ gtk_icon_view_get_item_row (GtkIconView *icon_view,
   g_return_val_if_fail (icon_view->priv->model != NULL, -1);
   g_return_val_if_fail (path != NULL, -1);
 
-  item = g_list_nth_data (icon_view->priv->items,
-                          gtk_tree_path_get_indices(path)[0]);
+  item = gtk_icon_view_get_item (icon_view, gtk_tree_path_get_indices(path)[0]);
 
   if (!item)
     return -1;
@@ -5632,8 +5759,7 @@ gtk_icon_view_get_item_column (GtkIconView *icon_view,
   g_return_val_if_fail (icon_view->priv->model != NULL, -1);
   g_return_val_if_fail (path != NULL, -1);
 
-  item = g_list_nth_data (icon_view->priv->items,
-                          gtk_tree_path_get_indices(path)[0]);
+  item = gtk_icon_view_get_item (icon_view, gtk_tree_path_get_indices(path)[0]);
 
   if (!item)
     return -1;
@@ -7120,8 +7246,7 @@ gtk_icon_view_create_drag_icon (GtkIconView *icon_view,
   GtkWidget *widget;
   cairo_t *cr;
   cairo_surface_t *surface;
-  GList *l;
-  gint index;
+  GtkIconViewItem *item;
 
   g_return_val_if_fail (GTK_IS_ICON_VIEW (icon_view), NULL);
   g_return_val_if_fail (path != NULL, NULL);
@@ -7131,37 +7256,31 @@ gtk_icon_view_create_drag_icon (GtkIconView *icon_view,
   if (!gtk_widget_get_realized (widget))
     return NULL;
 
-  index = gtk_tree_path_get_indices (path)[0];
-
-  for (l = icon_view->priv->items; l; l = l->next) 
+  item = gtk_icon_view_get_item (icon_view, gtk_tree_path_get_indices (path)[0]);
+  if (item)
     {
-      GtkIconViewItem *item = l->data;
-      
-      if (index == item->index)
-	{
-	  GdkRectangle rect = { 
-	    item->cell_area.x - icon_view->priv->item_padding, 
-	    item->cell_area.y - icon_view->priv->item_padding, 
-	    item->cell_area.width  + icon_view->priv->item_padding * 2, 
-	    item->cell_area.height + icon_view->priv->item_padding * 2 
-	  };
+      GdkRectangle rect = { 
+        item->cell_area.x - icon_view->priv->item_padding, 
+        item->cell_area.y - icon_view->priv->item_padding, 
+        item->cell_area.width  + icon_view->priv->item_padding * 2, 
+        item->cell_area.height + icon_view->priv->item_padding * 2 
+      };
 
-	  surface = gdk_window_create_similar_surface (icon_view->priv->bin_window,
-                                                       CAIRO_CONTENT_COLOR_ALPHA,
-                                                       rect.width,
-                                                       rect.height);
+      surface = gdk_window_create_similar_surface (icon_view->priv->bin_window,
+                                                   CAIRO_CONTENT_COLOR_ALPHA,
+                                                   rect.width,
+                                                   rect.height);
 
-	  cr = cairo_create (surface);
+      cr = cairo_create (surface);
 
-	  gtk_icon_view_paint_item (icon_view, cr, item, 
-				    icon_view->priv->item_padding,
-				    icon_view->priv->item_padding,
-                                    FALSE);
+      gtk_icon_view_paint_item (icon_view, cr, item, 
+                                icon_view->priv->item_padding,
+                                icon_view->priv->item_padding,
+                                FALSE);
 
-	  cairo_destroy (cr);
+      cairo_destroy (cr);
 
-	  return surface;
-	}
+      return surface;
     }
   
   return NULL;
@@ -7288,6 +7407,54 @@ gtk_icon_view_get_activate_on_single_click (GtkIconView *icon_view)
   return icon_view->priv->activate_on_single_click;
 }
 
+/**
+ * gtk_icon_view_set_fixed_size_mode:
+ * @icon_view: a #GtkIconView
+ * @enable: %TRUE to enable fixed size mode
+ *
+ * Enables or disables the fixed size mode of @icon_view. 
+ * Fixed size mode speeds up #GtkIconView by assuming that all 
+ * items have the same size. Only the first item of the model
+ * is measured, which makes layouting large models much cheaper.
+ *
+ * Since: 3.12
+ **/
+void
+gtk_icon_view_set_fixed_size_mode (GtkIconView *icon_view,
+                                   gboolean     enable)
+{
+  g_return_if_fail (GTK_IS_ICON_VIEW (icon_view));
+
+  enable = enable != FALSE;
+
+  if (icon_view->priv->fixed_size_mode == enable)
+    return;
+
+  icon_view->priv->fixed_size_mode = enable;
+
+  gtk_icon_view_invalidate_sizes (icon_view);
+
+  g_object_notify (G_OBJECT (icon_view), "fixed-size-mode");
+}
+
+/**
+ * gtk_icon_view_get_fixed_size_mode:
+ * @icon_view: a #GtkIconView
+ *
+ * Returns whether fixed size mode is turned on for @icon_view.
+ *
+ * Return value: %TRUE if @icon_view is in fixed size mode
+ *
+ * Since: 3.12
+ **/
+gboolean
+gtk_icon_view_get_fixed_size_mode (GtkIconView *icon_view)
+{
+  g_return_val_if_fail (GTK_IS_ICON_VIEW (icon_view), FALSE);
+
+  return icon_view->priv->fixed_size_mode;
+}
+
 static gboolean
 gtk_icon_view_buildable_custom_tag_start (GtkBuildable  *buildable,
                                           GtkBuilder    *builder,
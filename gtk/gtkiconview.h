@@ -170,6 +170,9 @@ void           gtk_icon_view_set_activate_on_single_click (GtkIconView  *icon_vi
                                                            gboolean      single);
 GDK_AVAILABLE_IN_3_8
 gboolean       gtk_icon_view_get_activate_on_single_click (GtkIconView  *icon_view);
+void           gtk_icon_view_set_fixed_size_mode (GtkIconView    *icon_view,
+                                                  gboolean        enable);
+gboolean       gtk_icon_view_get_fixed_size_mode (GtkIconView    *icon_view);
 
 void           gtk_icon_view_selected_foreach   (GtkIconView            *icon_view,
 						 GtkIconViewForeachFunc  func,
@@ -58,7 +58,10 @@ struct _GtkIconViewPrivate
 
   GtkTreeModel *model;
 
-  GList *items;
+  /* GtkIconViewItem, indexed by model position; items are laid out
+   * row-major, so item->index == item->row * n_columns + visual column */
+  GPtrArray *items;
+  gint n_columns;
 
   GtkAdjustment *hadjustment;
   GtkAdjustment *vadjustment;
@@ -118,6 +121,7 @@ struct _GtkIconViewPrivate
   guint reorderable : 1;
   guint empty_view_drop :1;
   guint activate_on_single_click : 1;
+  guint fixed_size_mode : 1;
 
   guint modify_selection_pressed : 1;
   guint extend_selection_pressed : 1;
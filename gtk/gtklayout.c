@@ -34,6 +34,7 @@
 
 #include "gdk/gdk.h"
 
+#include "gtkcontainerprivate.h"
 #include "gtkprivate.h"
 #include "gtkintl.h"
 #include "gtkmarshalers.h"
@@ -841,6 +842,9 @@ gtk_layout_init (GtkLayout *layout)
   priv->visibility = GDK_VISIBILITY_PARTIAL;
 
   priv->freeze_count = 0;
+
+  /* our size request never depends on our children */
+  _gtk_container_set_layout_boundary (GTK_CONTAINER (layout), TRUE);
 }
 
 /* Widget methods
@@ -89,6 +89,22 @@ typedef struct
 
   int n_visible_rows;
   gboolean in_widget;
+
+  /* Model mode, see gtk_list_box_bind_model(). Only the rows near the
+   * visible area are bound, and are kept in children ordered by item.
+   */
+  GtkTreeModel *model;
+  GtkListBoxBindRowFunc bind_func;
+  gpointer bind_func_target;
+  GDestroyNotify bind_func_target_destroy_notify;
+  gulong model_handlers[4];
+
+  GArray *item_heights;
+  GArray *item_sums;
+  gint64 measured_height;
+  guint n_measured;
+  gint selected_item;
+  GSList *recycled_rows;
 } GtkListBoxPrivate;
 
 typedef struct
@@ -98,6 +114,7 @@ typedef struct
   gint y;
   gint height;
   gboolean visible;
+  gint item;
 } GtkListBoxRowPrivate;
 
 enum {
@@ -124,6 +141,8 @@ enum  {
 G_DEFINE_TYPE_WITH_PRIVATE (GtkListBox, gtk_list_box, GTK_TYPE_CONTAINER)
 G_DEFINE_TYPE_WITH_PRIVATE (GtkListBoxRow, gtk_list_box_row, GTK_TYPE_BIN)
 
+#define ROW_PRIV(_row) ((GtkListBoxRowPrivate *)gtk_list_box_row_get_instance_private (_row))
+
 static void                 gtk_list_box_update_selected              (GtkListBox          *list_box,
                                                                        GtkListBoxRow       *row);
 static void                 gtk_list_box_apply_filter_all             (GtkListBox          *list_box);
@@ -190,6 +209,13 @@ static void                 gtk_list_box_real_move_cursor             (GtkListBo
                                                                        GtkMovementStep      step,
                                                                        gint                 count);
 static void                 gtk_list_box_finalize                     (GObject             *obj);
+static void                 gtk_list_box_adjustment_value_changed     (GtkAdjustment       *adjustment,
+                                                                       GtkListBox          *list_box);
+static void                 gtk_list_box_layout_model_rows            (GtkListBox          *list_box);
+static GtkListBoxRow       *gtk_list_box_find_model_row               (GtkListBox          *list_box,
+                                                                       gint                 item);
+static gint                 gtk_list_box_get_item_y                   (GtkListBox          *list_box,
+                                                                       gint                 item);
 static void                 gtk_list_box_real_parent_set              (GtkWidget           *widget,
                                                                        GtkWidget           *prev_parent);
 
@@ -241,6 +267,7 @@ gtk_list_box_init (GtkListBox *list_box)
 
   priv->children = g_sequence_new (NULL);
   priv->header_hash = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, NULL);
+  priv->selected_item = -1;
 
   context = gtk_widget_get_style_context (GTK_WIDGET (list_box));
   gtk_style_context_add_class (context, GTK_STYLE_CLASS_LIST);
@@ -291,6 +318,18 @@ gtk_list_box_set_property (GObject      *obj,
     }
 }
 
+static void
+gtk_list_box_dispose (GObject *obj)
+{
+  GtkListBox *list_box = GTK_LIST_BOX (obj);
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+
+  if (priv->model != NULL || priv->bind_func != NULL)
+    gtk_list_box_bind_model (list_box, NULL, NULL, NULL, NULL);
+
+  G_OBJECT_CLASS (gtk_list_box_parent_class)->dispose (obj);
+}
+
 static void
 gtk_list_box_finalize (GObject *obj)
 {
@@ -304,6 +343,10 @@ gtk_list_box_finalize (GObject *obj)
   if (priv->update_header_func_target_destroy_notify != NULL)
     priv->update_header_func_target_destroy_notify (priv->update_header_func_target);
 
+  if (priv->adjustment != NULL)
+    g_signal_handlers_disconnect_by_func (priv->adjustment,
+                                          gtk_list_box_adjustment_value_changed,
+                                          list_box);
   g_clear_object (&priv->adjustment);
   g_clear_object (&priv->drag_highlighted_row);
 
@@ -325,6 +368,7 @@ gtk_list_box_class_init (GtkListBoxClass *klass)
 
   object_class->get_property = gtk_list_box_get_property;
   object_class->set_property = gtk_list_box_set_property;
+  object_class->dispose = gtk_list_box_dispose;
   object_class->finalize = gtk_list_box_finalize;
   widget_class->enter_notify_event = gtk_list_box_real_enter_notify_event;
   widget_class->leave_notify_event = gtk_list_box_real_leave_notify_event;
@@ -495,6 +539,10 @@ gtk_list_box_get_selected_row (GtkListBox *list_box)
  *
  * Gets the n:th child in the list (not counting headers).
  *
+ * If a model is bound to @list_box, this returns the row showing
+ * the n:th item of the model, or %NULL if that item has currently
+ * no row because it is too far away from the visible area.
+ *
  * Return value: (transfer none): the child #GtkWidget
  *
  * Since: 3.10
@@ -508,6 +556,9 @@ gtk_list_box_get_row_at_index (GtkListBox *list_box,
 
   g_return_val_if_fail (list_box != NULL, NULL);
 
+  if (priv->model != NULL)
+    return gtk_list_box_find_model_row (list_box, index_);
+
   iter = g_sequence_get_iter_at_pos (priv->children, index_);
   if (iter)
     return g_sequence_get (iter);
@@ -634,8 +685,15 @@ gtk_list_box_set_adjustment (GtkListBox    *list_box,
 
   g_object_ref_sink (adjustment);
   if (priv->adjustment)
-    g_object_unref (priv->adjustment);
+    {
+      g_signal_handlers_disconnect_by_func (priv->adjustment,
+                                            gtk_list_box_adjustment_value_changed,
+                                            list_box);
+      g_object_unref (priv->adjustment);
+    }
   priv->adjustment = adjustment;
+  g_signal_connect (adjustment, "value-changed",
+                    G_CALLBACK (gtk_list_box_adjustment_value_changed), list_box);
 }
 
 /**
@@ -659,6 +717,19 @@ gtk_list_box_get_adjustment (GtkListBox *list_box)
   return priv->adjustment;
 }
 
+static void
+gtk_list_box_adjustment_value_changed (GtkAdjustment *adjustment,
+                                       GtkListBox    *list_box)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+
+  /* Scrolling a bound list only changes which items need rows, so
+   * skip the full size request and just rebind around the new view.
+   */
+  if (priv->model != NULL && gtk_widget_get_realized (GTK_WIDGET (list_box)))
+    gtk_list_box_layout_model_rows (list_box);
+}
+
 static void
 gtk_list_box_real_parent_set (GtkWidget *widget,
                               GtkWidget *prev_parent)
@@ -864,6 +935,10 @@ gtk_list_box_invalidate_sort (GtkListBox *list_box)
 
   g_return_if_fail (list_box != NULL);
 
+  /* Bound rows must stay in model order, sort the model instead */
+  if (priv->model != NULL)
+    return;
+
   g_sequence_sort (priv->children,
                    (GCompareDataFunc)do_sort, list_box);
   gtk_list_box_invalidate_headers (list_box);
@@ -876,6 +951,9 @@ gtk_list_box_do_reseparate (GtkListBox *list_box)
   GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
   GSequenceIter *iter;
 
+  if (priv->model != NULL)
+    return;
+
   for (iter = g_sequence_get_begin_iter (priv->children);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
@@ -952,6 +1030,10 @@ gtk_list_box_got_row_changed (GtkListBox    *list_box,
   g_return_if_fail (list_box != NULL);
   g_return_if_fail (row != NULL);
 
+  /* Changes to bound rows come in through the model */
+  if (row_priv->item >= 0 || row_priv->iter == NULL)
+    return;
+
   prev_next = gtk_list_box_get_next_visible (list_box, row_priv->iter);
   if (priv->sort_func != NULL)
     {
@@ -1054,13 +1136,15 @@ gtk_list_box_update_selected (GtkListBox    *list_box,
 {
   GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
 
-  if (row != priv->selected_row &&
+  if ((row != priv->selected_row ||
+       (row == NULL && priv->selected_item >= 0)) &&
       (row == NULL || priv->selection_mode != GTK_SELECTION_NONE))
     {
       if (priv->selected_row)
         gtk_widget_unset_state_flags (GTK_WIDGET (priv->selected_row),
                                       GTK_STATE_FLAG_SELECTED);
       priv->selected_row = row;
+      priv->selected_item = row ? ROW_PRIV (row)->item : -1;
       if (priv->selected_row)
         gtk_widget_set_state_flags (GTK_WIDGET (priv->selected_row),
                                     GTK_STATE_FLAG_SELECTED,
@@ -1321,8 +1405,6 @@ gtk_list_box_real_show (GtkWidget *widget)
   GTK_WIDGET_CLASS (gtk_list_box_parent_class)->show (widget);
 }
 
-#define ROW_PRIV(_row) ((GtkListBoxRowPrivate *)gtk_list_box_row_get_instance_private (_row))
-
 static gboolean
 gtk_list_box_real_focus (GtkWidget        *widget,
                          GtkDirectionType  direction)
@@ -1484,6 +1566,12 @@ update_row_is_visible (GtkListBox    *list_box,
     gtk_widget_get_visible (GTK_WIDGET (row)) &&
     gtk_widget_get_child_visible (GTK_WIDGET (row));
 
+  /* Bound rows come and go while scrolling, the model's
+   * item count is what decides about the placeholder.
+   */
+  if (row_priv->item >= 0 || row_priv->iter == NULL)
+    return;
+
   if (was_visible && !row_priv->visible)
     list_box_add_visible_rows (list_box, -1);
   if (!was_visible && row_priv->visible)
@@ -1519,6 +1607,9 @@ gtk_list_box_apply_filter_all (GtkListBox *list_box)
   GtkListBoxRow *row;
   GSequenceIter *iter;
 
+  if (priv->model != NULL)
+    return;
+
   for (iter = g_sequence_get_begin_iter (priv->children);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
@@ -1685,6 +1776,10 @@ gtk_list_box_row_visibility_changed (GtkListBox    *list_box,
 {
   update_row_is_visible (list_box, row);
 
+  /* Bound rows don't get headers */
+  if (ROW_PRIV (row)->item >= 0 || ROW_PRIV (row)->iter == NULL)
+    return;
+
   if (gtk_widget_get_visible (GTK_WIDGET (list_box)))
     {
       gtk_list_box_update_header (list_box, ROW_PRIV (row)->iter);
@@ -1732,13 +1827,22 @@ gtk_list_box_real_remove (GtkContainer *container,
     }
 
   row = GTK_LIST_BOX_ROW (child);
-  if (g_sequence_iter_get_sequence (ROW_PRIV (row)->iter) != priv->children)
+  if (ROW_PRIV (row)->iter == NULL &&
+      g_slist_find (priv->recycled_rows, row) != NULL)
+    {
+      priv->recycled_rows = g_slist_remove (priv->recycled_rows, row);
+      gtk_widget_unparent (child);
+      return;
+    }
+
+  if (ROW_PRIV (row)->iter == NULL ||
+      g_sequence_iter_get_sequence (ROW_PRIV (row)->iter) != priv->children)
     {
       g_warning ("Tried to remove non-child %p\n", child);
       return;
     }
 
-  if (ROW_PRIV (row)->visible)
+  if (ROW_PRIV (row)->visible && ROW_PRIV (row)->item < 0)
     list_box_add_visible_rows (list_box, -1);
 
   if (ROW_PRIV (row)->header != NULL)
@@ -1770,6 +1874,8 @@ gtk_list_box_real_remove (GtkContainer *container,
   next = gtk_list_box_get_next_visible (list_box, ROW_PRIV (row)->iter);
   gtk_widget_unparent (child);
   g_sequence_remove (ROW_PRIV (row)->iter);
+  ROW_PRIV (row)->iter = NULL;
+  ROW_PRIV (row)->item = -1;
   if (gtk_widget_get_visible (GTK_WIDGET (list_box)))
     gtk_list_box_update_header (list_box, next);
 
@@ -1787,10 +1893,19 @@ gtk_list_box_real_forall_internal (GtkContainer *container,
   GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
   GSequenceIter *iter;
   GtkListBoxRow *row;
+  GSList *l;
 
   if (priv->placeholder != NULL && include_internals)
     callback (priv->placeholder, callback_target);
 
+  l = priv->recycled_rows;
+  while (l != NULL && include_internals)
+    {
+      row = l->data;
+      l = l->next;
+      callback (GTK_WIDGET (row), callback_target);
+    }
+
   iter = g_sequence_get_begin_iter (priv->children);
   while (!g_sequence_iter_is_end (iter))
     {
@@ -1860,6 +1975,11 @@ gtk_list_box_real_get_preferred_height_for_width (GtkWidget *widget,
     gtk_widget_get_preferred_height_for_width (priv->placeholder, width,
                                                &minimum_height, NULL);
 
+  /* A bound list is as tall as its items, measured or not */
+  if (priv->model != NULL)
+    minimum_height += gtk_list_box_get_item_y (list_box,
+                                               priv->item_heights->len);
+
   for (iter = g_sequence_get_begin_iter (priv->children);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
@@ -1868,7 +1988,7 @@ gtk_list_box_real_get_preferred_height_for_width (GtkWidget *widget,
       gint row_min = 0;
 
       row = g_sequence_get (iter);
-      if (!row_is_visible (row))
+      if (!row_is_visible (row) || ROW_PRIV (row)->item >= 0)
         continue;
 
       if (ROW_PRIV (row)->header != NULL)
@@ -2000,6 +2120,12 @@ gtk_list_box_real_size_allocate (GtkWidget     *widget,
       child_allocation.y += child_min;
     }
 
+  if (priv->model != NULL)
+    {
+      gtk_list_box_layout_model_rows (list_box);
+      return;
+    }
+
   for (iter = g_sequence_get_begin_iter (priv->children);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
@@ -2079,6 +2205,7 @@ gtk_list_box_insert (GtkListBox *list_box,
 
   g_return_if_fail (list_box != NULL);
   g_return_if_fail (child != NULL);
+  g_return_if_fail (priv->model == NULL);
 
   if (GTK_IS_LIST_BOX_ROW (child))
     row = GTK_LIST_BOX_ROW (child);
@@ -2119,6 +2246,787 @@ gtk_list_box_insert (GtkListBox *list_box,
     }
 }
 
+/* Height assumed for items that never had a row, until
+ * some rows have been measured
+ */
+#define ESTIMATED_ROW_HEIGHT 32
+
+static gint
+gtk_list_box_get_estimated_height (GtkListBox *list_box)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+
+  if (priv->n_measured == 0)
+    return ESTIMATED_ROW_HEIGHT;
+
+  return priv->measured_height / priv->n_measured;
+}
+
+/* The item heights are summed up in a binary indexed tree, so that
+ * finding the items in the visible area doesn't have to walk all items
+ * before it. Unmeasured items are counted, not summed, because the
+ * estimate for them changes with every measurement.
+ */
+typedef struct
+{
+  gint height;
+  gint n_measured;
+} GtkListBoxItemSum;
+
+static void
+gtk_list_box_invalidate_item_sums (GtkListBox *list_box)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+
+  g_array_set_size (priv->item_sums, 0);
+}
+
+static GtkListBoxItemSum *
+gtk_list_box_get_item_sums (GtkListBox *list_box)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  GtkListBoxItemSum *sums;
+  gint item_height;
+  gint n_items;
+  gint i, j;
+
+  n_items = priv->item_heights->len;
+  if (priv->item_sums->len == n_items + 1)
+    return (GtkListBoxItemSum *) priv->item_sums->data;
+
+  g_array_set_size (priv->item_sums, n_items + 1);
+  sums = (GtkListBoxItemSum *) priv->item_sums->data;
+  sums[0].height = 0;
+  sums[0].n_measured = 0;
+
+  for (i = 1; i <= n_items; i++)
+    {
+      item_height = g_array_index (priv->item_heights, gint, i - 1);
+      sums[i].height = MAX (item_height, 0);
+      sums[i].n_measured = item_height >= 0;
+    }
+
+  for (i = 1; i <= n_items; i++)
+    {
+      j = i + (i & -i);
+      if (j <= n_items)
+        {
+          sums[j].height += sums[i].height;
+          sums[j].n_measured += sums[i].n_measured;
+        }
+    }
+
+  return sums;
+}
+
+/* Returns the height of the items before @item */
+static gint
+gtk_list_box_get_item_y (GtkListBox *list_box,
+                         gint        item)
+{
+  GtkListBoxItemSum *sums;
+  gint estimated;
+  gint height;
+  gint n_measured;
+  gint i;
+
+  sums = gtk_list_box_get_item_sums (list_box);
+  estimated = gtk_list_box_get_estimated_height (list_box);
+  height = 0;
+  n_measured = 0;
+
+  for (i = item; i > 0; i -= i & -i)
+    {
+      height += sums[i].height;
+      n_measured += sums[i].n_measured;
+    }
+
+  return height + (item - n_measured) * estimated;
+}
+
+/* Returns the number of items that end above @y */
+static gint
+gtk_list_box_count_items_above (GtkListBox *list_box,
+                                gint        y)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  GtkListBoxItemSum *sums;
+  gint estimated;
+  gint n_items;
+  gint height;
+  gint item_y;
+  gint step;
+  gint item;
+
+  sums = gtk_list_box_get_item_sums (list_box);
+  estimated = gtk_list_box_get_estimated_height (list_box);
+  n_items = priv->item_heights->len;
+
+  for (step = 1; step * 2 <= n_items; step *= 2)
+    ;
+
+  item = 0;
+  item_y = 0;
+  for (; step > 0; step /= 2)
+    {
+      if (item + step > n_items)
+        continue;
+
+      height = sums[item + step].height +
+               (step - sums[item + step].n_measured) * estimated;
+      if (item_y + height < y)
+        {
+          item += step;
+          item_y += height;
+        }
+    }
+
+  return item;
+}
+
+static gint
+gtk_list_box_get_item_height (GtkListBox *list_box,
+                              gint        item)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  gint item_height;
+
+  item_height = g_array_index (priv->item_heights, gint, item);
+  if (item_height >= 0)
+    return item_height;
+
+  return gtk_list_box_get_estimated_height (list_box);
+}
+
+static void
+gtk_list_box_set_item_height (GtkListBox *list_box,
+                              gint        item,
+                              gint        height)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  GtkListBoxItemSum *sums;
+  gint *item_height;
+  gint delta_height;
+  gint delta_measured;
+  gint n_items;
+  gint i;
+
+  item_height = &g_array_index (priv->item_heights, gint, item);
+  delta_height = MAX (height, 0) - MAX (*item_height, 0);
+  delta_measured = (height >= 0) - (*item_height >= 0);
+
+  if (*item_height >= 0)
+    {
+      priv->measured_height -= *item_height;
+      priv->n_measured--;
+    }
+
+  if (height >= 0)
+    {
+      priv->measured_height += height;
+      priv->n_measured++;
+    }
+
+  *item_height = height;
+
+  /* Invalid sums are rebuilt from the heights when needed */
+  n_items = priv->item_heights->len;
+  if (priv->item_sums->len != n_items + 1)
+    return;
+
+  sums = (GtkListBoxItemSum *) priv->item_sums->data;
+  for (i = item + 1; i <= n_items; i += i & -i)
+    {
+      sums[i].height += delta_height;
+      sums[i].n_measured += delta_measured;
+    }
+}
+
+static GtkListBoxRow *
+gtk_list_box_find_model_row (GtkListBox *list_box,
+                             gint        item)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  GSequenceIter *iter;
+  GtkListBoxRow *row;
+
+  for (iter = g_sequence_get_begin_iter (priv->children);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      row = g_sequence_get (iter);
+      if (ROW_PRIV (row)->item == item)
+        return row;
+      if (ROW_PRIV (row)->item > item)
+        break;
+    }
+
+  return NULL;
+}
+
+static void
+gtk_list_box_bind_row (GtkListBox    *list_box,
+                       GtkListBoxRow *row,
+                       gint           item)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  GtkTreeIter iter;
+
+  ROW_PRIV (row)->item = item;
+
+  if (gtk_tree_model_iter_nth_child (priv->model, &iter, NULL, item))
+    priv->bind_func (row, priv->model, &iter, priv->bind_func_target);
+
+  /* The selection belongs to the item, not to the row showing it */
+  if (item == priv->selected_item && row != priv->selected_row)
+    {
+      priv->selected_row = row;
+      gtk_widget_set_state_flags (GTK_WIDGET (row),
+                                  GTK_STATE_FLAG_SELECTED,
+                                  FALSE);
+    }
+}
+
+static GtkListBoxRow *
+gtk_list_box_bind_item (GtkListBox    *list_box,
+                        gint           item,
+                        GSequenceIter *before)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  GtkListBoxRow *row;
+
+  if (priv->recycled_rows != NULL)
+    {
+      row = priv->recycled_rows->data;
+      priv->recycled_rows = g_slist_delete_link (priv->recycled_rows,
+                                                 priv->recycled_rows);
+      ROW_PRIV (row)->item = item;
+    }
+  else
+    {
+      row = GTK_LIST_BOX_ROW (gtk_list_box_row_new ());
+      ROW_PRIV (row)->item = item;
+      gtk_widget_show (GTK_WIDGET (row));
+      gtk_widget_set_parent (GTK_WIDGET (row), GTK_WIDGET (list_box));
+    }
+
+  ROW_PRIV (row)->iter = g_sequence_insert_before (before, row);
+  gtk_widget_set_child_visible (GTK_WIDGET (row), TRUE);
+  gtk_list_box_bind_row (list_box, row, item);
+  ROW_PRIV (row)->visible = gtk_widget_get_visible (GTK_WIDGET (row));
+
+  return row;
+}
+
+static void
+gtk_list_box_unbind_row (GtkListBox    *list_box,
+                         GtkListBoxRow *row)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+
+  if (row == priv->selected_row)
+    {
+      gtk_widget_unset_state_flags (GTK_WIDGET (row),
+                                    GTK_STATE_FLAG_SELECTED);
+      priv->selected_row = NULL;
+    }
+  if (row == priv->prelight_row)
+    {
+      gtk_widget_unset_state_flags (GTK_WIDGET (row),
+                                    GTK_STATE_FLAG_PRELIGHT);
+      priv->prelight_row = NULL;
+    }
+  if (row == priv->cursor_row)
+    priv->cursor_row = NULL;
+  if (row == priv->active_row)
+    {
+      if (priv->active_row_active)
+        gtk_widget_unset_state_flags (GTK_WIDGET (row),
+                                      GTK_STATE_FLAG_ACTIVE);
+      priv->active_row = NULL;
+    }
+  if (row == priv->drag_highlighted_row)
+    gtk_list_box_drag_unhighlight_row (list_box);
+
+  g_sequence_remove (ROW_PRIV (row)->iter);
+  ROW_PRIV (row)->iter = NULL;
+  ROW_PRIV (row)->item = -1;
+  ROW_PRIV (row)->visible = FALSE;
+
+  /* Recycled rows stay parented, so that binding them again
+   * doesn't have to go through realizing and styling a new row
+   */
+  gtk_widget_set_child_visible (GTK_WIDGET (row), FALSE);
+  priv->recycled_rows = g_slist_prepend (priv->recycled_rows, row);
+}
+
+/* Binds a row for @item if it has none, like for moving the cursor
+ * to an item away from the visible area. The row is positioned when
+ * the list box is allocated next.
+ */
+static GtkListBoxRow *
+gtk_list_box_ensure_model_row (GtkListBox *list_box,
+                               gint        item)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  GSequenceIter *iter;
+  GtkListBoxRow *row;
+
+  for (iter = g_sequence_get_begin_iter (priv->children);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      row = g_sequence_get (iter);
+      if (ROW_PRIV (row)->item == item)
+        return row;
+      if (ROW_PRIV (row)->item > item)
+        break;
+    }
+
+  row = gtk_list_box_bind_item (list_box, item, iter);
+  gtk_widget_queue_resize (GTK_WIDGET (list_box));
+
+  return row;
+}
+
+static void
+gtk_list_box_scroll_to_item (GtkListBox *list_box,
+                             gint        item)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  GtkAllocation allocation;
+  gdouble value, page_size;
+  gint y, height;
+
+  if (priv->adjustment == NULL)
+    return;
+
+  /* There are items, so the placeholder takes no space */
+  gtk_widget_get_allocation (GTK_WIDGET (list_box), &allocation);
+  y = allocation.y + gtk_list_box_get_item_y (list_box, item);
+  height = gtk_list_box_get_item_height (list_box, item);
+
+  value = gtk_adjustment_get_value (priv->adjustment);
+  page_size = gtk_adjustment_get_page_size (priv->adjustment);
+
+  if (y < value)
+    gtk_adjustment_set_value (priv->adjustment, y);
+  else if (y + height > value + page_size)
+    gtk_adjustment_set_value (priv->adjustment, y + height - page_size);
+}
+
+static void
+gtk_list_box_layout_model_rows (GtkListBox *list_box)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  GtkAllocation allocation;
+  GtkAllocation child_allocation;
+  GtkListBoxRow *row, *focus_row;
+  GtkWidget *focus_child;
+  GSequenceIter *iter;
+  gboolean resize;
+  gdouble value, page_size;
+  gint top, bottom;
+  gint first, last;
+  gint first_y, items_y;
+  gint n_items;
+  gint height;
+  gint y;
+  gint i;
+
+  gtk_widget_get_allocation (GTK_WIDGET (list_box), &allocation);
+  n_items = priv->item_heights->len;
+
+  y = 0;
+  if (priv->placeholder != NULL && gtk_widget_get_child_visible (priv->placeholder))
+    y = gtk_widget_get_allocated_height (priv->placeholder);
+  items_y = y;
+
+  /* The row with the keyboard focus is never recycled, making
+   * it child-invisible would make the window drop the focus
+   */
+  focus_row = NULL;
+  focus_child = gtk_container_get_focus_child (GTK_CONTAINER (list_box));
+  if (GTK_IS_LIST_BOX_ROW (focus_child) &&
+      ROW_PRIV (GTK_LIST_BOX_ROW (focus_child))->item >= 0)
+    focus_row = GTK_LIST_BOX_ROW (focus_child);
+
+  /* Keep rows for a page above and below the visible area,
+   * so that scrolling doesn't have to bind them right away
+   */
+  top = 0;
+  bottom = allocation.height;
+  if (priv->adjustment != NULL)
+    {
+      page_size = gtk_adjustment_get_page_size (priv->adjustment);
+      if (page_size > 0)
+        {
+          value = gtk_adjustment_get_value (priv->adjustment) - allocation.y;
+          top = floor (value - page_size);
+          bottom = ceil (value + 2 * page_size);
+        }
+    }
+
+  first = gtk_list_box_count_items_above (list_box, top - items_y + 1);
+  last = -1;
+  if (bottom > items_y)
+    last = MIN (gtk_list_box_count_items_above (list_box, bottom - items_y),
+                n_items - 1);
+  first_y = items_y + gtk_list_box_get_item_y (list_box, first);
+
+  iter = g_sequence_get_begin_iter (priv->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      row = g_sequence_get (iter);
+      iter = g_sequence_iter_next (iter);
+      if ((ROW_PRIV (row)->item < first || ROW_PRIV (row)->item > last) &&
+          row != focus_row)
+        gtk_list_box_unbind_row (list_box, row);
+    }
+
+  child_allocation.x = 0;
+  child_allocation.width = allocation.width;
+  resize = FALSE;
+  y = first_y;
+
+  iter = g_sequence_get_begin_iter (priv->children);
+  for (i = first; i <= last; i++)
+    {
+      row = g_sequence_iter_is_end (iter) ? NULL : g_sequence_get (iter);
+      if (row != NULL && row == focus_row && ROW_PRIV (row)->item < first)
+        {
+          iter = g_sequence_iter_next (iter);
+          row = g_sequence_iter_is_end (iter) ? NULL : g_sequence_get (iter);
+        }
+      if (row != NULL && ROW_PRIV (row)->item == i)
+        iter = g_sequence_iter_next (iter);
+      else
+        row = gtk_list_box_bind_item (list_box, i, iter);
+
+      gtk_widget_get_preferred_height_for_width (GTK_WIDGET (row),
+                                                 allocation.width, &height, NULL);
+      if (height != gtk_list_box_get_item_height (list_box, i))
+        resize = TRUE;
+      gtk_list_box_set_item_height (list_box, i, height);
+
+      ROW_PRIV (row)->y = y;
+      ROW_PRIV (row)->height = height;
+      child_allocation.y = y;
+      child_allocation.height = height;
+      gtk_widget_size_allocate (GTK_WIDGET (row), &child_allocation);
+
+      y += height;
+    }
+
+  /* A focus row out of the range still goes where its item is */
+  if (focus_row != NULL &&
+      (ROW_PRIV (focus_row)->item < first || ROW_PRIV (focus_row)->item > last))
+    {
+      i = ROW_PRIV (focus_row)->item;
+      ROW_PRIV (focus_row)->y = items_y + gtk_list_box_get_item_y (list_box, i);
+      ROW_PRIV (focus_row)->height = gtk_list_box_get_item_height (list_box, i);
+      child_allocation.y = ROW_PRIV (focus_row)->y;
+      child_allocation.height = ROW_PRIV (focus_row)->height;
+      gtk_widget_size_allocate (GTK_WIDGET (focus_row), &child_allocation);
+    }
+
+  /* The estimates we were allocated for turned out wrong */
+  if (resize)
+    gtk_widget_queue_resize (GTK_WIDGET (list_box));
+}
+
+static void
+gtk_list_box_shift_model_rows (GtkListBox *list_box,
+                               gint        first,
+                               gint        delta)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  GSequenceIter *iter;
+  GtkListBoxRow *row;
+
+  for (iter = g_sequence_get_begin_iter (priv->children);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      row = g_sequence_get (iter);
+      if (ROW_PRIV (row)->item >= first)
+        ROW_PRIV (row)->item += delta;
+    }
+
+  if (priv->selected_item >= first)
+    priv->selected_item += delta;
+}
+
+static void
+gtk_list_box_model_row_inserted (GtkTreeModel *model,
+                                 GtkTreePath  *path,
+                                 GtkTreeIter  *iter,
+                                 GtkListBox   *list_box)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  gint unmeasured = -1;
+  gint item;
+
+  if (gtk_tree_path_get_depth (path) != 1)
+    return;
+
+  item = gtk_tree_path_get_indices (path)[0];
+  gtk_list_box_shift_model_rows (list_box, item, 1);
+  g_array_insert_val (priv->item_heights, item, unmeasured);
+  gtk_list_box_invalidate_item_sums (list_box);
+
+  list_box_add_visible_rows (list_box, 1);
+  gtk_widget_queue_resize (GTK_WIDGET (list_box));
+}
+
+static void
+gtk_list_box_model_row_deleted (GtkTreeModel *model,
+                                GtkTreePath  *path,
+                                GtkListBox   *list_box)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  GtkListBoxRow *row;
+  gint item;
+
+  if (gtk_tree_path_get_depth (path) != 1)
+    return;
+
+  item = gtk_tree_path_get_indices (path)[0];
+  row = gtk_list_box_find_model_row (list_box, item);
+  if (row != NULL)
+    gtk_list_box_unbind_row (list_box, row);
+
+  gtk_list_box_set_item_height (list_box, item, -1);
+  g_array_remove_index (priv->item_heights, item);
+  gtk_list_box_invalidate_item_sums (list_box);
+
+  if (item == priv->selected_item)
+    {
+      priv->selected_item = -1;
+      g_signal_emit (list_box, signals[ROW_SELECTED], 0, NULL);
+      _gtk_list_box_accessible_selection_changed (list_box);
+    }
+  gtk_list_box_shift_model_rows (list_box, item + 1, -1);
+
+  list_box_add_visible_rows (list_box, -1);
+  gtk_widget_queue_resize (GTK_WIDGET (list_box));
+}
+
+static void
+gtk_list_box_model_row_changed (GtkTreeModel *model,
+                                GtkTreePath  *path,
+                                GtkTreeIter  *iter,
+                                GtkListBox   *list_box)
+{
+  GtkListBoxRow *row;
+  gint item;
+
+  if (gtk_tree_path_get_depth (path) != 1)
+    return;
+
+  item = gtk_tree_path_get_indices (path)[0];
+  row = gtk_list_box_find_model_row (list_box, item);
+  if (row != NULL)
+    gtk_list_box_bind_row (list_box, row, item);
+
+  gtk_list_box_set_item_height (list_box, item, -1);
+  gtk_widget_queue_resize (GTK_WIDGET (list_box));
+}
+
+static void
+gtk_list_box_model_rows_reordered (GtkTreeModel *model,
+                                   GtkTreePath  *path,
+                                   GtkTreeIter  *iter,
+                                   gpointer      new_order,
+                                   GtkListBox   *list_box)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  GSequenceIter *seq_iter;
+  GtkWidget *focus_child;
+  GArray *item_heights;
+  gint *order = new_order;
+  gint selected_item;
+  gint i;
+
+  if (gtk_tree_path_get_depth (path) != 0)
+    return;
+
+  item_heights = g_array_sized_new (FALSE, FALSE, sizeof (gint),
+                                    priv->item_heights->len);
+  selected_item = -1;
+  for (i = 0; i < priv->item_heights->len; i++)
+    {
+      g_array_append_val (item_heights,
+                          g_array_index (priv->item_heights, gint, order[i]));
+      if (order[i] == priv->selected_item)
+        selected_item = i;
+    }
+  g_array_unref (priv->item_heights);
+  priv->item_heights = item_heights;
+  gtk_list_box_invalidate_item_sums (list_box);
+
+  /* Rebind everything, the measured heights moved along with the items.
+   * The row with the keyboard focus keeps its item, see
+   * gtk_list_box_layout_model_rows().
+   */
+  focus_child = gtk_container_get_focus_child (GTK_CONTAINER (list_box));
+  seq_iter = g_sequence_get_begin_iter (priv->children);
+  while (!g_sequence_iter_is_end (seq_iter))
+    {
+      GtkListBoxRow *row = g_sequence_get (seq_iter);
+      seq_iter = g_sequence_iter_next (seq_iter);
+      if (GTK_WIDGET (row) == focus_child)
+        {
+          for (i = 0; i < priv->item_heights->len; i++)
+            {
+              if (order[i] == ROW_PRIV (row)->item)
+                {
+                  ROW_PRIV (row)->item = i;
+                  break;
+                }
+            }
+        }
+      else
+        gtk_list_box_unbind_row (list_box, row);
+    }
+  priv->selected_item = selected_item;
+
+  gtk_widget_queue_resize (GTK_WIDGET (list_box));
+}
+
+/**
+ * gtk_list_box_bind_model:
+ * @list_box: a #GtkListBox
+ * @model: (allow-none): the #GtkTreeModel to show, or %NULL
+ * @bind_func: (closure user_data) (allow-none): function that
+ *     makes a row show an item of @model
+ * @user_data: user data passed to @bind_func
+ * @destroy: destroy notifier for @user_data
+ *
+ * Binds @model to @list_box. The top level of @model is shown as a
+ * list, but rows are only created for the items in and near the
+ * visible area of the surrounding #GtkScrolledWindow. When items
+ * scroll out of view their rows are reused for other items, calling
+ * @bind_func to update them. This keeps the cost of a list box with
+ * a large number of items close to that of the rows on screen.
+ * The row with the keyboard focus is not reused while it has it.
+ *
+ * Items that never had a row are assumed to be as tall as the
+ * average of the rows measured so far, so the scrollbar can change
+ * a bit while scrolling through rows of very different heights.
+ *
+ * Rows can't be added to a list box with a model, and any existing
+ * rows are removed when binding one. The sort, filter and header
+ * functions are not used for bound rows; wrap @model in a
+ * #GtkTreeModelSort or #GtkTreeModelFilter to sort or filter the
+ * items instead. Selection follows the item, so a selected item
+ * stays selected when its row is reused.
+ *
+ * Passing %NULL for @model unbinds the current model.
+ *
+ * Since: 3.12
+ */
+void
+gtk_list_box_bind_model (GtkListBox            *list_box,
+                         GtkTreeModel          *model,
+                         GtkListBoxBindRowFunc  bind_func,
+                         gpointer               user_data,
+                         GDestroyNotify         destroy)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+  GSequenceIter *iter;
+  GtkListBoxRow *row;
+  gint unmeasured = -1;
+  gint n_items;
+  gint i;
+
+  g_return_if_fail (list_box != NULL);
+  g_return_if_fail (model == NULL || GTK_IS_TREE_MODEL (model));
+  g_return_if_fail (model == NULL || bind_func != NULL);
+
+  if (priv->model != NULL)
+    {
+      for (i = 0; i < G_N_ELEMENTS (priv->model_handlers); i++)
+        g_signal_handler_disconnect (priv->model, priv->model_handlers[i]);
+      list_box_add_visible_rows (list_box, - (gint) priv->item_heights->len);
+      g_clear_object (&priv->model);
+      g_array_unref (priv->item_heights);
+      priv->item_heights = NULL;
+      g_array_unref (priv->item_sums);
+      priv->item_sums = NULL;
+      priv->measured_height = 0;
+      priv->n_measured = 0;
+    }
+
+  if (priv->bind_func_target_destroy_notify != NULL)
+    priv->bind_func_target_destroy_notify (priv->bind_func_target);
+
+  while (priv->recycled_rows != NULL)
+    gtk_container_remove (GTK_CONTAINER (list_box), priv->recycled_rows->data);
+
+  iter = g_sequence_get_begin_iter (priv->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      row = g_sequence_get (iter);
+      iter = g_sequence_iter_next (iter);
+      gtk_container_remove (GTK_CONTAINER (list_box), GTK_WIDGET (row));
+    }
+
+  if (priv->selected_item >= 0)
+    gtk_list_box_update_selected (list_box, NULL);
+
+  priv->bind_func = bind_func;
+  priv->bind_func_target = user_data;
+  priv->bind_func_target_destroy_notify = destroy;
+
+  if (model != NULL)
+    {
+      priv->model = g_object_ref (model);
+
+      n_items = gtk_tree_model_iter_n_children (model, NULL);
+      priv->item_heights = g_array_sized_new (FALSE, FALSE, sizeof (gint), n_items);
+      for (i = 0; i < n_items; i++)
+        g_array_append_val (priv->item_heights, unmeasured);
+      priv->item_sums = g_array_new (FALSE, FALSE, sizeof (GtkListBoxItemSum));
+      list_box_add_visible_rows (list_box, n_items);
+
+      priv->model_handlers[0] =
+        g_signal_connect (model, "row-inserted",
+                          G_CALLBACK (gtk_list_box_model_row_inserted), list_box);
+      priv->model_handlers[1] =
+        g_signal_connect (model, "row-deleted",
+                          G_CALLBACK (gtk_list_box_model_row_deleted), list_box);
+      priv->model_handlers[2] =
+        g_signal_connect (model, "row-changed",
+                          G_CALLBACK (gtk_list_box_model_row_changed), list_box);
+      priv->model_handlers[3] =
+        g_signal_connect (model, "rows-reordered",
+                          G_CALLBACK (gtk_list_box_model_rows_reordered), list_box);
+    }
+
+  gtk_widget_queue_resize (GTK_WIDGET (list_box));
+}
+
+/**
+ * gtk_list_box_get_model:
+ * @list_box: a #GtkListBox
+ *
+ * Gets the model bound with gtk_list_box_bind_model().
+ *
+ * Return value: (transfer none): the bound model, or %NULL
+ *
+ * Since: 3.12
+ */
+GtkTreeModel *
+gtk_list_box_get_model (GtkListBox *list_box)
+{
+  GtkListBoxPrivate *priv = gtk_list_box_get_instance_private (list_box);
+
+  g_return_val_if_fail (list_box != NULL, NULL);
+
+  return priv->model;
+}
+
 /**
  * gtk_list_box_drag_unhighlight_row:
  * @list_box: An #GtkListBox.
@@ -2223,6 +3131,8 @@ gtk_list_box_real_move_cursor (GtkListBox      *list_box,
   GSequenceIter *iter;
   gint start_y;
   gint end_y;
+  gint n_items;
+  gint item;
 
   modify_selection_pressed = FALSE;
 
@@ -2234,17 +3144,28 @@ gtk_list_box_real_move_cursor (GtkListBox      *list_box,
         modify_selection_pressed = TRUE;
     }
 
+  /* A bound list moves by items, most of which have no row */
+  n_items = priv->model != NULL ? priv->item_heights->len : 0;
+  item = -1;
+
   row = NULL;
   switch (step)
     {
     case GTK_MOVEMENT_BUFFER_ENDS:
-      if (count < 0)
+      if (priv->model != NULL)
+        item = count < 0 ? 0 : n_items - 1;
+      else if (count < 0)
         row = gtk_list_box_get_first_focusable (list_box);
       else
         row = gtk_list_box_get_last_focusable (list_box);
       break;
     case GTK_MOVEMENT_DISPLAY_LINES:
-      if (priv->cursor_row != NULL)
+      if (priv->model != NULL)
+        {
+          if (priv->cursor_row != NULL)
+            item = CLAMP (ROW_PRIV (priv->cursor_row)->item + count, 0, n_items - 1);
+        }
+      else if (priv->cursor_row != NULL)
         {
           iter = ROW_PRIV (priv->cursor_row)->iter;
 
@@ -2268,7 +3189,36 @@ gtk_list_box_real_move_cursor (GtkListBox      *list_box,
       if (priv->adjustment != NULL)
         page_size = gtk_adjustment_get_page_increment (priv->adjustment);
 
-      if (priv->cursor_row != NULL)
+      if (priv->model != NULL)
+        {
+          if (priv->cursor_row == NULL)
+            break;
+
+          item = ROW_PRIV (priv->cursor_row)->item;
+          start_y = gtk_list_box_get_item_y (list_box, item);
+          if (count < 0)
+            {
+              /* Up, to the first item starting within a page */
+              end_y = start_y - page_size;
+              if (end_y > 0)
+                item = gtk_list_box_count_items_above (list_box, end_y) + 1;
+              else
+                item = 0;
+            }
+          else
+            {
+              /* Down, to the last item starting within a page */
+              end_y = start_y + page_size;
+              item = MIN (gtk_list_box_count_items_above (list_box, end_y + 1),
+                          n_items - 1);
+            }
+          end_y = gtk_list_box_get_item_y (list_box, item);
+          if (end_y != start_y && priv->adjustment != NULL)
+            gtk_adjustment_set_value (priv->adjustment,
+                                      gtk_adjustment_get_value (priv->adjustment) +
+                                      end_y - start_y);
+        }
+      else if (priv->cursor_row != NULL)
         {
           start_y = ROW_PRIV (priv->cursor_row)->y;
           end_y = start_y;
@@ -2318,6 +3268,12 @@ gtk_list_box_real_move_cursor (GtkListBox      *list_box,
       return;
     }
 
+  if (item >= 0)
+    {
+      gtk_list_box_scroll_to_item (list_box, item);
+      row = gtk_list_box_ensure_model_row (list_box, item);
+    }
+
   if (row == NULL || row == priv->cursor_row)
     {
       GtkDirectionType direction = count < 0 ? GTK_DIR_UP : GTK_DIR_DOWN;
@@ -2363,6 +3319,8 @@ gtk_list_box_row_init (GtkListBoxRow *row)
 {
   GtkStyleContext *context;
 
+  ROW_PRIV (row)->item = -1;
+
   gtk_widget_set_can_focus (GTK_WIDGET (row), TRUE);
   gtk_widget_set_redraw_on_allocate (GTK_WIDGET (row), TRUE);
 
@@ -2777,6 +3735,8 @@ gtk_list_box_row_set_header (GtkListBoxRow *row,
  * @row: a #GtkListBoxRow
  *
  * Gets the current index of the @row in its #GtkListBox container.
+ * For a list box bound to a model this is the position of the item
+ * that @row is showing.
  *
  * Returns: the index of the @row, or -1 if the @row is not in a listbox
  *
@@ -2789,6 +3749,9 @@ gtk_list_box_row_get_index (GtkListBoxRow *row)
 
   g_return_val_if_fail (GTK_IS_LIST_BOX_ROW (row), -1);
 
+  if (priv->item >= 0)
+    return priv->item;
+
   if (priv->iter != NULL)
     return g_sequence_iter_get_position (priv->iter);
 
@@ -27,6 +27,7 @@
 #endif
 
 #include <gtk/gtkbin.h>
+#include <gtk/gtktreemodel.h>
 
 G_BEGIN_DECLS
 
@@ -144,6 +145,26 @@ typedef void (*GtkListBoxUpdateHeaderFunc) (GtkListBoxRow *row,
                                             GtkListBoxRow *before,
                                             gpointer       user_data);
 
+/**
+ * GtkListBoxBindRowFunc:
+ * @row: the row to bind
+ * @model: the #GtkTreeModel bound to the list box
+ * @iter: a #GtkTreeIter pointing to the item to show in @row
+ * @user_data: (closure): user data
+ *
+ * Called by a list box bound to a model whenever @row needs to show
+ * the item at @iter. Rows are reused for other items when they scroll
+ * out of view, so this must update the complete content of @row. A
+ * freshly created row has no child yet, which is the time to build
+ * the widgets that later calls will update.
+ *
+ * Since: 3.12
+ */
+typedef void (*GtkListBoxBindRowFunc) (GtkListBoxRow *row,
+                                       GtkTreeModel  *model,
+                                       GtkTreeIter   *iter,
+                                       gpointer       user_data);
+
 GType      gtk_list_box_row_get_type      (void) G_GNUC_CONST;
 GtkWidget* gtk_list_box_row_new           (void);
 GtkWidget* gtk_list_box_row_get_header (GtkListBoxRow *row);
@@ -194,6 +215,12 @@ void           gtk_list_box_prepend                      (GtkListBox
 void           gtk_list_box_insert                       (GtkListBox                    *list_box,
                                                           GtkWidget                     *child,
                                                           gint                           position);                                                                         
+void           gtk_list_box_bind_model                   (GtkListBox                    *list_box,
+                                                          GtkTreeModel                  *model,
+                                                          GtkListBoxBindRowFunc          bind_func,
+                                                          gpointer                       user_data,
+                                                          GDestroyNotify                 destroy);
+GtkTreeModel * gtk_list_box_get_model                    (GtkListBox                    *list_box);
 
 G_END_DECLS
 
@@ -234,6 +234,188 @@ _gtk_pango_fill_layout (cairo_t     *cr,
     cairo_move_to (cr, current_x, current_y);
 }
 
+/* Font metrics cache
+ *
+ * pango_context_get_metrics() loads a fontset and walks all its fonts,
+ * which is way too expensive for something that size requests of
+ * labels and entries do all the time, with the same handful of fonts.
+ * So we cache the metrics on the font map, keyed by everything in the
+ * context that can influence them.
+ */
+
+#define METRICS_CACHE_MAX_SIZE 64
+
+typedef struct
+{
+  PangoFontDescription *font_desc;
+  PangoLanguage *language;
+  PangoGravity gravity;
+  gdouble resolution;
+  cairo_font_options_t *font_options;
+
+  PangoFontMetrics *metrics;
+} MetricsCacheEntry;
+
+static void
+metrics_cache_entry_free (MetricsCacheEntry *entry)
+{
+  pango_font_description_free (entry->font_desc);
+  if (entry->font_options)
+    cairo_font_options_destroy (entry->font_options);
+  if (entry->metrics)
+    pango_font_metrics_unref (entry->metrics);
+
+  g_slice_free (MetricsCacheEntry, entry);
+}
+
+static guint
+metrics_cache_entry_hash (gconstpointer data)
+{
+  const MetricsCacheEntry *entry = data;
+  guint hash;
+
+  hash = pango_font_description_hash (entry->font_desc);
+  hash ^= GPOINTER_TO_UINT (entry->language);
+  hash ^= entry->gravity << 16;
+  hash ^= (guint) entry->resolution;
+  if (entry->font_options)
+    hash ^= cairo_font_options_hash (entry->font_options);
+
+  return hash;
+}
+
+static gboolean
+metrics_cache_entry_equal (gconstpointer a,
+                           gconstpointer b)
+{
+  const MetricsCacheEntry *entry_a = a;
+  const MetricsCacheEntry *entry_b = b;
+
+  if (entry_a->language != entry_b->language ||
+      entry_a->gravity != entry_b->gravity ||
+      entry_a->resolution != entry_b->resolution)
+    return FALSE;
+
+  if (entry_a->font_options == NULL || entry_b->font_options == NULL)
+    {
+      if (entry_a->font_options != entry_b->font_options)
+        return FALSE;
+    }
+  else if (!cairo_font_options_equal (entry_a->font_options, entry_b->font_options))
+    return FALSE;
+
+  return pango_font_description_equal (entry_a->font_desc, entry_b->font_desc);
+}
+
+static GQuark
+metrics_cache_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (G_UNLIKELY (quark == 0))
+    quark = g_quark_from_static_string ("gtk-pango-metrics-cache");
+
+  return quark;
+}
+
+/**
+ * _gtk_pango_context_get_metrics:
+ * @context: a #PangoContext
+ * @font_desc: (allow-none): a #PangoFontDescription, or %NULL to use
+ *     the font description of @context
+ * @language: (allow-none): a #PangoLanguage, or %NULL to use the
+ *     language of @context
+ *
+ * Like pango_context_get_metrics(), but the metrics are cached and
+ * shared between all contexts using the same font map, font options
+ * and resolution.
+ *
+ * Returns: a #PangoFontMetrics, to be freed with pango_font_metrics_unref()
+ */
+PangoFontMetrics *
+_gtk_pango_context_get_metrics (PangoContext               *context,
+                                const PangoFontDescription *font_desc,
+                                PangoLanguage              *language)
+{
+  const cairo_font_options_t *font_options;
+  PangoFontMap *font_map;
+  GHashTable *cache;
+  MetricsCacheEntry key;
+  MetricsCacheEntry *entry;
+
+  g_return_val_if_fail (PANGO_IS_CONTEXT (context), NULL);
+
+  if (font_desc == NULL)
+    font_desc = pango_context_get_font_description (context);
+
+  /* NULL means the context's language, which differs between contexts */
+  if (language == NULL)
+    language = pango_context_get_language (context);
+
+  font_map = pango_context_get_font_map (context);
+
+  /* Transformed contexts are rare, don't bother */
+  if (font_map == NULL || pango_context_get_matrix (context) != NULL)
+    return pango_context_get_metrics (context, font_desc, language);
+
+  cache = g_object_get_qdata (G_OBJECT (font_map), metrics_cache_quark ());
+  if (cache == NULL)
+    {
+      cache = g_hash_table_new_full (metrics_cache_entry_hash,
+                                     metrics_cache_entry_equal,
+                                     (GDestroyNotify) metrics_cache_entry_free,
+                                     NULL);
+      g_object_set_qdata_full (G_OBJECT (font_map), metrics_cache_quark (),
+                               cache, (GDestroyNotify) g_hash_table_unref);
+    }
+
+  font_options = pango_cairo_context_get_font_options (context);
+
+  key.font_desc = (PangoFontDescription *) font_desc;
+  key.language = language;
+  key.gravity = pango_context_get_gravity (context);
+  key.resolution = pango_cairo_context_get_resolution (context);
+  key.font_options = (cairo_font_options_t *) font_options;
+
+  entry = g_hash_table_lookup (cache, &key);
+  if (entry == NULL)
+    {
+      /* Only ever a few fonts are in use, so if the cache grows
+       * large something is cycling through fonts, and keeping
+       * the old entries around won't help.
+       */
+      if (g_hash_table_size (cache) >= METRICS_CACHE_MAX_SIZE)
+        g_hash_table_remove_all (cache);
+
+      entry = g_slice_new (MetricsCacheEntry);
+      entry->font_desc = pango_font_description_copy (font_desc);
+      entry->language = key.language;
+      entry->gravity = key.gravity;
+      entry->resolution = key.resolution;
+      entry->font_options = font_options ? cairo_font_options_copy (font_options) : NULL;
+      entry->metrics = pango_context_get_metrics (context, font_desc, language);
+
+      g_hash_table_add (cache, entry);
+    }
+
+  return pango_font_metrics_ref (entry->metrics);
+}
+
+/**
+ * _gtk_pango_font_map_clear_metrics:
+ * @font_map: a #PangoFontMap
+ *
+ * Drops the metrics cached by _gtk_pango_context_get_metrics() for
+ * @font_map. This needs to be called when the fonts themselves change.
+ */
+void
+_gtk_pango_font_map_clear_metrics (PangoFontMap *font_map)
+{
+  g_return_if_fail (PANGO_IS_FONT_MAP (font_map));
+
+  g_object_set_qdata (G_OBJECT (font_map), metrics_cache_quark (), NULL);
+}
+
 static AtkAttributeSet *
 add_attribute (AtkAttributeSet  *attributes,
                AtkTextAttribute  attr,
@@ -36,6 +36,11 @@ G_BEGIN_DECLS
 void             _gtk_pango_fill_layout            (cairo_t         *cr,
                                                     PangoLayout     *layout);
 
+PangoFontMetrics *_gtk_pango_context_get_metrics   (PangoContext               *context,
+                                                    const PangoFontDescription *font_desc,
+                                                    PangoLanguage              *language);
+void             _gtk_pango_font_map_clear_metrics (PangoFontMap    *font_map);
+
 
 AtkAttributeSet *_gtk_pango_get_default_attributes (AtkAttributeSet *attributes,
                                                     PangoLayout     *layout);
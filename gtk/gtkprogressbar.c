@@ -30,6 +30,7 @@
 
 #include "gtkprogressbar.h"
 #include "gtkorientableprivate.h"
+#include "gtkpango.h"
 #include "gtkprivate.h"
 #include "gtkintl.h"
 
@@ -517,9 +518,9 @@ gtk_progress_bar_get_preferred_width (GtkWidget *widget,
 
           /* The minimum size for ellipsized text is ~ 3 chars */
           context = pango_layout_get_context (layout);
-          metrics = pango_context_get_metrics (context,
-                                               pango_context_get_font_description (context),
-                                               pango_context_get_language (context));
+          metrics = _gtk_pango_context_get_metrics (context,
+                                                    pango_context_get_font_description (context),
+                                                    pango_context_get_language (context));
 
           char_width = pango_font_metrics_get_approximate_char_width (metrics);
           pango_font_metrics_unref (metrics);
@@ -165,11 +165,44 @@ struct _GtkRecentInfo
   gint ref_count;
 };
 
+/* identifies a version of the storage file, so that we can tell
+ * the file we wrote ourselves apart from changes made by others;
+ * replacing the file always creates a new inode
+ */
+typedef struct
+{
+  guint64 inode;
+  goffset size;
+  time_t mtime;
+} RecentFileStamp;
+
+/* a snapshot of the list, handed to a writer thread */
+typedef struct
+{
+  gchar *filename;
+  gchar *contents;
+  gsize length;
+  guint64 serial;
+} RecentWriteData;
+
+/* the result of reloading the list in a thread */
+typedef struct
+{
+  gchar *filename;
+  GBookmarkFile *items;
+  RecentFileStamp stamp;
+  guint64 written_serial;
+} RecentLoadData;
+
 struct _GtkRecentManagerPrivate
 {
   gchar *filename;
 
   guint is_dirty : 1;
+  guint write_in_flight : 1;
+  guint reload_in_flight : 1;
+  guint reload_pending : 1;
+  guint reloaded : 1;
   
   gint size;
 
@@ -179,6 +212,20 @@ struct _GtkRecentManagerPrivate
 
   guint changed_timeout;
   guint changed_age;
+
+  /* the serial of the last snapshot of the list we took; snapshots
+   * are only ever stored in increasing order, so that a slow writer
+   * cannot replace the file with an older version of the list
+   */
+  guint64 write_serial;
+  RecentWriteData *pending_write;
+
+  /* protects written_serial and stamp, which are updated by the
+   * writer and read by the reloading threads
+   */
+  GMutex write_lock;
+  guint64 written_serial;
+  RecentFileStamp stamp;
 };
 
 enum
@@ -215,6 +262,9 @@ static void     gtk_recent_manager_set_filename        (GtkRecentManager  *manag
 static void     gtk_recent_manager_clamp_to_age        (GtkRecentManager  *manager,
                                                         gint               age);
 static void     gtk_recent_manager_enabled_changed     (GtkRecentManager  *manager);
+static void     gtk_recent_manager_save                (GtkRecentManager  *manager,
+                                                        gboolean           sync);
+static void     gtk_recent_manager_reload              (GtkRecentManager  *manager);
 
 
 static void build_recent_items_list (GtkRecentManager  *manager);
@@ -227,6 +277,8 @@ static void           recent_app_info_free (RecentAppInfo *app_info);
 static GtkRecentInfo *gtk_recent_info_new  (const gchar   *uri);
 static void           gtk_recent_info_free (GtkRecentInfo *recent_info);
 
+static gchar *get_uri_shortname_for_display (const gchar *uri);
+
 static guint signal_changed = 0;
 
 static GtkRecentManager *recent_manager_singleton = NULL;
@@ -265,6 +317,52 @@ has_case_prefix (const gchar *haystack,
   return *n == '\0';
 }
 
+static void
+recent_write_data_free (RecentWriteData *data)
+{
+  g_free (data->filename);
+  g_free (data->contents);
+
+  g_slice_free (RecentWriteData, data);
+}
+
+static void
+recent_load_data_free (RecentLoadData *data)
+{
+  g_free (data->filename);
+
+  if (data->items != NULL)
+    g_bookmark_file_free (data->items);
+
+  g_slice_free (RecentLoadData, data);
+}
+
+static void
+recent_file_stamp_read (const gchar     *filename,
+                        RecentFileStamp *stamp)
+{
+  GStatBuf buf;
+
+  if (g_stat (filename, &buf) < 0)
+    {
+      memset (stamp, 0, sizeof (RecentFileStamp));
+      return;
+    }
+
+  stamp->inode = buf.st_ino;
+  stamp->size = buf.st_size;
+  stamp->mtime = buf.st_mtime;
+}
+
+static gboolean
+recent_file_stamp_equal (const RecentFileStamp *a,
+                         const RecentFileStamp *b)
+{
+  return a->inode == b->inode &&
+         a->size == b->size &&
+         a->mtime == b->mtime;
+}
+
 GQuark
 gtk_recent_manager_error_quark (void)
 {
@@ -352,6 +450,8 @@ gtk_recent_manager_init (GtkRecentManager *manager)
   priv->size = 0;
   priv->filename = NULL;
 
+  g_mutex_init (&priv->write_lock);
+
   settings = gtk_settings_get_default ();
   g_signal_connect_swapped (settings, "notify::gtk-recent-files-enabled",
                             G_CALLBACK (gtk_recent_manager_enabled_changed), manager);
@@ -409,6 +509,11 @@ gtk_recent_manager_finalize (GObject *object)
   if (priv->recent_items != NULL)
     g_bookmark_file_free (priv->recent_items);
 
+  if (priv->pending_write != NULL)
+    recent_write_data_free (priv->pending_write);
+
+  g_mutex_clear (&priv->write_lock);
+
   G_OBJECT_CLASS (gtk_recent_manager_parent_class)->finalize (object);
 }
 
@@ -434,12 +539,11 @@ gtk_recent_manager_dispose (GObject *gobject)
       priv->changed_age = 0;
     }
 
+  /* pending asynchronous writes hold a reference on the manager, so
+   * only changes that have not been handed to a writer yet are left
+   */
   if (priv->is_dirty)
-    {
-      g_object_ref (manager);
-      g_signal_emit (manager, signal_changed, 0);
-      g_object_unref (manager);
-    }
+    gtk_recent_manager_save (manager, TRUE);
 
   G_OBJECT_CLASS (gtk_recent_manager_parent_class)->dispose (gobject);
 }
@@ -451,71 +555,350 @@ gtk_recent_manager_enabled_changed (GtkRecentManager *manager)
   gtk_recent_manager_changed (manager);
 }
 
+/* stores a snapshot of the list; this is called both from the
+ * writer thread and, when syncing, from the main thread
+ */
 static void
-gtk_recent_manager_real_changed (GtkRecentManager *manager)
+recent_manager_store (GtkRecentManager *manager,
+                      RecentWriteData  *data)
 {
   GtkRecentManagerPrivate *priv = manager->priv;
+  GError *write_error;
 
-  g_object_freeze_notify (G_OBJECT (manager));
+  g_mutex_lock (&priv->write_lock);
 
-  if (priv->is_dirty)
+  /* a newer snapshot has been stored in the meantime */
+  if (data->serial <= priv->written_serial)
     {
-      GError *write_error;
-      
-      /* we are marked as dirty, so we dump the content of our
-       * recently used items list
+      g_mutex_unlock (&priv->write_lock);
+      return;
+    }
+
+  /* the contents are written to a temporary file that then replaces
+   * the old one, so readers never see a partially written list
+   */
+  write_error = NULL;
+  if (!g_file_set_contents (data->filename, data->contents, data->length, &write_error))
+    {
+      filename_warning ("Attempting to store changes into `%s', "
+                        "but failed: %s",
+                        data->filename,
+                        write_error->message);
+      g_error_free (write_error);
+    }
+  else if (g_chmod (data->filename, 0600) < 0)
+    {
+      filename_warning ("Attempting to set the permissions of `%s', "
+                        "but failed: %s",
+                        data->filename,
+                        g_strerror (errno));
+    }
+
+  priv->written_serial = data->serial;
+  recent_file_stamp_read (data->filename, &priv->stamp);
+
+  g_mutex_unlock (&priv->write_lock);
+}
+
+static void
+recent_manager_write_thread (GTask        *task,
+                             gpointer      source_object,
+                             gpointer      task_data,
+                             GCancellable *cancellable)
+{
+  recent_manager_store (source_object, task_data);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void recent_manager_queue_write (GtkRecentManager *manager,
+                                        RecentWriteData  *data);
+
+static void
+recent_manager_write_done (GObject      *source_object,
+                           GAsyncResult *result,
+                           gpointer      user_data)
+{
+  GtkRecentManager *manager = GTK_RECENT_MANAGER (source_object);
+  GtkRecentManagerPrivate *priv = manager->priv;
+  RecentWriteData *data;
+
+  priv->write_in_flight = FALSE;
+
+  /* only the latest of the snapshots taken while we were
+   * writing is kept around, so bursts of changes coalesce
+   */
+  if (priv->pending_write != NULL)
+    {
+      data = priv->pending_write;
+      priv->pending_write = NULL;
+
+      recent_manager_queue_write (manager, data);
+    }
+}
+
+static void
+recent_manager_queue_write (GtkRecentManager *manager,
+                            RecentWriteData  *data)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  GTask *task;
+
+  if (priv->write_in_flight)
+    {
+      if (priv->pending_write != NULL)
+        recent_write_data_free (priv->pending_write);
+
+      priv->pending_write = data;
+      return;
+    }
+
+  priv->write_in_flight = TRUE;
+
+  task = g_task_new (manager, NULL, recent_manager_write_done, NULL);
+  g_task_set_task_data (task, data, (GDestroyNotify) recent_write_data_free);
+  g_task_run_in_thread (task, recent_manager_write_thread);
+  g_object_unref (task);
+}
+
+/* dumps the contents of the recently used items list; the list is
+ * serialized on the calling thread, but unless @sync is %TRUE the
+ * file itself is written by a thread
+ */
+static void
+gtk_recent_manager_save (GtkRecentManager *manager,
+                         gboolean          sync)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  RecentWriteData *data;
+  GError *write_error;
+  gchar *contents;
+  gsize length;
+
+  g_assert (priv->filename != NULL);
+
+  if (!priv->recent_items)
+    {
+      /* if no container object has been defined, we create a new
+       * empty container, and dump it
        */
-      g_assert (priv->filename != NULL);
+      priv->recent_items = g_bookmark_file_new ();
+      priv->size = 0;
+    }
+  else
+    {
+      GtkSettings *settings = gtk_settings_get_default ();
+      gint age = 30;
+      gboolean enabled;
+
+      g_object_get (G_OBJECT (settings),
+                    "gtk-recent-files-max-age", &age,
+                    "gtk-recent-files-enabled", &enabled,
+                    NULL);
 
-      if (!priv->recent_items)
+      if (age == 0 || !enabled)
         {
-          /* if no container object has been defined, we create a new
-           * empty container, and dump it
-           */
+          g_bookmark_file_free (priv->recent_items);
           priv->recent_items = g_bookmark_file_new ();
-	  priv->size = 0;
-	}
-      else
+        }
+      else if (age > 0)
+        gtk_recent_manager_clamp_to_age (manager, age);
+    }
+
+  /* mark us as clean */
+  priv->is_dirty = FALSE;
+
+  write_error = NULL;
+  contents = g_bookmark_file_to_data (priv->recent_items, &length, &write_error);
+  if (write_error)
+    {
+      filename_warning ("Attempting to store changes into `%s', "
+                        "but failed: %s",
+                        priv->filename,
+                        write_error->message);
+      g_error_free (write_error);
+      return;
+    }
+
+  data = g_slice_new (RecentWriteData);
+  data->filename = g_strdup (priv->filename);
+  data->contents = contents;
+  data->length = length;
+  data->serial = ++priv->write_serial;
+
+  if (sync)
+    {
+      /* this snapshot supersedes the one waiting for the writer */
+      if (priv->pending_write != NULL)
         {
-          GtkSettings *settings = gtk_settings_get_default ();
-          gint age = 30;
-          gboolean enabled;
+          recent_write_data_free (priv->pending_write);
+          priv->pending_write = NULL;
+        }
+
+      recent_manager_store (manager, data);
+      recent_write_data_free (data);
+    }
+  else
+    recent_manager_queue_write (manager, data);
+}
+
+static void
+recent_manager_load_thread (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+  GtkRecentManager *manager = source_object;
+  GtkRecentManagerPrivate *priv = manager->priv;
+  RecentLoadData *data = task_data;
+  RecentFileStamp stamp;
+  GError *read_error;
+
+  /* every snapshot up to written_serial is on disk before we read
+   * the file, so that is the oldest of our versions it can contain
+   */
+  g_mutex_lock (&priv->write_lock);
+  stamp = priv->stamp;
+  data->written_serial = priv->written_serial;
+  g_mutex_unlock (&priv->write_lock);
+
+  /* skip reparsing the file if it is the one we last wrote or read,
+   * which is what most of the monitor events are about
+   */
+  recent_file_stamp_read (data->filename, &data->stamp);
+  if (recent_file_stamp_equal (&data->stamp, &stamp))
+    {
+      g_task_return_boolean (task, FALSE);
+      return;
+    }
 
-          g_object_get (G_OBJECT (settings),
-                        "gtk-recent-files-max-age", &age,
-                        "gtk-recent-files-enabled", &enabled,
-                        NULL);
+  read_error = NULL;
+  data->items = g_bookmark_file_new ();
+  if (!g_bookmark_file_load_from_file (data->items, data->filename, &read_error))
+    {
+      g_task_return_error (task, read_error);
+      return;
+    }
+
+  g_task_return_boolean (task, TRUE);
+}
 
-          if (age == 0 || !enabled)
+static void
+recent_manager_load_done (GObject      *source_object,
+                          GAsyncResult *result,
+                          gpointer      user_data)
+{
+  GtkRecentManager *manager = GTK_RECENT_MANAGER (source_object);
+  GtkRecentManagerPrivate *priv = manager->priv;
+  RecentLoadData *data;
+  GError *read_error;
+  gint size;
+
+  priv->reload_in_flight = FALSE;
+
+  data = g_task_get_task_data (G_TASK (result));
+
+  read_error = NULL;
+  if (g_task_propagate_boolean (G_TASK (result), &read_error))
+    {
+      /* if the list was changed locally, or the file was read before
+       * our latest snapshot reached it, we keep our version, which is
+       * going to replace the file anyway
+       */
+      if (!priv->is_dirty && data->written_serial == priv->write_serial)
+        {
+          if (priv->recent_items)
+            g_bookmark_file_free (priv->recent_items);
+
+          priv->recent_items = data->items;
+          data->items = NULL;
+
+          g_mutex_lock (&priv->write_lock);
+          priv->stamp = data->stamp;
+          g_mutex_unlock (&priv->write_lock);
+
+          size = g_bookmark_file_get_size (priv->recent_items);
+          if (priv->size != size)
             {
-              g_bookmark_file_free (priv->recent_items);
-              priv->recent_items = g_bookmark_file_new ();
+              priv->size = size;
+
+              g_object_notify (G_OBJECT (manager), "size");
             }
-          else if (age > 0)
-            gtk_recent_manager_clamp_to_age (manager, age);
+
+          priv->reloaded = TRUE;
+          g_signal_emit (manager, signal_changed, 0);
         }
+    }
+  else if (read_error)
+    {
+      if (read_error->domain == G_FILE_ERROR &&
+          read_error->code != G_FILE_ERROR_NOENT)
+        filename_warning ("Attempting to read the recently used resources "
+                          "file at `%s', but the parser failed: %s.",
+                          data->filename,
+                          read_error->message);
 
-      write_error = NULL;
-      g_bookmark_file_to_file (priv->recent_items, priv->filename, &write_error);
-      if (write_error)
-        {
-          filename_warning ("Attempting to store changes into `%s', "
-			    "but failed: %s",
-			    priv->filename,
-			    write_error->message);
-	  g_error_free (write_error);
-	}
+      g_error_free (read_error);
+    }
 
-      if (g_chmod (priv->filename, 0600) < 0)
-        {
-          filename_warning ("Attempting to set the permissions of `%s', "
-                            "but failed: %s",
-                            priv->filename,
-                            g_strerror (errno));
-        }
+  if (priv->reload_pending)
+    {
+      priv->reload_pending = FALSE;
+      gtk_recent_manager_reload (manager);
+    }
+}
+
+/* picks up changes made to the file by others; the file is parsed
+ * by a thread, and the "changed" signal is emitted once the new
+ * list is in place
+ */
+static void
+gtk_recent_manager_reload (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  RecentLoadData *data;
+  GTask *task;
+
+  if (priv->filename == NULL)
+    return;
+
+  if (priv->reload_in_flight)
+    {
+      priv->reload_pending = TRUE;
+      return;
+    }
+
+  data = g_slice_new0 (RecentLoadData);
+  data->filename = g_strdup (priv->filename);
+
+  priv->reload_in_flight = TRUE;
+
+  task = g_task_new (manager, NULL, recent_manager_load_done, NULL);
+  g_task_set_task_data (task, data, (GDestroyNotify) recent_load_data_free);
+  g_task_run_in_thread (task, recent_manager_load_thread);
+  g_object_unref (task);
+}
+
+static void
+gtk_recent_manager_real_changed (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
 
-      /* mark us as clean */
-      priv->is_dirty = FALSE;
+  g_object_freeze_notify (G_OBJECT (manager));
+
+  if (priv->is_dirty)
+    {
+      /* we are marked as dirty, so we dump the content of our
+       * recently used items list
+       */
+      gtk_recent_manager_save (manager, FALSE);
+    }
+  else if (priv->reloaded)
+    {
+      /* we are being emitted because the list has just been
+       * reloaded from the file
+       */
+      priv->reloaded = FALSE;
     }
   else
     {
@@ -523,7 +906,7 @@ gtk_recent_manager_real_changed (GtkRecentManager *manager)
        * because the recently used resources file has been
        * changed (and not from us).
        */
-      build_recent_items_list (manager);
+      gtk_recent_manager_reload (manager);
     }
 
   g_object_thaw_notify (G_OBJECT (manager));
@@ -543,7 +926,7 @@ gtk_recent_manager_monitor_changed (GFileMonitor      *monitor,
     case G_FILE_MONITOR_EVENT_CHANGED:
     case G_FILE_MONITOR_EVENT_CREATED:
       gdk_threads_enter ();
-      gtk_recent_manager_changed (manager);
+      gtk_recent_manager_reload (manager);
       gdk_threads_leave ();
       break;
 
@@ -700,6 +1083,10 @@ build_recent_items_list (GtkRecentManager *manager)
         }
     }
 
+  g_mutex_lock (&priv->write_lock);
+  recent_file_stamp_read (priv->filename, &priv->stamp);
+  g_mutex_unlock (&priv->write_lock);
+
   priv->is_dirty = FALSE;
 }
 
@@ -1323,6 +1710,184 @@ gtk_recent_manager_get_items (GtkRecentManager *manager)
   return retval;
 }
 
+typedef struct
+{
+  const gchar *uri;
+  time_t modified;
+} RecentQueryItem;
+
+static gint
+recent_query_item_compare (gconstpointer a,
+                           gconstpointer b,
+                           gpointer      user_data)
+{
+  const RecentQueryItem *item_a = a;
+  const RecentQueryItem *item_b = b;
+
+  if (item_a->modified < item_b->modified)
+    return 1;
+  else if (item_a->modified > item_b->modified)
+    return -1;
+
+  return 0;
+}
+
+/* like filtering a #GtkRecentInfo, but only reads the fields
+ * that @filter needs out of the bookmarks
+ */
+static gboolean
+recent_item_is_filtered (GBookmarkFile   *bookmarks,
+                         const gchar     *uri,
+                         time_t           modified,
+                         time_t           now,
+                         GtkRecentFilter *filter)
+{
+  GtkRecentFilterInfo filter_info;
+  GtkRecentFilterFlags needed;
+  gchar *mime_type;
+  gchar *display_name = NULL;
+  gchar **applications = NULL;
+  gchar **groups = NULL;
+  gboolean retval;
+
+  needed = gtk_recent_filter_get_needed (filter);
+
+  mime_type = g_bookmark_file_get_mime_type (bookmarks, uri, NULL);
+
+  filter_info.contains = GTK_RECENT_FILTER_URI | GTK_RECENT_FILTER_MIME_TYPE;
+  filter_info.uri = uri;
+  filter_info.mime_type = mime_type ? mime_type : GTK_RECENT_DEFAULT_MIME;
+  filter_info.display_name = NULL;
+  filter_info.applications = NULL;
+  filter_info.groups = NULL;
+  filter_info.age = -1;
+
+  if (needed & GTK_RECENT_FILTER_DISPLAY_NAME)
+    {
+      display_name = g_bookmark_file_get_title (bookmarks, uri, NULL);
+      if (!display_name)
+        display_name = get_uri_shortname_for_display (uri);
+
+      filter_info.display_name = display_name;
+      filter_info.contains |= GTK_RECENT_FILTER_DISPLAY_NAME;
+    }
+
+  if (needed & GTK_RECENT_FILTER_APPLICATION)
+    {
+      applications = g_bookmark_file_get_applications (bookmarks, uri, NULL, NULL);
+
+      filter_info.applications = (const gchar **) applications;
+      filter_info.contains |= GTK_RECENT_FILTER_APPLICATION;
+    }
+
+  if (needed & GTK_RECENT_FILTER_GROUP)
+    {
+      groups = g_bookmark_file_get_groups (bookmarks, uri, NULL, NULL);
+
+      filter_info.groups = (const gchar **) groups;
+      filter_info.contains |= GTK_RECENT_FILTER_GROUP;
+    }
+
+  if (needed & GTK_RECENT_FILTER_AGE)
+    {
+      filter_info.age = (gint) ((now - modified) / (60 * 60 * 24));
+      filter_info.contains |= GTK_RECENT_FILTER_AGE;
+    }
+
+  retval = gtk_recent_filter_filter (filter, &filter_info);
+
+  g_free (mime_type);
+  g_free (display_name);
+  g_strfreev (applications);
+  g_strfreev (groups);
+
+  return !retval;
+}
+
+/**
+ * gtk_recent_manager_query_items:
+ * @manager: a #GtkRecentManager
+ * @filter: (allow-none): a #GtkRecentFilter, or %NULL
+ * @limit: the maximum number of items to return, or -1 for no limit
+ *
+ * Gets the most recently modified resources matching @filter, sorted
+ * from the most recently modified one to the least recently modified
+ * one.
+ *
+ * Unlike gtk_recent_manager_get_items(), this function only builds a
+ * #GtkRecentInfo for the resources it returns, and it only looks at
+ * the data of a resource that @filter needs to decide whether it
+ * matches, so it is cheap even on long lists of recently used
+ * resources.
+ *
+ * Return value: (element-type GtkRecentInfo) (transfer full): a list of
+ *   newly allocated #GtkRecentInfo objects. Use
+ *   gtk_recent_info_unref() on each item inside the list, and then
+ *   free the list itself using g_list_free().
+ *
+ * Since: 3.12
+ */
+GList *
+gtk_recent_manager_query_items (GtkRecentManager *manager,
+                                GtkRecentFilter  *filter,
+                                gint              limit)
+{
+  GtkRecentManagerPrivate *priv;
+  RecentQueryItem *items;
+  GList *retval = NULL;
+  gchar **uris;
+  gsize uris_len, i;
+  gint n_items;
+  time_t now;
+
+  g_return_val_if_fail (GTK_IS_RECENT_MANAGER (manager), NULL);
+  g_return_val_if_fail (filter == NULL || GTK_IS_RECENT_FILTER (filter), NULL);
+
+  priv = manager->priv;
+  if (!priv->recent_items || limit == 0)
+    return NULL;
+
+  uris = g_bookmark_file_get_uris (priv->recent_items, &uris_len);
+
+  /* sort on the modification time alone; everything else is only
+   * looked at once an item is a candidate for the result
+   */
+  items = g_new (RecentQueryItem, uris_len);
+  for (i = 0; i < uris_len; i++)
+    {
+      items[i].uri = uris[i];
+      items[i].modified = g_bookmark_file_get_modified (priv->recent_items, uris[i], NULL);
+    }
+
+  g_qsort_with_data (items, uris_len, sizeof (RecentQueryItem),
+                     recent_query_item_compare, NULL);
+
+  now = time (NULL);
+  n_items = 0;
+
+  for (i = 0; i < uris_len && (limit < 0 || n_items < limit); i++)
+    {
+      GtkRecentInfo *info;
+
+      if (filter &&
+          recent_item_is_filtered (priv->recent_items,
+                                   items[i].uri, items[i].modified,
+                                   now, filter))
+        continue;
+
+      info = gtk_recent_info_new (items[i].uri);
+      build_recent_info (priv->recent_items, info);
+
+      retval = g_list_prepend (retval, info);
+      n_items += 1;
+    }
+
+  g_free (items);
+  g_strfreev (uris);
+
+  return g_list_reverse (retval);
+}
+
 static void
 purge_recent_items_list (GtkRecentManager  *manager,
 			 GError           **error)
@@ -2498,8 +3063,9 @@ _gtk_recent_manager_sync (void)
 {
   if (recent_manager_singleton)
     {
-      /* force a dump of the contents of the recent manager singleton */
-      recent_manager_singleton->priv->is_dirty = TRUE;
-      gtk_recent_manager_real_changed (recent_manager_singleton);
+      /* force a dump of the contents of the recent manager singleton,
+       * without waiting for the writer thread
+       */
+      gtk_recent_manager_save (recent_manager_singleton, TRUE);
     }
 }
@@ -27,6 +27,7 @@
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gdk/gdk.h>
+#include <gtk/gtkrecentfilter.h>
 #include <time.h>
 
 G_BEGIN_DECLS
@@ -182,6 +183,9 @@ gboolean          gtk_recent_manager_move_item      (GtkRecentManager     *manag
 						     const gchar          *new_uri,
 						     GError              **error);
 GList *           gtk_recent_manager_get_items      (GtkRecentManager     *manager);
+GList *           gtk_recent_manager_query_items    (GtkRecentManager     *manager,
+                                                     GtkRecentFilter      *filter,
+                                                     gint                  limit);
 gint              gtk_recent_manager_purge_items    (GtkRecentManager     *manager,
 						     GError              **error);
 
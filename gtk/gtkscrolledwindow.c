@@ -28,7 +28,9 @@
 
 #include <math.h>
 
+#include "gtkadjustmentprivate.h"
 #include "gtkbindings.h"
+#include "gtkcontainerprivate.h"
 #include "gtkmarshalers.h"
 #include "gtkscrollable.h"
 #include "gtkscrollbar.h"
@@ -122,6 +124,9 @@
 
 #define DEFAULT_SCROLLBAR_SPACING  3
 
+/* Duration of animated wheel scrolling, in milliseconds */
+#define SMOOTH_SCROLL_DURATION 200
+
 struct _GtkScrolledWindowPrivate
 {
   GtkWidget     *hscrollbar;
@@ -137,6 +142,7 @@ struct _GtkScrolledWindowPrivate
   guint    vscrollbar_visible     : 1;
   guint    window_placement       : 2;
   guint    focus_out              : 1; /* Flag used by ::move-focus-out implementation */
+  guint    smooth_scrolling       : 1;
 
   gint     min_content_width;
   gint     min_content_height;
@@ -153,7 +159,8 @@ enum {
   PROP_WINDOW_PLACEMENT_SET,
   PROP_SHADOW_TYPE,
   PROP_MIN_CONTENT_WIDTH,
-  PROP_MIN_CONTENT_HEIGHT
+  PROP_MIN_CONTENT_HEIGHT,
+  PROP_SMOOTH_SCROLLING
 };
 
 /* Signals */
@@ -174,6 +181,7 @@ static void     gtk_scrolled_window_get_property       (GObject           *objec
                                                         GParamSpec        *pspec);
 
 static void     gtk_scrolled_window_destroy            (GtkWidget         *widget);
+static void     gtk_scrolled_window_unrealize          (GtkWidget         *widget);
 static void     gtk_scrolled_window_screen_changed     (GtkWidget         *widget,
                                                         GdkScreen         *previous_screen);
 static gboolean gtk_scrolled_window_draw               (GtkWidget         *widget,
@@ -272,6 +280,7 @@ gtk_scrolled_window_class_init (GtkScrolledWindowClass *class)
   gobject_class->get_property = gtk_scrolled_window_get_property;
 
   widget_class->destroy = gtk_scrolled_window_destroy;
+  widget_class->unrealize = gtk_scrolled_window_unrealize;
   widget_class->screen_changed = gtk_scrolled_window_screen_changed;
   widget_class->draw = gtk_scrolled_window_draw;
   widget_class->size_allocate = gtk_scrolled_window_size_allocate;
@@ -409,6 +418,23 @@ gtk_scrolled_window_class_init (GtkScrolledWindowClass *class)
                                                      P_("The minimum height that the scrolled window will allocate to its content"),
                                                      -1, G_MAXINT, -1,
                                                      GTK_PARAM_READWRITE));
+
+  /**
+   * GtkScrolledWindow:smooth-scrolling:
+   *
+   * Whether scrolling with the mouse wheel or touchpad animates the
+   * content to its new position over several frames instead of
+   * moving it in one step.
+   *
+   * Since: 3.12
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_SMOOTH_SCROLLING,
+                                   g_param_spec_boolean ("smooth-scrolling",
+                                                         P_("Smooth Scrolling"),
+                                                         P_("Whether scrolling is animated"),
+                                                         FALSE,
+                                                         GTK_PARAM_READWRITE));
   /**
    * GtkScrolledWindow::scroll-child:
    * @scrolled_window: a #GtkScrolledWindow
@@ -508,6 +534,11 @@ gtk_scrolled_window_init (GtkScrolledWindow *scrolled_window)
   gtk_scrolled_window_update_real_placement (scrolled_window);
   priv->min_content_width = -1;
   priv->min_content_height = -1;
+
+  /* with scrollbars in both directions our size does not depend
+   * on the size of the child
+   */
+  _gtk_container_set_layout_boundary (GTK_CONTAINER (scrolled_window), TRUE);
 }
 
 /**
@@ -788,6 +819,10 @@ gtk_scrolled_window_set_policy (GtkScrolledWindow *scrolled_window,
       priv->hscrollbar_policy = hscrollbar_policy;
       priv->vscrollbar_policy = vscrollbar_policy;
 
+      _gtk_container_set_layout_boundary (GTK_CONTAINER (scrolled_window),
+                                          hscrollbar_policy != GTK_POLICY_NEVER &&
+                                          vscrollbar_policy != GTK_POLICY_NEVER);
+
       gtk_widget_queue_resize (GTK_WIDGET (scrolled_window));
 
       g_object_freeze_notify (object);
@@ -1036,6 +1071,25 @@ gtk_scrolled_window_destroy (GtkWidget *widget)
   GTK_WIDGET_CLASS (gtk_scrolled_window_parent_class)->destroy (widget);
 }
 
+static void
+gtk_scrolled_window_unrealize (GtkWidget *widget)
+{
+  GtkScrolledWindowPrivate *priv = GTK_SCROLLED_WINDOW (widget)->priv;
+  GdkFrameClock *clock;
+
+  /* don't keep wheel scrolling queued on a frame clock we lose */
+  clock = gtk_widget_get_frame_clock (widget);
+  if (clock)
+    {
+      if (priv->hscrollbar)
+        _gtk_adjustment_cancel_queued_value (gtk_range_get_adjustment (GTK_RANGE (priv->hscrollbar)), clock);
+      if (priv->vscrollbar)
+        _gtk_adjustment_cancel_queued_value (gtk_range_get_adjustment (GTK_RANGE (priv->vscrollbar)), clock);
+    }
+
+  GTK_WIDGET_CLASS (gtk_scrolled_window_parent_class)->unrealize (widget);
+}
+
 static void
 gtk_scrolled_window_set_property (GObject      *object,
 				  guint         prop_id,
@@ -1086,6 +1140,10 @@ gtk_scrolled_window_set_property (GObject      *object,
       gtk_scrolled_window_set_min_content_height (scrolled_window,
                                                   g_value_get_int (value));
       break;
+    case PROP_SMOOTH_SCROLLING:
+      gtk_scrolled_window_set_smooth_scrolling (scrolled_window,
+                                                g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1132,6 +1190,9 @@ gtk_scrolled_window_get_property (GObject    *object,
     case PROP_MIN_CONTENT_HEIGHT:
       g_value_set_int (value, priv->min_content_height);
       break;
+    case PROP_SMOOTH_SCROLLING:
+      g_value_set_boolean (value, priv->smooth_scrolling);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1891,6 +1952,33 @@ gtk_scrolled_window_size_allocate (GtkWidget     *widget,
     }
 }
 
+/* Scrolls @range by @steps wheel steps in @direction. The adjustment
+ * is updated on the next frame, so that all scroll events arriving
+ * within one frame cause a single update of the scrolled child.
+ */
+static gboolean
+gtk_scrolled_window_scroll_range (GtkScrolledWindow  *scrolled_window,
+                                  GtkWidget          *range,
+                                  GdkScrollDirection  direction,
+                                  gdouble             steps)
+{
+  GtkAdjustment *adjustment;
+  gdouble delta;
+
+  if (range == NULL || !gtk_widget_get_visible (range))
+    return FALSE;
+
+  adjustment = gtk_range_get_adjustment (GTK_RANGE (range));
+  delta = _gtk_range_get_wheel_delta (GTK_RANGE (range), direction) * steps;
+
+  _gtk_adjustment_queue_value (adjustment,
+                               gtk_widget_get_frame_clock (GTK_WIDGET (scrolled_window)),
+                               _gtk_adjustment_get_target_value (adjustment) + delta,
+                               scrolled_window->priv->smooth_scrolling ? SMOOTH_SCROLL_DURATION : 0);
+
+  return TRUE;
+}
+
 static gboolean
 gtk_scrolled_window_scroll_event (GtkWidget      *widget,
 				  GdkEventScroll *event)
@@ -1905,24 +1993,34 @@ gtk_scrolled_window_scroll_event (GtkWidget      *widget,
   scrolled_window = GTK_SCROLLED_WINDOW (widget);
   priv = scrolled_window->priv;
 
-  if (event->direction == GDK_SCROLL_UP || event->direction == GDK_SCROLL_DOWN)
-    range = priv->vscrollbar;
-  else
-    range = priv->hscrollbar;
-
-  if (range && gtk_widget_get_visible (range))
+  if (event->direction == GDK_SCROLL_SMOOTH)
     {
-      GtkAdjustment *adjustment = gtk_range_get_adjustment (GTK_RANGE (range));
-      gdouble delta;
-
-      delta = _gtk_range_get_wheel_delta (GTK_RANGE (range), event->direction);
+      gdouble delta_x, delta_y;
+      gboolean handled = FALSE;
 
-      gtk_adjustment_set_value (adjustment, gtk_adjustment_get_value (adjustment) + delta);
+      if (gdk_event_get_scroll_deltas ((GdkEvent *) event, &delta_x, &delta_y))
+        {
+          if (delta_x != 0.0 &&
+              gtk_scrolled_window_scroll_range (scrolled_window, priv->hscrollbar,
+                                                GDK_SCROLL_RIGHT, delta_x))
+            handled = TRUE;
+
+          if (delta_y != 0.0 &&
+              gtk_scrolled_window_scroll_range (scrolled_window, priv->vscrollbar,
+                                                GDK_SCROLL_DOWN, delta_y))
+            handled = TRUE;
+        }
 
-      return TRUE;
+      return handled;
     }
 
-  return FALSE;
+  if (event->direction == GDK_SCROLL_UP || event->direction == GDK_SCROLL_DOWN)
+    range = priv->vscrollbar;
+  else
+    range = priv->hscrollbar;
+
+  return gtk_scrolled_window_scroll_range (scrolled_window, range,
+                                           event->direction, 1.0);
 }
 
 static gboolean
@@ -2448,3 +2546,52 @@ gtk_scrolled_window_set_min_content_height (GtkScrolledWindow *scrolled_window,
       g_object_notify (G_OBJECT (scrolled_window), "min-content-height");
     }
 }
+
+/**
+ * gtk_scrolled_window_set_smooth_scrolling:
+ * @scrolled_window: a #GtkScrolledWindow
+ * @smooth_scrolling: %TRUE to animate scrolling
+ *
+ * Sets whether scrolling @scrolled_window with the mouse wheel or a
+ * touchpad moves the content to its new position over several frames
+ * instead of in one step.
+ *
+ * Since: 3.12
+ */
+void
+gtk_scrolled_window_set_smooth_scrolling (GtkScrolledWindow *scrolled_window,
+                                          gboolean           smooth_scrolling)
+{
+  GtkScrolledWindowPrivate *priv;
+
+  g_return_if_fail (GTK_IS_SCROLLED_WINDOW (scrolled_window));
+
+  priv = scrolled_window->priv;
+  smooth_scrolling = smooth_scrolling != FALSE;
+
+  if (priv->smooth_scrolling != smooth_scrolling)
+    {
+      priv->smooth_scrolling = smooth_scrolling;
+
+      g_object_notify (G_OBJECT (scrolled_window), "smooth-scrolling");
+    }
+}
+
+/**
+ * gtk_scrolled_window_get_smooth_scrolling:
+ * @scrolled_window: a #GtkScrolledWindow
+ *
+ * Returns whether scrolling @scrolled_window is animated. See
+ * gtk_scrolled_window_set_smooth_scrolling().
+ *
+ * Returns: %TRUE if scrolling is animated
+ *
+ * Since: 3.12
+ */
+gboolean
+gtk_scrolled_window_get_smooth_scrolling (GtkScrolledWindow *scrolled_window)
+{
+  g_return_val_if_fail (GTK_IS_SCROLLED_WINDOW (scrolled_window), FALSE);
+
+  return scrolled_window->priv->smooth_scrolling;
+}
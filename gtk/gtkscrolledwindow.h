@@ -117,6 +117,9 @@ void           gtk_scrolled_window_set_min_content_width  (GtkScrolledWindow *sc
 gint           gtk_scrolled_window_get_min_content_height (GtkScrolledWindow *scrolled_window);
 void           gtk_scrolled_window_set_min_content_height (GtkScrolledWindow *scrolled_window,
                                                            gint               height);
+void           gtk_scrolled_window_set_smooth_scrolling   (GtkScrolledWindow *scrolled_window,
+                                                           gboolean           smooth_scrolling);
+gboolean       gtk_scrolled_window_get_smooth_scrolling   (GtkScrolledWindow *scrolled_window);
 
 gint _gtk_scrolled_window_get_scrollbar_spacing (GtkScrolledWindow *scrolled_window);
 
@@ -37,6 +37,11 @@
 static GQuark recursion_check_quark = 0;
 #endif /* G_DISABLE_CHECKS */
 
+/* the number of times a widget had to be measured because
+ * its size was not cached
+ */
+static guint n_measured = 0;
+
 static void
 push_recursion_check (GtkWidget       *widget,
                       GtkOrientation   orientation,
@@ -120,6 +125,8 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
     {
       gint adjusted_min, adjusted_natural, adjusted_for_size = for_size;
 
+      n_measured++;
+
       gtk_widget_ensure_style (widget);
 
       if (orientation == GTK_ORIENTATION_HORIZONTAL)
@@ -252,6 +259,19 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
                      found_in_cache ? "yes" : "no"));
 }
 
+/*
+ * _gtk_size_request_get_n_measured:
+ *
+ * Returns the number of size requests that were not answered
+ * from the cache so far; used to show how many widgets a resize
+ * had to measure again.
+ */
+guint
+_gtk_size_request_get_n_measured (void)
+{
+  return n_measured;
+}
+
 /* This is the main function that checks for a cached size and
  * possibly queries the widget class to compute the size if it's
  * not cached. If the for_size here is -1, then get_preferred_width()
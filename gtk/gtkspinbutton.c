@@ -39,6 +39,7 @@
 #include "gtkspinbutton.h"
 #include "gtkentryprivate.h"
 #include "gtkmarshalers.h"
+#include "gtkpango.h"
 #include "gtksettings.h"
 #include "gtkprivate.h"
 #include "gtkintl.h"
@@ -883,8 +884,8 @@ gtk_spin_button_get_preferred_width (GtkWidget *widget,
       font_desc = gtk_style_context_get_font (style_context, 0);
 
       context = gtk_widget_get_pango_context (widget);
-      metrics = pango_context_get_metrics (context, font_desc,
-                                           pango_context_get_language (context));
+      metrics = _gtk_pango_context_get_metrics (context, font_desc,
+                                                pango_context_get_language (context));
 
       digit_width = pango_font_metrics_get_approximate_digit_width (metrics);
       digit_width = PANGO_SCALE *
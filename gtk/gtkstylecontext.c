@@ -359,6 +359,7 @@ struct _GtkStyleContextPrivate
 
   GtkStyleContext *parent;
   GSList *children;
+  GSList *invalid_children;     /* children that are invalid or have invalid descendants */
   GtkWidget *widget;
   GtkWidgetPath *widget_path;
   GHashTable *style_data;
@@ -371,9 +372,10 @@ struct _GtkStyleContextPrivate
   GtkCssChange relevant_changes;
   GtkCssChange pending_changes;
 
-  const GtkBitmask *invalidating_context;
+  const GtkCssPropertySet *invalidating_context;
   guint animating : 1;
   guint invalid : 1;
+  guint invalid_queued : 1;     /* in parent's invalid_children */
 };
 
 enum {
@@ -975,10 +977,10 @@ create_query_path (GtkStyleContext *context,
 }
 
 static void
-build_properties (GtkStyleContext      *context,
-                  GtkCssComputedValues *values,
-                  GtkStyleInfo         *info,
-                  const GtkBitmask     *relevant_changes)
+build_properties (GtkStyleContext         *context,
+                  GtkCssComputedValues    *values,
+                  GtkStyleInfo            *info,
+                  const GtkCssPropertySet *relevant_changes)
 {
   GtkStyleContextPrivate *priv;
   GtkCssMatcher matcher;
@@ -1057,26 +1059,65 @@ style_data_lookup_for_state (GtkStyleContext *context,
   return data;
 }
 
+static gboolean
+gtk_style_context_has_invalid_subtree (GtkStyleContext *context)
+{
+  return context->priv->invalid || context->priv->invalid_children != NULL;
+}
+
+static void gtk_style_context_queue_invalid_child (GtkStyleContext *context,
+                                                   GtkStyleContext *child);
+
+/* Called when @context goes from having a valid subtree
+ * to having an invalid one */
+static void
+gtk_style_context_propagate_invalid (GtkStyleContext *context)
+{
+  GtkStyleContextPrivate *priv = context->priv;
+
+  if (GTK_IS_RESIZE_CONTAINER (priv->widget))
+    _gtk_container_queue_restyle (GTK_CONTAINER (priv->widget));
+  else if (priv->parent)
+    gtk_style_context_queue_invalid_child (priv->parent, context);
+}
+
+static void
+gtk_style_context_queue_invalid_child (GtkStyleContext *context,
+                                       GtkStyleContext *child)
+{
+  GtkStyleContextPrivate *priv = context->priv;
+  gboolean was_invalid;
+
+  if (child->priv->invalid_queued)
+    return;
+
+  was_invalid = gtk_style_context_has_invalid_subtree (context);
+
+  child->priv->invalid_queued = TRUE;
+  priv->invalid_children = g_slist_prepend (priv->invalid_children, child);
+
+  if (!was_invalid)
+    gtk_style_context_propagate_invalid (context);
+}
+
 static void
 gtk_style_context_set_invalid (GtkStyleContext *context,
                                gboolean         invalid)
 {
   GtkStyleContextPrivate *priv;
+  gboolean was_invalid;
   
   priv = context->priv;
 
   if (priv->invalid == invalid)
     return;
 
+  was_invalid = gtk_style_context_has_invalid_subtree (context);
+
   priv->invalid = invalid;
 
-  if (invalid)
-    {
-      if (GTK_IS_RESIZE_CONTAINER (priv->widget))
-        _gtk_container_queue_restyle (GTK_CONTAINER (priv->widget));
-      else if (priv->parent)
-        gtk_style_context_set_invalid (priv->parent, TRUE);
-    }
+  if (invalid && !was_invalid)
+    gtk_style_context_propagate_invalid (context);
 }
 
 /* returns TRUE if someone called gtk_style_context_save() but hasn't
@@ -1090,6 +1131,12 @@ gtk_style_context_is_saved (GtkStyleContext *context)
   return context->priv->info->next != NULL;
 }
 
+gboolean
+_gtk_style_context_is_saved (GtkStyleContext *context)
+{
+  return gtk_style_context_is_saved (context);
+}
+
 static void
 gtk_style_context_queue_invalidate_internal (GtkStyleContext *context,
                                              GtkCssChange     change)
@@ -1687,12 +1734,18 @@ gtk_style_context_set_parent (GtkStyleContext *context,
   if (priv->parent == parent)
     return;
 
+  if (priv->invalid_queued)
+    {
+      priv->parent->priv->invalid_children = g_slist_remove (priv->parent->priv->invalid_children, context);
+      priv->invalid_queued = FALSE;
+    }
+
   if (parent)
     {
       parent->priv->children = g_slist_prepend (parent->priv->children, context);
       g_object_ref (parent);
-      if (priv->invalid)
-        gtk_style_context_set_invalid (parent, TRUE);
+      if (gtk_style_context_has_invalid_subtree (context))
+        gtk_style_context_queue_invalid_child (parent, context);
     }
 
   if (priv->parent)
@@ -2328,7 +2381,7 @@ _gtk_style_context_peek_style_property (GtkStyleContext *context,
 
   if (priv->widget || priv->widget_path)
     {
-      GtkWidgetPath *widget_path = priv->widget ? _gtk_widget_create_path (priv->widget) : priv->widget_path;
+      GtkWidgetPath *widget_path = priv->widget ? gtk_widget_get_path (priv->widget) : priv->widget_path;
 
       if (gtk_style_provider_get_style_property (GTK_STYLE_PROVIDER (priv->cascade),
                                                  widget_path,
@@ -2370,14 +2423,8 @@ _gtk_style_context_peek_style_property (GtkStyleContext *context,
               gtk_symbolic_color_unref (color);
             }
 
-          if (priv->widget)
-            gtk_widget_path_free (widget_path);
-
           return &pcache->value;
         }
-
-      if (priv->widget)
-        gtk_widget_path_free (widget_path);
     }
 
   /* not supplied by any provider, revert to default */
@@ -3102,14 +3149,14 @@ gtk_style_context_clear_cache (GtkStyleContext *context)
 }
 
 static void
-gtk_style_context_update_cache (GtkStyleContext  *context,
-                                const GtkBitmask *parent_changes)
+gtk_style_context_update_cache (GtkStyleContext         *context,
+                                const GtkCssPropertySet *parent_changes)
 {
   GtkStyleContextPrivate *priv;
   GHashTableIter iter;
   gpointer key, value;
 
-  if (_gtk_bitmask_is_empty (parent_changes))
+  if (_gtk_css_property_set_is_empty (parent_changes))
     return;
 
   priv = context->priv;
@@ -3119,20 +3166,18 @@ gtk_style_context_update_cache (GtkStyleContext  *context,
     {
       GtkStyleInfo *info = key;
       StyleData *data = value;
-      GtkBitmask *changes;
+      GtkCssPropertySet changes;
 
-      changes = _gtk_css_computed_values_compute_dependencies (data->store, parent_changes);
+      _gtk_css_computed_values_compute_dependencies (data->store, parent_changes, &changes);
 
-      if (!_gtk_bitmask_is_empty (changes))
-	build_properties (context, data->store, info, changes);
-
-      _gtk_bitmask_free (changes);
+      if (!_gtk_css_property_set_is_empty (&changes))
+	build_properties (context, data->store, info, &changes);
     }
 }
 
 static void
-gtk_style_context_do_invalidate (GtkStyleContext  *context,
-                                 const GtkBitmask *changes)
+gtk_style_context_do_invalidate (GtkStyleContext         *context,
+                                 const GtkCssPropertySet *changes)
 {
   GtkStyleContextPrivate *priv;
 
@@ -3151,22 +3196,21 @@ gtk_style_context_do_invalidate (GtkStyleContext  *context,
   priv->invalidating_context = NULL;
 }
 
-static GtkBitmask *
-gtk_style_context_update_animations (GtkStyleContext *context,
-                                     gint64           timestamp)
+static void
+gtk_style_context_update_animations (GtkStyleContext   *context,
+                                     gint64             timestamp,
+                                     GtkCssPropertySet *changes)
 {
-  GtkBitmask *differences;
   StyleData *style_data;
   
   style_data = style_data_lookup (context);
 
-  differences = _gtk_css_computed_values_advance (style_data->store,
-                                                  timestamp);
+  _gtk_css_computed_values_advance (style_data->store,
+                                    timestamp,
+                                    changes);
 
   if (_gtk_css_computed_values_is_static (style_data->store))
     _gtk_style_context_update_animating (context);
-
-  return differences;
 }
 
 static gboolean
@@ -3230,19 +3274,50 @@ gtk_style_context_should_create_transitions (GtkStyleContext *context)
   return animate;
 }
 
-void
-_gtk_style_context_validate (GtkStyleContext  *context,
-                             gint64            timestamp,
-                             GtkCssChange      change,
-                             const GtkBitmask *parent_changes)
+/* Validates only the children that are invalid themselves or have
+ * invalid descendants, for when nothing changed that would affect
+ * the other children.
+ */
+static guint
+gtk_style_context_validate_invalid_children (GtkStyleContext         *context,
+                                             gint64                   timestamp,
+                                             const GtkCssPropertySet *empty)
+{
+  GtkStyleContextPrivate *priv = context->priv;
+  GSList *invalid, *list;
+  guint n_visited = 0;
+
+  invalid = priv->invalid_children;
+  priv->invalid_children = NULL;
+
+  for (list = invalid; list; list = list->next)
+    {
+      GtkStyleContext *child = list->data;
+
+      child->priv->invalid_queued = FALSE;
+      n_visited += _gtk_style_context_validate (child, timestamp, 0, empty);
+    }
+
+  g_slist_free (invalid);
+
+  return n_visited;
+}
+
+/* Returns the number of style contexts that were visited */
+guint
+_gtk_style_context_validate (GtkStyleContext         *context,
+                             gint64                   timestamp,
+                             GtkCssChange             change,
+                             const GtkCssPropertySet *parent_changes)
 {
   GtkStyleContextPrivate *priv;
   GtkStyleInfo *info;
   StyleData *current;
-  GtkBitmask *changes;
+  GtkCssPropertySet changes;
   GSList *list;
+  guint n_visited = 1;
 
-  g_return_if_fail (GTK_IS_STYLE_CONTEXT (context));
+  g_return_val_if_fail (GTK_IS_STYLE_CONTEXT (context), 0);
 
   priv = context->priv;
 
@@ -3263,8 +3338,14 @@ _gtk_style_context_validate (GtkStyleContext  *context,
   if (G_UNLIKELY (gtk_get_debug_flags () & GTK_DEBUG_NO_CSS_CACHE))
     change = GTK_CSS_CHANGE_ANY;
 
-  if (!priv->invalid && change == 0 && _gtk_bitmask_is_empty (parent_changes))
-    return;
+  if (!priv->invalid && change == 0 && _gtk_css_property_set_is_empty (parent_changes))
+    {
+      /* Our style is fine, only walk down to the invalid descendants */
+      if (priv->invalid_children)
+        n_visited += gtk_style_context_validate_invalid_children (context, timestamp, parent_changes);
+
+      return n_visited;
+    }
 
   priv->pending_changes = 0;
   gtk_style_context_set_invalid (context, FALSE);
@@ -3307,20 +3388,19 @@ _gtk_style_context_validate (GtkStyleContext  *context,
 
       if (current)
         {
-          changes = _gtk_css_computed_values_get_difference (data->store, current->store);
+          _gtk_css_computed_values_get_difference (data->store, current->store, &changes);
 
           /* In the case where we keep the cache, we want unanimated values */
           _gtk_css_computed_values_cancel_animations (current->store);
         }
       else
         {
-          changes = _gtk_bitmask_new ();
-          changes = _gtk_bitmask_invert_range (changes, 0, _gtk_css_style_property_get_n_properties ());
+          _gtk_css_property_set_init_all (&changes);
         }
     }
   else
     {
-      changes = _gtk_css_computed_values_compute_dependencies (current->store, parent_changes);
+      _gtk_css_computed_values_compute_dependencies (current->store, parent_changes, &changes);
 
       gtk_style_context_update_cache (context, parent_changes);
     }
@@ -3331,34 +3411,41 @@ _gtk_style_context_validate (GtkStyleContext  *context,
   if (change & GTK_CSS_CHANGE_ANIMATE &&
       gtk_style_context_is_animating (context))
     {
-      GtkBitmask *animation_changes;
-
-      animation_changes = gtk_style_context_update_animations (context, timestamp);
-      changes = _gtk_bitmask_union (changes, animation_changes);
-      _gtk_bitmask_free (animation_changes);
+      gtk_style_context_update_animations (context, timestamp, &changes);
     }
 
   if (change & GTK_CSS_CHANGE_FORCE_INVALIDATE)
     {
-      GtkBitmask *full = _gtk_bitmask_new ();
-      full = _gtk_bitmask_invert_range (full, 
-                                        0,
-                                        _gtk_css_style_property_get_n_properties ());
-      gtk_style_context_do_invalidate (context, full);
-      _gtk_bitmask_free (full);
+      GtkCssPropertySet full;
+
+      _gtk_css_property_set_init_all (&full);
+      gtk_style_context_do_invalidate (context, &full);
     }
-  else if (!_gtk_bitmask_is_empty (changes))
+  else if (!_gtk_css_property_set_is_empty (&changes))
     {
-      gtk_style_context_do_invalidate (context, changes);
+      gtk_style_context_do_invalidate (context, &changes);
     }
 
   change = _gtk_css_change_for_child (change);
-  for (list = priv->children; list; list = list->next)
+  if (change == 0 && _gtk_css_property_set_is_empty (&changes))
     {
-      _gtk_style_context_validate (list->data, timestamp, change, changes);
+      n_visited += gtk_style_context_validate_invalid_children (context, timestamp, &changes);
     }
+  else
+    {
+      /* All children are visited, so forget about the invalid ones */
+      for (list = priv->invalid_children; list; list = list->next)
+        ((GtkStyleContext *) list->data)->priv->invalid_queued = FALSE;
+      g_slist_free (priv->invalid_children);
+      priv->invalid_children = NULL;
 
-  _gtk_bitmask_free (changes);
+      for (list = priv->children; list; list = list->next)
+        {
+          n_visited += _gtk_style_context_validate (list->data, timestamp, change, &changes);
+        }
+    }
+
+  return n_visited;
 }
 
 void
@@ -3372,6 +3459,20 @@ _gtk_style_context_queue_invalidate (GtkStyleContext *context,
 
   priv = context->priv;
 
+  if (priv->widget != NULL && (change & GTK_CSS_CHANGE_PATH))
+    {
+      GtkWidget *parent;
+
+      _gtk_widget_invalidate_path (priv->widget);
+
+      /* Containers may put the classes and names of a child
+       * into the paths of its siblings.
+       */
+      parent = gtk_widget_get_parent (priv->widget);
+      if (parent && (change & (GTK_CSS_CHANGE_CLASS | GTK_CSS_CHANGE_NAME)))
+        _gtk_widget_invalidate_path (parent);
+    }
+
   if (priv->widget != NULL)
     {
       priv->pending_changes |= change;
@@ -3399,18 +3500,17 @@ _gtk_style_context_queue_invalidate (GtkStyleContext *context,
 void
 gtk_style_context_invalidate (GtkStyleContext *context)
 {
-  GtkBitmask *changes;
+  GtkCssPropertySet changes;
 
   g_return_if_fail (GTK_IS_STYLE_CONTEXT (context));
 
+  if (context->priv->widget)
+    _gtk_widget_invalidate_path (context->priv->widget);
+
   gtk_style_context_clear_cache (context);
 
-  changes = _gtk_bitmask_new ();
-  changes = _gtk_bitmask_invert_range (changes,
-                                       0,
-                                       _gtk_css_style_property_get_n_properties ());
-  gtk_style_context_do_invalidate (context, changes);
-  _gtk_bitmask_free (changes);
+  _gtk_css_property_set_init_all (&changes);
+  gtk_style_context_do_invalidate (context, &changes);
 }
 
 static gboolean
@@ -4774,7 +4874,7 @@ gtk_draw_insertion_cursor (GtkWidget          *widget,
  *
  * Returns: %NULL or the currently invalidating changes
  **/
-const GtkBitmask *
+const GtkCssPropertySet *
 _gtk_style_context_get_changes (GtkStyleContext *context)
 {
   g_return_val_if_fail (GTK_IS_STYLE_CONTEXT (context), NULL);
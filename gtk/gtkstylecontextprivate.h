@@ -22,14 +22,14 @@
 
 #include "gtkstylecontext.h"
 #include "gtkstyleproviderprivate.h"
-#include "gtkbitmaskprivate.h"
+#include "gtkcsspropertysetprivate.h"
 #include "gtkcssvalueprivate.h"
 
 G_BEGIN_DECLS
 
 void            _gtk_style_context_set_widget                (GtkStyleContext *context,
                                                               GtkWidget       *widget);
-const GtkBitmask *
+const GtkCssPropertySet *
                 _gtk_style_context_get_changes               (GtkStyleContext *context);
 
 GtkCssValue   * _gtk_style_context_peek_property             (GtkStyleContext *context,
@@ -38,12 +38,13 @@ const GValue * _gtk_style_context_peek_style_property        (GtkStyleContext *c
                                                               GType            widget_type,
                                                               GtkStateFlags    state,
                                                               GParamSpec      *pspec);
-void           _gtk_style_context_validate                   (GtkStyleContext *context,
+guint          _gtk_style_context_validate                   (GtkStyleContext *context,
                                                               gint64           timestamp,
                                                               GtkCssChange     change,
-                                                              const GtkBitmask*parent_changes);
+                                                              const GtkCssPropertySet *parent_changes);
 void           _gtk_style_context_queue_invalidate           (GtkStyleContext *context,
                                                               GtkCssChange     change);
+gboolean       _gtk_style_context_is_saved                   (GtkStyleContext *context);
 gboolean       _gtk_style_context_check_region_name          (const gchar     *str);
 
 gboolean       _gtk_style_context_resolve_color              (GtkStyleContext    *context,
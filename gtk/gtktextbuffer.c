@@ -959,6 +959,104 @@ gtk_text_buffer_insert (GtkTextBuffer *buffer,
   gtk_text_buffer_emit_insert (buffer, iter, text, len);
 }
 
+#define STREAM_CHUNK_SIZE 65536
+
+/**
+ * gtk_text_buffer_insert_from_stream:
+ * @buffer: a #GtkTextBuffer
+ * @iter: a position in the buffer
+ * @stream: a #GInputStream providing text in UTF-8 format
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Reads @stream until its end and inserts its contents at @iter.
+ *
+ * The text is inserted in large chunks as it is read, each of them
+ * emitting the #GtkTextBuffer::insert-text signal once, so this is
+ * an efficient way of loading long texts like log files without
+ * holding a copy of all of the text in memory. On return, @iter
+ * points to the end of the inserted text, even if an error occurred
+ * after some of the text had been inserted.
+ *
+ * Return value: %TRUE if the whole stream was inserted, %FALSE if an
+ *   error occurred, or if the stream did not contain valid UTF-8
+ *
+ * Since: 3.12
+ */
+gboolean
+gtk_text_buffer_insert_from_stream (GtkTextBuffer  *buffer,
+                                    GtkTextIter    *iter,
+                                    GInputStream   *stream,
+                                    GCancellable   *cancellable,
+                                    GError        **error)
+{
+  gchar *data;
+  gsize n_pending;
+  gboolean retval;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+  g_return_val_if_fail (gtk_text_iter_get_buffer (iter) == buffer, FALSE);
+  g_return_val_if_fail (G_IS_INPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  data = g_malloc (STREAM_CHUNK_SIZE);
+  n_pending = 0;
+  retval = TRUE;
+
+  while (TRUE)
+    {
+      const gchar *valid_end;
+      gssize n_read;
+      gsize n_data, n_insert;
+
+      n_read = g_input_stream_read (stream,
+                                    data + n_pending,
+                                    STREAM_CHUNK_SIZE - n_pending,
+                                    cancellable,
+                                    error);
+      if (n_read < 0)
+        {
+          retval = FALSE;
+          break;
+        }
+
+      n_data = n_pending + n_read;
+
+      if (!g_utf8_validate (data, n_data, &valid_end) &&
+          (n_read == 0 ||
+           g_utf8_get_char_validated (valid_end, data + n_data - valid_end) != (gunichar) -2))
+        {
+          /* not just a character that continues in the next read */
+          g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                               _("Invalid UTF-8 data encountered"));
+          n_data = valid_end - data;
+          retval = FALSE;
+        }
+
+      n_insert = valid_end - data;
+
+      /* a trailing \r may be the first half of a \r\n, which
+       * needs to be inserted in one go to end a single line
+       */
+      if (retval && n_read > 0 && n_insert > 0 && data[n_insert - 1] == '\r')
+        n_insert--;
+
+      if (n_insert > 0)
+        gtk_text_buffer_emit_insert (buffer, iter, data, n_insert);
+
+      if (!retval || n_read == 0)
+        break;
+
+      n_pending = n_data - n_insert;
+      memmove (data, data + n_insert, n_pending);
+    }
+
+  g_free (data);
+
+  return retval;
+}
+
 /**
  * gtk_text_buffer_insert_at_cursor:
  * @buffer: a #GtkTextBuffer
@@ -4259,6 +4357,293 @@ gtk_text_buffer_get_paste_target_list (GtkTextBuffer *buffer)
   return priv->paste_target_list;
 }
 
+/*
+ * Searching for all matches
+ */
+
+/* an asynchronous search runs for this long per idle, to leave
+ * the main loop responsive while searching large buffers
+ */
+#define SEARCH_STEP_TIME 5000 /* microseconds */
+#define SEARCH_STEP_LINES 1000
+
+typedef struct
+{
+  GtkTextSearch *search;
+  GArray *matches;
+  gint position;
+  gint limit;
+  guint chars_changed_stamp;
+} SearchAllData;
+
+static SearchAllData *
+search_all_data_new (GtkTextBuffer      *buffer,
+                     const gchar        *str,
+                     GtkTextSearchFlags  flags,
+                     const GtkTextIter  *start,
+                     const GtkTextIter  *end)
+{
+  SearchAllData *data;
+  GtkTextIter range_start, range_end;
+
+  if (start)
+    range_start = *start;
+  else
+    gtk_text_buffer_get_start_iter (buffer, &range_start);
+
+  if (end)
+    range_end = *end;
+  else
+    gtk_text_buffer_get_end_iter (buffer, &range_end);
+
+  gtk_text_iter_order (&range_start, &range_end);
+
+  data = g_slice_new (SearchAllData);
+  data->search = _gtk_text_search_new (str, flags);
+  data->matches = g_array_new (TRUE, FALSE, sizeof (gint));
+  data->position = gtk_text_iter_get_offset (&range_start);
+  data->limit = gtk_text_iter_get_offset (&range_end);
+  data->chars_changed_stamp = _gtk_text_btree_get_chars_changed_stamp (get_btree (buffer));
+
+  return data;
+}
+
+static void
+search_all_data_free (SearchAllData *data)
+{
+  _gtk_text_search_free (data->search);
+  if (data->matches)
+    g_array_unref (data->matches);
+
+  g_slice_free (SearchAllData, data);
+}
+
+/* Collects matches from data->position on, until the whole range is
+ * searched or, if @deadline is not 0, the deadline has passed.
+ * Returns %TRUE when the whole range has been searched.
+ */
+static gboolean
+search_all_step (GtkTextBuffer *buffer,
+                 SearchAllData *data,
+                 gint           max_lines,
+                 gint64         deadline)
+{
+  GtkTextIter iter, limit;
+  GtkTextIter match_start, match_end;
+  gint offsets[2];
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, data->position);
+  gtk_text_buffer_get_iter_at_offset (buffer, &limit, data->limit);
+
+  while (TRUE)
+    {
+      if (_gtk_text_search_forward (data->search, &iter, &limit, max_lines,
+                                    &match_start, &match_end))
+        {
+          offsets[0] = gtk_text_iter_get_offset (&match_start);
+          offsets[1] = gtk_text_iter_get_offset (&match_end);
+          g_array_append_vals (data->matches, offsets, 2);
+
+          iter = match_end;
+          if (offsets[0] == offsets[1] && !gtk_text_iter_forward_char (&iter))
+            return TRUE;
+        }
+      else if (gtk_text_iter_compare (&iter, &limit) >= 0 ||
+               gtk_text_iter_is_end (&iter))
+        return TRUE;
+
+      if (deadline != 0 && g_get_monotonic_time () >= deadline)
+        break;
+    }
+
+  data->position = gtk_text_iter_get_offset (&iter);
+
+  return FALSE;
+}
+
+static gint *
+search_all_steal_matches (SearchAllData *data,
+                          gint          *n_matches)
+{
+  GArray *matches = data->matches;
+
+  data->matches = NULL;
+
+  if (n_matches)
+    *n_matches = matches->len / 2;
+
+  return (gint *) g_array_free (matches, FALSE);
+}
+
+/**
+ * gtk_text_buffer_search_all:
+ * @buffer: a #GtkTextBuffer
+ * @str: a search string, which must not be empty
+ * @flags: flags affecting how the search is done
+ * @start: (allow-none): start of the range to search, or %NULL for the
+ *   start of the buffer
+ * @end: (allow-none): end of the range to search, or %NULL for the end
+ *   of the buffer
+ * @n_matches: (out) (allow-none): return location for the number of matches
+ *
+ * Finds all non-overlapping occurrences of @str between @start and @end,
+ * matching them like gtk_text_iter_forward_search() does.
+ *
+ * This is a lot faster than repeatedly calling
+ * gtk_text_iter_forward_search(), but it still takes time proportional
+ * to the size of the searched range; use gtk_text_buffer_search_all_async()
+ * to search large buffers without blocking the user interface.
+ *
+ * Return value: (transfer full): an array of 2 * @n_matches character
+ *   offsets, holding the start and end offset of each match in order.
+ *   Free with g_free().
+ *
+ * Since: 3.12
+ */
+gint *
+gtk_text_buffer_search_all (GtkTextBuffer      *buffer,
+                            const gchar        *str,
+                            GtkTextSearchFlags  flags,
+                            const GtkTextIter  *start,
+                            const GtkTextIter  *end,
+                            gint               *n_matches)
+{
+  SearchAllData *data;
+  gint *matches;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
+  g_return_val_if_fail (str != NULL && *str != '\0', NULL);
+  g_return_val_if_fail (start == NULL || gtk_text_iter_get_buffer (start) == buffer, NULL);
+  g_return_val_if_fail (end == NULL || gtk_text_iter_get_buffer (end) == buffer, NULL);
+
+  data = search_all_data_new (buffer, str, flags, start, end);
+
+  search_all_step (buffer, data, -1, 0);
+  matches = search_all_steal_matches (data, n_matches);
+
+  search_all_data_free (data);
+
+  return matches;
+}
+
+static gboolean
+search_all_idle (gpointer user_data)
+{
+  GTask *task = user_data;
+  GtkTextBuffer *buffer = g_task_get_source_object (task);
+  SearchAllData *data = g_task_get_task_data (task);
+
+  if (g_task_return_error_if_cancelled (task))
+    return G_SOURCE_REMOVE;
+
+  if (_gtk_text_btree_get_chars_changed_stamp (get_btree (buffer)) !=
+      data->chars_changed_stamp)
+    {
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                               _("The text buffer was modified during the search"));
+      return G_SOURCE_REMOVE;
+    }
+
+  if (!search_all_step (buffer, data, SEARCH_STEP_LINES,
+                        g_get_monotonic_time () + SEARCH_STEP_TIME))
+    return G_SOURCE_CONTINUE;
+
+  g_task_return_pointer (task, data->matches, (GDestroyNotify) g_array_unref);
+  data->matches = NULL;
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gtk_text_buffer_search_all_async:
+ * @buffer: a #GtkTextBuffer
+ * @str: a search string, which must not be empty
+ * @flags: flags affecting how the search is done
+ * @start: (allow-none): start of the range to search, or %NULL for the
+ *   start of the buffer
+ * @end: (allow-none): end of the range to search, or %NULL for the end
+ *   of the buffer
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *   search is finished
+ * @user_data: (closure): the data to pass to @callback
+ *
+ * Asynchronously finds all occurrences of @str between @start and @end,
+ * see gtk_text_buffer_search_all().
+ *
+ * The search runs in small steps from an idle handler in the main
+ * loop. If the text of @buffer changes before the search is finished,
+ * it fails with a %G_IO_ERROR_FAILED error.
+ *
+ * Since: 3.12
+ */
+void
+gtk_text_buffer_search_all_async (GtkTextBuffer       *buffer,
+                                  const gchar         *str,
+                                  GtkTextSearchFlags   flags,
+                                  const GtkTextIter   *start,
+                                  const GtkTextIter   *end,
+                                  GCancellable        *cancellable,
+                                  GAsyncReadyCallback  callback,
+                                  gpointer             user_data)
+{
+  GTask *task;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (str != NULL && *str != '\0');
+  g_return_if_fail (start == NULL || gtk_text_iter_get_buffer (start) == buffer);
+  g_return_if_fail (end == NULL || gtk_text_iter_get_buffer (end) == buffer);
+
+  task = g_task_new (buffer, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtk_text_buffer_search_all_async);
+  g_task_set_task_data (task,
+                        search_all_data_new (buffer, str, flags, start, end),
+                        (GDestroyNotify) search_all_data_free);
+
+  gdk_threads_add_idle_full (G_PRIORITY_DEFAULT_IDLE,
+                             search_all_idle,
+                             task, g_object_unref);
+}
+
+/**
+ * gtk_text_buffer_search_all_finish:
+ * @buffer: a #GtkTextBuffer
+ * @result: a #GAsyncResult
+ * @n_matches: (out) (allow-none): return location for the number of matches
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Finishes a search started with gtk_text_buffer_search_all_async().
+ *
+ * Return value: (transfer full): an array of 2 * @n_matches character
+ *   offsets like the one returned by gtk_text_buffer_search_all(), or
+ *   %NULL if the search failed or was cancelled. Free with g_free().
+ *
+ * Since: 3.12
+ */
+gint *
+gtk_text_buffer_search_all_finish (GtkTextBuffer  *buffer,
+                                   GAsyncResult   *result,
+                                   gint           *n_matches,
+                                   GError        **error)
+{
+  GArray *matches;
+
+  g_return_val_if_fail (g_task_is_valid (result, buffer), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (n_matches)
+    *n_matches = 0;
+
+  matches = g_task_propagate_pointer (G_TASK (result), error);
+  if (matches == NULL)
+    return NULL;
+
+  if (n_matches)
+    *n_matches = matches->len / 2;
+
+  return (gint *) g_array_free (matches, FALSE);
+}
+
 /*
  * Logical attribute cache
  */
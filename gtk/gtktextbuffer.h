@@ -161,6 +161,11 @@ void gtk_text_buffer_insert            (GtkTextBuffer *buffer,
                                         GtkTextIter   *iter,
                                         const gchar   *text,
                                         gint           len);
+gboolean gtk_text_buffer_insert_from_stream (GtkTextBuffer  *buffer,
+                                             GtkTextIter    *iter,
+                                             GInputStream   *stream,
+                                             GCancellable   *cancellable,
+                                             GError        **error);
 void gtk_text_buffer_insert_at_cursor  (GtkTextBuffer *buffer,
                                         const gchar   *text,
                                         gint           len);
@@ -377,6 +382,25 @@ void            gtk_text_buffer_end_user_action         (GtkTextBuffer *buffer);
 GtkTargetList * gtk_text_buffer_get_copy_target_list    (GtkTextBuffer *buffer);
 GtkTargetList * gtk_text_buffer_get_paste_target_list   (GtkTextBuffer *buffer);
 
+gint           *gtk_text_buffer_search_all        (GtkTextBuffer       *buffer,
+                                                   const gchar         *str,
+                                                   GtkTextSearchFlags   flags,
+                                                   const GtkTextIter   *start,
+                                                   const GtkTextIter   *end,
+                                                   gint                *n_matches);
+void            gtk_text_buffer_search_all_async  (GtkTextBuffer       *buffer,
+                                                   const gchar         *str,
+                                                   GtkTextSearchFlags   flags,
+                                                   const GtkTextIter   *start,
+                                                   const GtkTextIter   *end,
+                                                   GCancellable        *cancellable,
+                                                   GAsyncReadyCallback  callback,
+                                                   gpointer             user_data);
+gint           *gtk_text_buffer_search_all_finish (GtkTextBuffer       *buffer,
+                                                   GAsyncResult        *result,
+                                                   gint                *n_matches,
+                                                   GError             **error);
+
 /* INTERNAL private stuff */
 void            _gtk_text_buffer_spew                  (GtkTextBuffer      *buffer);
 
@@ -38,6 +38,15 @@ typedef struct
   GDestroyNotify  user_data_destroy;
 } GtkRichTextFormat;
 
+typedef struct
+{
+  GSList      *tags;
+  GtkTextMark *left_end;
+  GtkTextMark *right_start;
+  GSList      *left_start_list;
+  GSList      *right_end_list;
+} SplitTags;
+
 
 static GList   * register_format   (GList             *formats,
                                     const gchar       *mime_type,
@@ -54,6 +63,14 @@ static void      free_format_list  (GList             *formats);
 static GQuark    serialize_quark   (void);
 static GQuark    deserialize_quark (void);
 
+static GtkRichTextFormat * find_format  (GList             *formats,
+                                         GdkAtom            format);
+static void      split_tags_remove (GtkTextBuffer     *content_buffer,
+                                    GtkTextIter       *iter,
+                                    SplitTags         *split);
+static void      split_tags_apply  (GtkTextBuffer     *content_buffer,
+                                    SplitTags         *split);
+
 
 /**
  * gtk_text_buffer_register_serialize_format:
@@ -567,78 +584,9 @@ gtk_text_buffer_deserialize (GtkTextBuffer  *register_buffer,
         {
           GtkTextBufferDeserializeFunc function = fmt->function;
           gboolean                     success;
-          GSList                      *split_tags;
-          GSList                      *list;
-          GtkTextMark                 *left_end        = NULL;
-          GtkTextMark                 *right_start     = NULL;
-          GSList                      *left_start_list = NULL;
-          GSList                      *right_end_list  = NULL;
-
-          /*  We don't want the tags that are effective at the insertion
-           *  point to affect the pasted text, therefore we remove and
-           *  remember them, so they can be re-applied left and right of
-           *  the inserted text after pasting
-           */
-          split_tags = gtk_text_iter_get_tags (iter);
-
-          list = split_tags;
-          while (list)
-            {
-              GtkTextTag *tag = list->data;
-
-              list = g_slist_next (list);
-
-              /*  If a tag begins at the insertion point, ignore it
-               *  because it doesn't affect the pasted text
-               */
-              if (gtk_text_iter_begins_tag (iter, tag))
-                split_tags = g_slist_remove (split_tags, tag);
-            }
-
-          if (split_tags)
-            {
-              /*  Need to remember text marks, because text iters
-               *  don't survive pasting
-               */
-              left_end = gtk_text_buffer_create_mark (content_buffer,
-                                                      NULL, iter, TRUE);
-              right_start = gtk_text_buffer_create_mark (content_buffer,
-                                                         NULL, iter, FALSE);
-
-              for (list = split_tags; list; list = g_slist_next (list))
-                {
-                  GtkTextTag  *tag             = list->data;
-                  GtkTextIter *backward_toggle = gtk_text_iter_copy (iter);
-                  GtkTextIter *forward_toggle  = gtk_text_iter_copy (iter);
-                  GtkTextMark *left_start      = NULL;
-                  GtkTextMark *right_end       = NULL;
-
-                  gtk_text_iter_backward_to_tag_toggle (backward_toggle, tag);
-                  left_start = gtk_text_buffer_create_mark (content_buffer,
-                                                            NULL,
-                                                            backward_toggle,
-                                                            FALSE);
-
-                  gtk_text_iter_forward_to_tag_toggle (forward_toggle, tag);
-                  right_end = gtk_text_buffer_create_mark (content_buffer,
-                                                           NULL,
-                                                           forward_toggle,
-                                                           TRUE);
-
-                  left_start_list = g_slist_prepend (left_start_list, left_start);
-                  right_end_list = g_slist_prepend (right_end_list, right_end);
-
-                  gtk_text_buffer_remove_tag (content_buffer, tag,
-                                              backward_toggle,
-                                              forward_toggle);
-
-                  gtk_text_iter_free (forward_toggle);
-                  gtk_text_iter_free (backward_toggle);
-                }
-
-              left_start_list = g_slist_reverse (left_start_list);
-              right_end_list = g_slist_reverse (right_end_list);
-            }
+          SplitTags                    split;
+
+          split_tags_remove (content_buffer, iter, &split);
 
           success = function (register_buffer, content_buffer,
                               iter, data, length,
@@ -651,56 +599,7 @@ gtk_text_buffer_deserialize (GtkTextBuffer  *register_buffer,
                          _("Unknown error when trying to deserialize %s"),
                          gdk_atom_name (format));
 
-          if (split_tags)
-            {
-              GSList      *left_list;
-              GSList      *right_list;
-              GtkTextIter  left_e;
-              GtkTextIter  right_s;
-
-              /*  Turn the remembered marks back into iters so they
-               *  can by used to re-apply the remembered tags
-               */
-              gtk_text_buffer_get_iter_at_mark (content_buffer,
-                                                &left_e, left_end);
-              gtk_text_buffer_get_iter_at_mark (content_buffer,
-                                                &right_s, right_start);
-
-              for (list = split_tags,
-                     left_list = left_start_list,
-                     right_list = right_end_list;
-                   list && left_list && right_list;
-                   list = g_slist_next (list),
-                     left_list = g_slist_next (left_list),
-                     right_list = g_slist_next (right_list))
-                {
-                  GtkTextTag  *tag        = list->data;
-                  GtkTextMark *left_start = left_list->data;
-                  GtkTextMark *right_end  = right_list->data;
-                  GtkTextIter  left_s;
-                  GtkTextIter  right_e;
-
-                  gtk_text_buffer_get_iter_at_mark (content_buffer,
-                                                    &left_s, left_start);
-                  gtk_text_buffer_get_iter_at_mark (content_buffer,
-                                                    &right_e, right_end);
-
-                  gtk_text_buffer_apply_tag (content_buffer, tag,
-                                             &left_s, &left_e);
-                  gtk_text_buffer_apply_tag (content_buffer, tag,
-                                             &right_s, &right_e);
-
-                  gtk_text_buffer_delete_mark (content_buffer, left_start);
-                  gtk_text_buffer_delete_mark (content_buffer, right_end);
-                }
-
-              gtk_text_buffer_delete_mark (content_buffer, left_end);
-              gtk_text_buffer_delete_mark (content_buffer, right_start);
-
-              g_slist_free (split_tags);
-              g_slist_free (left_start_list);
-              g_slist_free (right_end_list);
-            }
+          split_tags_apply (content_buffer, &split);
 
           return success;
         }
@@ -713,6 +612,227 @@ gtk_text_buffer_deserialize (GtkTextBuffer  *register_buffer,
   return FALSE;
 }
 
+/**
+ * gtk_text_buffer_serialize_to_stream:
+ * @register_buffer: the #GtkTextBuffer @format is registered with
+ * @content_buffer: the #GtkTextBuffer to serialize
+ * @format: the rich text format to use for serializing
+ * @start: start of block of text to serialize
+ * @end: end of block of text to serialize
+ * @stream: the #GOutputStream to write the serialized data to
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore
+ * @progress_callback: (allow-none) (scope call): function to call with
+ *     the number of bytes written so far, or %NULL
+ * @progress_data: (closure): user data to pass to @progress_callback
+ * @error: return location for a #GError
+ *
+ * Like gtk_text_buffer_serialize(), but writes the serialized data
+ * to @stream. For the format registered by
+ * gtk_text_buffer_register_serialize_tagset() the data is produced
+ * and written in small pieces, so serializing a large buffer does
+ * not need a copy of it in memory. Other formats are serialized
+ * in memory first.
+ *
+ * The text between @start and @end must not be modified before
+ * this function returns.
+ *
+ * Return value: %TRUE on success, %FALSE if an error occurred
+ *
+ * Since: 3.12
+ **/
+gboolean
+gtk_text_buffer_serialize_to_stream (GtkTextBuffer          *register_buffer,
+                                     GtkTextBuffer          *content_buffer,
+                                     GdkAtom                 format,
+                                     const GtkTextIter      *start,
+                                     const GtkTextIter      *end,
+                                     GOutputStream          *stream,
+                                     GCancellable           *cancellable,
+                                     GFileProgressCallback   progress_callback,
+                                     gpointer                progress_data,
+                                     GError                **error)
+{
+  GtkRichTextFormat          *fmt;
+  GtkTextBufferSerializeFunc  function;
+  guint8                     *data;
+  gsize                       length;
+  gboolean                    success;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (register_buffer), FALSE);
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (content_buffer), FALSE);
+  g_return_val_if_fail (format != GDK_NONE, FALSE);
+  g_return_val_if_fail (start != NULL, FALSE);
+  g_return_val_if_fail (end != NULL, FALSE);
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  fmt = find_format (g_object_get_qdata (G_OBJECT (register_buffer),
+                                         serialize_quark ()),
+                     format);
+
+  if (!fmt)
+    {
+      g_set_error (error, 0, 0,
+                   _("No serialize function found for format %s"),
+                   gdk_atom_name (format));
+      return FALSE;
+    }
+
+  if (fmt->function == (gpointer) _gtk_text_buffer_serialize_rich_text)
+    return _gtk_text_buffer_serialize_rich_text_to_stream (register_buffer,
+                                                           content_buffer,
+                                                           start, end,
+                                                           stream,
+                                                           cancellable,
+                                                           progress_callback,
+                                                           progress_data,
+                                                           error);
+
+  function = fmt->function;
+  length = 0;
+  data = function (register_buffer, content_buffer,
+                   start, end, &length, fmt->user_data);
+
+  if (!data)
+    {
+      g_set_error (error, 0, 0,
+                   _("Unknown error when trying to serialize %s"),
+                   gdk_atom_name (format));
+      return FALSE;
+    }
+
+  success = g_output_stream_write_all (stream, data, length, NULL,
+                                       cancellable, error);
+  g_free (data);
+
+  if (success && progress_callback)
+    progress_callback (length, length, progress_data);
+
+  return success;
+}
+
+/**
+ * gtk_text_buffer_deserialize_from_stream:
+ * @register_buffer: the #GtkTextBuffer @format is registered with
+ * @content_buffer: the #GtkTextBuffer to deserialize into
+ * @format: the rich text format to use for deserializing
+ * @iter: insertion point for the deserialized text
+ * @stream: the #GInputStream to read the serialized data from
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore
+ * @progress_callback: (allow-none) (scope call): function to call with
+ *     the number of bytes read so far, or %NULL
+ * @progress_data: (closure): user data to pass to @progress_callback
+ * @error: return location for a #GError
+ *
+ * Like gtk_text_buffer_deserialize(), but reads the data to
+ * deserialize from @stream. For the format registered by
+ * gtk_text_buffer_register_deserialize_tagset() the text is
+ * inserted in batches while it is being read; in that case, if an
+ * error occurs, the text read up to that point stays in the buffer.
+ * Other formats are read into memory and deserialized at once.
+ *
+ * The total passed to @progress_callback is -1, as the size of
+ * the data is not known in advance.
+ *
+ * Return value: %TRUE on success, %FALSE otherwise
+ *
+ * Since: 3.12
+ **/
+gboolean
+gtk_text_buffer_deserialize_from_stream (GtkTextBuffer          *register_buffer,
+                                         GtkTextBuffer          *content_buffer,
+                                         GdkAtom                 format,
+                                         GtkTextIter            *iter,
+                                         GInputStream           *stream,
+                                         GCancellable           *cancellable,
+                                         GFileProgressCallback   progress_callback,
+                                         gpointer                progress_data,
+                                         GError                **error)
+{
+  GtkRichTextFormat *fmt;
+  gboolean           success;
+  SplitTags          split;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (register_buffer), FALSE);
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (content_buffer), FALSE);
+  g_return_val_if_fail (format != GDK_NONE, FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+  g_return_val_if_fail (G_IS_INPUT_STREAM (stream), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  fmt = find_format (g_object_get_qdata (G_OBJECT (register_buffer),
+                                         deserialize_quark ()),
+                     format);
+
+  if (!fmt)
+    {
+      g_set_error (error, 0, 0,
+                   _("No deserialize function found for format %s"),
+                   gdk_atom_name (format));
+      return FALSE;
+    }
+
+  if (fmt->function == (gpointer) _gtk_text_buffer_deserialize_rich_text)
+    {
+      split_tags_remove (content_buffer, iter, &split);
+
+      success = _gtk_text_buffer_deserialize_rich_text_from_stream (register_buffer,
+                                                                    content_buffer,
+                                                                    iter,
+                                                                    stream,
+                                                                    fmt->can_create_tags,
+                                                                    cancellable,
+                                                                    progress_callback,
+                                                                    progress_data,
+                                                                    error);
+
+      split_tags_apply (content_buffer, &split);
+    }
+  else
+    {
+      GOutputStream *memory;
+      gssize         length;
+
+      memory = g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
+      length = g_output_stream_splice (memory, stream,
+                                       G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                       cancellable, error);
+
+      if (length < 0)
+        success = FALSE;
+      else if (length == 0)
+        {
+          g_set_error (error, 0, 0,
+                       _("Unknown error when trying to deserialize %s"),
+                       gdk_atom_name (format));
+          success = FALSE;
+        }
+      else
+        {
+          if (progress_callback)
+            progress_callback (length, -1, progress_data);
+
+          success = gtk_text_buffer_deserialize (register_buffer,
+                                                 content_buffer,
+                                                 format, iter,
+                                                 g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (memory)),
+                                                 length,
+                                                 error);
+        }
+
+      g_object_unref (memory);
+
+      return success;
+    }
+
+  if (!success && error != NULL && *error == NULL)
+    g_set_error (error, 0, 0,
+                 _("Unknown error when trying to deserialize %s"),
+                 gdk_atom_name (format));
+
+  return success;
+}
+
 
 /*  private functions  */
 
@@ -821,3 +941,156 @@ deserialize_quark (void)
 
   return quark;
 }
+
+static GtkRichTextFormat *
+find_format (GList   *formats,
+             GdkAtom  format)
+{
+  GList *list;
+
+  for (list = formats; list; list = g_list_next (list))
+    {
+      GtkRichTextFormat *fmt = list->data;
+
+      if (fmt->atom == format)
+        return fmt;
+    }
+
+  return NULL;
+}
+
+static void
+split_tags_remove (GtkTextBuffer *content_buffer,
+                   GtkTextIter   *iter,
+                   SplitTags     *split)
+{
+  GSList *list;
+
+  split->left_end        = NULL;
+  split->right_start     = NULL;
+  split->left_start_list = NULL;
+  split->right_end_list  = NULL;
+
+  /*  We don't want the tags that are effective at the insertion
+   *  point to affect the pasted text, therefore we remove and
+   *  remember them, so they can be re-applied left and right of
+   *  the inserted text after pasting
+   */
+  split->tags = gtk_text_iter_get_tags (iter);
+
+  list = split->tags;
+  while (list)
+    {
+      GtkTextTag *tag = list->data;
+
+      list = g_slist_next (list);
+
+      /*  If a tag begins at the insertion point, ignore it
+       *  because it doesn't affect the pasted text
+       */
+      if (gtk_text_iter_begins_tag (iter, tag))
+        split->tags = g_slist_remove (split->tags, tag);
+    }
+
+  if (split->tags)
+    {
+      /*  Need to remember text marks, because text iters
+       *  don't survive pasting
+       */
+      split->left_end = gtk_text_buffer_create_mark (content_buffer,
+                                                     NULL, iter, TRUE);
+      split->right_start = gtk_text_buffer_create_mark (content_buffer,
+                                                        NULL, iter, FALSE);
+
+      for (list = split->tags; list; list = g_slist_next (list))
+        {
+          GtkTextTag  *tag             = list->data;
+          GtkTextIter *backward_toggle = gtk_text_iter_copy (iter);
+          GtkTextIter *forward_toggle  = gtk_text_iter_copy (iter);
+          GtkTextMark *left_start      = NULL;
+          GtkTextMark *right_end       = NULL;
+
+          gtk_text_iter_backward_to_tag_toggle (backward_toggle, tag);
+          left_start = gtk_text_buffer_create_mark (content_buffer,
+                                                    NULL,
+                                                    backward_toggle,
+                                                    FALSE);
+
+          gtk_text_iter_forward_to_tag_toggle (forward_toggle, tag);
+          right_end = gtk_text_buffer_create_mark (content_buffer,
+                                                   NULL,
+                                                   forward_toggle,
+                                                   TRUE);
+
+          split->left_start_list = g_slist_prepend (split->left_start_list, left_start);
+          split->right_end_list = g_slist_prepend (split->right_end_list, right_end);
+
+          gtk_text_buffer_remove_tag (content_buffer, tag,
+                                      backward_toggle,
+                                      forward_toggle);
+
+          gtk_text_iter_free (forward_toggle);
+          gtk_text_iter_free (backward_toggle);
+        }
+
+      split->left_start_list = g_slist_reverse (split->left_start_list);
+      split->right_end_list = g_slist_reverse (split->right_end_list);
+    }
+}
+
+static void
+split_tags_apply (GtkTextBuffer *content_buffer,
+                  SplitTags     *split)
+{
+  GSList      *list;
+  GSList      *left_list;
+  GSList      *right_list;
+  GtkTextIter  left_e;
+  GtkTextIter  right_s;
+
+  if (!split->tags)
+    return;
+
+  /*  Turn the remembered marks back into iters so they
+   *  can by used to re-apply the remembered tags
+   */
+  gtk_text_buffer_get_iter_at_mark (content_buffer,
+                                    &left_e, split->left_end);
+  gtk_text_buffer_get_iter_at_mark (content_buffer,
+                                    &right_s, split->right_start);
+
+  for (list = split->tags,
+         left_list = split->left_start_list,
+         right_list = split->right_end_list;
+       list && left_list && right_list;
+       list = g_slist_next (list),
+         left_list = g_slist_next (left_list),
+         right_list = g_slist_next (right_list))
+    {
+      GtkTextTag  *tag        = list->data;
+      GtkTextMark *left_start = left_list->data;
+      GtkTextMark *right_end  = right_list->data;
+      GtkTextIter  left_s;
+      GtkTextIter  right_e;
+
+      gtk_text_buffer_get_iter_at_mark (content_buffer,
+                                        &left_s, left_start);
+      gtk_text_buffer_get_iter_at_mark (content_buffer,
+                                        &right_e, right_end);
+
+      gtk_text_buffer_apply_tag (content_buffer, tag,
+                                 &left_s, &left_e);
+      gtk_text_buffer_apply_tag (content_buffer, tag,
+                                 &right_s, &right_e);
+
+      gtk_text_buffer_delete_mark (content_buffer, left_start);
+      gtk_text_buffer_delete_mark (content_buffer, right_end);
+    }
+
+  gtk_text_buffer_delete_mark (content_buffer, split->left_end);
+  gtk_text_buffer_delete_mark (content_buffer, split->right_start);
+
+  g_slist_free (split->tags);
+  g_slist_free (split->left_start_list);
+  g_slist_free (split->right_end_list);
+}
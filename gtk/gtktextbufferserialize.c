@@ -48,8 +48,29 @@ typedef struct
   GList *pixbufs;
   gint tag_id;
   GHashTable *tag_id_tags;
+
+  /* When flush_text is set, text_str is handed to the stream (or
+   * just counted, if there is none) every SERIALIZE_FLUSH_SIZE
+   * bytes instead of holding the whole <text> element.
+   */
+  gboolean flush_text;
+  goffset text_flushed;
+
+  GOutputStream *stream;
+  GCancellable *cancellable;
+  GError *error;
+  goffset written;
+  goffset total;
+  GFileProgressCallback progress_callback;
+  gpointer progress_data;
 } SerializationContext;
 
+/* Bytes of markup collected before they are written out when
+ * streaming, and characters of text escaped at a time.
+ */
+#define SERIALIZE_FLUSH_SIZE (64 * 1024)
+#define SERIALIZE_CHUNK_CHARS (16 * 1024)
+
 static gchar *
 serialize_value (GValue *value)
 {
@@ -433,6 +454,127 @@ serialize_section_header (GString     *str,
   g_string_append_c (str, length & 0xff);
 }
 
+static void
+serialize_write (SerializationContext *context,
+                 const gchar          *data,
+                 gsize                 len)
+{
+  if (context->stream == NULL || context->error != NULL || len == 0)
+    return;
+
+  if (!g_output_stream_write_all (context->stream, data, len, NULL,
+                                  context->cancellable, &context->error))
+    return;
+
+  context->written += len;
+
+  if (context->progress_callback)
+    context->progress_callback (context->written, context->total,
+                                context->progress_data);
+}
+
+static void
+serialize_flush_text (SerializationContext *context)
+{
+  serialize_write (context, context->text_str->str, context->text_str->len);
+
+  context->text_flushed += context->text_str->len;
+  g_string_truncate (context->text_str, 0);
+}
+
+static void
+serialize_maybe_flush_text (SerializationContext *context)
+{
+  if (context->flush_text &&
+      context->text_str->len >= SERIALIZE_FLUSH_SIZE)
+    serialize_flush_text (context);
+}
+
+static void
+serialize_escaped_text (SerializationContext *context,
+                        const gchar          *text,
+                        gssize                length)
+{
+  gchar *escaped_text;
+
+  if (length == 0)
+    return;
+
+  escaped_text = g_markup_escape_text (text, length);
+  g_string_append (context->text_str, escaped_text);
+  g_free (escaped_text);
+}
+
+/* Appends the text between @start and @end, which contains no tag
+ * toggles, a bounded number of characters at a time. Pixbufs are
+ * found by looking for U+FFFC in the slice rather than by walking
+ * the range one character at a time.
+ */
+static void
+serialize_text_run (SerializationContext *context,
+                    const GtkTextIter    *start,
+                    const GtkTextIter    *end)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter chunk_start, chunk_end;
+
+  buffer = gtk_text_iter_get_buffer (start);
+  chunk_start = *start;
+
+  while (gtk_text_iter_compare (&chunk_start, end) < 0 &&
+         context->error == NULL)
+    {
+      gchar *slice;
+      const gchar *run, *p;
+      gint offset;
+
+      chunk_end = chunk_start;
+      gtk_text_iter_forward_chars (&chunk_end, SERIALIZE_CHUNK_CHARS);
+      if (gtk_text_iter_compare (&chunk_end, end) > 0)
+        chunk_end = *end;
+
+      slice = gtk_text_iter_get_slice (&chunk_start, &chunk_end);
+      offset = gtk_text_iter_get_offset (&chunk_start);
+      run = slice;
+
+      /* U+FFFC is "\357\277\274" in UTF-8 */
+      while ((p = strstr (run, "\357\277\274")) != NULL)
+        {
+          GtkTextIter pixbuf_iter;
+          GdkPixbuf *pixbuf;
+
+          offset += g_utf8_strlen (run, p - run);
+          gtk_text_buffer_get_iter_at_offset (buffer, &pixbuf_iter, offset);
+          pixbuf = gtk_text_iter_get_pixbuf (&pixbuf_iter);
+
+          if (pixbuf)
+            {
+              /* Append the text before the pixbuf, and drop the
+               * 0xfffc char
+               */
+              serialize_escaped_text (context, run, p - run);
+
+              g_string_append_printf (context->text_str, "<pixbuf index=\"%d\" />", context->n_pixbufs);
+
+              context->n_pixbufs++;
+              context->pixbufs = g_list_prepend (context->pixbufs, pixbuf);
+            }
+          else
+            serialize_escaped_text (context, run, p + 3 - run);
+
+          offset++;
+          run = p + 3;
+        }
+
+      serialize_escaped_text (context, run, -1);
+      g_free (slice);
+
+      serialize_maybe_flush_text (context);
+
+      chunk_start = chunk_end;
+    }
+}
+
 static void
 serialize_text (GtkTextBuffer        *buffer,
                 SerializationContext *context)
@@ -451,7 +593,6 @@ serialize_text (GtkTextBuffer        *buffer,
     {
       GList *added, *removed;
       GList *tmp;
-      gchar *tmp_text, *escaped_text;
 
       new_tag_list = gtk_text_iter_get_tags (&iter);
       find_list_delta (tag_list, new_tag_list, &added, &removed);
@@ -525,59 +666,18 @@ serialize_text (GtkTextBuffer        *buffer,
 
       old_iter = iter;
 
-      /* Now try to go to either the next tag toggle, or if a pixbuf appears */
-      while (TRUE)
-	{
-	  gunichar ch = gtk_text_iter_get_char (&iter);
-
-	  if (ch == 0xFFFC)
-	    {
-	      GdkPixbuf *pixbuf = gtk_text_iter_get_pixbuf (&iter);
-
-	      if (pixbuf)
-		{
-		  /* Append the text before the pixbuf */
-		  tmp_text = gtk_text_iter_get_slice (&old_iter, &iter);
-		  escaped_text = g_markup_escape_text (tmp_text, -1);
-		  g_free (tmp_text);
-
-		  /* Forward so we don't get the 0xfffc char */
-		  gtk_text_iter_forward_char (&iter);
-		  old_iter = iter;
-
-		  g_string_append (context->text_str, escaped_text);
-		  g_free (escaped_text);
-
-		  g_string_append_printf (context->text_str, "<pixbuf index=\"%d\" />", context->n_pixbufs);
-
-		  context->n_pixbufs++;
-		  context->pixbufs = g_list_prepend (context->pixbufs, pixbuf);
-		}
-	    }
-          else if (ch == 0)
-            {
-                break;
-            }
-	  else
-	    gtk_text_iter_forward_char (&iter);
-
-	  if (gtk_text_iter_toggles_tag (&iter, NULL))
-	    break;
-	}
-
-      /* We might have moved too far */
-      if (gtk_text_iter_compare (&iter, &context->end) > 0)
+      /* Now go to the next tag toggle; we might move too far */
+      if (!gtk_text_iter_forward_to_tag_toggle (&iter, NULL) ||
+          gtk_text_iter_compare (&iter, &context->end) > 0)
 	iter = context->end;
 
       /* Append the text */
-      tmp_text = gtk_text_iter_get_slice (&old_iter, &iter);
-      escaped_text = g_markup_escape_text (tmp_text, -1);
-      g_free (tmp_text);
-
-      g_string_append (context->text_str, escaped_text);
-      g_free (escaped_text);
+      serialize_text_run (context, &old_iter, &iter);
     }
-  while (!gtk_text_iter_equal (&iter, &context->end));
+  while (!gtk_text_iter_equal (&iter, &context->end) &&
+         context->error == NULL);
+
+  g_slist_free (tag_list);
 
   /* Close any open tags */
   for (tag_list = active_tags; tag_list; tag_list = tag_list->next)
@@ -609,6 +709,31 @@ serialize_pixbufs (SerializationContext *context,
     }
 }
 
+static void
+serialization_context_init (SerializationContext *context,
+                            const GtkTextIter    *start,
+                            const GtkTextIter    *end)
+{
+  memset (context, 0, sizeof (SerializationContext));
+
+  context->tags = g_hash_table_new (NULL, NULL);
+  context->text_str = g_string_new (NULL);
+  context->tag_table_str = g_string_new (NULL);
+  context->start = *start;
+  context->end = *end;
+  context->tag_id_tags = g_hash_table_new (NULL, NULL);
+}
+
+static void
+serialization_context_free (SerializationContext *context)
+{
+  g_hash_table_destroy (context->tags);
+  g_list_free (context->pixbufs);
+  g_string_free (context->text_str, TRUE);
+  g_string_free (context->tag_table_str, TRUE);
+  g_hash_table_destroy (context->tag_id_tags);
+}
+
 guint8 *
 _gtk_text_buffer_serialize_rich_text (GtkTextBuffer     *register_buffer,
                                       GtkTextBuffer     *content_buffer,
@@ -620,15 +745,7 @@ _gtk_text_buffer_serialize_rich_text (GtkTextBuffer     *register_buffer,
   SerializationContext context;
   GString *text;
 
-  context.tags = g_hash_table_new (NULL, NULL);
-  context.text_str = g_string_new (NULL);
-  context.tag_table_str = g_string_new (NULL);
-  context.start = *start;
-  context.end = *end;
-  context.n_pixbufs = 0;
-  context.pixbufs = NULL;
-  context.tag_id = 0;
-  context.tag_id_tags = g_hash_table_new (NULL, NULL);
+  serialization_context_init (&context, start, end);
 
   /* We need to serialize the text before the tag table so we know
      what tags are used */
@@ -645,17 +762,118 @@ _gtk_text_buffer_serialize_rich_text (GtkTextBuffer     *register_buffer,
   context.pixbufs = g_list_reverse (context.pixbufs);
   serialize_pixbufs (&context, text);
 
-  g_hash_table_destroy (context.tags);
-  g_list_free (context.pixbufs);
-  g_string_free (context.text_str, TRUE);
-  g_string_free (context.tag_table_str, TRUE);
-  g_hash_table_destroy (context.tag_id_tags);
+  serialization_context_free (&context);
 
   *length = text->len;
 
   return (guint8 *) g_string_free (text, FALSE);
 }
 
+/* Writes the same data as _gtk_text_buffer_serialize_rich_text() to
+ * @stream, without ever holding more than SERIALIZE_FLUSH_SIZE bytes
+ * of text markup or more than one serialized pixbuf in memory.
+ *
+ * The contents section header carries the length of the markup and
+ * the tag table has to come before the text, so the text is walked
+ * twice: the first pass only measures it and collects the tags and
+ * pixbufs it uses, the second one writes it out.
+ */
+gboolean
+_gtk_text_buffer_serialize_rich_text_to_stream (GtkTextBuffer          *register_buffer,
+                                                GtkTextBuffer          *content_buffer,
+                                                const GtkTextIter      *start,
+                                                const GtkTextIter      *end,
+                                                GOutputStream          *stream,
+                                                GCancellable           *cancellable,
+                                                GFileProgressCallback   progress_callback,
+                                                gpointer                progress_data,
+                                                GError                **error)
+{
+  SerializationContext context;
+  GString *header;
+  goffset contents_length;
+  goffset text_length;
+  GList *list;
+
+  serialization_context_init (&context, start, end);
+  context.flush_text = TRUE;
+
+  serialize_text (content_buffer, &context);
+  serialize_flush_text (&context);
+  serialize_tags (&context);
+
+  text_length = context.text_flushed;
+  contents_length = context.tag_table_str->len + text_length;
+
+  if (contents_length > G_MAXINT)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                           _("Text is too large to be serialized"));
+      serialization_context_free (&context);
+      return FALSE;
+    }
+
+  context.total = 30 + contents_length;
+  for (list = context.pixbufs; list != NULL; list = list->next)
+    {
+      GdkPixdata pixdata;
+
+      /* Without RLE this doesn't copy the pixels */
+      gdk_pixdata_from_pixbuf (&pixdata, list->data, FALSE);
+      context.total += 30 + pixdata.length;
+    }
+
+  context.stream = stream;
+  context.cancellable = cancellable;
+  context.progress_callback = progress_callback;
+  context.progress_data = progress_data;
+
+  header = g_string_sized_new (30);
+  serialize_section_header (header, "GTKTEXTBUFFERCONTENTS-0001", contents_length);
+  serialize_write (&context, header->str, header->len);
+  serialize_write (&context, context.tag_table_str->str, context.tag_table_str->len);
+
+  g_list_free (context.pixbufs);
+  context.pixbufs = NULL;
+  context.n_pixbufs = 0;
+  context.text_flushed = 0;
+
+  serialize_text (content_buffer, &context);
+  serialize_flush_text (&context);
+
+  if (context.error == NULL && context.text_flushed != text_length)
+    g_set_error_literal (&context.error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                         _("Text buffer was modified while serializing"));
+
+  context.pixbufs = g_list_reverse (context.pixbufs);
+  for (list = context.pixbufs; list != NULL && context.error == NULL; list = list->next)
+    {
+      GdkPixdata pixdata;
+      guint8 *tmp;
+      guint len;
+
+      gdk_pixdata_from_pixbuf (&pixdata, list->data, FALSE);
+      tmp = gdk_pixdata_serialize (&pixdata, &len);
+
+      g_string_truncate (header, 0);
+      serialize_section_header (header, "GTKTEXTBUFFERPIXBDATA-0001", len);
+      serialize_write (&context, header->str, header->len);
+      serialize_write (&context, (gchar *) tmp, len);
+      g_free (tmp);
+    }
+
+  g_string_free (header, TRUE);
+  serialization_context_free (&context);
+
+  if (context.error)
+    {
+      g_propagate_error (error, context.error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
 typedef enum
 {
   STATE_START,
@@ -672,9 +890,17 @@ typedef struct
 {
   gchar *text;
   GdkPixbuf *pixbuf;
+  gint pixbuf_index;
   GSList *tags;
 } TextSpan;
 
+typedef struct
+{
+  GtkTextTag *tag;
+  gint start;
+  gint end;
+} TagRun;
+
 typedef struct
 {
   GtkTextTag *tag;
@@ -714,6 +940,12 @@ typedef struct
 
   GList *spans;
 
+  /* When reading from a stream the pixbuf sections come after the
+   * text, so <pixbuf> elements only leave a mark behind; this maps
+   * pixbuf indices to lists of those marks.
+   */
+  GHashTable *pixbuf_marks;
+
   gboolean create_tags;
 
   gboolean parsed_text;
@@ -1135,16 +1367,21 @@ parse_apply_tag_element (GMarkupParseContext  *context,
 	return;
 
       int_id = atoi (pixbuf_id);
-      pixbuf = get_pixbuf_from_headers (info->headers, int_id, error);
 
       span = g_new0 (TextSpan, 1);
-      span->pixbuf = pixbuf;
+      span->pixbuf_index = int_id;
       span->tags = NULL;
 
       info->spans = g_list_prepend (info->spans, span);
 
-      if (!pixbuf)
-	return;
+      if (!info->pixbuf_marks)
+        {
+          pixbuf = get_pixbuf_from_headers (info->headers, int_id, error);
+          span->pixbuf = pixbuf;
+
+          if (!pixbuf)
+            return;
+        }
 
       push_state (info, STATE_PIXBUF);
     }
@@ -1529,7 +1766,6 @@ end_element_handler (GMarkupParseContext  *context,
       pop_state (info);
       g_assert (peek_state (info) == STATE_TEXT_VIEW_MARKUP);
 
-      info->spans = g_list_reverse (info->spans);
       info->parsed_text = TRUE;
       break;
     case STATE_TEXT_VIEW_MARKUP:
@@ -1625,6 +1861,7 @@ parse_info_init (ParseInfo     *info,
   info->current_tag = NULL;
   info->current_tag_prio = -1;
   info->tag_priorities = NULL;
+  info->pixbuf_marks = NULL;
 
   info->buffer = buffer;
 }
@@ -1633,6 +1870,8 @@ static void
 text_span_free (TextSpan *span)
 {
   g_free (span->text);
+  if (span->pixbuf)
+    g_object_unref (span->pixbuf);
   g_slist_free (span->tags);
   g_free (span);
 }
@@ -1673,57 +1912,149 @@ parse_info_free (ParseInfo *info)
     }
   g_list_free (info->tag_priorities);
 
+  if (info->pixbuf_marks)
+    g_hash_table_destroy (info->pixbuf_marks);
+}
+
+static void
+insert_tagged_text (ParseInfo   *info,
+                    GtkTextIter *iter,
+                    GtkTextMark *mark,
+                    GString     *text,
+                    GArray      *runs)
+{
+  GtkTextIter start_iter;
+  gint offset;
+  guint i;
+
+  if (text->len == 0)
+    return;
+
+  gtk_text_buffer_move_mark (info->buffer, mark, iter);
+  gtk_text_buffer_insert (info->buffer, iter, text->str, text->len);
+  gtk_text_buffer_get_iter_at_mark (info->buffer, &start_iter, mark);
+  offset = gtk_text_iter_get_offset (&start_iter);
+
+  /* Apply tags */
+  for (i = 0; i < runs->len; i++)
+    {
+      TagRun *run = &g_array_index (runs, TagRun, i);
+      GtkTextIter run_start, run_end;
+
+      gtk_text_buffer_get_iter_at_offset (info->buffer, &run_start,
+                                          offset + run->start);
+      gtk_text_buffer_get_iter_at_offset (info->buffer, &run_end,
+                                          offset + run->end);
+      gtk_text_buffer_apply_tag (info->buffer, run->tag,
+                                 &run_start, &run_end);
+    }
 }
 
+/* Inserts the spans parsed so far at @iter and frees them.
+ *
+ * Consecutive text spans are inserted with a single
+ * gtk_text_buffer_insert(), and a tag covering several of them in
+ * a row is applied once to the whole run rather than once per span.
+ */
 static void
 insert_text (ParseInfo   *info,
 	     GtkTextIter *iter)
 {
-  GtkTextIter start_iter;
   GtkTextMark *mark;
+  GString *text;
+  GArray *runs;
+  GHashTable *last_runs;
+  gint n_chars;
   GList *tmp;
-  GSList *tags;
 
-  start_iter = *iter;
+  if (!info->spans)
+    return;
 
-  mark = gtk_text_buffer_create_mark (info->buffer, "deserialize_insert_point",
-  				      &start_iter, TRUE);
+  info->spans = g_list_reverse (info->spans);
 
-  tmp = info->spans;
-  while (tmp)
+  mark = gtk_text_buffer_create_mark (info->buffer, NULL, iter, TRUE);
+  text = g_string_new (NULL);
+  runs = g_array_new (FALSE, FALSE, sizeof (TagRun));
+  last_runs = g_hash_table_new (NULL, NULL);
+  n_chars = 0;
+
+  for (tmp = info->spans; tmp; tmp = tmp->next)
     {
       TextSpan *span = tmp->data;
+      GSList *tags;
+      gint span_chars;
 
       if (span->text)
-	gtk_text_buffer_insert (info->buffer, iter, span->text, -1);
-      else
-	{
-	  gtk_text_buffer_insert_pixbuf (info->buffer, iter, span->pixbuf);
-	  g_object_unref (span->pixbuf);
-	}
-      gtk_text_buffer_get_iter_at_mark (info->buffer, &start_iter, mark);
+        {
+          span_chars = g_utf8_strlen (span->text, -1);
 
-      /* Apply tags */
-      tags = span->tags;
-      while (tags)
-	{
-	  GtkTextTag *tag = tags->data;
+          for (tags = span->tags; tags; tags = tags->next)
+            {
+              TagRun *run = NULL;
+              gpointer run_index;
 
-	  gtk_text_buffer_apply_tag (info->buffer, tag,
-				     &start_iter, iter);
+              /* Extend the tag's previous run if it ends here */
+              if (g_hash_table_lookup_extended (last_runs, tags->data, NULL, &run_index))
+                {
+                  run = &g_array_index (runs, TagRun, GPOINTER_TO_INT (run_index));
 
-	  tags = tags->next;
-	}
+                  if (run->end != n_chars)
+                    run = NULL;
+                }
 
-      gtk_text_buffer_move_mark (info->buffer, mark, iter);
+              if (!run)
+                {
+                  TagRun new_run = { tags->data, n_chars, n_chars };
 
-      tmp = tmp->next;
+                  g_array_append_val (runs, new_run);
+                  g_hash_table_insert (last_runs, tags->data,
+                                       GINT_TO_POINTER (runs->len - 1));
+                  run = &g_array_index (runs, TagRun, runs->len - 1);
+                }
+
+              run->end = n_chars + span_chars;
+            }
+
+          g_string_append (text, span->text);
+          n_chars += span_chars;
+
+          continue;
+        }
+
+      insert_tagged_text (info, iter, mark, text, runs);
+      g_string_truncate (text, 0);
+      g_array_set_size (runs, 0);
+      g_hash_table_remove_all (last_runs);
+      n_chars = 0;
+
+      if (span->pixbuf)
+        {
+          gtk_text_buffer_insert_pixbuf (info->buffer, iter, span->pixbuf);
+        }
+      else if (info->pixbuf_marks)
+        {
+          GtkTextMark *pixbuf_mark;
+          GSList *marks;
+
+          pixbuf_mark = gtk_text_buffer_create_mark (info->buffer, NULL, iter, TRUE);
+          marks = g_hash_table_lookup (info->pixbuf_marks,
+                                       GINT_TO_POINTER (span->pixbuf_index));
+          g_hash_table_insert (info->pixbuf_marks,
+                               GINT_TO_POINTER (span->pixbuf_index),
+                               g_slist_prepend (marks, pixbuf_mark));
+        }
     }
 
-  gtk_text_buffer_delete_mark (info->buffer, mark);
-}
+  insert_tagged_text (info, iter, mark, text, runs);
 
+  gtk_text_buffer_delete_mark (info->buffer, mark);
+  g_string_free (text, TRUE);
+  g_array_free (runs, TRUE);
+  g_hash_table_destroy (last_runs);
 
+  g_list_free_full (info->spans, (GDestroyNotify) text_span_free);
+  info->spans = NULL;
+}
 
 static int
 read_int (const guchar *start)
@@ -1795,6 +2126,20 @@ read_headers (const gchar *start,
   return NULL;
 }
 
+static const GMarkupParser rich_text_parser = {
+  start_element_handler,
+  end_element_handler,
+  text_handler,
+  NULL,
+  NULL
+};
+
+/* When reading from a stream, markup is handed to GMarkup this many
+ * bytes at a time, and the spans parsed from each piece are inserted
+ * before the next one.
+ */
+#define DESERIALIZE_CHUNK_SIZE (64 * 1024)
+
 static gboolean
 deserialize_text (GtkTextBuffer *buffer,
 		  GtkTextIter   *iter,
@@ -1808,14 +2153,6 @@ deserialize_text (GtkTextBuffer *buffer,
   ParseInfo info;
   gboolean retval = FALSE;
 
-  static const GMarkupParser rich_text_parser = {
-    start_element_handler,
-    end_element_handler,
-    text_handler,
-    NULL,
-    NULL
-  };
-
   parse_info_init (&info, buffer, create_tags, headers);
 
   context = g_markup_parse_context_new (&rich_text_parser,
@@ -1832,7 +2169,7 @@ deserialize_text (GtkTextBuffer *buffer,
 
   retval = TRUE;
 
-  /* Now insert the text */
+  /* Now insert the text, only if all of it could be parsed */
   insert_text (&info, iter);
 
  out:
@@ -1883,3 +2220,302 @@ _gtk_text_buffer_deserialize_rich_text (GtkTextBuffer *register_buffer,
 
   return retval;
 }
+
+static gboolean
+read_section_header (GInputStream  *stream,
+                     guchar        *header,
+                     gsize         *bytes_read,
+                     GCancellable  *cancellable,
+                     GError       **error)
+{
+  if (!g_input_stream_read_all (stream, header, 30, bytes_read,
+                                cancellable, error))
+    return FALSE;
+
+  if (*bytes_read != 0 && *bytes_read != 30)
+    {
+      g_set_error_literal (error,
+                           G_MARKUP_ERROR,
+                           G_MARKUP_ERROR_PARSE,
+                           _("Serialized data is malformed"));
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+make_pixbuf_marks_right_gravity (gpointer key,
+                                 gpointer value,
+                                 gpointer user_data)
+{
+  GtkTextBuffer *buffer = user_data;
+  GSList *marks;
+
+  for (marks = value; marks; marks = marks->next)
+    {
+      GtkTextMark *mark = marks->data;
+      GtkTextIter iter;
+
+      gtk_text_buffer_get_iter_at_mark (buffer, &iter, mark);
+      marks->data = gtk_text_buffer_create_mark (buffer, NULL, &iter, FALSE);
+      gtk_text_buffer_delete_mark (buffer, mark);
+    }
+}
+
+static void
+delete_pixbuf_marks (gpointer key,
+                     gpointer value,
+                     gpointer user_data)
+{
+  GtkTextBuffer *buffer = user_data;
+  GSList *marks;
+
+  for (marks = value; marks; marks = marks->next)
+    gtk_text_buffer_delete_mark (buffer, marks->data);
+
+  g_slist_free (value);
+}
+
+static void
+insert_deferred_pixbuf (ParseInfo *info,
+                        gint       pixbuf_index,
+                        GdkPixbuf *pixbuf,
+                        GSList    *enclosing_tags)
+{
+  GSList *marks, *list;
+
+  marks = g_hash_table_lookup (info->pixbuf_marks, GINT_TO_POINTER (pixbuf_index));
+  g_hash_table_remove (info->pixbuf_marks, GINT_TO_POINTER (pixbuf_index));
+
+  for (list = marks; list; list = list->next)
+    {
+      GtkTextIter start, end;
+      GSList *tags, *l;
+
+      gtk_text_buffer_get_iter_at_mark (info->buffer, &end, list->data);
+      gtk_text_buffer_insert_pixbuf (info->buffer, &end, pixbuf);
+      gtk_text_buffer_delete_mark (info->buffer, list->data);
+
+      /* The pixbuf went into text that has already been tagged, but
+       * pixbufs don't carry tags of their own in this format. Inserted
+       * in one go, it would only have gotten the tags enclosing the
+       * insertion point, so remove all others.
+       */
+      start = end;
+      gtk_text_iter_backward_char (&start);
+
+      tags = gtk_text_iter_get_tags (&start);
+      for (l = tags; l; l = l->next)
+        {
+          if (!g_slist_find (enclosing_tags, l->data))
+            gtk_text_buffer_remove_tag (info->buffer, l->data, &start, &end);
+        }
+      g_slist_free (tags);
+    }
+
+  g_slist_free (marks);
+}
+
+/* Reads what _gtk_text_buffer_serialize_rich_text() writes from
+ * @stream, inserting the text in batches as it is parsed. Pixbufs
+ * are inserted once their sections, which follow the text, have
+ * been read. If an error occurs, the text read up to that point
+ * stays in the buffer.
+ */
+gboolean
+_gtk_text_buffer_deserialize_rich_text_from_stream (GtkTextBuffer          *register_buffer,
+                                                    GtkTextBuffer          *content_buffer,
+                                                    GtkTextIter            *iter,
+                                                    GInputStream           *stream,
+                                                    gboolean                create_tags,
+                                                    GCancellable           *cancellable,
+                                                    GFileProgressCallback   progress_callback,
+                                                    gpointer                progress_data,
+                                                    GError                **error)
+{
+  GMarkupParseContext *context;
+  ParseInfo info;
+  GtkTextMark *end_mark;
+  GtkTextIter before;
+  GSList *enclosing_tags;
+  guchar header[30];
+  gchar *chunk;
+  gsize bytes_read;
+  goffset total_read;
+  gint remaining;
+  gint pixbuf_index;
+  gboolean retval = FALSE;
+
+  if (!read_section_header (stream, header, &bytes_read, cancellable, error))
+    return FALSE;
+
+  if (bytes_read == 0 ||
+      strncmp ((gchar *) header, "GTKTEXTBUFFERCONTENTS-0001", 26) != 0)
+    {
+      g_set_error_literal (error,
+                           G_MARKUP_ERROR,
+                           G_MARKUP_ERROR_PARSE,
+                           _("Serialized data is malformed. First section isn't GTKTEXTBUFFERCONTENTS-0001"));
+      return FALSE;
+    }
+
+  remaining = read_int (header + 26);
+  total_read = 30;
+
+  /* The tags text inserted at @iter would get from the buffer */
+  enclosing_tags = NULL;
+  before = *iter;
+  if (gtk_text_iter_backward_char (&before))
+    {
+      GSList *tags, *l;
+
+      tags = gtk_text_iter_get_tags (&before);
+      for (l = tags; l; l = l->next)
+        {
+          if (gtk_text_iter_has_tag (iter, l->data))
+            enclosing_tags = g_slist_prepend (enclosing_tags, l->data);
+        }
+      g_slist_free (tags);
+    }
+
+  parse_info_init (&info, content_buffer, create_tags, NULL);
+  info.pixbuf_marks = g_hash_table_new (NULL, NULL);
+
+  context = g_markup_parse_context_new (&rich_text_parser,
+                                        0, &info, NULL);
+
+  end_mark = NULL;
+  chunk = g_malloc (DESERIALIZE_CHUNK_SIZE);
+
+  while (remaining > 0)
+    {
+      if (!g_input_stream_read_all (stream, chunk,
+                                    MIN (remaining, DESERIALIZE_CHUNK_SIZE),
+                                    &bytes_read, cancellable, error))
+        goto out;
+
+      if (bytes_read == 0)
+        {
+          g_set_error_literal (error,
+                               G_MARKUP_ERROR,
+                               G_MARKUP_ERROR_PARSE,
+                               _("Serialized data is malformed"));
+          goto out;
+        }
+
+      if (!g_markup_parse_context_parse (context, chunk, bytes_read, error))
+        goto out;
+
+      insert_text (&info, iter);
+
+      remaining -= bytes_read;
+      total_read += bytes_read;
+
+      if (progress_callback)
+        progress_callback (total_read, -1, progress_data);
+    }
+
+  if (!g_markup_parse_context_end_parse (context, error))
+    goto out;
+
+  /* No more text goes in from here on; pixbufs sharing a position
+   * now have to end up in section order, so the marks must move
+   * past each pixbuf inserted at them.
+   */
+  g_hash_table_foreach (info.pixbuf_marks,
+                        make_pixbuf_marks_right_gravity, content_buffer);
+  end_mark = gtk_text_buffer_create_mark (content_buffer, NULL, iter, FALSE);
+
+  for (pixbuf_index = 0; g_hash_table_size (info.pixbuf_marks) > 0; pixbuf_index++)
+    {
+      GdkPixdata pixdata;
+      GdkPixbuf *pixbuf;
+      guint8 *data;
+      gint length;
+
+      if (!read_section_header (stream, header, &bytes_read, cancellable, error))
+        goto out;
+
+      /* pixbufs are still missing */
+      if (bytes_read == 0 ||
+          strncmp ((gchar *) header, "GTKTEXTBUFFERPIXBDATA-0001", 26) != 0)
+        {
+          g_set_error_literal (error,
+                               G_MARKUP_ERROR,
+                               G_MARKUP_ERROR_PARSE,
+                               _("Serialized data is malformed"));
+          goto out;
+        }
+
+      length = read_int (header + 26);
+      if (length < 0)
+        {
+          g_set_error_literal (error,
+                               G_MARKUP_ERROR,
+                               G_MARKUP_ERROR_PARSE,
+                               _("Serialized data is malformed"));
+          goto out;
+        }
+
+      data = g_malloc (length);
+      if (!g_input_stream_read_all (stream, data, length, &bytes_read,
+                                    cancellable, error))
+        {
+          g_free (data);
+          goto out;
+        }
+
+      if (bytes_read != (gsize) length)
+        {
+          g_free (data);
+          g_set_error_literal (error,
+                               G_MARKUP_ERROR,
+                               G_MARKUP_ERROR_PARSE,
+                               _("Serialized data is malformed"));
+          goto out;
+        }
+
+      total_read += 30 + length;
+
+      if (!gdk_pixdata_deserialize (&pixdata, length, data, error))
+        {
+          g_free (data);
+          goto out;
+        }
+
+      pixbuf = gdk_pixbuf_from_pixdata (&pixdata, TRUE, error);
+      g_free (data);
+
+      if (!pixbuf)
+        goto out;
+
+      insert_deferred_pixbuf (&info, pixbuf_index, pixbuf, enclosing_tags);
+      g_object_unref (pixbuf);
+
+      if (progress_callback)
+        progress_callback (total_read, -1, progress_data);
+    }
+
+  retval = TRUE;
+
+ out:
+  g_free (chunk);
+  g_slist_free (enclosing_tags);
+
+  g_hash_table_foreach (info.pixbuf_marks,
+                        delete_pixbuf_marks, content_buffer);
+  g_hash_table_remove_all (info.pixbuf_marks);
+
+  if (end_mark)
+    {
+      gtk_text_buffer_get_iter_at_mark (content_buffer, iter, end_mark);
+      gtk_text_buffer_delete_mark (content_buffer, end_mark);
+    }
+
+  parse_info_free (&info);
+
+  g_markup_parse_context_free (context);
+
+  return retval;
+}
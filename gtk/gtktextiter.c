@@ -4845,6 +4845,268 @@ strbreakup (const char *string,
   return str_array;
 }
 
+/* GtkTextSearch holds everything about a search string that
+ * does not depend on the text being searched, so that searching
+ * for all occurrences of a string only prepares it once.
+ *
+ * Exact searches for a single line, by far the most common case,
+ * don't go through lines_match(): they run a Horspool search over
+ * the bytes of the line's segments in place, and only allocate to
+ * join lines that are split into several segments by tags, marks
+ * or embedded objects.
+ */
+struct _GtkTextSearch
+{
+  gchar **lines;
+  gsize needle_len;
+  gsize shift[256];
+  GString *line_text;
+  guint visible_only : 1;
+  guint slice : 1;
+  guint case_insensitive : 1;
+  guint bytewise : 1;
+};
+
+GtkTextSearch *
+_gtk_text_search_new (const gchar        *str,
+                      GtkTextSearchFlags  flags)
+{
+  GtkTextSearch *search;
+
+  g_return_val_if_fail (str != NULL && *str != '\0', NULL);
+
+  search = g_slice_new0 (GtkTextSearch);
+
+  search->visible_only = (flags & GTK_TEXT_SEARCH_VISIBLE_ONLY) != 0;
+  search->slice = (flags & GTK_TEXT_SEARCH_TEXT_ONLY) == 0;
+  search->case_insensitive = (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE) != 0;
+
+  search->lines = strbreakup (str, "\n", -1, NULL, search->case_insensitive);
+
+  /* A needle ending in a line delimiter is still a single piece,
+   * but a match would end past the line's text.
+   */
+  search->bytewise = search->slice &&
+                     !search->visible_only &&
+                     !search->case_insensitive &&
+                     search->lines[0] != NULL &&
+                     search->lines[1] == NULL &&
+                     strpbrk (search->lines[0], "\n\r") == NULL &&
+                     strstr (search->lines[0], "\342\200\251") == NULL;
+
+  if (search->bytewise)
+    {
+      const guchar *needle = (const guchar *) search->lines[0];
+      gsize i;
+
+      search->needle_len = strlen (search->lines[0]);
+
+      for (i = 0; i < G_N_ELEMENTS (search->shift); i++)
+        search->shift[i] = search->needle_len;
+      for (i = 0; i + 1 < search->needle_len; i++)
+        search->shift[needle[i]] = search->needle_len - 1 - i;
+
+      search->line_text = g_string_new (NULL);
+    }
+
+  return search;
+}
+
+void
+_gtk_text_search_free (GtkTextSearch *search)
+{
+  g_strfreev (search->lines);
+  if (search->line_text)
+    g_string_free (search->line_text, TRUE);
+
+  g_slice_free (GtkTextSearch, search);
+}
+
+/* Returns the text of @line as it would appear in a slice,
+ * without copying it if it is stored in a single segment.
+ */
+static const gchar *
+search_get_line_text (GtkTextSearch *search,
+                      GtkTextLine   *line,
+                      gint          *len)
+{
+  GtkTextLineSegment *seg;
+  GtkTextLineSegment *text_seg = NULL;
+  gint n_text_segs = 0;
+
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (seg->byte_count > 0)
+        {
+          text_seg = seg;
+          n_text_segs++;
+        }
+    }
+
+  if (n_text_segs == 0)
+    {
+      *len = 0;
+      return "";
+    }
+
+  if (n_text_segs == 1 && text_seg->type == &gtk_text_char_type)
+    {
+      *len = text_seg->byte_count;
+      return text_seg->body.chars;
+    }
+
+  g_string_truncate (search->line_text, 0);
+
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (seg->type == &gtk_text_char_type)
+        g_string_append_len (search->line_text,
+                             seg->body.chars, seg->byte_count);
+      else if (seg->byte_count > 0)
+        g_string_append_len (search->line_text,
+                             _gtk_text_unknown_char_utf8,
+                             GTK_TEXT_UNKNOWN_CHAR_UTF8_LEN);
+    }
+
+  *len = search->line_text->len;
+  return search->line_text->str;
+}
+
+static const gchar *
+search_find_bytes (GtkTextSearch *search,
+                   const gchar   *text,
+                   gsize          len)
+{
+  const guchar *needle = (const guchar *) search->lines[0];
+  const guchar *p = (const guchar *) text;
+  gsize n = search->needle_len;
+  gsize i;
+
+  if (len < n)
+    return NULL;
+
+  if (n == 1)
+    return memchr (text, needle[0], len);
+
+  i = 0;
+  while (i <= len - n)
+    {
+      guchar last = p[i + n - 1];
+
+      if (last == needle[n - 1] &&
+          memcmp (p + i, needle, n - 1) == 0)
+        return text + i;
+
+      i += search->shift[last];
+    }
+
+  return NULL;
+}
+
+static gboolean
+search_line_bytewise (GtkTextSearch     *search,
+                      const GtkTextIter *start,
+                      GtkTextIter       *match_start,
+                      GtkTextIter       *match_end)
+{
+  GtkTextBTree *tree;
+  GtkTextLine *line;
+  const gchar *text;
+  const gchar *found;
+  gint start_index;
+  gint len;
+
+  tree = _gtk_text_iter_get_btree (start);
+  line = _gtk_text_iter_get_text_line (start);
+  start_index = gtk_text_iter_get_line_index (start);
+
+  text = search_get_line_text (search, line, &len);
+
+  /* the newline after the end iter is not part of the buffer */
+  if (_gtk_text_line_contains_end_iter (line, tree))
+    {
+      GtkTextIter end;
+
+      _gtk_text_btree_get_end_iter (tree, &end);
+      len = MIN (len, gtk_text_iter_get_line_index (&end));
+    }
+
+  if (start_index >= len)
+    return FALSE;
+
+  found = search_find_bytes (search, text + start_index, len - start_index);
+  if (found == NULL)
+    return FALSE;
+
+  _gtk_text_btree_get_iter_at_line (tree, match_start, line,
+                                    found - text);
+  _gtk_text_btree_get_iter_at_line (tree, match_end, line,
+                                    found - text + search->needle_len);
+
+  return TRUE;
+}
+
+/* Searches forward from @iter for the next match starting at or
+ * after @iter. At most @max_lines lines are looked at, or all of
+ * them if @max_lines is negative. If no match is found, @iter is
+ * left where the search should continue: at the start of the first
+ * line that wasn't looked at, or at @limit or the end of the buffer
+ * if there is nothing left to search.
+ */
+gboolean
+_gtk_text_search_forward (GtkTextSearch     *search,
+                          GtkTextIter       *iter,
+                          const GtkTextIter *limit,
+                          gint               max_lines,
+                          GtkTextIter       *match_start,
+                          GtkTextIter       *match_end)
+{
+  GtkTextIter start, end;
+  gboolean found;
+
+  do
+    {
+      if (limit &&
+          gtk_text_iter_compare (iter, limit) >= 0)
+        {
+          *iter = *limit;
+          return FALSE;
+        }
+
+      if (max_lines == 0)
+        return FALSE;
+      else if (max_lines > 0)
+        max_lines--;
+
+      if (search->bytewise)
+        found = search_line_bytewise (search, iter, &start, &end);
+      else
+        found = lines_match (iter, (const gchar **) search->lines,
+                             search->visible_only, search->slice,
+                             search->case_insensitive, &start, &end);
+
+      if (found)
+        {
+          if (limit &&
+              gtk_text_iter_compare (&end, limit) > 0)
+            {
+              *iter = *limit;
+              return FALSE;
+            }
+
+          if (match_start)
+            *match_start = start;
+          if (match_end)
+            *match_end = end;
+
+          return TRUE;
+        }
+    }
+  while (gtk_text_iter_forward_line (iter));
+
+  return FALSE;
+}
+
 /**
  * gtk_text_iter_forward_search:
  * @iter: start of search
@@ -4881,13 +5143,10 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
                               GtkTextIter       *match_end,
                               const GtkTextIter *limit)
 {
-  gchar **lines = NULL;
+  GtkTextSearch *search;
   GtkTextIter match;
-  gboolean retval = FALSE;
-  GtkTextIter search;
-  gboolean visible_only;
-  gboolean slice;
-  gboolean case_insensitive;
+  GtkTextIter start;
+  gboolean retval;
 
   g_return_val_if_fail (iter != NULL, FALSE);
   g_return_val_if_fail (str != NULL, FALSE);
@@ -4917,50 +5176,13 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
         return FALSE;
     }
 
-  visible_only = (flags & GTK_TEXT_SEARCH_VISIBLE_ONLY) != 0;
-  slice = (flags & GTK_TEXT_SEARCH_TEXT_ONLY) == 0;
-  case_insensitive = (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE) != 0;
-
-  /* locate all lines */
-
-  lines = strbreakup (str, "\n", -1, NULL, case_insensitive);
-
-  search = *iter;
+  search = _gtk_text_search_new (str, flags);
+  start = *iter;
 
-  do
-    {
-      /* This loop has an inefficient worst-case, where
-       * gtk_text_iter_get_text () is called repeatedly on
-       * a single line.
-       */
-      GtkTextIter end;
-
-      if (limit &&
-          gtk_text_iter_compare (&search, limit) >= 0)
-        break;
-      
-      if (lines_match (&search, (const gchar**)lines,
-                       visible_only, slice, case_insensitive, &match, &end))
-        {
-          if (limit == NULL ||
-              (limit &&
-               gtk_text_iter_compare (&end, limit) <= 0))
-            {
-              retval = TRUE;
-              
-              if (match_start)
-                *match_start = match;
-              
-              if (match_end)
-                *match_end = end;
-            }
-          
-          break;
-        }
-    }
-  while (gtk_text_iter_forward_line (&search));
+  retval = _gtk_text_search_forward (search, &start, limit, -1,
+                                     match_start, match_end);
 
-  g_strfreev ((gchar**)lines);
+  _gtk_text_search_free (search);
 
   return retval;
 }
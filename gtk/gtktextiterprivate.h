@@ -43,6 +43,18 @@ gboolean            _gtk_text_iter_backward_indexable_segment (GtkTextIter
 gint                _gtk_text_iter_get_segment_byte           (const GtkTextIter *iter);
 gint                _gtk_text_iter_get_segment_char           (const GtkTextIter *iter);
 
+typedef struct _GtkTextSearch GtkTextSearch;
+
+GtkTextSearch *     _gtk_text_search_new                      (const gchar        *str,
+                                                               GtkTextSearchFlags  flags);
+void                _gtk_text_search_free                     (GtkTextSearch      *search);
+gboolean            _gtk_text_search_forward                  (GtkTextSearch      *search,
+                                                               GtkTextIter        *iter,
+                                                               const GtkTextIter  *limit,
+                                                               gint                max_lines,
+                                                               GtkTextIter        *match_start,
+                                                               GtkTextIter        *match_end);
+
 
 /* debug */
 void _gtk_text_iter_check (const GtkTextIter *iter);
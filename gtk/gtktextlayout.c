@@ -83,6 +83,7 @@
 #include "gtktextbtree.h"
 #include "gtktextiterprivate.h"
 #include "gtktextutil.h"
+#include "gtkdebug.h"
 #include "gtkintl.h"
 
 #include <stdlib.h>
@@ -98,8 +99,33 @@ struct _GtkTextLayoutPrivate
      direction only influences the direction of the cursor line.
   */
   GtkTextLine *cursor_line;
+
+  /* Cache of recently used line displays. Lines are only cached while
+   * they have line data for this layout, so that freeing the line data
+   * takes care of removing displays for deleted lines.
+   */
+  GHashTable *display_cache;   /* GtkTextLine => link in display_lru */
+  GQueue display_lru;          /* GtkTextLineDisplays, most recent first */
+  guint display_cache_hits;
+  guint display_cache_misses;
+
+  /* Bumped whenever line sizes are invalidated, so that sizes
+   * computed by gtk_text_layout_validate_async() in a worker
+   * thread can be discarded if they are out of date.
+   */
+  guint wrap_stamp;
+
+  /* Line whose size is being committed from a worker thread;
+   * gtk_text_layout_real_wrap() uses the given size for it.
+   */
+  GtkTextLine *presized_line;
+  gint presized_width;
+  gint presized_height;
 };
 
+/* Enough to cover a screenful of lines, so that redraws don't reshape */
+#define DISPLAY_CACHE_SIZE 256
+
 static GtkTextLineData *gtk_text_layout_real_wrap (GtkTextLayout *layout,
                                                    GtkTextLine *line,
                                                    /* may be NULL */
@@ -128,6 +154,8 @@ static void gtk_text_layout_emit_changed           (GtkTextLayout     *layout,
 
 static void gtk_text_layout_invalidate_all (GtkTextLayout *layout);
 
+static void gtk_text_layout_clear_display_cache (GtkTextLayout *layout);
+
 static PangoAttribute *gtk_text_attr_appearance_new (const GtkTextAppearance *appearance);
 
 static void gtk_text_layout_mark_set_handler    (GtkTextBuffer     *buffer,
@@ -146,6 +174,14 @@ static void gtk_text_layout_buffer_delete_range (GtkTextBuffer     *textbuffer,
 
 static void gtk_text_layout_update_cursor_line (GtkTextLayout *layout);
 
+static GtkTextLineDisplay *get_line_display (GtkTextLayout *layout,
+                                             GtkTextLine   *line,
+                                             gboolean       size_only,
+                                             gboolean       measure);
+static gboolean totally_invisible_line (GtkTextLayout *layout,
+                                        GtkTextLine   *line,
+                                        GtkTextIter   *iter);
+
 static void line_display_index_to_iter (GtkTextLayout      *layout,
 	                                GtkTextLineDisplay *display,
 			                GtkTextIter        *iter,
@@ -194,12 +230,7 @@ gtk_text_layout_dispose (GObject *object)
   g_clear_object (&layout->ltr_context);
   g_clear_object (&layout->rtl_context);
 
-  if (layout->one_display_cache)
-    {
-      GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-      layout->one_display_cache = NULL;
-      gtk_text_layout_free_line_display (layout, tmp_display);
-    }
+  gtk_text_layout_clear_display_cache (layout);
 
   if (layout->preedit_attrs != NULL)
     {
@@ -215,7 +246,16 @@ gtk_text_layout_finalize (GObject *object)
 {
   GtkTextLayout *layout;
 
+  GtkTextLayoutPrivate *priv;
+
   layout = GTK_TEXT_LAYOUT (object);
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  GTK_NOTE (TEXT,
+            g_print ("line display cache: %u hits, %u misses\n",
+                     priv->display_cache_hits, priv->display_cache_misses));
+
+  g_hash_table_unref (priv->display_cache);
 
   g_free (layout->preedit_string);
 
@@ -279,7 +319,12 @@ gtk_text_layout_class_init (GtkTextLayoutClass *klass)
 static void
 gtk_text_layout_init (GtkTextLayout *text_layout)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (text_layout);
+
   text_layout->cursor_visible = TRUE;
+
+  priv->display_cache = g_hash_table_new (NULL, NULL);
+  g_queue_init (&priv->display_lru);
 }
 
 GtkTextLayout*
@@ -313,6 +358,7 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
     return;
 
   free_style_cache (layout);
+  gtk_text_layout_clear_display_cache (layout);
 
   if (layout->buffer)
     {
@@ -638,18 +684,22 @@ text_layout_changed (GtkTextLayout *layout,
                      gint           new_height,
                      gboolean       cursors_only)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *l, *next;
+
+  /* Check if the range intersects our cached line displays,
+   * and invalidate the cached lines if so.
    */
-  if (layout->one_display_cache)
+  for (l = priv->display_lru.head; l != NULL; l = next)
     {
-      GtkTextLine *line = layout->one_display_cache->line;
+      GtkTextLineDisplay *display = l->data;
       gint cache_y = _gtk_text_btree_find_line_top (_gtk_text_buffer_get_btree (layout->buffer),
-						    line, layout);
-      gint cache_height = layout->one_display_cache->height;
+						    display->line, layout);
+
+      next = l->next;
 
-      if (cache_y + cache_height > y && cache_y < y + old_height)
-	gtk_text_layout_invalidate_cache (layout, line, cursors_only);
+      if (cache_y + display->height > y && cache_y < y + old_height)
+	gtk_text_layout_invalidate_cache (layout, display->line, cursors_only);
     }
 
   gtk_text_layout_emit_changed (layout, y, old_height, new_height);
@@ -816,14 +866,119 @@ gtk_text_layout_invalidate_all (GtkTextLayout *layout)
   gtk_text_layout_invalidate (layout, &start, &end);
 }
 
+static void
+line_display_free (GtkTextLineDisplay *display)
+{
+  if (display->layout)
+    g_object_unref (display->layout);
+
+  if (display->cursors)
+    g_array_free (display->cursors, TRUE);
+
+  if (display->pg_bg_color)
+    gdk_color_free (display->pg_bg_color);
+
+  if (display->pg_bg_rgba)
+    gdk_rgba_free (display->pg_bg_rgba);
+
+  g_slice_free (GtkTextLineDisplay, display);
+}
+
+static gboolean
+display_is_cached (GtkTextLayout      *layout,
+                   GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_cache, display->line);
+
+  return link != NULL && link->data == display;
+}
+
+static void
+display_cache_remove (GtkTextLayout *layout,
+                      GList         *link)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLineDisplay *display = link->data;
+
+  g_hash_table_remove (priv->display_cache, display->line);
+  g_queue_delete_link (&priv->display_lru, link);
+
+  line_display_free (display);
+}
+
+static void
+display_cache_insert (GtkTextLayout      *layout,
+                      GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  /* Without line data we wouldn't hear about the line going away */
+  if (_gtk_text_line_get_data (display->line, layout) == NULL)
+    return;
+
+  g_queue_push_head (&priv->display_lru, display);
+  g_hash_table_insert (priv->display_cache, display->line, priv->display_lru.head);
+
+  if (priv->display_lru.length > DISPLAY_CACHE_SIZE)
+    display_cache_remove (layout, priv->display_lru.tail);
+}
+
+static void
+gtk_text_layout_clear_display_cache (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  while (priv->display_lru.head)
+    display_cache_remove (layout, priv->display_lru.head);
+}
+
+/**
+ * gtk_text_layout_get_display_cache_stats:
+ * @layout: a #GtkTextLayout
+ * @n_cached: (out) (allow-none): return location for the number of
+ *     cached line displays
+ * @hits: (out) (allow-none): return location for the number of times
+ *     a line display was found in the cache
+ * @misses: (out) (allow-none): return location for the number of times
+ *     a line display had to be created
+ *
+ * Gets statistics about the line display cache of @layout.
+ */
+void
+gtk_text_layout_get_display_cache_stats (GtkTextLayout *layout,
+                                         guint         *n_cached,
+                                         guint         *hits,
+                                         guint         *misses)
+{
+  GtkTextLayoutPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
+
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  if (n_cached)
+    *n_cached = priv->display_lru.length;
+  if (hits)
+    *hits = priv->display_cache_hits;
+  if (misses)
+    *misses = priv->display_cache_misses;
+}
+
 static void
 gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
                                   GtkTextLine   *line,
 				  gboolean       cursors_only)
 {
-  if (layout->one_display_cache && line == layout->one_display_cache->line)
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_cache, line);
+  if (link)
     {
-      GtkTextLineDisplay *display = layout->one_display_cache;
+      GtkTextLineDisplay *display = link->data;
 
       if (cursors_only)
 	{
@@ -834,10 +989,7 @@ gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
 	  display->has_block_cursor = FALSE;
 	}
       else
-	{
-	  layout->one_display_cache = NULL;
-	  gtk_text_layout_free_line_display (layout, display);
-	}
+	display_cache_remove (layout, link);
     }
 }
 
@@ -862,6 +1014,7 @@ gtk_text_layout_invalidate_cursor_line (GtkTextLayout *layout,
 	{
 	  gtk_text_layout_invalidate_cache (layout, priv->cursor_line, FALSE);
 	  _gtk_text_line_invalidate_wrap (priv->cursor_line, line_data);
+          priv->wrap_stamp++;
 	}
 
       gtk_text_layout_invalidated (layout);
@@ -885,12 +1038,15 @@ gtk_text_layout_real_invalidate (GtkTextLayout *layout,
                                  const GtkTextIter *start,
                                  const GtkTextIter *end)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLine *line;
   GtkTextLine *last_line;
 
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
   g_return_if_fail (layout->wrap_loop_count == 0);
 
+  priv->wrap_stamp++;
+
   /* Because we may be invalidating a mark, it's entirely possible
    * that gtk_text_iter_equal (start, end) in which case we
    * should still invalidate the line they are both on. i.e.
@@ -929,32 +1085,50 @@ gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
 					 const GtkTextIter *start,
 					 const GtkTextIter *end)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLine *line;
+  GtkTextLine *last_line;
+
+  if (gtk_text_iter_compare (start, end) > 0)
+    {
+      const GtkTextIter *tmp = start;
+      start = end;
+      end = tmp;
+    }
+
+  /* Invalidate the cursors of the cached line displays in the range,
+   * walking either the range or the cache, whichever is shorter.
    */
-  if (layout->one_display_cache)
+  if (gtk_text_iter_get_line (end) - gtk_text_iter_get_line (start) <
+      (gint) priv->display_lru.length)
     {
-      GtkTextIter line_start, line_end;
-      GtkTextLine *line = layout->one_display_cache->line;
+      last_line = _gtk_text_iter_get_text_line (end);
+      line = _gtk_text_iter_get_text_line (start);
 
-      gtk_text_layout_get_iter_at_line (layout, &line_start, line, 0);
+      while (TRUE)
+        {
+          gtk_text_layout_invalidate_cache (layout, line, TRUE);
 
-      line_end = line_start;
-      if (!gtk_text_iter_ends_line (&line_end))
-	gtk_text_iter_forward_to_line_end (&line_end);
+          if (line == last_line)
+            break;
 
-      if (gtk_text_iter_compare (start, end) > 0)
-	{
-	  const GtkTextIter *tmp = start;
-	  start = end;
-	  end = tmp;
-	}
+          line = _gtk_text_line_next_excluding_last (line);
+        }
+    }
+  else
+    {
+      gint start_line = gtk_text_iter_get_line (start);
+      gint end_line = gtk_text_iter_get_line (end);
+      GList *l;
 
-      if (gtk_text_iter_compare (&line_start, end) <= 0 &&
-	  gtk_text_iter_compare (start, &line_end) <= 0)
-	{
-	  gtk_text_layout_invalidate_cache (layout, line, TRUE);
-	}
+      for (l = priv->display_lru.head; l != NULL; l = l->next)
+        {
+          GtkTextLineDisplay *display = l->data;
+          gint n = _gtk_text_line_get_number (display->line);
+
+          if (n >= start_line && n <= end_line)
+            gtk_text_layout_invalidate_cache (layout, display->line, TRUE);
+        }
     }
 
   gtk_text_layout_invalidated (layout);
@@ -965,8 +1139,13 @@ gtk_text_layout_real_free_line_data (GtkTextLayout     *layout,
                                      GtkTextLine       *line,
                                      GtkTextLineData   *line_data)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
   gtk_text_layout_invalidate_cache (layout, line, FALSE);
 
+  /* the line may be going away */
+  priv->wrap_stamp++;
+
   g_free (line_data);
 }
 
@@ -1146,12 +1325,449 @@ gtk_text_layout_validate (GtkTextLayout *layout,
     }
 }
 
+/*
+ * Validation in worker threads
+ *
+ * Shaping paragraphs with Pango is what makes validation expensive,
+ * and it only needs the text, the attributes and a few paragraph
+ * settings. gtk_text_layout_validate_async() collects those for a
+ * batch of invalid lines on the main thread, shapes them in a worker
+ * thread with a private font map and contexts set up like ours, and
+ * commits the sizes on the main thread if nothing was invalidated in
+ * the meantime.
+ */
+
+/* Lines looked at per batch */
+#define SHAPE_BATCH_LINES 256
+
+typedef struct
+{
+  GtkTextLine *line;
+
+  /* NULL if the line is validated on the main thread */
+  gchar *text;
+  gint length;
+  PangoAttrList *attrs;
+  PangoTabArray *tabs;
+  gint width;
+  PangoWrapMode wrap;
+  PangoAlignment alignment;
+  gboolean justify;
+  gint indent;
+  gint spacing;
+  gboolean rtl;
+
+  /* margins around the text */
+  gint extra_width;
+  gint extra_height;
+
+  /* set by the worker */
+  PangoRectangle extents;
+} ShapeLine;
+
+typedef struct
+{
+  GArray *lines;
+  guint wrap_stamp;
+
+  PangoFontDescription *font_desc;
+  PangoLanguage *language;
+  cairo_font_options_t *font_options;
+  gdouble resolution;
+} ShapeBatch;
+
+static GPrivate shape_font_map = G_PRIVATE_INIT (g_object_unref);
+
+static void
+shape_batch_free (ShapeBatch *batch)
+{
+  guint i;
+
+  for (i = 0; i < batch->lines->len; i++)
+    {
+      ShapeLine *sl = &g_array_index (batch->lines, ShapeLine, i);
+
+      g_free (sl->text);
+      if (sl->attrs)
+        pango_attr_list_unref (sl->attrs);
+      if (sl->tabs)
+        pango_tab_array_free (sl->tabs);
+    }
+
+  g_array_free (batch->lines, TRUE);
+
+  if (batch->font_desc)
+    pango_font_description_free (batch->font_desc);
+  if (batch->font_options)
+    cairo_font_options_destroy (batch->font_options);
+
+  g_slice_free (ShapeBatch, batch);
+}
+
+/* Whether the line can be shaped away from the main thread. Child
+ * widgets need to be allocated, and the cursor line has preedit and
+ * keyboard direction to deal with, so those are done here, as well
+ * as cached and invisible lines, which are cheap, and the last line,
+ * which is not part of the buffer.
+ */
+static gboolean
+line_can_be_shaped_in_thread (GtkTextLayout *layout,
+                              GtkTextLine   *line)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLineSegment *seg;
+  GtkTextIter iter;
+
+  if (line == priv->cursor_line ||
+      _gtk_text_line_next (line) == NULL ||
+      g_hash_table_lookup (priv->display_cache, line) != NULL)
+    return FALSE;
+
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (seg->type == &gtk_text_child_type)
+        return FALSE;
+    }
+
+  return !totally_invisible_line (layout, line, &iter);
+}
+
+static void
+shape_line_init (GtkTextLayout *layout,
+                 ShapeLine     *sl)
+{
+  GtkTextLineDisplay *display;
+  PangoLayout *pango_layout;
+  PangoAttrList *attrs;
+
+  display = get_line_display (layout, sl->line, TRUE, FALSE);
+  pango_layout = display->layout;
+
+  sl->text = g_strdup (pango_layout_get_text (pango_layout));
+  sl->length = strlen (sl->text);
+  attrs = pango_layout_get_attributes (pango_layout);
+  sl->attrs = attrs ? pango_attr_list_copy (attrs) : NULL;
+  sl->tabs = pango_layout_get_tabs (pango_layout);
+  sl->width = pango_layout_get_width (pango_layout);
+  sl->wrap = pango_layout_get_wrap (pango_layout);
+  sl->alignment = pango_layout_get_alignment (pango_layout);
+  sl->justify = pango_layout_get_justify (pango_layout);
+  sl->indent = pango_layout_get_indent (pango_layout);
+  sl->spacing = pango_layout_get_spacing (pango_layout);
+  sl->rtl = display->direction == GTK_TEXT_DIR_RTL;
+
+  sl->extra_width = display->left_margin + display->right_margin;
+  sl->extra_height = display->height;
+
+  line_display_free (display);
+}
+
+static ShapeBatch *
+shape_batch_new (GtkTextLayout *layout,
+                 gint           max_lines)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  const PangoFontDescription *font_desc;
+  const cairo_font_options_t *font_options;
+  ShapeBatch *batch;
+  GtkTextLine *line;
+  gint n_lines;
+
+  batch = g_slice_new0 (ShapeBatch);
+  batch->lines = g_array_new (FALSE, TRUE, sizeof (ShapeLine));
+  batch->wrap_stamp = priv->wrap_stamp;
+
+  font_desc = pango_context_get_font_description (layout->ltr_context);
+  batch->font_desc = font_desc ? pango_font_description_copy (font_desc) : NULL;
+  batch->language = pango_context_get_language (layout->ltr_context);
+  font_options = pango_cairo_context_get_font_options (layout->ltr_context);
+  batch->font_options = font_options ? cairo_font_options_copy (font_options) : NULL;
+  batch->resolution = pango_cairo_context_get_resolution (layout->ltr_context);
+
+  line = _gtk_text_btree_get_first_invalid_line (_gtk_text_buffer_get_btree (layout->buffer),
+                                                 layout);
+
+  for (n_lines = 0; line != NULL && n_lines < max_lines; n_lines++)
+    {
+      GtkTextLineData *ld = _gtk_text_line_get_data (line, layout);
+
+      if (!ld || !ld->valid)
+        {
+          ShapeLine *sl;
+
+          g_array_set_size (batch->lines, batch->lines->len + 1);
+          sl = &g_array_index (batch->lines, ShapeLine, batch->lines->len - 1);
+          sl->line = line;
+
+          if (line_can_be_shaped_in_thread (layout, line))
+            shape_line_init (layout, sl);
+        }
+
+      line = _gtk_text_line_next (line);
+    }
+
+  return batch;
+}
+
+static void
+shape_batch_thread (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+  ShapeBatch *batch = task_data;
+  PangoFontMap *font_map;
+  PangoContext *contexts[2];
+  guint i;
+
+  /* This relies on Pango being thread-safe, which it is since 1.32.6.
+   * Font maps still aren't meant to be shared, so each worker gets its
+   * own.
+   */
+  font_map = g_private_get (&shape_font_map);
+  if (font_map == NULL)
+    {
+      font_map = pango_cairo_font_map_new ();
+      g_private_set (&shape_font_map, font_map);
+    }
+
+  for (i = 0; i < 2; i++)
+    {
+      contexts[i] = pango_font_map_create_context (font_map);
+      pango_context_set_base_dir (contexts[i],
+                                  i ? PANGO_DIRECTION_RTL : PANGO_DIRECTION_LTR);
+      if (batch->font_desc)
+        pango_context_set_font_description (contexts[i], batch->font_desc);
+      pango_context_set_language (contexts[i], batch->language);
+      pango_cairo_context_set_font_options (contexts[i], batch->font_options);
+      pango_cairo_context_set_resolution (contexts[i], batch->resolution);
+    }
+
+  for (i = 0; i < batch->lines->len; i++)
+    {
+      ShapeLine *sl = &g_array_index (batch->lines, ShapeLine, i);
+      PangoLayout *pango_layout;
+
+      if (sl->text == NULL)
+        continue;
+
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      pango_layout = pango_layout_new (contexts[sl->rtl ? 1 : 0]);
+
+      pango_layout_set_alignment (pango_layout, sl->alignment);
+      pango_layout_set_justify (pango_layout, sl->justify);
+      pango_layout_set_spacing (pango_layout, sl->spacing);
+      pango_layout_set_indent (pango_layout, sl->indent);
+      pango_layout_set_width (pango_layout, sl->width);
+      pango_layout_set_wrap (pango_layout, sl->wrap);
+      if (sl->tabs)
+        pango_layout_set_tabs (pango_layout, sl->tabs);
+
+      pango_layout_set_text (pango_layout, sl->text, sl->length);
+      pango_layout_set_attributes (pango_layout, sl->attrs);
+
+      pango_layout_get_extents (pango_layout, NULL, &sl->extents);
+
+      g_object_unref (pango_layout);
+    }
+
+  g_object_unref (contexts[0]);
+  g_object_unref (contexts[1]);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+/* Validates the lines of the batch, using the sizes computed by the
+ * worker where there are some, and emits ::changed for each run of
+ * consecutive lines.
+ */
+static void
+shape_batch_commit (GtkTextLayout *layout,
+                    ShapeBatch    *batch)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextBTree *tree;
+  GtkTextLine *prev_line = NULL;
+  gint y = 0, old_height = 0, new_height = 0;
+  guint i;
+
+  tree = _gtk_text_buffer_get_btree (layout->buffer);
+
+  for (i = 0; i < batch->lines->len; i++)
+    {
+      ShapeLine *sl = &g_array_index (batch->lines, ShapeLine, i);
+      GtkTextLineData *ld;
+
+      /* ::changed handlers may invalidate lines, and delete them */
+      if (priv->wrap_stamp != batch->wrap_stamp)
+        return;
+
+      ld = _gtk_text_line_get_data (sl->line, layout);
+      if (ld && ld->valid)
+        continue;
+
+      if (prev_line != NULL && _gtk_text_line_next (prev_line) != sl->line)
+        {
+          update_layout_size (layout);
+          gtk_text_layout_emit_changed (layout, y, old_height, new_height);
+          prev_line = NULL;
+
+          if (priv->wrap_stamp != batch->wrap_stamp)
+            return;
+        }
+
+      if (prev_line == NULL)
+        {
+          y = _gtk_text_btree_find_line_top (tree, sl->line, layout);
+          old_height = 0;
+          new_height = 0;
+        }
+
+      if (ld)
+        old_height += ld->height;
+
+      if (sl->text != NULL)
+        {
+          priv->presized_line = sl->line;
+          priv->presized_width = PIXEL_BOUND (sl->extents.width) + sl->extra_width;
+          priv->presized_height = PANGO_PIXELS (sl->extents.height) + sl->extra_height;
+        }
+
+      _gtk_text_btree_validate_line (tree, sl->line, layout);
+      priv->presized_line = NULL;
+
+      ld = _gtk_text_line_get_data (sl->line, layout);
+      new_height += ld->height;
+
+      prev_line = sl->line;
+    }
+
+  if (prev_line != NULL)
+    {
+      update_layout_size (layout);
+      gtk_text_layout_emit_changed (layout, y, old_height, new_height);
+    }
+}
+
+static void
+shape_batch_done (GObject      *source,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+  GtkTextLayout *layout = GTK_TEXT_LAYOUT (source);
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GTask *task = user_data;
+  ShapeBatch *batch;
+  GError *error = NULL;
+
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  batch = g_task_get_task_data (G_TASK (result));
+
+  /* If anything was invalidated meanwhile, the sizes may be for
+   * lines that changed or don't exist anymore; the caller will
+   * just try again.
+   */
+  if (layout->buffer != NULL && priv->wrap_stamp == batch->wrap_stamp)
+    shape_batch_commit (layout, batch);
+
+  g_task_return_boolean (task, TRUE);
+  g_object_unref (task);
+}
+
+/**
+ * gtk_text_layout_validate_async:
+ * @layout: a #GtkTextLayout
+ * @max_lines: the maximum number of lines to validate
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the lines are validated
+ * @user_data: the data to pass to @callback
+ *
+ * Validates up to @max_lines lines starting from the first invalid one,
+ * like gtk_text_layout_validate(), but shapes their text in a worker
+ * thread. The sizes are committed, and ::changed emitted, on the main
+ * thread before @callback is called; if the layout was invalidated in
+ * the meantime they are dropped, so the layout may still not be valid
+ * afterwards.
+ *
+ * Only one validation should be running at a time.
+ */
+void
+gtk_text_layout_validate_async (GtkTextLayout       *layout,
+                                gint                 max_lines,
+                                GCancellable        *cancellable,
+                                GAsyncReadyCallback  callback,
+                                gpointer             user_data)
+{
+  GTask *task, *shape_task;
+  ShapeBatch *batch;
+  guint i;
+
+  g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
+  g_return_if_fail (layout->buffer != NULL);
+
+  task = g_task_new (layout, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtk_text_layout_validate_async);
+
+  batch = shape_batch_new (layout, MIN (max_lines, SHAPE_BATCH_LINES));
+
+  for (i = 0; i < batch->lines->len; i++)
+    {
+      if (g_array_index (batch->lines, ShapeLine, i).text != NULL)
+        break;
+    }
+
+  if (i == batch->lines->len)
+    {
+      /* nothing worth a thread */
+      shape_batch_commit (layout, batch);
+      shape_batch_free (batch);
+
+      g_task_return_boolean (task, TRUE);
+      g_object_unref (task);
+      return;
+    }
+
+  shape_task = g_task_new (layout, cancellable, shape_batch_done, task);
+  g_task_set_task_data (shape_task, batch, (GDestroyNotify) shape_batch_free);
+  g_task_run_in_thread (shape_task, shape_batch_thread);
+  g_object_unref (shape_task);
+}
+
+/**
+ * gtk_text_layout_validate_finish:
+ * @layout: a #GtkTextLayout
+ * @result: a #GAsyncResult
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Finishes a validation started with gtk_text_layout_validate_async().
+ *
+ * Return value: %FALSE if the validation was cancelled
+ */
+gboolean
+gtk_text_layout_validate_finish (GtkTextLayout  *layout,
+                                 GAsyncResult   *result,
+                                 GError        **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, layout), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 static GtkTextLineData*
 gtk_text_layout_real_wrap (GtkTextLayout   *layout,
                            GtkTextLine     *line,
                            /* may be NULL */
                            GtkTextLineData *line_data)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLineDisplay *display;
 
   g_return_val_if_fail (GTK_IS_TEXT_LAYOUT (layout), NULL);
@@ -1163,6 +1779,15 @@ gtk_text_layout_real_wrap (GtkTextLayout   *layout,
       _gtk_text_line_add_data (line, line_data);
     }
 
+  if (line == priv->presized_line)
+    {
+      line_data->width = priv->presized_width;
+      line_data->height = priv->presized_height;
+      line_data->valid = TRUE;
+
+      return line_data;
+    }
+
   display = gtk_text_layout_get_line_display (layout, line, TRUE);
   line_data->width = display->width;
   line_data->height = display->height;
@@ -2119,10 +2744,15 @@ tags_array_toggle_tag (GPtrArray  *array,
   return array;
 }
 
-GtkTextLineDisplay *
-gtk_text_layout_get_line_display (GtkTextLayout *layout,
-                                  GtkTextLine   *line,
-                                  gboolean       size_only)
+/* If @measure is %FALSE, the display is returned with its text and
+ * attributes set up but without shaping the text, and without adding
+ * it to the display cache; the caller owns it.
+ */
+static GtkTextLineDisplay *
+get_line_display (GtkTextLayout *layout,
+                  GtkTextLine   *line,
+                  gboolean       size_only,
+                  gboolean       measure)
 {
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLineDisplay *display;
@@ -2141,27 +2771,33 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   PangoDirection base_dir;
   GPtrArray *tags;
   gboolean initial_toggle_segments;
+  GList *link;
   
   g_return_val_if_fail (line != NULL, NULL);
 
-  if (layout->one_display_cache)
+  link = g_hash_table_lookup (priv->display_cache, line);
+  if (link)
     {
-      if (line == layout->one_display_cache->line &&
-          (size_only || !layout->one_display_cache->size_only))
+      display = link->data;
+
+      if (size_only || !display->size_only)
 	{
+          priv->display_cache_hits++;
+
+          g_queue_unlink (&priv->display_lru, link);
+          g_queue_push_head_link (&priv->display_lru, link);
+
 	  if (!size_only)
-            update_text_display_cursors (layout, line, layout->one_display_cache);
-	  return layout->one_display_cache;
+            update_text_display_cursors (layout, line, display);
+	  return display;
 	}
       else
-        {
-          GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-          layout->one_display_cache = NULL;
-          gtk_text_layout_free_line_display (layout, tmp_display);
-        }
+        display_cache_remove (layout, link);
     }
 
-  DV (g_print ("creating one line display cache (%s)\n", G_STRLOC));
+  priv->display_cache_misses++;
+
+  DV (g_print ("creating line display (%s)\n", G_STRLOC));
 
   display = g_slice_new0 (GtkTextLineDisplay);
 
@@ -2446,29 +3082,32 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   g_slist_free (cursor_byte_offsets);
   g_slist_free (cursor_segs);
 
-  pango_layout_get_extents (display->layout, NULL, &extents);
+  if (measure)
+    {
+      pango_layout_get_extents (display->layout, NULL, &extents);
 
-  display->width = PIXEL_BOUND (extents.width) + display->left_margin + display->right_margin;
-  display->height += PANGO_PIXELS (extents.height);
+      display->width = PIXEL_BOUND (extents.width) + display->left_margin + display->right_margin;
+      display->height += PANGO_PIXELS (extents.height);
 
-  /* If we aren't wrapping, we need to do the alignment of each
-   * paragraph ourselves.
-   */
-  if (pango_layout_get_width (display->layout) < 0)
-    {
-      gint excess = display->total_width - display->width;
+      /* If we aren't wrapping, we need to do the alignment of each
+       * paragraph ourselves.
+       */
+      if (pango_layout_get_width (display->layout) < 0)
+        {
+          gint excess = display->total_width - display->width;
 
-      switch (pango_layout_get_alignment (display->layout))
-	{
-	case PANGO_ALIGN_LEFT:
-	  break;
-	case PANGO_ALIGN_CENTER:
-	  display->x_offset += excess / 2;
-	  break;
-	case PANGO_ALIGN_RIGHT:
-	  display->x_offset += excess;
-	  break;
-	}
+          switch (pango_layout_get_alignment (display->layout))
+            {
+            case PANGO_ALIGN_LEFT:
+              break;
+            case PANGO_ALIGN_CENTER:
+              display->x_offset += excess / 2;
+              break;
+            case PANGO_ALIGN_RIGHT:
+              display->x_offset += excess;
+              break;
+            }
+        }
     }
   
   /* Free this if we aren't in a loop */
@@ -2480,34 +3119,31 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   if (tags != NULL)
     g_ptr_array_free (tags, TRUE);
 
-  layout->one_display_cache = display;
+  if (measure)
+    {
+      display_cache_insert (layout, display);
 
-  if (saw_widget)
-    allocate_child_widgets (layout, display);
+      if (saw_widget)
+        allocate_child_widgets (layout, display);
+    }
   
   return display;
 }
 
+GtkTextLineDisplay *
+gtk_text_layout_get_line_display (GtkTextLayout *layout,
+                                  GtkTextLine   *line,
+                                  gboolean       size_only)
+{
+  return get_line_display (layout, line, size_only, TRUE);
+}
+
 void
 gtk_text_layout_free_line_display (GtkTextLayout      *layout,
                                    GtkTextLineDisplay *display)
 {
-  if (display != layout->one_display_cache)
-    {
-      if (display->layout)
-        g_object_unref (display->layout);
-
-      if (display->cursors)
-        g_array_free (display->cursors, TRUE);
-
-      if (display->pg_bg_color)
-        gdk_color_free (display->pg_bg_color);
-
-      if (display->pg_bg_rgba)
-        gdk_rgba_free (display->pg_bg_rgba);
-
-      g_slice_free (GtkTextLineDisplay, display);
-    }
+  if (!display_is_cached (layout, display))
+    line_display_free (display);
 }
 
 /* Functions to convert iter <=> index for the line of a GtkTextLineDisplay
@@ -145,8 +145,8 @@ struct _GtkTextLayout
    * over long runs with the same style. */
   GtkTextAttributes *one_style_cache;
 
-  /* A cache of one line display. Getting the same line
-   * many times in a row is the most common case.
+  /* Unused, line displays are cached in the private
+   * data now, see gtk_text_layout_get_line_display().
    */
   GtkTextLineDisplay *one_display_cache;
 
@@ -316,6 +316,10 @@ GtkTextLineDisplay* gtk_text_layout_get_line_display  (GtkTextLayout      *layou
                                                        gboolean            size_only);
 void                gtk_text_layout_free_line_display (GtkTextLayout      *layout,
                                                        GtkTextLineDisplay *display);
+void                gtk_text_layout_get_display_cache_stats (GtkTextLayout *layout,
+                                                             guint         *n_cached,
+                                                             guint         *hits,
+                                                             guint         *misses);
 
 void gtk_text_layout_get_line_at_y     (GtkTextLayout     *layout,
                                         GtkTextIter       *target_iter,
@@ -347,6 +351,14 @@ void     gtk_text_layout_validate_yrange (GtkTextLayout *layout,
                                           gint           y1_);
 void     gtk_text_layout_validate        (GtkTextLayout *layout,
                                           gint           max_pixels);
+void     gtk_text_layout_validate_async  (GtkTextLayout       *layout,
+                                          gint                 max_lines,
+                                          GCancellable        *cancellable,
+                                          GAsyncReadyCallback  callback,
+                                          gpointer             user_data);
+gboolean gtk_text_layout_validate_finish (GtkTextLayout       *layout,
+                                          GAsyncResult        *result,
+                                          GError             **error);
 
 /* This function should return the passed-in line data,
  * OR remove the existing line data from the line, and
@@ -34,6 +34,7 @@
 #include "gtktextdisplay.h"
 #include "gtktextbuffer.h"
 #include "gtkmenuitem.h"
+#include "gtkpango.h"
 #include "gtkintl.h"
 
 #define DRAG_ICON_MAX_WIDTH 250
@@ -433,7 +434,8 @@ layout_get_char_width (PangoLayout *layout)
   if (!font_desc)
     font_desc = pango_context_get_font_description (context);
 
-  metrics = pango_context_get_metrics (context, font_desc, NULL);
+  metrics = _gtk_pango_context_get_metrics (context, font_desc,
+                                            pango_context_get_language (context));
   width = pango_font_metrics_get_approximate_char_width (metrics);
   pango_font_metrics_unref (metrics);
 
@@ -183,6 +183,7 @@ struct _GtkTextViewPrivate
 
   guint first_validate_idle;        /* Idle to revalidate onscreen portion, runs before resize */
   guint incremental_validate_idle;  /* Idle to revalidate offscreen portions, runs after redraw */
+  GCancellable *incremental_validate_cancellable; /* Offscreen validation running in a thread */
 
   gint pending_place_cursor_button;
 
@@ -3025,6 +3026,12 @@ gtk_text_view_remove_validate_idles (GtkTextView *text_view)
       g_source_remove (priv->incremental_validate_idle);
       priv->incremental_validate_idle = 0;
     }
+
+  if (priv->incremental_validate_cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->incremental_validate_cancellable);
+      g_clear_object (&priv->incremental_validate_cancellable);
+    }
 }
 
 static void
@@ -3830,25 +3837,60 @@ first_validate_callback (gpointer data)
   return FALSE;
 }
 
+static gboolean incremental_validate_callback (gpointer data);
+
+static void
+incremental_validate_done (GObject      *source,
+                           GAsyncResult *result,
+                           gpointer      data)
+{
+  GtkTextView *text_view;
+  GtkTextViewPrivate *priv;
+  GError *error = NULL;
+
+  if (!gtk_text_layout_validate_finish (GTK_TEXT_LAYOUT (source), result, &error))
+    {
+      /* Cancelled when the layout went away, the view may be gone too */
+      g_error_free (error);
+      return;
+    }
+
+  text_view = data;
+  priv = text_view->priv;
+
+  g_clear_object (&priv->incremental_validate_cancellable);
+
+  gtk_text_view_update_adjustments (text_view);
+
+  if (!gtk_text_layout_is_valid (priv->layout) &&
+      !priv->incremental_validate_idle)
+    priv->incremental_validate_idle = gdk_threads_add_idle_full (GTK_TEXT_VIEW_PRIORITY_VALIDATE, incremental_validate_callback, text_view, NULL);
+}
+
 static gboolean
 incremental_validate_callback (gpointer data)
 {
   GtkTextView *text_view = data;
-  gboolean result = TRUE;
+  GtkTextViewPrivate *priv = text_view->priv;
 
   DV(g_print(G_STRLOC"\n"));
-  
-  gtk_text_layout_validate (text_view->priv->layout, 2000);
 
-  gtk_text_view_update_adjustments (text_view);
-  
-  if (gtk_text_layout_is_valid (text_view->priv->layout))
-    {
-      text_view->priv->incremental_validate_idle = 0;
-      result = FALSE;
-    }
+  priv->incremental_validate_idle = 0;
+
+  if (gtk_text_layout_is_valid (priv->layout))
+    return FALSE;
 
-  return result;
+  /* Shape offscreen paragraphs in a worker thread; onscreen ones
+   * are validated synchronously by first_validate_callback and
+   * gtk_text_view_validate_onscreen().
+   */
+  priv->incremental_validate_cancellable = g_cancellable_new ();
+  gtk_text_layout_validate_async (priv->layout, 256,
+                                  priv->incremental_validate_cancellable,
+                                  incremental_validate_done,
+                                  text_view);
+
+  return FALSE;
 }
 
 static void
@@ -3872,7 +3914,8 @@ gtk_text_view_invalidate (GtkTextView *text_view)
                    priv->first_validate_idle));
     }
       
-  if (!priv->incremental_validate_idle)
+  if (!priv->incremental_validate_idle &&
+      !priv->incremental_validate_cancellable)
     {
       priv->incremental_validate_idle = gdk_threads_add_idle_full (GTK_TEXT_VIEW_PRIORITY_VALIDATE, incremental_validate_callback, text_view, NULL);
       DV (g_print (G_STRLOC": adding incremental validate idle %d\n",
@@ -4185,7 +4228,7 @@ gtk_text_view_style_updated (GtkWidget *widget)
   GtkTextViewPrivate *priv;
   PangoContext *ltr_context, *rtl_context;
   GtkStyleContext *style_context;
-  const GtkBitmask *changes;
+  const GtkCssPropertySet *changes;
 
   text_view = GTK_TEXT_VIEW (widget);
   priv = text_view->priv;
@@ -45,6 +45,7 @@
 #include "gtkmenu.h"
 #include "gtkorientable.h"
 #include "gtkorientableprivate.h"
+#include "gtkpango.h"
 #include "gtkradiobutton.h"
 #include "gtkradiotoolbutton.h"
 #include "gtkseparatormenuitem.h"
@@ -3339,9 +3340,9 @@ calculate_max_homogeneous_pixels (GtkWidget *widget)
   
   context = gtk_widget_get_pango_context (widget);
 
-  metrics = pango_context_get_metrics (context,
-                                       pango_context_get_font_description (context),
-				       pango_context_get_language (context));
+  metrics = _gtk_pango_context_get_metrics (context,
+                                            pango_context_get_font_description (context),
+					    pango_context_get_language (context));
   char_width = pango_font_metrics_get_approximate_char_width (metrics);
   pango_font_metrics_unref (metrics);
   
@@ -34,6 +34,9 @@
  */
 
 #include "config.h"
+
+#include <string.h>
+
 #include "gtkintl.h"
 #include "gtktreemenu.h"
 #include "gtkmarshalers.h"
@@ -70,6 +73,7 @@ static void      gtk_tree_menu_get_preferred_width            (GtkWidget
 static void      gtk_tree_menu_get_preferred_height           (GtkWidget           *widget,
                                                                gint                *minimum_size,
                                                                gint                *natural_size);
+static void      gtk_tree_menu_show                           (GtkWidget           *widget);
 
 /* GtkCellLayoutIface */
 static void      gtk_tree_menu_cell_layout_init               (GtkCellLayoutIface  *iface);
@@ -159,9 +163,15 @@ struct _GtkTreeMenuPrivate
   gint                 row_span_col;
   gint                 col_span_col;
 
+  /* Menu items for the rows at this depth, indexed by row position
+   * (not including the header, its separator and the tearoff item) */
+  GPtrArray           *row_items;
+
   /* Flags */
   guint32              menu_with_header : 1;
   guint32              tearoff     : 1;
+  guint32              populated   : 1;
+  guint32              lazy        : 1;
 
   /* Row separators */
   GtkTreeViewRowSeparatorFunc row_separator_func;
@@ -222,8 +232,12 @@ _gtk_tree_menu_init (GtkTreeMenu *menu)
   priv->row_span_col = -1;
   priv->col_span_col = -1;
 
+  priv->row_items = g_ptr_array_new ();
+
   priv->menu_with_header = FALSE;
   priv->tearoff          = FALSE;
+  priv->populated        = FALSE;
+  priv->lazy             = FALSE;
 
   priv->row_separator_func    = NULL;
   priv->row_separator_data    = NULL;
@@ -252,6 +266,7 @@ _gtk_tree_menu_class_init (GtkTreeMenuClass *class)
 
   widget_class->get_preferred_width  = gtk_tree_menu_get_preferred_width;
   widget_class->get_preferred_height = gtk_tree_menu_get_preferred_height;
+  widget_class->show                 = gtk_tree_menu_show;
 
   /*
    * GtkTreeMenu::menu-activate:
@@ -485,6 +500,8 @@ gtk_tree_menu_finalize (GObject *object)
   if (priv->root)
     gtk_tree_row_reference_free (priv->root);
 
+  g_ptr_array_free (priv->row_items, TRUE);
+
   G_OBJECT_CLASS (_gtk_tree_menu_parent_class)->finalize (object);
 }
 
@@ -644,6 +661,21 @@ gtk_tree_menu_get_preferred_height (GtkWidget           *widget,
   g_signal_handler_unblock (priv->context, priv->size_changed_id);
 }
 
+static void
+gtk_tree_menu_show (GtkWidget *widget)
+{
+  GtkTreeMenu        *menu = GTK_TREE_MENU (widget);
+  GtkTreeMenuPrivate *priv = menu->priv;
+
+  /* Submenus are only populated the first time they are shown,
+   * so that large hierarchies don't create menu items for rows
+   * that are never looked at */
+  if (!priv->populated)
+    gtk_tree_menu_populate (menu);
+
+  GTK_WIDGET_CLASS (_gtk_tree_menu_parent_class)->show (widget);
+}
+
 /****************************************************************
  *                      GtkCellLayoutIface                      *
  ****************************************************************/
@@ -666,12 +698,41 @@ gtk_tree_menu_cell_layout_get_area (GtkCellLayout *layout)
 /****************************************************************
  *             TreeModel callbacks/populating menus             *
  ****************************************************************/
+static gint
+gtk_tree_menu_get_row_index (GtkTreePath *path)
+{
+  gint *indices, depth;
+
+  indices = gtk_tree_path_get_indices (path);
+  depth   = gtk_tree_path_get_depth (path);
+
+  return indices[depth - 1];
+}
+
 static GtkWidget *
 gtk_tree_menu_get_path_item (GtkTreeMenu          *menu,
                              GtkTreePath          *search)
 {
+  GtkTreeMenuPrivate *priv = menu->priv;
   GtkWidget *item = NULL;
   GList     *children, *l;
+  gboolean   is_header;
+  gint       index;
+
+  if (!priv->populated)
+    return NULL;
+
+  /* Rows of this menu are looked up by their position, this is
+   * also where rows that were just deleted from the model are found */
+  if (gtk_tree_menu_path_in_menu (menu, search, &is_header) && !is_header)
+    {
+      index = gtk_tree_menu_get_row_index (search);
+
+      if (index < priv->row_items->len)
+        return g_ptr_array_index (priv->row_items, index);
+
+      return NULL;
+    }
 
   children = gtk_container_get_children (GTK_CONTAINER (menu));
 
@@ -776,8 +837,8 @@ gtk_tree_menu_path_needs_submenu (GtkTreeMenu *menu,
                                   GtkTreePath *search)
 {
   GtkWidget   *item = NULL;
-  GList       *children, *l;
   GtkTreePath *parent_path;
+  gboolean     is_header;
 
   if (gtk_tree_path_get_depth (search) <= 1)
     return NULL;
@@ -785,35 +846,16 @@ gtk_tree_menu_path_needs_submenu (GtkTreeMenu *menu,
   parent_path = gtk_tree_path_copy (search);
   gtk_tree_path_up (parent_path);
 
-  children    = gtk_container_get_children (GTK_CONTAINER (menu));
+  if (gtk_tree_menu_path_in_menu (menu, parent_path, &is_header) && !is_header)
+    item = gtk_tree_menu_get_path_item (menu, parent_path);
 
-  for (l = children; item == NULL && l != NULL; l = l->next)
-    {
-      GtkWidget   *child = l->data;
-      GtkTreePath *path  = NULL;
-
-      /* Separators dont get submenus, if it already has a submenu then let
-       * the submenu handle inserted rows */
-      if (!GTK_IS_SEPARATOR_MENU_ITEM (child) &&
-          !gtk_menu_item_get_submenu (GTK_MENU_ITEM (child)))
-        {
-          GtkWidget *view = gtk_bin_get_child (GTK_BIN (child));
+  /* Separators dont get submenus, if it already has a submenu then let
+   * the submenu handle inserted rows */
+  if (item &&
+      (GTK_IS_SEPARATOR_MENU_ITEM (item) ||
+       gtk_menu_item_get_submenu (GTK_MENU_ITEM (item))))
+    item = NULL;
 
-          /* It's always a cellview */
-          if (GTK_IS_CELL_VIEW (view))
-            path = gtk_cell_view_get_displayed_row (GTK_CELL_VIEW (view));
-        }
-
-      if (path)
-        {
-          if (gtk_tree_path_compare (parent_path, path) == 0)
-            item = child;
-
-          gtk_tree_path_free (path);
-        }
-    }
-
-  g_list_free (children);
   gtk_tree_path_free (parent_path);
 
   return item;
@@ -867,9 +909,13 @@ row_inserted_cb (GtkTreeModel     *model,
                  GtkTreeMenu      *menu)
 {
   GtkTreeMenuPrivate *priv = menu->priv;
-  gint               *indices, index, depth;
+  gint                row, index;
   GtkWidget          *item;
 
+  /* Menus that were not populated yet will pick up the row later */
+  if (!priv->populated)
+    return;
+
   /* If the iter should be in this menu then go ahead and insert it */
   if (gtk_tree_menu_path_in_menu (menu, path, NULL))
     {
@@ -878,9 +924,8 @@ row_inserted_cb (GtkTreeModel     *model,
       else
         {
           /* Get the index of the path for this depth */
-          indices = gtk_tree_path_get_indices (path);
-          depth   = gtk_tree_path_get_depth (path);
-          index   = indices[depth -1];
+          row   = gtk_tree_menu_get_row_index (path);
+          index = row;
 
           /* Menus with a header include a menuitem for its root node
            * and a separator menu item */
@@ -894,6 +939,13 @@ row_inserted_cb (GtkTreeModel     *model,
             index += 1;
 
           item = gtk_tree_menu_create_item (menu, iter, FALSE);
+
+          row = MIN (row, priv->row_items->len);
+          g_ptr_array_add (priv->row_items, item);
+          memmove (&priv->row_items->pdata[row + 1], &priv->row_items->pdata[row],
+                   (priv->row_items->len - 1 - row) * sizeof (gpointer));
+          priv->row_items->pdata[row] = item;
+
           gtk_menu_shell_insert (GTK_MENU_SHELL (menu), item, index);
 
           /* Resize everything */
@@ -935,6 +987,7 @@ row_deleted_cb (GtkTreeModel     *model,
       else
         {
           /* Get rid of the deleted item */
+          g_ptr_array_remove (priv->row_items, item);
           gtk_widget_destroy (item);
 
           /* Resize everything */
@@ -1010,6 +1063,9 @@ row_changed_cb (GtkTreeModel         *model,
   gboolean            has_header = FALSE;
   GtkWidget          *item;
 
+  if (!priv->populated)
+    return;
+
   item = gtk_tree_menu_get_path_item (menu, path);
 
   if (priv->root)
@@ -1065,9 +1121,12 @@ row_changed_cb (GtkTreeModel         *model,
           if (is_separator != GTK_IS_SEPARATOR_MENU_ITEM (item))
             {
               gint position = menu_item_position (menu, item);
+              gint row = gtk_tree_menu_get_row_index (path);
 
               gtk_widget_destroy (item);
               item = gtk_tree_menu_create_item (menu, iter, FALSE);
+              if (row < priv->row_items->len)
+                priv->row_items->pdata[row] = item;
               gtk_menu_shell_insert (GTK_MENU_SHELL (menu), item, position);
             }
         }
@@ -1283,6 +1342,9 @@ gtk_tree_menu_create_submenu (GtkTreeMenu *menu,
 
   submenu = _gtk_tree_menu_new_with_area (priv->area);
 
+  /* Don't create the items of the submenu until it pops up */
+  GTK_TREE_MENU (submenu)->priv->lazy = TRUE;
+
   _gtk_tree_menu_set_row_separator_func (GTK_TREE_MENU (submenu),
                                          priv->row_separator_func,
                                          priv->row_separator_data,
@@ -1365,9 +1427,11 @@ rebuild_menu (GtkTreeMenu *menu)
   /* Destroy all the menu items */
   gtk_container_foreach (GTK_CONTAINER (menu),
                          (GtkCallback) gtk_widget_destroy, NULL);
+  g_ptr_array_set_size (priv->row_items, 0);
+  priv->populated = FALSE;
 
-  /* Populate */
-  if (priv->model)
+  /* Populate, lazy submenus wait until they are shown */
+  if (!priv->lazy || gtk_widget_get_visible (GTK_WIDGET (menu)))
     gtk_tree_menu_populate (menu);
 }
 
@@ -1385,6 +1449,8 @@ gtk_tree_menu_populate (GtkTreeMenu *menu)
   if (!priv->model)
     return;
 
+  priv->populated = TRUE;
+
   if (priv->root)
     path = gtk_tree_row_reference_get_path (priv->root);
 
@@ -1438,6 +1504,7 @@ gtk_tree_menu_populate (GtkTreeMenu *menu)
     {
       menu_item = gtk_tree_menu_create_item (menu, &iter, FALSE);
 
+      g_ptr_array_add (priv->row_items, menu_item);
       gtk_menu_shell_append (GTK_MENU_SHELL (menu), menu_item);
 
       if (priv->wrap_width > 0)
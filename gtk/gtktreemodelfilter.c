@@ -19,9 +19,10 @@
  */
 
 #include "config.h"
-#include "gtktreemodelfilter.h"
+#include "gtktreemodelfilterprivate.h"
 #include "gtkintl.h"
 #include "gtktreednd.h"
+#include "gtkmain.h"
 #include "gtkprivate.h"
 #include <string.h>
 
@@ -238,6 +239,32 @@
  * row-has-child-toggled could appear frequently; it does happen that
  * we simply forward the signal emitted by e.g. GtkTreeStore but also
  * emit our own copy).
+ *
+ * Deferred refiltering
+ * --------------------
+ *
+ * gtk_tree_model_filter_refilter() pushes every row of the child model
+ * through the row-changed handler, which emits row-changed for every
+ * row that stays visible.  gtk_tree_model_filter_queue_refilter() instead
+ * sets "refilter_pending" and installs an idle (flush_idle_id) that runs
+ * before the next resize and redraw.  The flush walks each cached level
+ * exactly once, in step with the child model, and collects the offsets
+ * of nodes whose visibility changed.  Only for these nodes signals are
+ * emitted: first the nodes that became visible (so a level never drops
+ * to zero visible nodes in between, which would cause spurious
+ * row-has-child-toggled emissions and could free the level), then the
+ * nodes that became invisible.  Finally the walk recurses into the child
+ * levels that remain cached.  Uncached levels are not visited; they will
+ * be evaluated from scratch once they get built.
+ *
+ * When "batch_updates" is set, row-changed signals from the child model
+ * are not handled immediately either.  The rows are remembered as
+ * GtkTreeRowReferences in "pending_changes", so that structural changes
+ * in the child model that happen before the flush keep them valid, and
+ * are handled in child model order (duplicates dropped) during the
+ * flush.  Structural signals (row-inserted, row-deleted, rows-reordered
+ * and row-has-child-toggled) are always handled right away, because the
+ * offsets stored in the FilterElts must stay in sync with the child model.
  */
 
 
@@ -294,6 +321,13 @@ struct _GtkTreeModelFilterPrivate
   guint in_row_deleted       : 1;
   guint virtual_root_deleted : 1;
 
+  guint batch_updates        : 1;
+  guint refilter_pending     : 1;
+
+  /* deferred work, see gtk_tree_model_filter_queue_refilter() */
+  guint flush_idle_id;
+  GPtrArray *pending_changes;
+
   /* signal ids */
   gulong changed_id;
   gulong inserted_id;
@@ -307,7 +341,8 @@ enum
 {
   PROP_0,
   PROP_CHILD_MODEL,
-  PROP_VIRTUAL_ROOT
+  PROP_VIRTUAL_ROOT,
+  PROP_BATCH_UPDATES
 };
 
 /* Set this to 0 to disable caching of child iterators.  This
@@ -330,6 +365,8 @@ enum
 #define FILTER_ELT(filter_elt) ((FilterElt *)filter_elt)
 #define FILTER_LEVEL(filter_level) ((FilterLevel *)filter_level)
 #define GET_ELT(siter) ((FilterElt*) (siter ? g_sequence_get (siter) : NULL))
+#define LEVEL_IS_CACHED(filter, parent_elt, level) \
+        (((parent_elt) ? (gpointer) (parent_elt)->children : (filter)->priv->root) == (level))
 
 /* general code (object/interface init, properties, etc) */
 static void         gtk_tree_model_filter_tree_model_init                 (GtkTreeModelIface       *iface);
@@ -349,6 +386,10 @@ static void         gtk_tree_model_filter_row_changed                     (GtkTr
                                                                            GtkTreePath            *c_path,
                                                                            GtkTreeIter            *c_iter,
                                                                            gpointer                data);
+static void         gtk_tree_model_filter_real_row_changed                (GtkTreeModel           *c_model,
+                                                                           GtkTreePath            *c_path,
+                                                                           GtkTreeIter            *c_iter,
+                                                                           gpointer                data);
 static void         gtk_tree_model_filter_row_inserted                    (GtkTreeModel           *c_model,
                                                                            GtkTreePath            *c_path,
                                                                            GtkTreeIter            *c_iter,
@@ -497,6 +538,10 @@ static void         gtk_tree_model_filter_emit_row_inserted_for_path      (GtkTr
                                                                            GtkTreePath            *c_path,
                                                                            GtkTreeIter            *c_iter);
 
+static void         gtk_tree_model_filter_queue_flush                     (GtkTreeModelFilter     *filter);
+static void         gtk_tree_model_filter_flush                           (GtkTreeModelFilter     *filter);
+static void         gtk_tree_model_filter_clear_pending                   (GtkTreeModelFilter     *filter);
+
 
 G_DEFINE_TYPE_WITH_CODE (GtkTreeModelFilter, gtk_tree_model_filter, G_TYPE_OBJECT,
 			 G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL,
@@ -517,6 +562,10 @@ gtk_tree_model_filter_init (GtkTreeModelFilter *filter)
   filter->priv->modify_func_set = FALSE;
   filter->priv->in_row_deleted = FALSE;
   filter->priv->virtual_root_deleted = FALSE;
+  filter->priv->batch_updates = FALSE;
+  filter->priv->refilter_pending = FALSE;
+  filter->priv->flush_idle_id = 0;
+  filter->priv->pending_changes = NULL;
 }
 
 static void
@@ -553,6 +602,24 @@ gtk_tree_model_filter_class_init (GtkTreeModelFilterClass *filter_class)
                                                        GTK_TYPE_TREE_PATH,
                                                        GTK_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
 
+  /**
+   * GtkTreeModelFilter:batch-updates:
+   *
+   * Whether row-changed signals of the child model are collected and
+   * handled together, right before the next resize and redraw, instead
+   * of one at a time as they arrive. See
+   * gtk_tree_model_filter_set_batch_updates().
+   *
+   * Since: 3.12
+   */
+  g_object_class_install_property (object_class,
+                                   PROP_BATCH_UPDATES,
+                                   g_param_spec_boolean ("batch-updates",
+                                                         ("Batch updates"),
+                                                         ("Whether changes in the child model are handled in batches"),
+                                                         FALSE,
+                                                         GTK_PARAM_READWRITE));
+
   g_type_class_add_private (object_class, sizeof (GtkTreeModelFilterPrivate));
 }
 
@@ -590,6 +657,9 @@ gtk_tree_model_filter_finalize (GObject *object)
 {
   GtkTreeModelFilter *filter = (GtkTreeModelFilter *) object;
 
+  /* The row references in pending_changes need the child model */
+  gtk_tree_model_filter_clear_pending (filter);
+
   if (filter->priv->virtual_root && !filter->priv->virtual_root_deleted)
     {
       gtk_tree_model_filter_unref_path (filter, filter->priv->virtual_root,
@@ -633,6 +703,9 @@ gtk_tree_model_filter_set_property (GObject      *object,
       case PROP_VIRTUAL_ROOT:
         gtk_tree_model_filter_set_root (filter, g_value_get_boxed (value));
         break;
+      case PROP_BATCH_UPDATES:
+        gtk_tree_model_filter_set_batch_updates (filter, g_value_get_boolean (value));
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -655,6 +728,9 @@ gtk_tree_model_filter_get_property (GObject    *object,
       case PROP_VIRTUAL_ROOT:
         g_value_set_boxed (value, filter->priv->virtual_root);
         break;
+      case PROP_BATCH_UPDATES:
+        g_value_set_boolean (value, filter->priv->batch_updates);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -1997,6 +2073,39 @@ gtk_tree_model_filter_row_changed (GtkTreeModel *c_model,
                                    GtkTreePath  *c_path,
                                    GtkTreeIter  *c_iter,
                                    gpointer      data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  GtkTreePath *path;
+
+  if (!filter->priv->batch_updates)
+    {
+      gtk_tree_model_filter_real_row_changed (c_model, c_path, c_iter, data);
+      return;
+    }
+
+  g_return_if_fail (c_path != NULL || c_iter != NULL);
+
+  if (c_path)
+    path = gtk_tree_path_copy (c_path);
+  else
+    path = gtk_tree_model_get_path (c_model, c_iter);
+
+  if (!filter->priv->pending_changes)
+    filter->priv->pending_changes =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) gtk_tree_row_reference_free);
+
+  g_ptr_array_add (filter->priv->pending_changes,
+                   gtk_tree_row_reference_new (c_model, path));
+  gtk_tree_path_free (path);
+
+  gtk_tree_model_filter_queue_flush (filter);
+}
+
+static void
+gtk_tree_model_filter_real_row_changed (GtkTreeModel *c_model,
+                                        GtkTreePath  *c_path,
+                                        GtkTreeIter  *c_iter,
+                                        gpointer      data)
 {
   GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
   GtkTreeIter iter;
@@ -4256,11 +4365,310 @@ gtk_tree_model_filter_refilter_helper (GtkTreeModel *model,
                                        gpointer      data)
 {
   /* evil, don't try this at home, but certainly speeds things up */
-  gtk_tree_model_filter_row_changed (model, path, iter, data);
+  gtk_tree_model_filter_real_row_changed (model, path, iter, data);
+
+  return FALSE;
+}
+
+/* Re-evaluates the visibility of all nodes in level against the child
+ * model and only emits signals for the nodes whose state changed.  See
+ * "Deferred refiltering" in the notes at the top of this file.
+ */
+static void
+gtk_tree_model_filter_refilter_level (GtkTreeModelFilter *filter,
+                                      FilterLevel        *level)
+{
+  GtkTreeModel *c_model = filter->priv->child_model;
+  FilterElt *parent_elt = level->parent_elt;
+  GtkTreeIter c_parent_iter;
+  GtkTreeIter c_iter;
+  GtkTreePath *c_parent_path;
+  GSequenceIter *siter;
+  GSequenceIter *end_siter;
+  GArray *show;
+  GPtrArray *hide;
+  GPtrArray *recurse;
+  gint offset;
+  guint i;
+
+  if (level->parent_elt)
+    {
+      GtkTreeIter parent_iter;
+
+      parent_iter.stamp = filter->priv->stamp;
+      parent_iter.user_data = level->parent_level;
+      parent_iter.user_data2 = level->parent_elt;
+
+      gtk_tree_model_filter_convert_iter_to_child_iter (filter,
+                                                        &c_parent_iter,
+                                                        &parent_iter);
+      if (!gtk_tree_model_iter_children (c_model, &c_iter, &c_parent_iter))
+        return;
+
+      c_parent_path = gtk_tree_model_filter_elt_get_path (level->parent_level,
+                                                          level->parent_elt,
+                                                          filter->priv->virtual_root);
+    }
+  else
+    {
+      if (filter->priv->virtual_root)
+        {
+          if (!gtk_tree_model_get_iter (c_model, &c_parent_iter,
+                                        filter->priv->virtual_root) ||
+              !gtk_tree_model_iter_children (c_model, &c_iter, &c_parent_iter))
+            return;
+
+          c_parent_path = gtk_tree_path_copy (filter->priv->virtual_root);
+        }
+      else
+        {
+          if (!gtk_tree_model_get_iter_first (c_model, &c_iter))
+            return;
+
+          c_parent_path = gtk_tree_path_new ();
+        }
+    }
+
+  show = g_array_new (FALSE, FALSE, sizeof (gint));
+  hide = g_ptr_array_new ();
+  recurse = g_ptr_array_new ();
+
+  /* First pass: compare the requested state of every child node with
+   * the cached state.  No signals are emitted here, so the level cannot
+   * change under our feet.  Both the child model and level->seq are
+   * ordered by offset, so they can be walked side by side.
+   */
+  siter = g_sequence_get_begin_iter (level->seq);
+  end_siter = g_sequence_get_end_iter (level->seq);
+  offset = 0;
+
+  do
+    {
+      FilterElt *elt = NULL;
+      gboolean requested_state;
+
+      if (siter != end_siter && GET_ELT (siter)->offset == offset)
+        {
+          elt = GET_ELT (siter);
+          siter = g_sequence_iter_next (siter);
+        }
+
+      requested_state = gtk_tree_model_filter_visible (filter, &c_iter);
+
+      if (elt && elt->visible_siter)
+        {
+          if (!requested_state)
+            g_ptr_array_add (hide, elt);
+        }
+      else if (requested_state)
+        g_array_append_val (show, offset);
+
+      offset++;
+    }
+  while (gtk_tree_model_iter_next (c_model, &c_iter));
+
+  /* Nodes which became visible.  Doing these before the removals ensures
+   * the level keeps at least one visible node if it ends up with any.
+   */
+  for (i = 0; i < show->len; i++)
+    {
+      GtkTreePath *c_path;
+
+      c_path = gtk_tree_path_copy (c_parent_path);
+      gtk_tree_path_append_index (c_path, g_array_index (show, gint, i));
+
+      if (gtk_tree_model_get_iter (c_model, &c_iter, c_path))
+        gtk_tree_model_filter_emit_row_inserted_for_path (filter, c_model,
+                                                          c_path, &c_iter);
+
+      gtk_tree_path_free (c_path);
+    }
+
+  /* Nodes which became invisible.  Removing the last node of a level
+   * might free the level, so check whether it is still around.
+   */
+  for (i = 0; i < hide->len && LEVEL_IS_CACHED (filter, parent_elt, level); i++)
+    {
+      FilterElt *elt = g_ptr_array_index (hide, i);
+
+      if (elt->visible_siter)
+        gtk_tree_model_filter_remove_elt_from_level (filter, level, elt);
+    }
+
+  /* Cached child levels, of visible and invisible nodes alike; the latter
+   * are monitoring levels which decide over the parent's visibility once
+   * it gets shown.
+   */
+  if (LEVEL_IS_CACHED (filter, parent_elt, level))
+    {
+      end_siter = g_sequence_get_end_iter (level->seq);
+      for (siter = g_sequence_get_begin_iter (level->seq);
+           siter != end_siter;
+           siter = g_sequence_iter_next (siter))
+        {
+          FilterElt *elt = GET_ELT (siter);
+
+          if (elt->children)
+            g_ptr_array_add (recurse, elt);
+        }
+
+      for (i = 0; i < recurse->len; i++)
+        {
+          FilterElt *elt = g_ptr_array_index (recurse, i);
+
+          if (elt->children)
+            gtk_tree_model_filter_refilter_level (filter, elt->children);
+        }
+    }
+
+  /* As in real_row_changed(), the ancestors of changed nodes need to be
+   * checked.  The changed nodes share their ancestors, so one check is
+   * enough.  This is done last, as it might free the level.
+   */
+  if (parent_elt && (show->len > 0 || hide->len > 0))
+    {
+      GtkTreePath *real_path;
+
+      if (filter->priv->virtual_root)
+        real_path = gtk_tree_model_filter_remove_root (c_parent_path,
+                                                       filter->priv->virtual_root);
+      else
+        real_path = gtk_tree_path_copy (c_parent_path);
+
+      /* only the ancestors of the last index are looked at */
+      gtk_tree_path_append_index (real_path, 0);
+      gtk_tree_model_filter_check_ancestors (filter, real_path);
+      gtk_tree_path_free (real_path);
+    }
+
+  gtk_tree_path_free (c_parent_path);
+  g_array_free (show, TRUE);
+  g_ptr_array_free (hide, TRUE);
+  g_ptr_array_free (recurse, TRUE);
+}
+
+static gint
+gtk_tree_model_filter_compare_paths (gconstpointer a,
+                                     gconstpointer b)
+{
+  return gtk_tree_path_compare (*(GtkTreePath **) a, *(GtkTreePath **) b);
+}
+
+static void
+gtk_tree_model_filter_flush_changes (GtkTreeModelFilter *filter,
+                                     GPtrArray          *changes)
+{
+  GPtrArray *paths;
+  GtkTreePath *prev = NULL;
+  guint i;
+
+  paths = g_ptr_array_new_with_free_func ((GDestroyNotify) gtk_tree_path_free);
+
+  for (i = 0; i < changes->len; i++)
+    {
+      GtkTreePath *path;
+
+      /* NULL if the row has been deleted in the meantime */
+      path = gtk_tree_row_reference_get_path (g_ptr_array_index (changes, i));
+      if (path)
+        g_ptr_array_add (paths, path);
+    }
+
+  g_ptr_array_sort (paths, gtk_tree_model_filter_compare_paths);
+
+  for (i = 0; i < paths->len; i++)
+    {
+      GtkTreePath *path = g_ptr_array_index (paths, i);
+      GtkTreeIter c_iter;
+
+      if (prev && gtk_tree_path_compare (prev, path) == 0)
+        continue;
+      prev = path;
+
+      if (gtk_tree_model_get_iter (filter->priv->child_model, &c_iter, path))
+        gtk_tree_model_filter_real_row_changed (filter->priv->child_model,
+                                                path, &c_iter, filter);
+    }
+
+  g_ptr_array_unref (paths);
+}
+
+static void
+gtk_tree_model_filter_flush (GtkTreeModelFilter *filter)
+{
+  GPtrArray *changes;
+  gboolean refilter;
+
+  changes = filter->priv->pending_changes;
+  refilter = filter->priv->refilter_pending;
+
+  filter->priv->pending_changes = NULL;
+  filter->priv->refilter_pending = FALSE;
+
+  if (filter->priv->flush_idle_id)
+    {
+      g_source_remove (filter->priv->flush_idle_id);
+      filter->priv->flush_idle_id = 0;
+    }
+
+  if (refilter && filter->priv->root && !filter->priv->virtual_root_deleted)
+    gtk_tree_model_filter_refilter_level (filter, filter->priv->root);
+
+  /* After a refilter the visibility of these rows is already correct,
+   * but they still need their row-changed.
+   */
+  if (changes)
+    {
+      gtk_tree_model_filter_flush_changes (filter, changes);
+      g_ptr_array_unref (changes);
+    }
+}
+
+static gboolean
+gtk_tree_model_filter_flush_idle (gpointer data)
+{
+  GtkTreeModelFilter *filter = data;
+
+  filter->priv->flush_idle_id = 0;
+
+  g_object_ref (filter);
+  gtk_tree_model_filter_flush (filter);
+  g_object_unref (filter);
 
   return FALSE;
 }
 
+static void
+gtk_tree_model_filter_queue_flush (GtkTreeModelFilter *filter)
+{
+  /* Run before resizes and redraws, so that views see the result in
+   * the frame in which the changes were requested.
+   */
+  if (!filter->priv->flush_idle_id)
+    filter->priv->flush_idle_id =
+      gdk_threads_add_idle_full (GTK_PRIORITY_RESIZE - 2,
+                                 gtk_tree_model_filter_flush_idle,
+                                 filter, NULL);
+}
+
+static void
+gtk_tree_model_filter_clear_pending (GtkTreeModelFilter *filter)
+{
+  if (filter->priv->flush_idle_id)
+    {
+      g_source_remove (filter->priv->flush_idle_id);
+      filter->priv->flush_idle_id = 0;
+    }
+
+  if (filter->priv->pending_changes)
+    {
+      g_ptr_array_unref (filter->priv->pending_changes);
+      filter->priv->pending_changes = NULL;
+    }
+
+  filter->priv->refilter_pending = FALSE;
+}
+
 /**
  * gtk_tree_model_filter_refilter:
  * @filter: A #GtkTreeModelFilter.
@@ -4275,12 +4683,112 @@ gtk_tree_model_filter_refilter (GtkTreeModelFilter *filter)
 {
   g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
 
+  /* This visits every row and emits row-changed for all visible ones,
+   * which covers anything that has been queued.
+   */
+  gtk_tree_model_filter_clear_pending (filter);
+
   /* S L O W */
   gtk_tree_model_foreach (filter->priv->child_model,
                           gtk_tree_model_filter_refilter_helper,
                           filter);
 }
 
+/**
+ * gtk_tree_model_filter_queue_refilter:
+ * @filter: A #GtkTreeModelFilter.
+ *
+ * Schedules the visibility of all rows to be re-evaluated, right before
+ * the next resize and redraw. Multiple calls before that point are
+ * coalesced into a single pass.
+ *
+ * Unlike gtk_tree_model_filter_refilter(), this only emits
+ * #GtkTreeModel::row-inserted and #GtkTreeModel::row-deleted for rows
+ * whose visibility actually changed, and no #GtkTreeModel::row-changed
+ * at all. Use it when the visible function depends on external state,
+ * such as the text of a search entry.
+ *
+ * Since: 3.12
+ */
+void
+gtk_tree_model_filter_queue_refilter (GtkTreeModelFilter *filter)
+{
+  g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+
+  filter->priv->refilter_pending = TRUE;
+  gtk_tree_model_filter_queue_flush (filter);
+}
+
+/* Like gtk_tree_model_filter_queue_refilter(), but synchronous, for
+ * callers which need the result right away.  Anything queued is handled
+ * as well.
+ */
+void
+_gtk_tree_model_filter_refilter_changed (GtkTreeModelFilter *filter)
+{
+  g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+
+  filter->priv->refilter_pending = TRUE;
+  gtk_tree_model_filter_flush (filter);
+}
+
+/**
+ * gtk_tree_model_filter_set_batch_updates:
+ * @filter: A #GtkTreeModelFilter.
+ * @batch_updates: whether to handle child model changes in batches
+ *
+ * If @batch_updates is %TRUE, #GtkTreeModel::row-changed signals of the
+ * child model are not handled right away. Instead, the changed rows are
+ * collected and handled together right before the next resize and
+ * redraw, along with a refilter queued by
+ * gtk_tree_model_filter_queue_refilter(). A row that changed several
+ * times in between is only handled once.
+ *
+ * Rows being inserted, deleted or reordered in the child model are
+ * always handled immediately.
+ *
+ * Turning batching off handles all collected changes right away.
+ *
+ * Since: 3.12
+ */
+void
+gtk_tree_model_filter_set_batch_updates (GtkTreeModelFilter *filter,
+                                         gboolean            batch_updates)
+{
+  g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+
+  batch_updates = batch_updates != FALSE;
+
+  if (filter->priv->batch_updates == batch_updates)
+    return;
+
+  filter->priv->batch_updates = batch_updates;
+
+  if (!batch_updates && filter->priv->pending_changes)
+    gtk_tree_model_filter_flush (filter);
+
+  g_object_notify (G_OBJECT (filter), "batch-updates");
+}
+
+/**
+ * gtk_tree_model_filter_get_batch_updates:
+ * @filter: A #GtkTreeModelFilter.
+ *
+ * Returns whether child model changes are handled in batches.
+ * See gtk_tree_model_filter_set_batch_updates().
+ *
+ * Return value: %TRUE if changes are handled in batches
+ *
+ * Since: 3.12
+ */
+gboolean
+gtk_tree_model_filter_get_batch_updates (GtkTreeModelFilter *filter)
+{
+  g_return_val_if_fail (GTK_IS_TREE_MODEL_FILTER (filter), FALSE);
+
+  return filter->priv->batch_updates;
+}
+
 /**
  * gtk_tree_model_filter_clear_cache:
  * @filter: A #GtkTreeModelFilter.
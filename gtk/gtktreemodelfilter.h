@@ -140,6 +140,10 @@ GtkTreePath  *gtk_tree_model_filter_convert_path_to_child_path (GtkTreeModelFilt
 /* extras */
 void          gtk_tree_model_filter_refilter                   (GtkTreeModelFilter           *filter);
 void          gtk_tree_model_filter_clear_cache                (GtkTreeModelFilter           *filter);
+void          gtk_tree_model_filter_queue_refilter             (GtkTreeModelFilter           *filter);
+void          gtk_tree_model_filter_set_batch_updates          (GtkTreeModelFilter           *filter,
+                                                                gboolean                      batch_updates);
+gboolean      gtk_tree_model_filter_get_batch_updates          (GtkTreeModelFilter           *filter);
 
 G_END_DECLS
 
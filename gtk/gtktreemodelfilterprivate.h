@@ -0,0 +1,30 @@
+/* gtktreemodelfilterprivate.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_TREE_MODEL_FILTER_PRIVATE_H__
+#define __GTK_TREE_MODEL_FILTER_PRIVATE_H__
+
+#include "gtktreemodelfilter.h"
+
+G_BEGIN_DECLS
+
+
+void        _gtk_tree_model_filter_refilter_changed     (GtkTreeModelFilter *filter);
+
+
+G_END_DECLS
+
+#endif /* __GTK_TREE_MODEL_FILTER_PRIVATE_H__ */
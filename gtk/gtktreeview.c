@@ -8445,7 +8445,7 @@ gtk_tree_view_style_updated (GtkWidget *widget)
   GList *list;
   GtkTreeViewColumn *column;
   GtkStyleContext *style_context;
-  const GtkBitmask *changes;
+  const GtkCssPropertySet *changes;
 
   GTK_WIDGET_CLASS (gtk_tree_view_parent_class)->style_updated (widget);
 
@@ -392,6 +392,16 @@ typedef struct {
   GDestroyNotify        destroy_notify;
 } GtkWidgetTemplate;
 
+typedef struct {
+  cairo_surface_t *recording;  /* last ::draw output, or NULL */
+  GList            link;       /* link in the draw cache LRU */
+  guint            clipped : 1; /* recording was clipped to the allocation */
+  guint            draws;      /* draws since the last invalidation */
+  guint            wasted;     /* consecutive recordings never replayed */
+  guint            hits;
+  guint            misses;
+} GtkWidgetDrawCache;
+
 struct _GtkWidgetPrivate
 {
   guint state_flags : GTK_STATE_FLAGS_BITS;
@@ -444,6 +454,8 @@ struct _GtkWidgetPrivate
   guint norender_children     : 1;
   guint norender              : 1; /* Don't expose windows, instead recurse via draw */
 
+  guint path_invalid          : 1; /* path must be rebuilt before next use */
+
   guint8 alpha;
   guint8 user_alpha;
 
@@ -468,8 +480,16 @@ struct _GtkWidgetPrivate
   GtkStyle *style;
   GtkStyleContext *context;
 
-  /* Widget's path for styling */
+  /* Widget's path for styling, and the path of the parent (or
+   * attach widget) it was built from. The path stays valid for as
+   * long as the parent keeps returning the same path and nothing
+   * invalidated the widget's own element.
+   */
   GtkWidgetPath *path;
+  GtkWidgetPath *path_parent;
+
+  /* Retained drawing, see gtk_widget_set_cache_drawing() */
+  GtkWidgetDrawCache *draw_cache;
 
   /* The widget's allocated size */
   GtkAllocation allocation;
@@ -737,6 +757,8 @@ static void		gtk_widget_aux_info_destroy		(GtkWidgetAuxInfo *aux_info);
 static AtkObject*	gtk_widget_real_get_accessible		(GtkWidget	  *widget);
 static void		gtk_widget_accessible_interface_init	(AtkImplementorIface *iface);
 static AtkObject*	gtk_widget_ref_accessible		(AtkImplementor *implementor);
+static void             gtk_widget_invalidate_draw_cache        (GtkWidget        *widget);
+static void             gtk_widget_free_draw_cache              (GtkWidget        *widget);
 static void             gtk_widget_invalidate_widget_windows    (GtkWidget        *widget,
 								 cairo_region_t        *region);
 static GdkScreen *      gtk_widget_get_screen_unchecked         (GtkWidget        *widget);
@@ -4167,8 +4189,11 @@ gtk_widget_unparent (GtkWidget *widget)
    */
   priv->child_visible = TRUE;
 
+  gtk_widget_invalidate_draw_cache (widget);
+
   old_parent = priv->parent;
   priv->parent = NULL;
+  _gtk_widget_invalidate_path (widget);
 
   /* parent may no longer expand if the removed
    * child was expand=TRUE and could therefore
@@ -4503,6 +4528,7 @@ gtk_widget_map (GtkWidget *widget)
 
       g_signal_emit (widget, widget_signals[MAP], 0);
 
+      gtk_widget_invalidate_draw_cache (widget);
       if (!gtk_widget_get_has_window (widget))
         gdk_window_invalidate_rect (priv->window, &priv->allocation, FALSE);
 
@@ -4533,6 +4559,7 @@ gtk_widget_unmap (GtkWidget *widget)
     {
       gtk_widget_push_verify_invariants (widget);
 
+      gtk_widget_invalidate_draw_cache (widget);
       if (!gtk_widget_get_has_window (widget))
 	gdk_window_invalidate_rect (priv->window, &priv->allocation, FALSE);
       _gtk_tooltip_hide (widget);
@@ -5078,6 +5105,8 @@ gtk_widget_queue_draw_region (GtkWidget            *widget,
 
   priv = widget->priv;
 
+  gtk_widget_invalidate_draw_cache (widget);
+
   if (!gtk_widget_get_realized (widget))
     return;
 
@@ -5499,6 +5528,9 @@ gtk_widget_size_allocate (GtkWidget	*widget,
   if (!alloc_needed && !size_changed && !position_changed)
     goto out;
 
+  if (size_changed || position_changed)
+    gtk_widget_invalidate_draw_cache (widget);
+
   g_signal_emit (widget, widget_signals[SIZE_ALLOCATE], 0, &real_allocation);
 
   /* Size allocation is god... after consulting god, no further requests or allocations are needed */
@@ -6297,6 +6329,183 @@ gtk_widget_get_clip_draw (GtkWidget *widget)
   return TRUE;
 }
 
+/* Retained drawing: widgets that enabled gtk_widget_set_cache_drawing()
+ * keep a recording of their last ::draw emission and replay it until
+ * they or one of their descendants get invalidated. At most
+ * DRAW_CACHE_MAX_RECORDINGS recordings are alive at once, the least
+ * recently drawn one is dropped first. Widgets whose recordings keep
+ * getting invalidated before they are replayed (animations, spinners,
+ * ...) are drawn directly until they stay unchanged for two draws.
+ */
+#define DRAW_CACHE_MAX_RECORDINGS 64
+#define DRAW_CACHE_MAX_WASTED 4
+
+static GQueue draw_cache_lru = G_QUEUE_INIT;
+static guint n_draw_caches = 0;
+
+static void
+gtk_widget_draw_cache_drop (GtkWidgetDrawCache *cache)
+{
+  if (cache->recording == NULL)
+    return;
+
+  g_queue_unlink (&draw_cache_lru, &cache->link);
+  cairo_surface_destroy (cache->recording);
+  cache->recording = NULL;
+}
+
+static void
+gtk_widget_invalidate_draw_cache (GtkWidget *widget)
+{
+  GtkWidgetDrawCache *cache;
+  GtkWidget *w;
+
+  if (n_draw_caches == 0)
+    return;
+
+  for (w = widget; w != NULL; w = w->priv->parent)
+    {
+      cache = w->priv->draw_cache;
+      if (cache == NULL)
+        continue;
+
+      if (cache->draws == 1)
+        cache->wasted++;
+      else if (cache->draws > 1)
+        cache->wasted = 0;
+      cache->draws = 0;
+
+      gtk_widget_draw_cache_drop (cache);
+    }
+}
+
+static void
+gtk_widget_free_draw_cache (GtkWidget *widget)
+{
+  GtkWidgetDrawCache *cache = widget->priv->draw_cache;
+
+  if (cache == NULL)
+    return;
+
+  GTK_NOTE (MISC,
+            g_message ("draw cache of %s %p: %u hits, %u misses",
+                       G_OBJECT_TYPE_NAME (widget), widget,
+                       cache->hits, cache->misses));
+
+  gtk_widget_draw_cache_drop (cache);
+  g_slice_free (GtkWidgetDrawCache, cache);
+  widget->priv->draw_cache = NULL;
+  n_draw_caches--;
+}
+
+static void
+gtk_widget_check_windowless (GtkWidget *widget,
+                             gpointer   data)
+{
+  gboolean *windowless = data;
+
+  if (!*windowless)
+    return;
+
+  if (gtk_widget_get_has_window (widget))
+    *windowless = FALSE;
+  else if (GTK_IS_CONTAINER (widget))
+    gtk_container_forall (GTK_CONTAINER (widget),
+                          gtk_widget_check_windowless,
+                          windowless);
+}
+
+/* Draws @widget from its recording, recording it first if needed.
+ * Returns %FALSE if the widget must be drawn directly instead.
+ */
+static gboolean
+gtk_widget_draw_cached (GtkWidget *widget,
+                        cairo_t   *cr,
+                        gboolean   clip_to_size)
+{
+  GtkWidgetDrawCache *cache = widget->priv->draw_cache;
+
+  cache->draws++;
+
+  if (cache->recording != NULL && cache->clipped != clip_to_size)
+    gtk_widget_draw_cache_drop (cache);
+
+  if (cache->recording != NULL)
+    {
+      cache->hits++;
+      g_queue_unlink (&draw_cache_lru, &cache->link);
+      g_queue_push_head_link (&draw_cache_lru, &cache->link);
+    }
+  else
+    {
+      cairo_surface_t *recording;
+      cairo_t *record_cr;
+      gboolean windowless = TRUE;
+      gboolean result;
+
+      if (cache->wasted >= DRAW_CACHE_MAX_WASTED && cache->draws < 2)
+        return FALSE;
+
+      /* Windows are exposed separately, a recording can only
+       * stand in for a subtree that draws into a single window.
+       */
+      gtk_widget_check_windowless (widget, &windowless);
+      if (!windowless)
+        return FALSE;
+
+      recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, NULL);
+      record_cr = cairo_create (recording);
+      if (clip_to_size)
+        {
+          cairo_rectangle (record_cr,
+                           0, 0,
+                           widget->priv->allocation.width,
+                           widget->priv->allocation.height);
+          cairo_clip (record_cr);
+        }
+
+      g_signal_emit (widget, widget_signals[DRAW],
+                     0, record_cr,
+                     &result);
+
+      if (cairo_status (record_cr))
+        {
+          cairo_destroy (record_cr);
+          cairo_surface_destroy (recording);
+          return FALSE;
+        }
+      cairo_destroy (record_cr);
+
+      /* Drawing may have invalidated the widget again, in which
+       * case the recording is only good for this one draw.
+       */
+      if (cache->draws == 0)
+        {
+          cairo_save (cr);
+          cairo_set_source_surface (cr, recording, 0, 0);
+          cairo_paint (cr);
+          cairo_restore (cr);
+          cairo_surface_destroy (recording);
+          return TRUE;
+        }
+
+      if (draw_cache_lru.length >= DRAW_CACHE_MAX_RECORDINGS)
+        gtk_widget_draw_cache_drop (g_queue_peek_tail (&draw_cache_lru));
+
+      cache->misses++;
+      cache->recording = recording;
+      cache->clipped = clip_to_size;
+      g_queue_push_head_link (&draw_cache_lru, &cache->link);
+    }
+
+  cairo_save (cr);
+  cairo_set_source_surface (cr, cache->recording, 0, 0);
+  cairo_paint (cr);
+  cairo_restore (cr);
+
+  return TRUE;
+}
+
 /* code shared by gtk_container_propagate_draw() and
  * gtk_widget_draw()
  */
@@ -6323,6 +6532,10 @@ _gtk_widget_draw_internal (GtkWidget *widget,
     {
       gboolean result;
 
+      if (widget->priv->draw_cache != NULL &&
+          gtk_widget_draw_cached (widget, cr, clip_to_size))
+        return;
+
       g_signal_emit (widget, widget_signals[DRAW],
                      0, cr,
                      &result);
@@ -7167,7 +7380,7 @@ gtk_widget_real_style_updated (GtkWidget *widget)
 
   if (widget->priv->context)
     {
-      const GtkBitmask *changes = _gtk_style_context_get_changes (widget->priv->context);
+      const GtkCssPropertySet *changes = _gtk_style_context_get_changes (widget->priv->context);
 
       if (gtk_widget_get_realized (widget) &&
           gtk_widget_get_has_window (widget) &&
@@ -8324,6 +8537,73 @@ gtk_widget_set_redraw_on_allocate (GtkWidget *widget,
   widget->priv->redraw_on_alloc = redraw_on_allocate;
 }
 
+/**
+ * gtk_widget_set_cache_drawing:
+ * @widget: a #GtkWidget
+ * @cache_drawing: %TRUE to keep a recording of the widget's drawing
+ *
+ * Sets whether GTK+ keeps a recording of what @widget drew and
+ * replays it instead of emitting #GtkWidget::draw again. The
+ * recording is dropped whenever @widget or one of its children
+ * queues a redraw, changes its size allocation or style, or gets
+ * mapped or unmapped.
+ *
+ * This is useful for complex widgets that rarely change but sit in
+ * a window that is redrawn often, such as a panel of labels and
+ * frames next to an animation. Only widgets that don't have a
+ * #GdkWindow of their own, and whose children don't either, are
+ * cached; the number of recordings kept alive at once is limited.
+ *
+ * Widgets with caching enabled must queue a redraw whenever their
+ * appearance changes, as widgets implemented in GTK+ do.
+ *
+ * Since: 3.12
+ **/
+void
+gtk_widget_set_cache_drawing (GtkWidget *widget,
+                              gboolean   cache_drawing)
+{
+  GtkWidgetPrivate *priv;
+  GtkWidgetDrawCache *cache;
+
+  g_return_if_fail (GTK_IS_WIDGET (widget));
+
+  priv = widget->priv;
+  cache_drawing = cache_drawing != FALSE;
+
+  if ((priv->draw_cache != NULL) == cache_drawing)
+    return;
+
+  if (cache_drawing)
+    {
+      cache = g_slice_new0 (GtkWidgetDrawCache);
+      cache->link.data = cache;
+      priv->draw_cache = cache;
+      n_draw_caches++;
+    }
+  else
+    gtk_widget_free_draw_cache (widget);
+}
+
+/**
+ * gtk_widget_get_cache_drawing:
+ * @widget: a #GtkWidget
+ *
+ * Returns whether the drawing of @widget is cached. See
+ * gtk_widget_set_cache_drawing().
+ *
+ * Returns: %TRUE if the drawing of @widget is cached
+ *
+ * Since: 3.12
+ **/
+gboolean
+gtk_widget_get_cache_drawing (GtkWidget *widget)
+{
+  g_return_val_if_fail (GTK_IS_WIDGET (widget), FALSE);
+
+  return widget->priv->draw_cache != NULL;
+}
+
 /**
  * gtk_widget_set_sensitive:
  * @widget: a #GtkWidget
@@ -8461,6 +8741,8 @@ gtk_widget_set_parent (GtkWidget *widget,
   gtk_widget_push_verify_invariants (widget);
 
   priv->parent = parent;
+  _gtk_widget_invalidate_path (widget);
+  gtk_widget_invalidate_draw_cache (widget);
 
   parent_flags = gtk_widget_get_state_flags (parent);
 
@@ -11412,10 +11694,7 @@ gtk_widget_constructed (GObject *object)
    */
   if (priv->path &&
       G_OBJECT_TYPE (widget) != gtk_widget_path_get_object_type (priv->path))
-    {
-      gtk_widget_path_free (priv->path);
-      priv->path = NULL;
-    }
+    _gtk_widget_invalidate_path (widget);
 
   G_OBJECT_CLASS (gtk_widget_parent_class)->constructed (object);
 }
@@ -11662,6 +11941,10 @@ gtk_widget_finalize (GObject *object)
 
   if (priv->path)
     gtk_widget_path_free (priv->path);
+  if (priv->path_parent)
+    gtk_widget_path_unref (priv->path_parent);
+
+  gtk_widget_free_draw_cache (widget);
 
   if (priv->context)
     {
@@ -15650,8 +15933,20 @@ gtk_widget_path_append_for_widget (GtkWidgetPath *path,
   return pos;
 }
 
-GtkWidgetPath *
-_gtk_widget_create_path (GtkWidget *widget)
+static GtkWidget *
+gtk_widget_get_path_parent (GtkWidget *widget)
+{
+  if (widget->priv->parent)
+    return widget->priv->parent;
+
+  if (GTK_IS_WINDOW (widget))
+    return gtk_window_get_attached_to (GTK_WINDOW (widget));
+
+  return NULL;
+}
+
+static GtkWidgetPath *
+gtk_widget_build_path (GtkWidget *widget)
 {
   GtkWidget *parent;
 
@@ -15683,6 +15978,40 @@ _gtk_widget_create_path (GtkWidget *widget)
     }
 }
 
+/* Paths picked up the classes of saved style contexts, so they
+ * must not outlive the gtk_style_context_save() that caused them.
+ */
+static gboolean
+gtk_widget_has_saved_style (GtkWidget *widget,
+                            GtkWidget *parent)
+{
+  if (widget->priv->context &&
+      _gtk_style_context_is_saved (widget->priv->context))
+    return TRUE;
+
+  if (parent && parent->priv->context &&
+      _gtk_style_context_is_saved (parent->priv->context))
+    return TRUE;
+
+  return FALSE;
+}
+
+/* Marks the widget's own element of its path as changed. The paths
+ * of its descendants notice when they are next used, because the
+ * path they were built from is no longer their parent's path.
+ */
+void
+_gtk_widget_invalidate_path (GtkWidget *widget)
+{
+  widget->priv->path_invalid = TRUE;
+}
+
+GtkWidgetPath *
+_gtk_widget_create_path (GtkWidget *widget)
+{
+  return gtk_widget_path_copy (gtk_widget_get_path (widget));
+}
+
 /**
  * gtk_widget_get_path:
  * @widget: a #GtkWidget
@@ -15696,22 +16025,49 @@ _gtk_widget_create_path (GtkWidget *widget)
 GtkWidgetPath *
 gtk_widget_get_path (GtkWidget *widget)
 {
+  GtkWidgetPrivate *priv;
+  GtkWidget *parent;
+  GtkWidgetPath *parent_path;
+  GtkWidgetPath *old_path, *old_path_parent;
+
   g_return_val_if_fail (GTK_IS_WIDGET (widget), NULL);
 
-  if (!widget->priv->path)
-    widget->priv->path = _gtk_widget_create_path (widget);
+  priv = widget->priv;
+
+  parent = gtk_widget_get_path_parent (widget);
+  parent_path = parent ? gtk_widget_get_path (parent) : NULL;
 
-  return widget->priv->path;
+  if (priv->path &&
+      !priv->path_invalid &&
+      priv->path_parent == parent_path)
+    return priv->path;
+
+  old_path = priv->path;
+  old_path_parent = priv->path_parent;
+
+  priv->path = gtk_widget_build_path (widget);
+
+  /* Building the path asks the parent for its path again, which
+   * replaces it if the parent's style context is saved, so we
+   * remember the one that was actually used. Keeping it alive
+   * means a new path for the parent can never be mistaken for it.
+   */
+  priv->path_parent = parent ? gtk_widget_path_ref (parent->priv->path) : NULL;
+  priv->path_invalid = gtk_widget_has_saved_style (widget, priv->parent);
+
+  /* only let go of the old paths once nothing can be using them */
+  if (old_path)
+    gtk_widget_path_unref (old_path);
+  if (old_path_parent)
+    gtk_widget_path_unref (old_path_parent);
+
+  return priv->path;
 }
 
 void
 _gtk_widget_style_context_invalidated (GtkWidget *widget)
 {
-  if (widget->priv->path)
-    {
-      gtk_widget_path_free (widget->priv->path);
-      widget->priv->path = NULL;
-    }
+  gtk_widget_invalidate_draw_cache (widget);
 
   if (gtk_widget_get_realized (widget))
     g_signal_emit (widget, widget_signals[STYLE_UPDATED], 0);
@@ -15778,6 +16134,9 @@ _gtk_widget_invalidate_style_context (GtkWidget    *widget,
 
   priv = widget->priv;
 
+  if (change & GTK_CSS_CHANGE_PATH)
+    _gtk_widget_invalidate_path (widget);
+
   if (priv->context == NULL)
     return;
 
@@ -647,6 +647,9 @@ gboolean              gtk_widget_get_double_buffered    (GtkWidget    *widget);
 
 void                  gtk_widget_set_redraw_on_allocate (GtkWidget    *widget,
 							 gboolean      redraw_on_allocate);
+void                  gtk_widget_set_cache_drawing      (GtkWidget    *widget,
+                                                         gboolean      cache_drawing);
+gboolean              gtk_widget_get_cache_drawing      (GtkWidget    *widget);
 
 void                  gtk_widget_set_parent             (GtkWidget    *widget,
 							 GtkWidget    *parent);
@@ -73,6 +73,7 @@ void _gtk_widget_compute_size_for_orientation  (GtkWidget         *widget,
                                                 gint               for_size,
                                                 gint              *minimum_size,
                                                 gint              *natural_size);
+guint _gtk_size_request_get_n_measured        (void);
 void _gtk_widget_get_preferred_size_for_size   (GtkWidget         *widget,
                                                 GtkOrientation     orientation,
                                                 gint               size,
@@ -130,6 +131,7 @@ void              _gtk_widget_buildable_finish_accelerator (GtkWidget *widget,
                                                             gpointer   user_data);
 
 GtkWidgetPath *   _gtk_widget_create_path                  (GtkWidget    *widget);
+void              _gtk_widget_invalidate_path              (GtkWidget    *widget);
 void              _gtk_widget_invalidate_style_context     (GtkWidget    *widget,
                                                             GtkCssChange  change);
 void              _gtk_widget_style_context_invalidated    (GtkWidget    *widget);
@@ -0,0 +1,159 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2013 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+/* Returns the menu items of the rows at @depth in @menu, leaving
+ * out tearoff, header and separator items
+ */
+static GList *
+get_row_items (GtkWidget *menu,
+               gint       depth)
+{
+  GList *children, *l, *items = NULL;
+  GtkWidget *child;
+  GtkTreePath *path;
+
+  children = gtk_container_get_children (GTK_CONTAINER (menu));
+  for (l = children; l; l = l->next)
+    {
+      child = gtk_bin_get_child (GTK_BIN (l->data));
+      if (!GTK_IS_CELL_VIEW (child))
+        continue;
+
+      path = gtk_cell_view_get_displayed_row (GTK_CELL_VIEW (child));
+      if (path && gtk_tree_path_get_depth (path) == depth)
+        items = g_list_prepend (items, l->data);
+      gtk_tree_path_free (path);
+    }
+  g_list_free (children);
+
+  return g_list_reverse (items);
+}
+
+/* Checks that @menu has one item per row of @parent, in order */
+static void
+check_menu (GtkWidget    *menu,
+            GtkTreeModel *model,
+            GtkTreeIter  *parent)
+{
+  GList *items, *l;
+  GtkTreePath *path, *expected;
+  gint depth, i;
+
+  if (parent)
+    {
+      expected = gtk_tree_model_get_path (model, parent);
+      gtk_tree_path_down (expected);
+    }
+  else
+    expected = gtk_tree_path_new_first ();
+  depth = gtk_tree_path_get_depth (expected);
+
+  items = get_row_items (menu, depth);
+  g_assert_cmpint (g_list_length (items), ==, gtk_tree_model_iter_n_children (model, parent));
+
+  for (l = items, i = 0; l; l = l->next, i++)
+    {
+      path = gtk_cell_view_get_displayed_row (GTK_CELL_VIEW (gtk_bin_get_child (l->data)));
+      g_assert_cmpint (gtk_tree_path_compare (path, expected), ==, 0);
+      gtk_tree_path_free (path);
+      gtk_tree_path_next (expected);
+    }
+
+  gtk_tree_path_free (expected);
+  g_list_free (items);
+}
+
+/* The menu of a combo box indexes its row items by position and
+ * populates submenus lazily, model changes must still end up in
+ * the right items
+ */
+static void
+test_tree_menu_changes (void)
+{
+  GtkWidget *window, *combo, *menu, *submenu;
+  GtkTreeStore *store;
+  GtkCellRenderer *cell;
+  GtkTreeIter parent, iter;
+  GList *items;
+
+  store = gtk_tree_store_new (2, G_TYPE_STRING, G_TYPE_BOOLEAN);
+  gtk_tree_store_insert_with_values (store, &parent, NULL, -1, 0, "a", 1, TRUE, -1);
+  gtk_tree_store_insert_with_values (store, NULL, &parent, -1, 0, "a1", 1, TRUE, -1);
+  gtk_tree_store_insert_with_values (store, NULL, &parent, -1, 0, "a2", 1, TRUE, -1);
+  gtk_tree_store_insert_with_values (store, NULL, NULL, -1, 0, "b", 1, TRUE, -1);
+  gtk_tree_store_insert_with_values (store, NULL, NULL, -1, 0, "c", 1, TRUE, -1);
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  combo = gtk_combo_box_new_with_model (GTK_TREE_MODEL (store));
+  cell = gtk_cell_renderer_text_new ();
+  gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (combo), cell, TRUE);
+  gtk_cell_layout_set_attributes (GTK_CELL_LAYOUT (combo), cell,
+                                  "text", 0, "sensitive", 1, NULL);
+  gtk_container_add (GTK_CONTAINER (window), combo);
+  gtk_widget_show_all (window);
+  gtk_test_widget_wait_for_draw (window);
+
+  gtk_combo_box_popup (GTK_COMBO_BOX (combo));
+  menu = gtk_menu_get_for_attach_widget (combo)->data;
+  gtk_test_widget_wait_for_draw (gtk_widget_get_toplevel (menu));
+  check_menu (menu, GTK_TREE_MODEL (store), NULL);
+
+  /* moves all row items */
+  gtk_tree_store_insert_with_values (store, NULL, NULL, 0, 0, "new", 1, TRUE, -1);
+  check_menu (menu, GTK_TREE_MODEL (store), NULL);
+
+  /* "b" is the third row now */
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 2);
+  gtk_tree_store_set (store, &iter, 1, FALSE, -1);
+  gtk_test_widget_wait_for_draw (gtk_widget_get_toplevel (menu));
+
+  items = get_row_items (menu, 1);
+  g_assert (gtk_widget_get_sensitive (g_list_nth_data (items, 1)));
+  g_assert (!gtk_widget_get_sensitive (g_list_nth_data (items, 2)));
+  g_assert (gtk_widget_get_sensitive (g_list_nth_data (items, 3)));
+
+  /* rows added to a submenu that was never shown show up once it is */
+  gtk_tree_store_insert_with_values (store, NULL, &parent, 0, 0, "a0", 1, TRUE, -1);
+  submenu = gtk_menu_item_get_submenu (g_list_nth_data (items, 1));
+  g_assert (submenu != NULL);
+  gtk_widget_show (submenu);
+  check_menu (submenu, GTK_TREE_MODEL (store), &parent);
+
+  /* and it follows changes from then on */
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, &parent, 1);
+  gtk_tree_store_remove (store, &iter);
+  check_menu (submenu, GTK_TREE_MODEL (store), &parent);
+
+  g_list_free (items);
+  gtk_combo_box_popdown (GTK_COMBO_BOX (combo));
+  gtk_widget_destroy (window);
+  g_object_unref (store);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/combobox/tree-menu-changes", test_tree_menu_changes);
+
+  return g_test_run ();
+}
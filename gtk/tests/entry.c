@@ -308,6 +308,146 @@ test_delete (void)
   g_object_unref (entry);
 }
 
+static gchar *
+complete (GtkEntryCompletion *completion,
+          const gchar        *text)
+{
+  gtk_entry_set_text (GTK_ENTRY (gtk_entry_completion_get_entry (completion)), text);
+  gtk_entry_completion_complete (completion);
+
+  /* the common prefix of all rows which are currently matching */
+  return gtk_entry_completion_compute_prefix (completion, "");
+}
+
+static void
+test_completion (void)
+{
+  GtkWidget *entry;
+  GtkEntryCompletion *completion;
+  GtkListStore *store;
+  GtkTreeIter iter, abc, abd;
+  gchar *prefix;
+
+  entry = gtk_entry_new ();
+  g_object_ref_sink (entry);
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  gtk_list_store_insert_with_values (store, &abc, -1, 0, "abc", -1);
+  gtk_list_store_insert_with_values (store, &abd, -1, 0, "abd", -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, "Abx", -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, NULL, -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, "b", -1);
+
+  completion = gtk_entry_completion_new ();
+  gtk_entry_completion_set_model (completion, GTK_TREE_MODEL (store));
+  gtk_entry_completion_set_text_column (completion, 0);
+  gtk_entry_set_completion (GTK_ENTRY (entry), completion);
+
+  prefix = complete (completion, "ab");
+  g_assert_cmpstr (prefix, ==, "");
+  g_free (prefix);
+
+  prefix = complete (completion, "abc");
+  g_assert_cmpstr (prefix, ==, "abc");
+  g_free (prefix);
+
+  /* rows are matched as they are added, changed and removed */
+  gtk_list_store_insert_with_values (store, &iter, 0, 0, "ABCD", -1);
+  prefix = gtk_entry_completion_compute_prefix (completion, "");
+  g_assert_cmpstr (prefix, ==, "");
+  g_free (prefix);
+
+  gtk_list_store_set (store, &iter, 0, "abcd", -1);
+  prefix = gtk_entry_completion_compute_prefix (completion, "");
+  g_assert_cmpstr (prefix, ==, "abc");
+  g_free (prefix);
+
+  gtk_list_store_remove (store, &abc);
+  prefix = gtk_entry_completion_compute_prefix (completion, "");
+  g_assert_cmpstr (prefix, ==, "abcd");
+  g_free (prefix);
+
+  prefix = complete (completion, "abcd");
+  g_assert_cmpstr (prefix, ==, "abcd");
+  g_free (prefix);
+
+  prefix = complete (completion, "B");
+  g_assert_cmpstr (prefix, ==, "b");
+  g_free (prefix);
+
+  prefix = complete (completion, "abx");
+  g_assert_cmpstr (prefix, ==, "Abx");
+  g_free (prefix);
+
+  prefix = complete (completion, "x");
+  g_assert_cmpstr (prefix, ==, NULL);
+  g_free (prefix);
+
+  /* removing a row keeps the sorted index and the current matches */
+  prefix = complete (completion, "ab");
+  g_assert_cmpstr (prefix, ==, "");
+  g_free (prefix);
+
+  gtk_list_store_remove (store, &abd);
+  prefix = gtk_entry_completion_compute_prefix (completion, "");
+  g_assert_cmpstr (prefix, ==, "");
+  g_free (prefix);
+
+  prefix = complete (completion, "abx");
+  g_assert_cmpstr (prefix, ==, "Abx");
+  g_free (prefix);
+
+  prefix = complete (completion, "abd");
+  g_assert_cmpstr (prefix, ==, NULL);
+  g_free (prefix);
+
+  g_object_unref (completion);
+  g_object_unref (store);
+  g_object_unref (entry);
+}
+
+static gint
+get_width_with_font (GtkWidget   *entry,
+                     const gchar *font_name)
+{
+  PangoFontDescription *font;
+  gint width;
+
+  font = pango_font_description_from_string (font_name);
+  gtk_widget_override_font (entry, font);
+  pango_font_description_free (font);
+
+  gtk_test_widget_wait_for_draw (gtk_widget_get_toplevel (entry));
+
+  gtk_widget_get_preferred_width (entry, &width, NULL);
+
+  return width;
+}
+
+/* The width of width-chars comes from cached font metrics, which
+ * must still follow the font
+ */
+static void
+test_width_chars_font (void)
+{
+  GtkWidget *window, *entry;
+  gint small, large;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  entry = gtk_entry_new ();
+  gtk_entry_set_width_chars (GTK_ENTRY (entry), 20);
+  gtk_container_add (GTK_CONTAINER (window), entry);
+  gtk_widget_show_all (window);
+
+  small = get_width_with_font (entry, "Sans 10");
+  large = get_width_with_font (entry, "Sans 30");
+  g_assert_cmpint (large, >, small);
+
+  g_assert_cmpint (get_width_with_font (entry, "Sans 10"), ==, small);
+
+  gtk_widget_destroy (window);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -316,6 +456,8 @@ main (int   argc,
 
   g_test_add_func ("/entry/delete", test_delete);
   g_test_add_func ("/entry/insert", test_insert);
+  g_test_add_func ("/entry/completion", test_completion);
+  g_test_add_func ("/entry/width-chars-font", test_width_chars_font);
 
   return g_test_run();
 }
@@ -2340,6 +2340,141 @@ filtered_rows_reordered_child_level_all_hidden (FilterTest    *fixture,
   signal_monitor_assert_is_empty (fixture->monitor);
 }
 
+static void
+run_pending_updates (void)
+{
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+}
+
+static void
+queued_refilter_root_level (FilterTest    *fixture,
+                            gconstpointer  user_data)
+{
+  /* Change visibility behind the filter's back */
+  filter_test_block_signals (fixture);
+  set_path_visibility (fixture, "1", FALSE);
+  set_path_visibility (fixture, "3", FALSE);
+  filter_test_unblock_signals (fixture);
+
+  /* Nothing may be emitted before the main loop runs, and rows which
+   * stay visible do not get row-changed.
+   */
+  gtk_tree_model_filter_queue_refilter (fixture->filter);
+  gtk_tree_model_filter_queue_refilter (fixture->filter);
+
+  signal_monitor_append_signal (fixture->monitor, ROW_DELETED, "1");
+  signal_monitor_append_signal (fixture->monitor, ROW_DELETED, "2");
+  run_pending_updates ();
+  signal_monitor_assert_is_empty (fixture->monitor);
+
+  check_filter_model (fixture);
+  check_level_length (fixture->filter, NULL, LEVEL_LENGTH - 2);
+
+  filter_test_block_signals (fixture);
+  set_path_visibility (fixture, "1", TRUE);
+  set_path_visibility (fixture, "3", TRUE);
+  filter_test_unblock_signals (fixture);
+
+  gtk_tree_model_filter_queue_refilter (fixture->filter);
+
+  signal_monitor_append_signal (fixture->monitor, ROW_INSERTED, "1");
+  signal_monitor_append_signal (fixture->monitor, ROW_HAS_CHILD_TOGGLED, "1");
+  signal_monitor_append_signal (fixture->monitor, ROW_INSERTED, "3");
+  signal_monitor_append_signal (fixture->monitor, ROW_HAS_CHILD_TOGGLED, "3");
+  run_pending_updates ();
+  signal_monitor_assert_is_empty (fixture->monitor);
+
+  check_filter_model (fixture);
+  check_level_length (fixture->filter, NULL, LEVEL_LENGTH);
+}
+
+static void
+queued_refilter_child_level (FilterTest    *fixture,
+                             gconstpointer  user_data)
+{
+  GtkTreePath *path;
+
+  path = gtk_tree_path_new_from_indices (0, -1);
+  gtk_tree_view_expand_row (GTK_TREE_VIEW (fixture->tree_view), path, FALSE);
+  gtk_tree_path_free (path);
+
+  filter_test_block_signals (fixture);
+  set_path_visibility (fixture, "2", FALSE);
+  set_path_visibility (fixture, "0:1", FALSE);
+  set_path_visibility (fixture, "0:3", FALSE);
+  filter_test_unblock_signals (fixture);
+
+  gtk_tree_model_filter_queue_refilter (fixture->filter);
+
+  /* Levels are handled top-down */
+  signal_monitor_append_signal (fixture->monitor, ROW_DELETED, "2");
+  signal_monitor_append_signal (fixture->monitor, ROW_DELETED, "0:1");
+  signal_monitor_append_signal (fixture->monitor, ROW_DELETED, "0:2");
+  run_pending_updates ();
+  signal_monitor_assert_is_empty (fixture->monitor);
+
+  check_filter_model (fixture);
+  check_level_length (fixture->filter, NULL, LEVEL_LENGTH - 1);
+  check_level_length (fixture->filter, "0", LEVEL_LENGTH - 2);
+}
+
+static void
+batch_updates_row_changed (FilterTest    *fixture,
+                           gconstpointer  user_data)
+{
+  gtk_tree_model_filter_set_batch_updates (fixture->filter, TRUE);
+
+  set_path_visibility (fixture, "3", FALSE);
+  set_path_visibility (fixture, "1", TRUE);
+  set_path_visibility (fixture, "1", TRUE);
+  set_path_visibility (fixture, "2", FALSE);
+
+  /* Handled once per row, in child model order */
+  signal_monitor_append_signal (fixture->monitor, ROW_CHANGED, "1");
+  signal_monitor_append_signal (fixture->monitor, ROW_DELETED, "2");
+  signal_monitor_append_signal (fixture->monitor, ROW_DELETED, "2");
+  run_pending_updates ();
+
+  check_filter_model (fixture);
+  check_level_length (fixture->filter, NULL, LEVEL_LENGTH - 2);
+}
+
+static void
+batch_updates_row_deleted (FilterTest    *fixture,
+                           gconstpointer  user_data)
+{
+  GtkTreeIter iter;
+
+  gtk_tree_model_filter_set_batch_updates (fixture->filter, TRUE);
+
+  set_path_visibility (fixture, "3", FALSE);
+
+  /* Structural changes are not deferred, the pending change follows
+   * its row.
+   */
+  signal_monitor_append_signal (fixture->monitor, ROW_DELETED, "0");
+  gtk_tree_model_get_iter_from_string (GTK_TREE_MODEL (fixture->store),
+                                       &iter, "0");
+  gtk_tree_store_remove (fixture->store, &iter);
+  signal_monitor_assert_is_empty (fixture->monitor);
+
+  signal_monitor_append_signal (fixture->monitor, ROW_DELETED, "2");
+  run_pending_updates ();
+
+  check_filter_model (fixture);
+  check_level_length (fixture->filter, NULL, LEVEL_LENGTH - 2);
+
+  /* Turning batching off handles changes right away */
+  set_path_visibility (fixture, "0", FALSE);
+
+  signal_monitor_append_signal (fixture->monitor, ROW_DELETED, "0");
+  gtk_tree_model_filter_set_batch_updates (fixture->filter, FALSE);
+  signal_monitor_assert_is_empty (fixture->monitor);
+
+  check_filter_model (fixture);
+}
+
 static void
 insert_before (void)
 {
@@ -6995,6 +7130,27 @@ register_filter_model_tests (void)
               filtered_rows_reordered_child_level_all_hidden,
               filter_test_teardown);
 
+  g_test_add ("/TreeModelFilter/queued-refilter/root-level",
+              FilterTest, NULL,
+              filter_test_setup,
+              queued_refilter_root_level,
+              filter_test_teardown);
+  g_test_add ("/TreeModelFilter/queued-refilter/child-level",
+              FilterTest, NULL,
+              filter_test_setup,
+              queued_refilter_child_level,
+              filter_test_teardown);
+  g_test_add ("/TreeModelFilter/batch-updates/row-changed",
+              FilterTest, NULL,
+              filter_test_setup,
+              batch_updates_row_changed,
+              filter_test_teardown);
+  g_test_add ("/TreeModelFilter/batch-updates/row-deleted",
+              FilterTest, NULL,
+              filter_test_setup,
+              batch_updates_row_deleted,
+              filter_test_teardown);
+
   /* Inserts in child models after creation of filter model */
   g_test_add_func ("/TreeModelFilter/insert/before",
                    insert_before);
@@ -0,0 +1,164 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2013 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+static GtkIconView *
+create_icon_view (GtkListStore *store)
+{
+  GtkWidget *window, *icon_view;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  icon_view = gtk_icon_view_new_with_model (GTK_TREE_MODEL (store));
+  gtk_icon_view_set_text_column (GTK_ICON_VIEW (icon_view), 0);
+  gtk_icon_view_set_columns (GTK_ICON_VIEW (icon_view), 3);
+  gtk_container_add (GTK_CONTAINER (window), icon_view);
+  gtk_widget_show_all (window);
+
+  return GTK_ICON_VIEW (icon_view);
+}
+
+static GtkListStore *
+create_store (gint n_items)
+{
+  GtkListStore *store;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < n_items; i++)
+    gtk_list_store_insert_with_values (store, NULL, i, 0, "item", -1);
+
+  return store;
+}
+
+static void
+get_cell_rect (GtkIconView  *icon_view,
+               gint          index,
+               GdkRectangle *rect)
+{
+  GtkTreePath *path;
+
+  gtk_test_widget_wait_for_draw (gtk_widget_get_toplevel (GTK_WIDGET (icon_view)));
+
+  path = gtk_tree_path_new_from_indices (index, -1);
+  g_assert (gtk_icon_view_get_cell_rect (icon_view, path, NULL, rect));
+  gtk_tree_path_free (path);
+}
+
+/* Checks the position of an item and that hit testing at its
+ * position finds it again
+ */
+static void
+check_item (GtkIconView *icon_view,
+            gint         index,
+            gint         row,
+            gint         column)
+{
+  GtkTreePath *path, *hit;
+  GdkRectangle rect;
+
+  get_cell_rect (icon_view, index, &rect);
+
+  path = gtk_tree_path_new_from_indices (index, -1);
+  g_assert_cmpint (gtk_icon_view_get_item_row (icon_view, path), ==, row);
+  g_assert_cmpint (gtk_icon_view_get_item_column (icon_view, path), ==, column);
+
+  hit = gtk_icon_view_get_path_at_pos (icon_view,
+                                       rect.x + rect.width / 2,
+                                       rect.y + rect.height / 2);
+  g_assert (hit != NULL);
+  g_assert_cmpint (gtk_tree_path_compare (hit, path), ==, 0);
+
+  gtk_tree_path_free (hit);
+  gtk_tree_path_free (path);
+}
+
+/* The row index has to follow inserted and removed items and
+ * changes to the number of columns
+ */
+static void
+test_row_index (void)
+{
+  GtkListStore *store;
+  GtkIconView *icon_view;
+  GtkTreeIter iter;
+
+  store = create_store (12);
+  icon_view = create_icon_view (store);
+
+  check_item (icon_view, 0, 0, 0);
+  check_item (icon_view, 4, 1, 1);
+  check_item (icon_view, 11, 3, 2);
+
+  gtk_list_store_insert_with_values (store, NULL, 0, 0, "first", -1);
+  check_item (icon_view, 4, 1, 1);
+  check_item (icon_view, 12, 4, 0);
+
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  gtk_list_store_remove (store, &iter);
+  gtk_list_store_remove (store, &iter);
+  check_item (icon_view, 10, 3, 1);
+
+  gtk_icon_view_set_columns (icon_view, 2);
+  check_item (icon_view, 4, 2, 0);
+  check_item (icon_view, 10, 5, 0);
+
+  gtk_widget_destroy (gtk_widget_get_toplevel (GTK_WIDGET (icon_view)));
+  g_object_unref (store);
+}
+
+/* In fixed size mode only the first item is measured, so changing
+ * it has to resize all items
+ */
+static void
+test_fixed_size_mode (void)
+{
+  GtkListStore *store;
+  GtkIconView *icon_view;
+  GtkTreeIter iter;
+  GdkRectangle rect;
+  gint width;
+
+  store = create_store (6);
+  icon_view = create_icon_view (store);
+  gtk_icon_view_set_fixed_size_mode (icon_view, TRUE);
+
+  get_cell_rect (icon_view, 5, &rect);
+  width = rect.width;
+
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  gtk_list_store_set (store, &iter, 0, "a much longer item", -1);
+
+  get_cell_rect (icon_view, 5, &rect);
+  g_assert_cmpint (rect.width, >, width);
+
+  gtk_widget_destroy (gtk_widget_get_toplevel (GTK_WIDGET (icon_view)));
+  g_object_unref (store);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/iconview/row-index", test_row_index);
+  g_test_add_func ("/iconview/fixed-size-mode", test_fixed_size_mode);
+
+  return g_test_run ();
+}
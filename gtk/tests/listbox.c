@@ -0,0 +1,315 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2013 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+#define N_ITEMS 1000
+#define ROW_HEIGHT 20
+
+typedef struct {
+  GtkWidget *window;
+  GtkListBox *list_box;
+  GtkAdjustment *adjustment;
+  GtkListStore *store;
+} BoundFixture;
+
+static void
+bind_label (GtkListBoxRow *row,
+            GtkTreeModel  *model,
+            GtkTreeIter   *iter,
+            gpointer       user_data)
+{
+  GtkWidget *label;
+  gchar *text;
+
+  label = gtk_bin_get_child (GTK_BIN (row));
+  if (label == NULL)
+    {
+      label = gtk_label_new (NULL);
+      gtk_widget_show (label);
+      gtk_container_add (GTK_CONTAINER (row), label);
+      gtk_widget_set_size_request (GTK_WIDGET (row), -1, ROW_HEIGHT);
+    }
+
+  gtk_tree_model_get (model, iter, 0, &text, -1);
+  gtk_label_set_text (GTK_LABEL (label), text);
+  g_free (text);
+}
+
+static void
+flush_events (void)
+{
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+}
+
+static void
+bound_fixture_setup (BoundFixture  *fixture,
+                     gconstpointer  test_data)
+{
+  GtkWidget *scrolled_window, *list_box;
+  gint i;
+
+  fixture->store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      gchar *text = g_strdup_printf ("%d", i);
+
+      gtk_list_store_insert_with_values (fixture->store, NULL, i, 0, text, -1);
+      g_free (text);
+    }
+
+  fixture->window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (fixture->window), 200, 400);
+  scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  list_box = gtk_list_box_new ();
+  gtk_container_add (GTK_CONTAINER (scrolled_window), list_box);
+  gtk_container_add (GTK_CONTAINER (fixture->window), scrolled_window);
+
+  fixture->list_box = GTK_LIST_BOX (list_box);
+  fixture->adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (scrolled_window));
+  gtk_list_box_bind_model (fixture->list_box, GTK_TREE_MODEL (fixture->store),
+                           bind_label, NULL, NULL);
+
+  gtk_widget_show_all (fixture->window);
+  flush_events ();
+}
+
+static void
+bound_fixture_teardown (BoundFixture  *fixture,
+                        gconstpointer  test_data)
+{
+  gtk_widget_destroy (fixture->window);
+  g_object_unref (fixture->store);
+}
+
+static const gchar *
+row_text (GtkListBoxRow *row)
+{
+  g_assert (row != NULL);
+
+  return gtk_label_get_text (GTK_LABEL (gtk_bin_get_child (GTK_BIN (row))));
+}
+
+static void
+scroll_to (BoundFixture *fixture,
+           gdouble       value)
+{
+  gtk_adjustment_set_value (fixture->adjustment, value);
+  flush_events ();
+}
+
+static void
+assert_selected_rows (BoundFixture  *fixture,
+                      GtkListBoxRow *selected)
+{
+  GList *children, *l;
+
+  children = gtk_container_get_children (GTK_CONTAINER (fixture->list_box));
+  for (l = children; l; l = l->next)
+    {
+      gboolean is_selected;
+
+      is_selected = (gtk_widget_get_state_flags (l->data) & GTK_STATE_FLAG_SELECTED) != 0;
+      g_assert (is_selected == (l->data == selected));
+    }
+  g_list_free (children);
+}
+
+static void
+test_bound_row_at_index (BoundFixture  *fixture,
+                         gconstpointer  test_data)
+{
+  g_assert_cmpstr (row_text (gtk_list_box_get_row_at_index (fixture->list_box, 0)), ==, "0");
+  g_assert_cmpstr (row_text (gtk_list_box_get_row_at_index (fixture->list_box, 5)), ==, "5");
+  g_assert (gtk_list_box_get_row_at_index (fixture->list_box, N_ITEMS - 1) == NULL);
+
+  scroll_to (fixture, gtk_adjustment_get_upper (fixture->adjustment));
+
+  g_assert (gtk_list_box_get_row_at_index (fixture->list_box, 0) == NULL);
+  g_assert_cmpstr (row_text (gtk_list_box_get_row_at_index (fixture->list_box, N_ITEMS - 1)), ==, "999");
+}
+
+static void
+test_bound_insert_delete (BoundFixture  *fixture,
+                          gconstpointer  test_data)
+{
+  GtkListBoxRow *row;
+  GtkTreeIter iter;
+
+  row = gtk_list_box_get_row_at_index (fixture->list_box, 2);
+  g_assert_cmpstr (row_text (row), ==, "2");
+
+  /* rows after an inserted item move down right away */
+  gtk_list_store_insert_with_values (fixture->store, &iter, 1, 0, "new", -1);
+  g_assert (gtk_list_box_get_row_at_index (fixture->list_box, 3) == row);
+  g_assert_cmpstr (row_text (gtk_list_box_get_row_at_index (fixture->list_box, 0)), ==, "0");
+
+  flush_events ();
+  g_assert_cmpstr (row_text (gtk_list_box_get_row_at_index (fixture->list_box, 1)), ==, "new");
+  g_assert_cmpstr (row_text (gtk_list_box_get_row_at_index (fixture->list_box, 3)), ==, "2");
+
+  /* and back up when it is deleted */
+  gtk_list_store_remove (fixture->store, &iter);
+  g_assert (gtk_list_box_get_row_at_index (fixture->list_box, 2) == row);
+
+  flush_events ();
+  g_assert_cmpstr (row_text (gtk_list_box_get_row_at_index (fixture->list_box, 1)), ==, "1");
+  g_assert_cmpstr (row_text (gtk_list_box_get_row_at_index (fixture->list_box, 2)), ==, "2");
+}
+
+static void
+test_bound_reorder (BoundFixture  *fixture,
+                    gconstpointer  test_data)
+{
+  GtkTreeIter a, b;
+  GtkListBoxRow *row;
+
+  gtk_list_box_select_row (fixture->list_box,
+                           gtk_list_box_get_row_at_index (fixture->list_box, 0));
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (fixture->store), &a, NULL, 0);
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (fixture->store), &b, NULL, 1);
+  gtk_list_store_swap (fixture->store, &a, &b);
+  flush_events ();
+
+  g_assert_cmpstr (row_text (gtk_list_box_get_row_at_index (fixture->list_box, 0)), ==, "1");
+  g_assert_cmpstr (row_text (gtk_list_box_get_row_at_index (fixture->list_box, 1)), ==, "0");
+
+  /* the selection moved with the item */
+  row = gtk_list_box_get_selected_row (fixture->list_box);
+  g_assert (row == gtk_list_box_get_row_at_index (fixture->list_box, 1));
+  assert_selected_rows (fixture, row);
+}
+
+static void
+test_bound_selection_recycled (BoundFixture  *fixture,
+                               gconstpointer  test_data)
+{
+  GtkListBoxRow *row;
+
+  gtk_list_box_select_row (fixture->list_box,
+                           gtk_list_box_get_row_at_index (fixture->list_box, 3));
+
+  /* the row is reused for another item, which is not selected */
+  scroll_to (fixture, gtk_adjustment_get_upper (fixture->adjustment));
+  g_assert (gtk_list_box_get_row_at_index (fixture->list_box, 3) == NULL);
+  assert_selected_rows (fixture, NULL);
+
+  /* whatever row shows the item again is selected */
+  scroll_to (fixture, 0);
+  row = gtk_list_box_get_row_at_index (fixture->list_box, 3);
+  g_assert_cmpstr (row_text (row), ==, "3");
+  g_assert (gtk_list_box_get_selected_row (fixture->list_box) == row);
+  assert_selected_rows (fixture, row);
+}
+
+static void
+test_bound_focus_kept (BoundFixture  *fixture,
+                       gconstpointer  test_data)
+{
+  GtkListBoxRow *row;
+
+  row = gtk_list_box_get_row_at_index (fixture->list_box, 0);
+  gtk_widget_grab_focus (GTK_WIDGET (row));
+  g_assert (gtk_window_get_focus (GTK_WINDOW (fixture->window)) == GTK_WIDGET (row));
+
+  /* the focus row is not recycled when scrolled out of view */
+  scroll_to (fixture, gtk_adjustment_get_upper (fixture->adjustment));
+  g_assert (gtk_window_get_focus (GTK_WINDOW (fixture->window)) == GTK_WIDGET (row));
+  g_assert (gtk_list_box_get_row_at_index (fixture->list_box, 0) == row);
+  g_assert_cmpstr (row_text (row), ==, "0");
+  g_assert_cmpstr (row_text (gtk_list_box_get_row_at_index (fixture->list_box, N_ITEMS - 1)), ==, "999");
+
+  scroll_to (fixture, 0);
+  g_assert (gtk_list_box_get_row_at_index (fixture->list_box, 0) == row);
+  g_assert_cmpstr (row_text (gtk_list_box_get_row_at_index (fixture->list_box, 1)), ==, "1");
+}
+
+static GtkListBoxRow *
+move_cursor (BoundFixture    *fixture,
+             GtkMovementStep  step,
+             gint             count)
+{
+  GtkListBoxRow *row;
+
+  g_signal_emit_by_name (fixture->list_box, "move-cursor", step, count);
+  flush_events ();
+
+  row = gtk_list_box_get_selected_row (fixture->list_box);
+  g_assert (row != NULL);
+  g_assert (gtk_window_get_focus (GTK_WINDOW (fixture->window)) == GTK_WIDGET (row));
+
+  return row;
+}
+
+static void
+test_bound_move_cursor (BoundFixture  *fixture,
+                        gconstpointer  test_data)
+{
+  GtkListBoxRow *row;
+  gint index;
+
+  gtk_widget_grab_focus (GTK_WIDGET (gtk_list_box_get_row_at_index (fixture->list_box, 0)));
+
+  /* the cursor moves to items that had no row */
+  row = move_cursor (fixture, GTK_MOVEMENT_BUFFER_ENDS, 1);
+  g_assert_cmpint (gtk_list_box_row_get_index (row), ==, N_ITEMS - 1);
+  g_assert_cmpstr (row_text (row), ==, "999");
+  g_assert_cmpfloat (gtk_adjustment_get_value (fixture->adjustment), >, 0.0);
+
+  row = move_cursor (fixture, GTK_MOVEMENT_DISPLAY_LINES, -1);
+  g_assert_cmpint (gtk_list_box_row_get_index (row), ==, N_ITEMS - 2);
+
+  row = move_cursor (fixture, GTK_MOVEMENT_BUFFER_ENDS, -1);
+  g_assert_cmpint (gtk_list_box_row_get_index (row), ==, 0);
+  g_assert_cmpfloat (gtk_adjustment_get_value (fixture->adjustment), ==, 0.0);
+
+  /* a page down moves by several items, and scrolls along */
+  row = move_cursor (fixture, GTK_MOVEMENT_PAGES, 1);
+  index = gtk_list_box_row_get_index (row);
+  g_assert_cmpint (index, >, 1);
+  g_assert_cmpint (index, <, N_ITEMS - 1);
+  g_assert_cmpfloat (gtk_adjustment_get_value (fixture->adjustment), >, 0.0);
+
+  row = move_cursor (fixture, GTK_MOVEMENT_PAGES, -1);
+  g_assert_cmpint (gtk_list_box_row_get_index (row), <, index);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add ("/listbox/bound/row-at-index", BoundFixture, NULL,
+              bound_fixture_setup, test_bound_row_at_index, bound_fixture_teardown);
+  g_test_add ("/listbox/bound/insert-delete", BoundFixture, NULL,
+              bound_fixture_setup, test_bound_insert_delete, bound_fixture_teardown);
+  g_test_add ("/listbox/bound/reorder", BoundFixture, NULL,
+              bound_fixture_setup, test_bound_reorder, bound_fixture_teardown);
+  g_test_add ("/listbox/bound/selection-recycled", BoundFixture, NULL,
+              bound_fixture_setup, test_bound_selection_recycled, bound_fixture_teardown);
+  g_test_add ("/listbox/bound/focus-kept", BoundFixture, NULL,
+              bound_fixture_setup, test_bound_focus_kept, bound_fixture_teardown);
+  g_test_add ("/listbox/bound/move-cursor", BoundFixture, NULL,
+              bound_fixture_setup, test_bound_move_cursor, bound_fixture_teardown);
+
+  return g_test_run();
+}
@@ -0,0 +1,122 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2013 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* The property set is internal to GTK+. It is header-only, apart from
+ * the allocated bitmasks, which are built into this test.
+ */
+#define GTK_COMPILATION
+
+#include <string.h>
+
+#include <gtk/gtk.h>
+#include "gtk/gtkcsspropertysetprivate.h"
+
+#define N_CUSTOM 3
+
+static void
+test_init_all (void)
+{
+  GtkCssPropertySet all, added;
+  guint i;
+
+  _gtk_css_property_set_init_all (&all);
+
+  _gtk_css_property_set_init (&added);
+  g_assert (_gtk_css_property_set_is_empty (&added));
+  for (i = 0; i < GTK_CSS_PROPERTY_SET_N_BITS; i++)
+    {
+      g_assert (_gtk_css_property_set_get (&all, i));
+      _gtk_css_property_set_add (&added, i);
+    }
+
+  /* the bits past the last property stay clear */
+  g_assert (memcmp (&all, &added, sizeof (GtkCssPropertySet)) == 0);
+
+  _gtk_css_property_set_subtract (&all, &added);
+  g_assert (_gtk_css_property_set_is_empty (&all));
+}
+
+static void
+test_custom (void)
+{
+  GtkCssPropertySet set, other;
+
+  /* all custom properties share one bit */
+  _gtk_css_property_set_init (&set);
+  _gtk_css_property_set_add (&set, GTK_CSS_PROPERTY_N_PROPERTIES + 5);
+  g_assert (_gtk_css_property_set_get (&set, GTK_CSS_PROPERTY_SET_CUSTOM));
+  g_assert (_gtk_css_property_set_get (&set, GTK_CSS_PROPERTY_N_PROPERTIES + 17));
+  g_assert (!_gtk_css_property_set_get (&set, GTK_CSS_PROPERTY_N_PROPERTIES - 1));
+
+  _gtk_css_property_set_init (&other);
+  _gtk_css_property_set_add (&other, GTK_CSS_PROPERTY_N_PROPERTIES + 1);
+  g_assert (memcmp (&set, &other, sizeof (GtkCssPropertySet)) == 0);
+  g_assert (_gtk_css_property_set_intersects (&set, &other));
+
+  _gtk_css_property_set_add (&other, GTK_CSS_PROPERTY_COLOR);
+  _gtk_css_property_set_intersect (&other, &set);
+  g_assert (!_gtk_css_property_set_get (&other, GTK_CSS_PROPERTY_COLOR));
+  g_assert (_gtk_css_property_set_get (&other, GTK_CSS_PROPERTY_SET_CUSTOM));
+}
+
+/* The bitmask GtkCssLookup is created with */
+static void
+test_to_bitmask (void)
+{
+  GtkCssPropertySet set;
+  GtkBitmask *mask;
+  guint n, i;
+
+  n = GTK_CSS_PROPERTY_N_PROPERTIES + N_CUSTOM;
+
+  _gtk_css_property_set_init (&set);
+  _gtk_css_property_set_add (&set, GTK_CSS_PROPERTY_COLOR);
+  mask = _gtk_css_property_set_to_bitmask (&set, n);
+  for (i = 0; i < n + 1; i++)
+    g_assert (_gtk_bitmask_get (mask, i) == (i == GTK_CSS_PROPERTY_COLOR));
+  _gtk_bitmask_free (mask);
+
+  /* the custom bit covers every custom property */
+  _gtk_css_property_set_add (&set, GTK_CSS_PROPERTY_N_PROPERTIES);
+  mask = _gtk_css_property_set_to_bitmask (&set, n);
+  g_assert (_gtk_bitmask_get (mask, GTK_CSS_PROPERTY_COLOR));
+  g_assert (!_gtk_bitmask_get (mask, GTK_CSS_PROPERTY_FONT_SIZE));
+  for (i = GTK_CSS_PROPERTY_N_PROPERTIES; i < n; i++)
+    g_assert (_gtk_bitmask_get (mask, i));
+  g_assert (!_gtk_bitmask_get (mask, n));
+  _gtk_bitmask_free (mask);
+
+  /* without custom properties there is nothing to expand */
+  mask = _gtk_css_property_set_to_bitmask (&set, GTK_CSS_PROPERTY_N_PROPERTIES);
+  g_assert (!_gtk_bitmask_get (mask, GTK_CSS_PROPERTY_N_PROPERTIES));
+  _gtk_bitmask_free (mask);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/propertyset/init-all", test_init_all);
+  g_test_add_func ("/propertyset/custom", test_custom);
+  g_test_add_func ("/propertyset/to-bitmask", test_to_bitmask);
+
+  return g_test_run();
+}
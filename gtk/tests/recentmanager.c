@@ -19,6 +19,7 @@
  * Boston, MA 02111-1307, USA.
  */
 
+#include <string.h>
 #include <glib/gstdio.h>
 #include <gtk/gtk.h>
 
@@ -96,6 +97,73 @@ recent_manager_add (void)
   g_slice_free (GtkRecentData, recent_data);
 }
 
+static gboolean
+wait_timeout (gpointer data)
+{
+  gboolean *timed_out = data;
+
+  *timed_out = TRUE;
+
+  return FALSE;
+}
+
+static gboolean
+file_has_uri (const gchar *filename,
+              const gchar *file_uri)
+{
+  gchar *contents;
+  gboolean res;
+
+  if (!g_file_get_contents (filename, &contents, NULL, NULL))
+    return FALSE;
+
+  res = strstr (contents, file_uri) != NULL;
+  g_free (contents);
+
+  return res;
+}
+
+/* the list is written and reloaded by threads, so we spin the main
+ * loop until the change shows up, or give up after a few seconds
+ */
+static gboolean
+wait_for_file (const gchar *filename,
+               const gchar *file_uri,
+               gboolean     present)
+{
+  gboolean timed_out = FALSE;
+  guint id;
+
+  id = g_timeout_add (5000, wait_timeout, &timed_out);
+
+  while (file_has_uri (filename, file_uri) != present && !timed_out)
+    g_main_context_iteration (NULL, TRUE);
+
+  if (!timed_out)
+    g_source_remove (id);
+
+  return !timed_out;
+}
+
+static gboolean
+wait_for_item (GtkRecentManager *manager,
+               const gchar      *item_uri,
+               gboolean          present)
+{
+  gboolean timed_out = FALSE;
+  guint id;
+
+  id = g_timeout_add (5000, wait_timeout, &timed_out);
+
+  while (gtk_recent_manager_has_item (manager, item_uri) != present && !timed_out)
+    g_main_context_iteration (NULL, TRUE);
+
+  if (!timed_out)
+    g_source_remove (id);
+
+  return !timed_out;
+}
+
 typedef struct {
   GMainLoop *main_loop;
   gint counter;
@@ -151,6 +219,9 @@ recent_manager_add_many (void)
 
   g_main_loop_run (closure->main_loop);
 
+  /* "changed" only hands the list to the writer thread */
+  g_assert (wait_for_file ("recently-used.xbel", "file:///doesnotexist-99.txt", TRUE));
+
   g_main_loop_unref (closure->main_loop);
   g_slice_free (GtkRecentData, data);
   g_free (closure);
@@ -292,6 +363,150 @@ recent_manager_purge (void)
   g_assert (n == 1);
 }
 
+static void
+recent_manager_save_reload (void)
+{
+  const gchar *uri_a = "file:///tmp/testrecentsave-a.txt";
+  const gchar *uri_b = "file:///tmp/testrecentsave-b.txt";
+  GtkRecentManager *manager;
+  GtkRecentManager *manager2;
+  GtkRecentData *recent_data;
+  gchar *dirname, *filename;
+  GError *error;
+
+  error = NULL;
+  dirname = g_dir_make_tmp ("recentmanager-XXXXXX", &error);
+  g_assert_no_error (error);
+  filename = g_build_filename (dirname, "recently-used.xbel", NULL);
+
+  manager = g_object_new (GTK_TYPE_RECENT_MANAGER,
+                          "filename", filename,
+                          NULL);
+
+  recent_data = g_slice_new0 (GtkRecentData);
+  recent_data->mime_type = "text/plain";
+  recent_data->app_name = "testrecentchooser";
+  recent_data->app_exec = "testrecentchooser %u";
+
+  gtk_recent_manager_add_full (manager, uri_a, recent_data);
+  g_assert (wait_for_file (filename, uri_a, TRUE));
+
+  /* a new manager reads what the first one wrote */
+  manager2 = g_object_new (GTK_TYPE_RECENT_MANAGER,
+                           "filename", filename,
+                           NULL);
+  g_assert (gtk_recent_manager_has_item (manager2, uri_a));
+
+  /* and the first one reloads what the second one writes */
+  gtk_recent_manager_add_full (manager2, uri_b, recent_data);
+  g_assert (wait_for_item (manager, uri_b, TRUE));
+  g_assert (gtk_recent_manager_has_item (manager, uri_a));
+
+  gtk_recent_manager_remove_item (manager, uri_a, NULL);
+  g_assert (!gtk_recent_manager_has_item (manager, uri_a));
+  g_assert (wait_for_item (manager2, uri_a, FALSE));
+  g_assert (gtk_recent_manager_has_item (manager2, uri_b));
+
+  /* the file we wrote ourselves does not replace the list */
+  g_assert (wait_for_file (filename, uri_a, FALSE));
+  g_assert (!gtk_recent_manager_has_item (manager, uri_a));
+  g_assert (gtk_recent_manager_has_item (manager, uri_b));
+
+  g_slice_free (GtkRecentData, recent_data);
+  g_object_unref (manager2);
+  g_object_unref (manager);
+
+  g_assert_cmpint (g_unlink (filename), ==, 0);
+  g_assert_cmpint (g_rmdir (dirname), ==, 0);
+
+  g_free (filename);
+  g_free (dirname);
+}
+
+static void
+check_query (GtkRecentManager *manager,
+             GtkRecentFilter  *filter,
+             gint              limit,
+             const gchar     **expected)
+{
+  GList *items, *l;
+  gint i;
+
+  items = gtk_recent_manager_query_items (manager, filter, limit);
+
+  for (l = items, i = 0; l != NULL; l = l->next, i++)
+    {
+      g_assert (expected[i] != NULL);
+      g_assert_cmpstr (gtk_recent_info_get_uri (l->data), ==, expected[i]);
+    }
+  g_assert (expected[i] == NULL);
+
+  g_list_free_full (items, (GDestroyNotify) gtk_recent_info_unref);
+}
+
+static void
+recent_manager_query_items (void)
+{
+  const gchar *all[] = {
+    "file:///tmp/testrecentquery-b.txt",
+    "file:///tmp/testrecentquery-c.png",
+    "file:///tmp/testrecentquery-a.txt",
+    NULL
+  };
+  const gchar *first_two[] = { all[0], all[1], NULL };
+  const gchar *text[] = { all[0], all[2], NULL };
+  const gchar *first_text[] = { all[0], NULL };
+  const gchar *none[] = { NULL };
+  GtkRecentManager *manager;
+  GtkRecentFilter *filter;
+  GBookmarkFile *bookmarks;
+  gchar *dirname, *filename;
+  GError *error;
+
+  error = NULL;
+  dirname = g_dir_make_tmp ("recentmanager-XXXXXX", &error);
+  g_assert_no_error (error);
+  filename = g_build_filename (dirname, "recently-used.xbel", NULL);
+
+  /* items are returned by modification time, not in file order */
+  bookmarks = g_bookmark_file_new ();
+  g_bookmark_file_add_application (bookmarks, all[2], "testrecentchooser", "testrecentchooser %u");
+  g_bookmark_file_set_mime_type (bookmarks, all[2], "text/plain");
+  g_bookmark_file_set_modified (bookmarks, all[2], 1000);
+  g_bookmark_file_add_application (bookmarks, all[0], "testrecentchooser", "testrecentchooser %u");
+  g_bookmark_file_set_mime_type (bookmarks, all[0], "text/plain");
+  g_bookmark_file_set_modified (bookmarks, all[0], 3000);
+  g_bookmark_file_add_application (bookmarks, all[1], "testrecentchooser", "testrecentchooser %u");
+  g_bookmark_file_set_mime_type (bookmarks, all[1], "image/png");
+  g_bookmark_file_set_modified (bookmarks, all[1], 2000);
+  g_bookmark_file_to_file (bookmarks, filename, &error);
+  g_assert_no_error (error);
+  g_bookmark_file_free (bookmarks);
+
+  manager = g_object_new (GTK_TYPE_RECENT_MANAGER,
+                          "filename", filename,
+                          NULL);
+
+  check_query (manager, NULL, -1, all);
+  check_query (manager, NULL, 2, first_two);
+  check_query (manager, NULL, 0, none);
+
+  filter = g_object_ref_sink (gtk_recent_filter_new ());
+  gtk_recent_filter_add_mime_type (filter, "text/plain");
+
+  check_query (manager, filter, -1, text);
+  check_query (manager, filter, 1, first_text);
+
+  g_object_unref (filter);
+  g_object_unref (manager);
+
+  g_assert_cmpint (g_unlink (filename), ==, 0);
+  g_assert_cmpint (g_rmdir (dirname), ==, 0);
+
+  g_free (filename);
+  g_free (dirname);
+}
+
 int
 main (int    argc,
       char **argv)
@@ -306,6 +521,8 @@ main (int    argc,
   g_test_add_func ("/recent-manager/lookup-item", recent_manager_lookup_item);
   g_test_add_func ("/recent-manager/remove-item", recent_manager_remove_item);
   g_test_add_func ("/recent-manager/purge", recent_manager_purge);
+  g_test_add_func ("/recent-manager/save-reload", recent_manager_save_reload);
+  g_test_add_func ("/recent-manager/query-items", recent_manager_query_items);
 
   return g_test_run ();
 }
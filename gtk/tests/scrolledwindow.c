@@ -0,0 +1,276 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2013 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+static GtkWidget *
+create_scrolled_window (GtkWidget **window)
+{
+  GtkWidget *scrolled_window, *viewport, *area;
+
+  *window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (*window), 200, 200);
+
+  area = gtk_drawing_area_new ();
+  gtk_widget_set_size_request (area, 100, 10000);
+  viewport = gtk_viewport_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (viewport), area);
+  scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (scrolled_window), viewport);
+  gtk_container_add (GTK_CONTAINER (*window), scrolled_window);
+
+  gtk_widget_show_all (*window);
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  return scrolled_window;
+}
+
+static void
+send_scroll_events (GtkWidget *widget,
+                    gint       n_events)
+{
+  gint i;
+
+  for (i = 0; i < n_events; i++)
+    {
+      GdkEvent *event;
+
+      event = gdk_event_new (GDK_SCROLL);
+      event->scroll.window = g_object_ref (gtk_widget_get_window (widget));
+      event->scroll.direction = GDK_SCROLL_DOWN;
+      event->scroll.time = GDK_CURRENT_TIME;
+      gtk_widget_event (widget, event);
+      gdk_event_free (event);
+    }
+}
+
+static void
+count_value_changed (GtkAdjustment *adjustment,
+                     gint          *count)
+{
+  (*count)++;
+}
+
+static gboolean
+quit_loop (gpointer data)
+{
+  g_main_loop_quit (data);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Runs a few frames worth of main loop */
+static void
+run_frames (void)
+{
+  GMainLoop *loop;
+
+  loop = g_main_loop_new (NULL, FALSE);
+  g_timeout_add (100, quit_loop, loop);
+  g_main_loop_run (loop);
+  g_main_loop_unref (loop);
+}
+
+/* Wheel scrolling within one frame is applied as one value change */
+static void
+test_scroll_coalesce (void)
+{
+  GtkWidget *window, *scrolled_window;
+  GtkAdjustment *vadjustment;
+  gdouble delta, expected;
+  gint count = 0;
+  gint i;
+
+  scrolled_window = create_scrolled_window (&window);
+  vadjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (scrolled_window));
+  g_signal_connect (vadjustment, "value-changed",
+                    G_CALLBACK (count_value_changed), &count);
+  g_assert_cmpfloat (gtk_adjustment_get_value (vadjustment), ==, 0.0);
+
+  /* one step, to learn the size of a step */
+  send_scroll_events (scrolled_window, 1);
+  g_assert_cmpint (count, ==, 0);
+  run_frames ();
+  g_assert_cmpint (count, ==, 1);
+  delta = gtk_adjustment_get_value (vadjustment);
+  g_assert_cmpfloat (delta, >, 0.0);
+
+  /* several steps before the next frame */
+  count = 0;
+  send_scroll_events (scrolled_window, 3);
+  g_assert_cmpint (count, ==, 0);
+  run_frames ();
+  g_assert_cmpint (count, ==, 1);
+
+  expected = delta;
+  for (i = 0; i < 3; i++)
+    expected += delta;
+  g_assert_cmpfloat (gtk_adjustment_get_value (vadjustment), ==, expected);
+
+  gtk_widget_destroy (window);
+}
+
+/* Configuring the adjustment keeps queued wheel scrolling */
+static void
+test_scroll_configure (void)
+{
+  GtkWidget *window, *scrolled_window;
+  GtkAdjustment *vadjustment;
+  gint count = 0;
+
+  scrolled_window = create_scrolled_window (&window);
+  vadjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (scrolled_window));
+  g_signal_connect (vadjustment, "value-changed",
+                    G_CALLBACK (count_value_changed), &count);
+
+  send_scroll_events (scrolled_window, 3);
+  gtk_adjustment_configure (vadjustment,
+                            0.0,
+                            gtk_adjustment_get_lower (vadjustment),
+                            gtk_adjustment_get_upper (vadjustment),
+                            gtk_adjustment_get_step_increment (vadjustment),
+                            gtk_adjustment_get_page_increment (vadjustment),
+                            gtk_adjustment_get_page_size (vadjustment));
+  run_frames ();
+  g_assert_cmpint (count, ==, 1);
+  g_assert_cmpfloat (gtk_adjustment_get_value (vadjustment), >, 0.0);
+
+  /* an explicit value still drops it */
+  send_scroll_events (scrolled_window, 3);
+  gtk_adjustment_set_value (vadjustment, 0.0);
+  count = 0;
+  run_frames ();
+  g_assert_cmpint (count, ==, 0);
+  g_assert_cmpfloat (gtk_adjustment_get_value (vadjustment), ==, 0.0);
+
+  gtk_widget_destroy (window);
+}
+
+/* Shrinking the adjustment during queued wheel scrolling clamps the
+ * scrolling to the new bounds instead of dropping it
+ */
+static void
+test_scroll_upper (void)
+{
+  GtkWidget *window, *scrolled_window;
+  GtkAdjustment *vadjustment;
+  gint count = 0;
+
+  scrolled_window = create_scrolled_window (&window);
+  vadjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (scrolled_window));
+  g_signal_connect (vadjustment, "value-changed",
+                    G_CALLBACK (count_value_changed), &count);
+
+  send_scroll_events (scrolled_window, 3);
+  gtk_adjustment_set_upper (vadjustment,
+                            gtk_adjustment_get_page_size (vadjustment) + 1.0);
+  g_assert_cmpint (count, ==, 0);
+  run_frames ();
+  g_assert_cmpint (count, ==, 1);
+  g_assert_cmpfloat (gtk_adjustment_get_value (vadjustment), ==, 1.0);
+
+  gtk_widget_destroy (window);
+}
+
+static GtkWidget *
+create_label_window (GtkWidget **window,
+                     GtkWidget **box,
+                     GtkWidget **label)
+{
+  GtkWidget *scrolled_window, *viewport;
+
+  *window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  *box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  *label = gtk_label_new ("short");
+  viewport = gtk_viewport_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (viewport), *label);
+  scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (scrolled_window), viewport);
+  gtk_container_add (GTK_CONTAINER (*box), scrolled_window);
+  gtk_container_add (GTK_CONTAINER (*window), *box);
+
+  gtk_widget_show_all (*window);
+  gtk_test_widget_wait_for_draw (*window);
+
+  return scrolled_window;
+}
+
+/* A resize queued inside a scrolled window stops there, but the
+ * child is still measured and allocated again
+ */
+static void
+test_layout_boundary (void)
+{
+  GtkWidget *window, *box, *label, *scrolled_window;
+  GtkAllocation allocation, label_allocation, new_allocation;
+  gint width, box_width;
+
+  scrolled_window = create_label_window (&window, &box, &label);
+
+  gtk_widget_get_allocation (scrolled_window, &allocation);
+  gtk_widget_get_allocation (label, &label_allocation);
+  gtk_widget_get_preferred_width (box, NULL, &box_width);
+
+  gtk_label_set_text (GTK_LABEL (label), "a text that is a lot longer than the first one");
+  gtk_test_widget_wait_for_draw (window);
+
+  gtk_widget_get_allocation (label, &new_allocation);
+  g_assert_cmpint (new_allocation.width, >, label_allocation.width);
+
+  gtk_widget_get_allocation (scrolled_window, &new_allocation);
+  g_assert_cmpint (new_allocation.width, ==, allocation.width);
+  g_assert_cmpint (new_allocation.height, ==, allocation.height);
+
+  gtk_widget_get_preferred_width (box, NULL, &width);
+  g_assert_cmpint (width, ==, box_width);
+
+  /* without horizontal scrolling the size of the scrolled window
+   * follows the label, so resizes go up to the toplevel again
+   */
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window),
+                                  GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+  gtk_test_widget_wait_for_draw (window);
+  gtk_widget_get_preferred_width (box, NULL, &box_width);
+
+  gtk_label_set_text (GTK_LABEL (label), "a text that is a lot longer than the first one, and then some more");
+  gtk_test_widget_wait_for_draw (window);
+
+  gtk_widget_get_preferred_width (box, NULL, &width);
+  g_assert_cmpint (width, >, box_width);
+
+  gtk_widget_get_allocation (scrolled_window, &new_allocation);
+  g_assert_cmpint (new_allocation.width, >, allocation.width);
+
+  gtk_widget_destroy (window);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/scrolledwindow/scroll-coalesce", test_scroll_coalesce);
+  g_test_add_func ("/scrolledwindow/scroll-configure", test_scroll_configure);
+  g_test_add_func ("/scrolledwindow/scroll-upper", test_scroll_upper);
+  g_test_add_func ("/scrolledwindow/layout-boundary", test_layout_boundary);
+
+  return g_test_run();
+}
@@ -1,4 +1,6 @@
 #include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include <string.h>
 
 static void
 test_parse_selectors (void)
@@ -313,6 +315,99 @@ test_style_property (void)
   g_object_unref (context);
 }
 
+static void
+test_widget_path_cache (void)
+{
+  GtkWidget *window, *box, *other, *button;
+  GtkWidgetPath *path, *box_path;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  other = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+  button = gtk_button_new ();
+  gtk_container_add (GTK_CONTAINER (window), box);
+  gtk_container_add (GTK_CONTAINER (box), other);
+  gtk_container_add (GTK_CONTAINER (box), button);
+
+  /* unchanged widgets keep their path */
+  path = gtk_widget_get_path (button);
+  box_path = gtk_widget_get_path (box);
+  g_assert (gtk_widget_get_path (button) == path);
+  g_assert (gtk_widget_get_path (box) == box_path);
+  g_assert_cmpint (gtk_widget_path_length (path), ==, 3);
+
+  /* a class on the parent shows up in the child's path */
+  gtk_style_context_add_class (gtk_widget_get_style_context (box), "foo");
+  path = gtk_widget_get_path (button);
+  g_assert (gtk_widget_path_iter_has_class (path, 1, "foo"));
+  g_assert (!gtk_widget_path_iter_has_class (path, 2, "foo"));
+
+  /* state changes don't touch the path */
+  gtk_widget_set_state_flags (button, GTK_STATE_FLAG_PRELIGHT, FALSE);
+  g_assert (gtk_widget_get_path (button) == path);
+
+  gtk_widget_set_name (button, "bar");
+  path = gtk_widget_get_path (button);
+  g_assert (gtk_widget_path_iter_has_name (path, 2, "bar"));
+
+  /* saved classes don't outlive gtk_style_context_restore() */
+  gtk_style_context_save (gtk_widget_get_style_context (box));
+  gtk_style_context_add_class (gtk_widget_get_style_context (box), "baz");
+  gtk_widget_get_path (button);
+  gtk_style_context_restore (gtk_widget_get_style_context (box));
+  path = gtk_widget_get_path (button);
+  g_assert (!gtk_widget_path_iter_has_class (path, 1, "baz"));
+
+  g_object_ref (button);
+  gtk_container_remove (GTK_CONTAINER (box), button);
+  gtk_container_add (GTK_CONTAINER (other), button);
+  g_object_unref (button);
+  path = gtk_widget_get_path (button);
+  g_assert_cmpint (gtk_widget_path_length (path), ==, 4);
+  g_assert (gtk_widget_path_iter_get_object_type (path, 2) == GTK_TYPE_BOX);
+  g_assert (gtk_widget_path_iter_has_class (path, 1, "foo"));
+
+  gtk_widget_destroy (window);
+}
+
+/* Asking for the path of a child rebuilds the path of its parent
+ * while the parent's style context is saved
+ */
+static void
+test_widget_path_saved (void)
+{
+  GtkWidget *window, *box, *button;
+  GtkStyleContext *context;
+  GtkWidgetPath *path;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  button = gtk_button_new ();
+  gtk_container_add (GTK_CONTAINER (window), box);
+  gtk_container_add (GTK_CONTAINER (box), button);
+  context = gtk_widget_get_style_context (box);
+
+  gtk_widget_get_path (button);
+
+  gtk_style_context_save (context);
+  gtk_style_context_add_class (context, "saved");
+  g_assert (gtk_widget_path_iter_has_class (gtk_widget_get_path (box), 1, "saved"));
+
+  path = gtk_widget_get_path (button);
+  g_assert (gtk_widget_path_iter_has_class (path, 1, "saved"));
+  path = gtk_widget_get_path (button);
+  g_assert (gtk_widget_path_iter_has_class (path, 1, "saved"));
+  g_assert (gtk_widget_path_iter_has_class (gtk_widget_get_path (box), 1, "saved"));
+
+  gtk_style_context_restore (context);
+
+  path = gtk_widget_get_path (button);
+  g_assert (!gtk_widget_path_iter_has_class (path, 1, "saved"));
+  g_assert (gtk_widget_get_path (button) == path);
+
+  gtk_widget_destroy (window);
+}
+
 void
 test_basic_properties (void)
 {
@@ -343,6 +438,413 @@ test_basic_properties (void)
   g_object_unref (context);
 }
 
+static void
+async_load_done (GObject      *source,
+                 GAsyncResult *result,
+                 gpointer      data)
+{
+  GMainLoop *loop = data;
+  GError *error = NULL;
+  gboolean res;
+
+  res = gtk_css_provider_load_from_file_finish (GTK_CSS_PROVIDER (source), result, &error);
+  g_assert_no_error (error);
+  g_assert (res);
+
+  g_main_loop_quit (loop);
+}
+
+static void
+test_load_async (void)
+{
+  const gchar *css =
+    "@define-color fg_color #0000ff;\n"
+    "GtkButton { color: @fg_color; }\n"
+    ".label { padding: 2px; }\n";
+  GtkCssProvider *provider, *expected;
+  GMainLoop *loop;
+  GFileIOStream *stream;
+  GFile *file;
+  gchar *str, *expected_str;
+
+  file = g_file_new_tmp ("gtk-test-XXXXXX.css", &stream, NULL);
+  g_assert (file != NULL);
+  g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (stream)),
+                             css, strlen (css), NULL, NULL, NULL);
+  g_io_stream_close (G_IO_STREAM (stream), NULL, NULL);
+  g_object_unref (stream);
+
+  expected = gtk_css_provider_new ();
+  gtk_css_provider_load_from_file (expected, file, NULL);
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider, "* { margin: 1px; }", -1, NULL);
+
+  loop = g_main_loop_new (NULL, FALSE);
+  gtk_css_provider_load_from_file_async (provider, file, NULL, async_load_done, loop);
+  g_main_loop_run (loop);
+
+  str = gtk_css_provider_to_string (provider);
+  expected_str = gtk_css_provider_to_string (expected);
+  g_assert_cmpstr (str, ==, expected_str);
+
+  g_free (str);
+  g_free (expected_str);
+  g_main_loop_unref (loop);
+  g_object_unref (provider);
+  g_object_unref (expected);
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+static void
+async_load_cancelled (GObject      *source,
+                      GAsyncResult *result,
+                      gpointer      data)
+{
+  GMainLoop *loop = data;
+  GError *error = NULL;
+  gboolean res;
+
+  res = gtk_css_provider_load_from_file_finish (GTK_CSS_PROVIDER (source), result, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert (!res);
+  g_error_free (error);
+
+  g_main_loop_quit (loop);
+}
+
+static void
+cancel_on_error (GtkCssProvider *provider,
+                 GtkCssSection  *section,
+                 const GError   *error,
+                 GCancellable   *cancellable)
+{
+  g_cancellable_cancel (cancellable);
+
+  /* Use up the time slice, so the load can't finish before it
+   * notices the cancellation
+   */
+  g_usleep (20000);
+}
+
+/* Cancelling a load in the middle of parsing keeps the old contents */
+static void
+test_load_async_cancel (void)
+{
+  GtkCssProvider *provider;
+  GCancellable *cancellable;
+  GMainLoop *loop;
+  GFileIOStream *stream;
+  GFile *file;
+  GString *css;
+  gchar *str, *expected_str;
+  gint i;
+
+  css = g_string_new ("GtkButton { color: red; }\n"
+                      "GtkButton { margin: invalid; }\n");
+  for (i = 0; i < 100; i++)
+    g_string_append_printf (css, ".class%d { padding: %dpx; }\n", i, i);
+
+  file = g_file_new_tmp ("gtk-test-XXXXXX.css", &stream, NULL);
+  g_assert (file != NULL);
+  g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (stream)),
+                             css->str, css->len, NULL, NULL, NULL);
+  g_io_stream_close (G_IO_STREAM (stream), NULL, NULL);
+  g_object_unref (stream);
+  g_string_free (css, TRUE);
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider, "* { margin: 1px; }", -1, NULL);
+  expected_str = gtk_css_provider_to_string (provider);
+
+  cancellable = g_cancellable_new ();
+  g_signal_connect (provider, "parsing-error",
+                    G_CALLBACK (cancel_on_error), cancellable);
+
+  loop = g_main_loop_new (NULL, FALSE);
+  gtk_css_provider_load_from_file_async (provider, file, cancellable,
+                                         async_load_cancelled, loop);
+  g_main_loop_run (loop);
+
+  g_assert (g_cancellable_is_cancelled (cancellable));
+  str = gtk_css_provider_to_string (provider);
+  g_assert_cmpstr (str, ==, expected_str);
+
+  g_free (str);
+  g_free (expected_str);
+  g_main_loop_unref (loop);
+  g_object_unref (cancellable);
+  g_object_unref (provider);
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+typedef struct {
+  gboolean done;
+  gboolean result;
+  GError *error;
+} AsyncLoadResult;
+
+static void
+async_load_finished (GObject      *source,
+                     GAsyncResult *result,
+                     gpointer      data)
+{
+  AsyncLoadResult *res = data;
+
+  res->result = gtk_css_provider_load_from_file_finish (GTK_CSS_PROVIDER (source),
+                                                        result, &res->error);
+  res->done = TRUE;
+}
+
+static GFile *
+create_css_file (const gchar *css)
+{
+  GFileIOStream *stream;
+  GFile *file;
+
+  file = g_file_new_tmp ("gtk-test-XXXXXX.css", &stream, NULL);
+  g_assert (file != NULL);
+  g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (stream)),
+                             css, strlen (css), NULL, NULL, NULL);
+  g_io_stream_close (G_IO_STREAM (stream), NULL, NULL);
+  g_object_unref (stream);
+
+  return file;
+}
+
+/* A newer load, async or not, wins over an older async one */
+static void
+test_load_async_overlap (void)
+{
+  GtkCssProvider *provider, *expected;
+  AsyncLoadResult first = { 0, }, second = { 0, };
+  GFile *first_file, *second_file;
+  gchar *str, *expected_str;
+
+  first_file = create_css_file ("GtkButton { color: red; }\n");
+  second_file = create_css_file ("GtkButton { color: blue; }\n");
+
+  expected = gtk_css_provider_new ();
+  gtk_css_provider_load_from_file (expected, second_file, NULL);
+  expected_str = gtk_css_provider_to_string (expected);
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_file_async (provider, first_file, NULL,
+                                         async_load_finished, &first);
+  gtk_css_provider_load_from_file_async (provider, second_file, NULL,
+                                         async_load_finished, &second);
+  while (!first.done || !second.done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_error (first.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert (!first.result);
+  g_assert_no_error (second.error);
+  g_assert (second.result);
+
+  str = gtk_css_provider_to_string (provider);
+  g_assert_cmpstr (str, ==, expected_str);
+  g_free (str);
+  g_free (expected_str);
+  g_clear_error (&first.error);
+
+  /* a synchronous load supersedes a pending one too */
+  gtk_css_provider_load_from_data (expected, "GtkButton { color: green; }", -1, NULL);
+  expected_str = gtk_css_provider_to_string (expected);
+
+  first.done = FALSE;
+  gtk_css_provider_load_from_file_async (provider, first_file, NULL,
+                                         async_load_finished, &first);
+  gtk_css_provider_load_from_data (provider, "GtkButton { color: green; }", -1, NULL);
+  while (!first.done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_error (first.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert (!first.result);
+
+  str = gtk_css_provider_to_string (provider);
+  g_assert_cmpstr (str, ==, expected_str);
+  g_free (str);
+  g_free (expected_str);
+  g_clear_error (&first.error);
+
+  g_object_unref (provider);
+  g_object_unref (expected);
+  g_file_delete (first_file, NULL, NULL);
+  g_object_unref (first_file);
+  g_file_delete (second_file, NULL, NULL);
+  g_object_unref (second_file);
+}
+
+static gint
+get_background_image_width (GtkCssProvider *provider)
+{
+  GtkStyleContext *context;
+  GtkWidgetPath *path;
+  cairo_pattern_t *pattern;
+  cairo_surface_t *surface;
+  gint width;
+
+  context = gtk_style_context_new ();
+  path = gtk_widget_path_new ();
+  gtk_widget_path_append_type (path, GTK_TYPE_BOX);
+  gtk_style_context_set_path (context, path);
+  gtk_widget_path_free (path);
+  gtk_style_context_add_provider (context, GTK_STYLE_PROVIDER (provider),
+                                  GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  gtk_style_context_get (context, 0, "background-image", &pattern, NULL);
+  g_assert (pattern != NULL);
+  g_assert (cairo_pattern_get_surface (pattern, &surface) == CAIRO_STATUS_SUCCESS);
+  width = cairo_image_surface_get_width (surface);
+
+  cairo_pattern_destroy (pattern);
+  g_object_unref (context);
+
+  return width;
+}
+
+/* Printing a provider with url() images and parsing the result, like
+ * the theme cache does, gives the same images again
+ */
+static void
+test_print_image_url (void)
+{
+  GtkCssProvider *provider, *copy;
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+  gchar *dir, *image_file, *css_file;
+  gchar *str, *copy_str;
+
+  dir = g_dir_make_tmp ("gtkcssXXXXXX", &error);
+  g_assert_no_error (error);
+
+  image_file = g_build_filename (dir, "image.png", NULL);
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 4, 4);
+  gdk_pixbuf_fill (pixbuf, 0xff0000ff);
+  gdk_pixbuf_save (pixbuf, image_file, "png", &error, NULL);
+  g_assert_no_error (error);
+  g_object_unref (pixbuf);
+
+  css_file = g_build_filename (dir, "test.css", NULL);
+  g_file_set_contents (css_file, "GtkBox { background-image: url(\"image.png\"); }", -1, &error);
+  g_assert_no_error (error);
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_path (provider, css_file, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (get_background_image_width (provider), ==, 4);
+
+  str = gtk_css_provider_to_string (provider);
+  g_assert (strstr (str, "data:") == NULL);
+
+  copy = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (copy, str, -1, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (get_background_image_width (copy), ==, 4);
+
+  copy_str = gtk_css_provider_to_string (copy);
+  g_assert_cmpstr (str, ==, copy_str);
+
+  g_free (copy_str);
+  g_free (str);
+  g_object_unref (copy);
+  g_object_unref (provider);
+  g_unlink (css_file);
+  g_unlink (image_file);
+  g_rmdir (dir);
+  g_free (css_file);
+  g_free (image_file);
+  g_free (dir);
+}
+
+static void
+count_allocations (GtkWidget     *widget,
+                   GtkAllocation *allocation,
+                   gint          *count)
+{
+  (*count)++;
+}
+
+static void
+assert_color (GtkStyleContext *context,
+              GtkStateFlags    state,
+              const gchar     *expected)
+{
+  GdkRGBA color, expected_color;
+
+  gtk_style_context_get_color (context, state, &color);
+  gdk_rgba_parse (&expected_color, expected);
+  g_assert (gdk_rgba_equal (&color, &expected_color));
+}
+
+/* A child shares the font group of its parent. Restyling the child
+ * for a change of its parent copies the group instead of writing
+ * into the parent's cached values, and only the changed property is
+ * reported, so nothing is resized.
+ */
+static void
+test_shared_values (void)
+{
+  GtkCssProvider *provider;
+  GtkWidget *window, *box, *area;
+  GtkStyleContext *box_context, *area_context;
+  GtkStateFlags normal;
+  gint n_allocations = 0;
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider,
+                                   "GtkBox { color: red; }\n"
+                                   "GtkBox:hover { color: blue; }\n"
+                                   "GtkDrawingArea { color: inherit; }\n",
+                                   -1, NULL);
+  gtk_style_context_add_provider_for_screen (gdk_screen_get_default (),
+                                             GTK_STYLE_PROVIDER (provider),
+                                             GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  area = gtk_drawing_area_new ();
+  gtk_widget_set_size_request (area, 20, 20);
+  gtk_container_add (GTK_CONTAINER (box), area);
+  gtk_container_add (GTK_CONTAINER (window), box);
+  gtk_widget_show_all (window);
+  gtk_test_widget_wait_for_draw (window);
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  box_context = gtk_widget_get_style_context (box);
+  area_context = gtk_widget_get_style_context (area);
+  normal = gtk_style_context_get_state (box_context);
+  assert_color (area_context, gtk_style_context_get_state (area_context), "red");
+
+  g_signal_connect (box, "size-allocate",
+                    G_CALLBACK (count_allocations), &n_allocations);
+
+  /* the hover state doesn't propagate, so the area is only
+   * restyled for the change of its parent
+   */
+  gtk_widget_set_state_flags (box, GTK_STATE_FLAG_PRELIGHT, FALSE);
+  gtk_test_widget_wait_for_draw (window);
+
+  assert_color (area_context, gtk_style_context_get_state (area_context), "blue");
+  assert_color (box_context, normal, "red");
+  g_assert_cmpint (n_allocations, ==, 0);
+
+  gtk_widget_unset_state_flags (box, GTK_STATE_FLAG_PRELIGHT);
+  gtk_test_widget_wait_for_draw (window);
+
+  assert_color (area_context, gtk_style_context_get_state (area_context), "red");
+  assert_color (box_context, normal | GTK_STATE_FLAG_PRELIGHT, "blue");
+  g_assert_cmpint (n_allocations, ==, 0);
+
+  gtk_widget_destroy (window);
+  gtk_style_context_remove_provider_for_screen (gdk_screen_get_default (),
+                                                GTK_STYLE_PROVIDER (provider));
+  g_object_unref (provider);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -354,6 +856,13 @@ main (int argc, char *argv[])
   g_test_add_func ("/style/match", test_match);
   g_test_add_func ("/style/style-property", test_style_property);
   g_test_add_func ("/style/basic", test_basic_properties);
+  g_test_add_func ("/style/widget-path-cache", test_widget_path_cache);
+  g_test_add_func ("/style/widget-path-saved", test_widget_path_saved);
+  g_test_add_func ("/style/load-async", test_load_async);
+  g_test_add_func ("/style/load-async-cancel", test_load_async_cancel);
+  g_test_add_func ("/style/load-async-overlap", test_load_async_overlap);
+  g_test_add_func ("/style/print-image-url", test_print_image_url);
+  g_test_add_func ("/style/shared-values", test_shared_values);
 
   return g_test_run ();
 }
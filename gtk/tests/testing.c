@@ -287,6 +287,64 @@ test_statusbar_remove_all (void)
   g_object_unref (statusbar);
 }
 
+static gboolean
+count_draws (GtkWidget *widget,
+             cairo_t   *cr,
+             gint      *draws)
+{
+  (*draws)++;
+  return FALSE;
+}
+
+static void
+test_draw_cache (void)
+{
+  GtkWidget *window, *box, *label;
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  gint draws = 0, before;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  label = gtk_label_new ("Cached");
+  gtk_container_add (GTK_CONTAINER (box), label);
+  gtk_container_add (GTK_CONTAINER (window), box);
+  g_signal_connect (label, "draw", G_CALLBACK (count_draws), &draws);
+
+  g_assert (!gtk_widget_get_cache_drawing (box));
+  gtk_widget_set_cache_drawing (box, TRUE);
+  g_assert (gtk_widget_get_cache_drawing (box));
+
+  gtk_widget_show_all (window);
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 100, 100);
+  cr = cairo_create (surface);
+
+  /* the second draw replays the recording */
+  before = draws;
+  gtk_widget_draw (box, cr);
+  gtk_widget_draw (box, cr);
+  g_assert_cmpint (draws - before, <=, 1);
+
+  /* a redraw queued on a child drops the parent's recording */
+  before = draws;
+  gtk_widget_queue_draw (label);
+  gtk_widget_draw (box, cr);
+  g_assert_cmpint (draws - before, ==, 1);
+
+  gtk_widget_set_cache_drawing (box, FALSE);
+  before = draws;
+  gtk_widget_draw (box, cr);
+  gtk_widget_draw (box, cr);
+  g_assert_cmpint (draws - before, ==, 2);
+
+  cairo_destroy (cr);
+  cairo_surface_destroy (surface);
+  gtk_widget_destroy (window);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -303,6 +361,7 @@ main (int   argc,
   g_test_add_func ("/ui-tests/slider-ranges", test_slider_ranges);
   g_test_add_func ("/ui-tests/xserver-sync", test_xserver_sync);
   g_test_add_func ("/ui-tests/spin-button-arrows", test_spin_button_arrows);
+  g_test_add_func ("/ui-tests/draw-cache", test_draw_cache);
 
   return g_test_run();
 }
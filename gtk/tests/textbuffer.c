@@ -1321,6 +1321,374 @@ test_tag (void)
   g_object_unref (buffer);
 }
 
+/* An input stream which returns at most 3 bytes per read */
+typedef GFilterInputStream ShortReadStream;
+typedef GFilterInputStreamClass ShortReadStreamClass;
+
+static GType short_read_stream_get_type (void);
+
+G_DEFINE_TYPE (ShortReadStream, short_read_stream, G_TYPE_FILTER_INPUT_STREAM)
+
+static gssize
+short_read_stream_read (GInputStream  *stream,
+                        void          *buffer,
+                        gsize          count,
+                        GCancellable  *cancellable,
+                        GError       **error)
+{
+  GInputStream *base = g_filter_input_stream_get_base_stream (G_FILTER_INPUT_STREAM (stream));
+
+  return g_input_stream_read (base, buffer, MIN (count, 3), cancellable, error);
+}
+
+static void
+short_read_stream_class_init (ShortReadStreamClass *klass)
+{
+  G_INPUT_STREAM_CLASS (klass)->read_fn = short_read_stream_read;
+}
+
+static void
+short_read_stream_init (ShortReadStream *stream)
+{
+}
+
+static void
+check_insert_from_stream (const gchar *data,
+                          gsize        len,
+                          gboolean     short_reads,
+                          const gchar *expected,
+                          gint         n_lines)
+{
+  GtkTextBuffer *buffer;
+  GInputStream *stream;
+  GtkTextIter start, end;
+  GError *error = NULL;
+  gchar *text;
+
+  buffer = gtk_text_buffer_new (NULL);
+  stream = g_memory_input_stream_new_from_data (data, len, NULL);
+  if (short_reads)
+    {
+      GInputStream *base = stream;
+
+      stream = g_object_new (short_read_stream_get_type (),
+                             "base-stream", base,
+                             NULL);
+      g_object_unref (base);
+    }
+
+  gtk_text_buffer_get_end_iter (buffer, &end);
+  g_assert (gtk_text_buffer_insert_from_stream (buffer, &end, stream, NULL, &error));
+  g_assert_no_error (error);
+  g_assert (gtk_text_iter_is_end (&end));
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+  g_assert_cmpstr (text, ==, expected);
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, n_lines);
+  g_free (text);
+
+  g_object_unref (stream);
+  g_object_unref (buffer);
+}
+
+static void
+test_insert_from_stream (void)
+{
+  GtkTextBuffer *buffer;
+  GInputStream *stream;
+  GtkTextIter iter;
+  GError *error = NULL;
+  GString *big;
+  gint i;
+
+  check_insert_from_stream ("", 0, FALSE, "", 1);
+  check_insert_from_stream ("Hello\r\nWorld\n", 13, FALSE, "Hello\r\nWorld\n", 3);
+  check_insert_from_stream ("\303\244\342\200\251x", 6, FALSE, "\303\244\342\200\251x", 2);
+
+  /* large enough to span several full reads */
+  big = g_string_new (NULL);
+  for (i = 0; i < 20000; i++)
+    g_string_append (big, "\303\244\r\n");
+  check_insert_from_stream (big->str, big->len, FALSE, big->str, 20001);
+
+  /* With 3 byte reads of 4 byte records, the reads end at every
+   * offset within a record, so \r\n pairs and multibyte characters
+   * get split between reads.
+   */
+  g_string_truncate (big, 4 * 1000);
+  check_insert_from_stream (big->str, big->len, TRUE, big->str, 1001);
+  g_string_free (big, TRUE);
+
+  buffer = gtk_text_buffer_new (NULL);
+  stream = g_memory_input_stream_new_from_data ("abc\377def", 7, NULL);
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  g_assert (!gtk_text_buffer_insert_from_stream (buffer, &iter, stream, NULL, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+  g_assert_cmpint (gtk_text_buffer_get_char_count (buffer), ==, 3);
+  g_clear_error (&error);
+  g_object_unref (stream);
+
+  /* a character cut off by the end of the stream */
+  stream = g_memory_input_stream_new_from_data ("\342\200", 2, NULL);
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  g_assert (!gtk_text_buffer_insert_from_stream (buffer, &iter, stream, NULL, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+  g_assert_cmpint (gtk_text_buffer_get_char_count (buffer), ==, 3);
+  g_clear_error (&error);
+  g_object_unref (stream);
+
+  g_object_unref (buffer);
+}
+
+static void
+serialize_progress (goffset  current,
+                    goffset  total,
+                    gpointer user_data)
+{
+  goffset *progress = user_data;
+
+  g_assert_cmpint (current, >, progress[0]);
+
+  progress[0] = current;
+  progress[1] = total;
+}
+
+static void
+test_serialize_stream (void)
+{
+  GtkTextBuffer *buffer, *copy;
+  GdkAtom format, copy_format;
+  GOutputStream *out;
+  GInputStream *in;
+  GtkTextIter start, end, iter, iter2;
+  GError *error = NULL;
+  guint8 *data, *copy_data;
+  gsize length, copy_length;
+  goffset progress[2] = { 0, 0 };
+  guint32 contents_length;
+  gint i;
+
+  buffer = gtk_text_buffer_new (NULL);
+  fill_buffer (buffer);
+
+  /* enough tagged text to span several chunks */
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  for (i = 0; i < 5000; i++)
+    {
+      gint offset = gtk_text_iter_get_offset (&iter);
+
+      gtk_text_buffer_insert (buffer, &iter, "woo woo woo woo woo woo\n", -1);
+
+      if (i % 2)
+        {
+          gtk_text_buffer_get_iter_at_offset (buffer, &iter2, offset);
+          gtk_text_buffer_apply_tag_by_name (buffer, "fg_red", &iter2, &iter);
+        }
+    }
+
+  format = gtk_text_buffer_register_serialize_tagset (buffer, NULL);
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  data = gtk_text_buffer_serialize (buffer, buffer, format, &start, &end, &length);
+
+  /* streaming writes exactly what gtk_text_buffer_serialize() returns */
+  out = g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
+  g_assert (gtk_text_buffer_serialize_to_stream (buffer, buffer, format,
+                                                 &start, &end, out, NULL,
+                                                 serialize_progress, progress,
+                                                 &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (out)), ==, length);
+  g_assert (memcmp (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (out)), data, length) == 0);
+  g_assert_cmpint (progress[0], ==, length);
+  g_assert_cmpint (progress[1], ==, length);
+  g_object_unref (out);
+
+  /* reading it back gives the same buffer as gtk_text_buffer_deserialize() */
+  copy = gtk_text_buffer_new (gtk_text_buffer_get_tag_table (buffer));
+  copy_format = gtk_text_buffer_register_deserialize_tagset (copy, NULL);
+  gtk_text_buffer_get_start_iter (copy, &iter);
+  g_assert (gtk_text_buffer_deserialize (copy, copy, copy_format,
+                                         &iter, data, length, &error));
+  g_assert_no_error (error);
+
+  format = gtk_text_buffer_register_serialize_tagset (copy, NULL);
+  gtk_text_buffer_get_bounds (copy, &start, &end);
+  g_free (data);
+  data = gtk_text_buffer_serialize (copy, copy, format, &start, &end, &length);
+
+  gtk_text_buffer_set_text (copy, "", -1);
+  in = g_memory_input_stream_new_from_data (data, length, NULL);
+  gtk_text_buffer_get_start_iter (copy, &iter);
+  g_assert (gtk_text_buffer_deserialize_from_stream (copy, copy, copy_format,
+                                                     &iter, in, NULL,
+                                                     NULL, NULL, &error));
+  g_assert_no_error (error);
+  g_assert (gtk_text_iter_is_end (&iter));
+  g_object_unref (in);
+
+  gtk_text_buffer_get_bounds (copy, &start, &end);
+  copy_data = gtk_text_buffer_serialize (copy, copy, format, &start, &end, &copy_length);
+  g_assert_cmpuint (copy_length, ==, length);
+  g_assert (memcmp (copy_data, data, length) == 0);
+  g_free (copy_data);
+
+  /* a stream that ends in the middle of the text */
+  gtk_text_buffer_set_text (copy, "", -1);
+  in = g_memory_input_stream_new_from_data (data, length / 2, NULL);
+  gtk_text_buffer_get_start_iter (copy, &iter);
+  g_assert (!gtk_text_buffer_deserialize_from_stream (copy, copy, copy_format,
+                                                      &iter, in, NULL,
+                                                      NULL, NULL, &error));
+  g_assert_error (error, G_MARKUP_ERROR, G_MARKUP_ERROR_PARSE);
+  g_clear_error (&error);
+  g_object_unref (in);
+
+  /* a stream that ends before the pixbuf sections */
+  gtk_text_buffer_set_text (copy, "", -1);
+  memcpy (&contents_length, data + 26, 4);
+  in = g_memory_input_stream_new_from_data (data, 30 + GUINT32_FROM_BE (contents_length), NULL);
+  gtk_text_buffer_get_start_iter (copy, &iter);
+  g_assert (!gtk_text_buffer_deserialize_from_stream (copy, copy, copy_format,
+                                                      &iter, in, NULL,
+                                                      NULL, NULL, &error));
+  g_assert_error (error, G_MARKUP_ERROR, G_MARKUP_ERROR_PARSE);
+  g_clear_error (&error);
+  g_object_unref (in);
+
+  g_free (data);
+  g_object_unref (copy);
+  g_object_unref (buffer);
+}
+
+static void
+test_deserialize_malformed (void)
+{
+  static const gchar markup[] =
+    "<text_view_markup>\n"
+    " <tags>\n"
+    " </tags>\n"
+    "<text>hello</text>\n";
+  GtkTextBuffer *buffer;
+  GdkAtom format;
+  GtkTextIter iter;
+  GError *error = NULL;
+  GString *data;
+  guint32 length;
+
+  data = g_string_new ("GTKTEXTBUFFERCONTENTS-0001");
+  length = GUINT32_TO_BE (strlen (markup));
+  g_string_append_len (data, (gchar *) &length, 4);
+  g_string_append (data, markup);
+
+  /* nothing is inserted if the markup is not complete */
+  buffer = gtk_text_buffer_new (NULL);
+  format = gtk_text_buffer_register_deserialize_tagset (buffer, NULL);
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  g_assert (!gtk_text_buffer_deserialize (buffer, buffer, format, &iter,
+                                          (guint8 *) data->str, data->len,
+                                          &error));
+  g_assert_error (error, G_MARKUP_ERROR, G_MARKUP_ERROR_PARSE);
+  g_assert_cmpint (gtk_text_buffer_get_char_count (buffer), ==, 0);
+  g_clear_error (&error);
+
+  g_string_free (data, TRUE);
+  g_object_unref (buffer);
+}
+
+static void
+check_same_tags (GtkTextBuffer *buffer,
+                 GtkTextBuffer *other)
+{
+  GtkTextIter iter, other_iter;
+
+  g_assert_cmpint (gtk_text_buffer_get_char_count (buffer), ==,
+                   gtk_text_buffer_get_char_count (other));
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  gtk_text_buffer_get_start_iter (other, &other_iter);
+  while (!gtk_text_iter_is_end (&iter))
+    {
+      GSList *tags, *other_tags;
+
+      tags = gtk_text_iter_get_tags (&iter);
+      other_tags = gtk_text_iter_get_tags (&other_iter);
+      g_assert_cmpint (g_slist_length (tags), ==, g_slist_length (other_tags));
+      for (; tags; tags = g_slist_delete_link (tags, tags))
+        g_assert (g_slist_find (other_tags, tags->data));
+      g_slist_free (other_tags);
+
+      gtk_text_iter_forward_char (&iter);
+      gtk_text_iter_forward_char (&other_iter);
+    }
+}
+
+static void
+test_deserialize_stream_pixbuf_tags (void)
+{
+  GtkTextBuffer *buffer, *copy, *stream_copy;
+  GdkAtom format;
+  GtkTextTag *red, *green;
+  GtkTextIter start, end, iter;
+  GInputStream *in;
+  GError *error = NULL;
+  GdkPixbuf *pixbuf;
+  guint8 *data;
+  gsize length;
+
+  buffer = gtk_text_buffer_new (NULL);
+  red = gtk_text_buffer_create_tag (buffer, "red", "foreground", "red", NULL);
+  green = gtk_text_buffer_create_tag (buffer, "green", "background", "green", NULL);
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 1, 1);
+  gtk_text_buffer_set_text (buffer, "xy", -1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 1);
+  gtk_text_buffer_insert_pixbuf (buffer, &iter, pixbuf);
+  g_object_unref (pixbuf);
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  gtk_text_buffer_apply_tag (buffer, red, &start, &end);
+
+  format = gtk_text_buffer_register_serialize_tagset (buffer, NULL);
+  data = gtk_text_buffer_serialize (buffer, buffer, format, &start, &end, &length);
+
+  /* destinations with a tag of their own around the insertion point */
+  copy = gtk_text_buffer_new (gtk_text_buffer_get_tag_table (buffer));
+  stream_copy = gtk_text_buffer_new (gtk_text_buffer_get_tag_table (buffer));
+  gtk_text_buffer_set_text (copy, "ab", -1);
+  gtk_text_buffer_set_text (stream_copy, "ab", -1);
+  gtk_text_buffer_get_bounds (copy, &start, &end);
+  gtk_text_buffer_apply_tag (copy, green, &start, &end);
+  gtk_text_buffer_get_bounds (stream_copy, &start, &end);
+  gtk_text_buffer_apply_tag (stream_copy, green, &start, &end);
+
+  format = gtk_text_buffer_register_deserialize_tagset (copy, NULL);
+  gtk_text_buffer_get_iter_at_offset (copy, &iter, 1);
+  g_assert (gtk_text_buffer_deserialize (copy, copy, format,
+                                         &iter, data, length, &error));
+  g_assert_no_error (error);
+
+  format = gtk_text_buffer_register_deserialize_tagset (stream_copy, NULL);
+  in = g_memory_input_stream_new_from_data (data, length, NULL);
+  gtk_text_buffer_get_iter_at_offset (stream_copy, &iter, 1);
+  g_assert (gtk_text_buffer_deserialize_from_stream (stream_copy, stream_copy, format,
+                                                     &iter, in, NULL,
+                                                     NULL, NULL, &error));
+  g_assert_no_error (error);
+  g_object_unref (in);
+
+  /* the pixbuf keeps the destination's tag */
+  gtk_text_buffer_get_iter_at_offset (stream_copy, &iter, 2);
+  g_assert (gtk_text_iter_get_pixbuf (&iter) != NULL);
+  g_assert (gtk_text_iter_has_tag (&iter, green));
+
+  check_same_tags (copy, stream_copy);
+
+  g_free (data);
+  g_object_unref (stream_copy);
+  g_object_unref (copy);
+  g_object_unref (buffer);
+}
+
 extern void pixbuf_init (void);
 
 int
@@ -1341,6 +1709,10 @@ main (int argc, char** argv)
   g_test_add_func ("/TextBuffer/Get and Set", test_get_set);
   g_test_add_func ("/TextBuffer/Fill and Empty", test_fill_empty);
   g_test_add_func ("/TextBuffer/Tag", test_tag);
+  g_test_add_func ("/TextBuffer/Insert from stream", test_insert_from_stream);
+  g_test_add_func ("/TextBuffer/Serialize to stream", test_serialize_stream);
+  g_test_add_func ("/TextBuffer/Deserialize malformed", test_deserialize_malformed);
+  g_test_add_func ("/TextBuffer/Deserialize stream pixbuf tags", test_deserialize_stream_pixbuf_tags);
   
   return g_test_run();
 }
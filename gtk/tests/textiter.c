@@ -176,6 +176,11 @@ test_search (void)
   check_found_forward ("This is some foo\nfoo text", "foo\nfoo", 0, 13, 20, "foo\nfoo");
   check_found_backward ("This is some foo\nfoo text", "foo\nfoo", 0, 13, 20, "foo\nfoo");
   check_not_found ("This is some foo\nfoo text", "Foo\nfoo", 0);
+
+  /* a needle ending in a line delimiter */
+  check_found_forward ("This is some foo\nfoo text", "foo\n", 0, 13, 17, "foo\n");
+  check_found_backward ("This is some foo\nfoo text", "foo\n", 0, 13, 17, "foo\n");
+  check_found_forward ("This is some foo\r\nfoo text", "foo\r\n", 0, 13, 18, "foo\r\n");
 }
 
 static void
@@ -257,6 +262,167 @@ test_search_caseless (void)
   check_found_backward ("This is some \303\200\n\303\200 text", "a\u0300\na\u0300", flags, 13, 16, "\303\200\n\303\200");
 }
 
+static void
+test_search_all (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end;
+  GtkTextTag *tag;
+  gint *matches;
+  gint n_matches;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, "foo bar foo\nfoofoo\n\303\240foo", -1);
+
+  matches = gtk_text_buffer_search_all (buffer, "foo", 0, NULL, NULL, &n_matches);
+  g_assert_cmpint (n_matches, ==, 5);
+  g_assert_cmpint (matches[0], ==, 0);
+  g_assert_cmpint (matches[1], ==, 3);
+  g_assert_cmpint (matches[2], ==, 8);
+  g_assert_cmpint (matches[4], ==, 12);
+  g_assert_cmpint (matches[6], ==, 15);
+  g_assert_cmpint (matches[8], ==, 20);
+  g_assert_cmpint (matches[9], ==, 23);
+  g_free (matches);
+
+  /* matches must be within the range */
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, 15);
+  matches = gtk_text_buffer_search_all (buffer, "foo", 0, &start, &end, &n_matches);
+  g_assert_cmpint (n_matches, ==, 2);
+  g_assert_cmpint (matches[0], ==, 8);
+  g_assert_cmpint (matches[2], ==, 12);
+  g_free (matches);
+
+  /* lines split into several segments by tags */
+  tag = gtk_text_buffer_create_tag (buffer, NULL, NULL);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 13);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, 16);
+  gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+  matches = gtk_text_buffer_search_all (buffer, "ofo", 0, NULL, NULL, &n_matches);
+  g_assert_cmpint (n_matches, ==, 1);
+  g_assert_cmpint (matches[0], ==, 14);
+  g_free (matches);
+
+  matches = gtk_text_buffer_search_all (buffer, "Foo", 0, NULL, NULL, &n_matches);
+  g_assert_cmpint (n_matches, ==, 0);
+  g_free (matches);
+
+  matches = gtk_text_buffer_search_all (buffer, "Foo", GTK_TEXT_SEARCH_CASE_INSENSITIVE,
+                                        NULL, NULL, &n_matches);
+  g_assert_cmpint (n_matches, ==, 5);
+  g_free (matches);
+
+  /* needles ending in a line delimiter */
+  matches = gtk_text_buffer_search_all (buffer, "foo\n", 0, NULL, NULL, &n_matches);
+  g_assert_cmpint (n_matches, ==, 2);
+  g_assert_cmpint (matches[0], ==, 8);
+  g_assert_cmpint (matches[1], ==, 12);
+  g_assert_cmpint (matches[2], ==, 15);
+  g_assert_cmpint (matches[3], ==, 19);
+  g_free (matches);
+
+  g_object_unref (buffer);
+}
+
+static void
+search_all_done (GObject      *source,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+  GAsyncResult **result_out = user_data;
+
+  *result_out = g_object_ref (result);
+}
+
+static GAsyncResult *
+search_all_wait (GtkTextBuffer *buffer,
+                 const gchar   *str,
+                 GCancellable  *cancellable,
+                 gboolean       modify)
+{
+  GAsyncResult *result = NULL;
+
+  gtk_text_buffer_search_all_async (buffer, str, 0, NULL, NULL, cancellable,
+                                    search_all_done, &result);
+
+  /* nothing happens before the main loop runs */
+  g_assert (result == NULL);
+
+  if (cancellable)
+    g_cancellable_cancel (cancellable);
+  if (modify)
+    gtk_text_buffer_insert_at_cursor (buffer, "x", -1);
+
+  while (result == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  return result;
+}
+
+static void
+test_search_all_async (void)
+{
+  GtkTextBuffer *buffer;
+  GAsyncResult *result;
+  GCancellable *cancellable;
+  GError *error = NULL;
+  GString *text;
+  gint *matches, *async_matches;
+  gint n_matches, n_async_matches;
+  gint i;
+
+  /* enough lines to need several steps */
+  text = g_string_new (NULL);
+  for (i = 0; i < 5000; i++)
+    g_string_append (text, "foo bar baz\nbar foo\n");
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text->str, text->len);
+  g_string_free (text, TRUE);
+
+  matches = gtk_text_buffer_search_all (buffer, "foo", 0, NULL, NULL, &n_matches);
+  g_assert_cmpint (n_matches, ==, 10000);
+
+  result = search_all_wait (buffer, "foo", NULL, FALSE);
+  async_matches = gtk_text_buffer_search_all_finish (buffer, result, &n_async_matches, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n_async_matches, ==, n_matches);
+  g_assert (memcmp (matches, async_matches, 2 * n_matches * sizeof (gint)) == 0);
+  g_free (async_matches);
+  g_object_unref (result);
+  g_free (matches);
+
+  /* matches of line delimiters */
+  result = search_all_wait (buffer, "foo\n", NULL, FALSE);
+  async_matches = gtk_text_buffer_search_all_finish (buffer, result, &n_async_matches, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n_async_matches, ==, 5000);
+  g_assert_cmpint (async_matches[0], ==, 16);
+  g_assert_cmpint (async_matches[1], ==, 20);
+  g_free (async_matches);
+  g_object_unref (result);
+
+  cancellable = g_cancellable_new ();
+  result = search_all_wait (buffer, "foo", cancellable, FALSE);
+  async_matches = gtk_text_buffer_search_all_finish (buffer, result, &n_async_matches, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert (async_matches == NULL);
+  g_assert_cmpint (n_async_matches, ==, 0);
+  g_clear_error (&error);
+  g_object_unref (result);
+  g_object_unref (cancellable);
+
+  result = search_all_wait (buffer, "foo", NULL, TRUE);
+  async_matches = gtk_text_buffer_search_all_finish (buffer, result, &n_async_matches, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+  g_assert (async_matches == NULL);
+  g_clear_error (&error);
+  g_object_unref (result);
+
+  g_object_unref (buffer);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -266,6 +432,8 @@ main (int argc, char** argv)
   g_test_add_func ("/TextIter/Search Full Buffer", test_full_buffer);
   g_test_add_func ("/TextIter/Search", test_search);
   g_test_add_func ("/TextIter/Search Caseless", test_search_caseless);
+  g_test_add_func ("/TextIter/Search All", test_search_all);
+  g_test_add_func ("/TextIter/Search All Async", test_search_all_async);
 
   return g_test_run();
 }
@@ -0,0 +1,261 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2013 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+static GtkWidget *
+create_text_view (const gchar *text)
+{
+  GtkWidget *window, *text_view;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), 400, 400);
+  text_view = gtk_text_view_new ();
+  gtk_text_buffer_set_text (gtk_text_view_get_buffer (GTK_TEXT_VIEW (text_view)), text, -1);
+  gtk_container_add (GTK_CONTAINER (window), text_view);
+  gtk_widget_show_all (window);
+  gtk_test_widget_wait_for_draw (window);
+
+  return text_view;
+}
+
+static gint
+get_line_height (GtkWidget *text_view,
+                 gint       line)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter iter;
+  gint y, height;
+
+  gtk_test_widget_wait_for_draw (gtk_widget_get_toplevel (text_view));
+
+  buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (text_view));
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, line);
+  gtk_text_view_get_line_yrange (GTK_TEXT_VIEW (text_view), &iter, &y, &height);
+
+  return height;
+}
+
+static gint
+get_line_end_x (GtkWidget *text_view,
+                gint       line)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter iter;
+  GdkRectangle rect;
+
+  gtk_test_widget_wait_for_draw (gtk_widget_get_toplevel (text_view));
+
+  buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (text_view));
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, line);
+  gtk_text_iter_forward_to_line_end (&iter);
+  gtk_text_view_get_iter_location (GTK_TEXT_VIEW (text_view), &iter, &rect);
+
+  return rect.x;
+}
+
+/* Line displays are cached, tag and text changes must still reach
+ * the lines they apply to, and only those
+ */
+static void
+test_display_cache (void)
+{
+  GtkWidget *text_view;
+  GtkTextBuffer *buffer;
+  GtkTextTag *tag;
+  GtkTextIter start, end;
+  gint height, x;
+
+  text_view = create_text_view ("first line\nsecond line\nthird line");
+  buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (text_view));
+
+  height = get_line_height (text_view, 1);
+  g_assert_cmpint (get_line_height (text_view, 0), ==, height);
+
+  tag = gtk_text_buffer_create_tag (buffer, NULL, "scale", 3.0, NULL);
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 1);
+  end = start;
+  gtk_text_iter_forward_to_line_end (&end);
+  gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+
+  g_assert_cmpint (get_line_height (text_view, 1), >, height);
+  g_assert_cmpint (get_line_height (text_view, 0), ==, height);
+  g_assert_cmpint (get_line_height (text_view, 2), ==, height);
+
+  /* changing the tag itself drops the displays that use it */
+  g_object_set (tag, "scale", 1.0, NULL);
+  g_assert_cmpint (get_line_height (text_view, 1), ==, height);
+
+  x = get_line_end_x (text_view, 2);
+  gtk_text_buffer_get_end_iter (buffer, &end);
+  gtk_text_buffer_insert (buffer, &end, " and more", -1);
+  g_assert_cmpint (get_line_end_x (text_view, 2), >, x);
+
+  gtk_widget_destroy (gtk_widget_get_toplevel (text_view));
+}
+
+static GtkWidget *
+create_wrapped_text_view (const gchar *text)
+{
+  GtkWidget *window, *scrolled_window, *text_view;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), 300, 200);
+  scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window),
+                                  GTK_POLICY_NEVER, GTK_POLICY_ALWAYS);
+  text_view = gtk_text_view_new ();
+  gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (text_view), GTK_WRAP_WORD);
+  gtk_text_buffer_set_text (gtk_text_view_get_buffer (GTK_TEXT_VIEW (text_view)), text, -1);
+  gtk_container_add (GTK_CONTAINER (scrolled_window), text_view);
+  gtk_container_add (GTK_CONTAINER (window), scrolled_window);
+  gtk_widget_show_all (window);
+  gtk_test_widget_wait_for_draw (window);
+
+  return text_view;
+}
+
+static GtkWidget *
+create_reference_text_view (GtkWidget *text_view)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end;
+  GtkWidget *reference;
+  gchar *text;
+
+  buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (text_view));
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  text = gtk_text_buffer_get_text (buffer, &start, &end, FALSE);
+  reference = create_wrapped_text_view (text);
+  g_free (text);
+
+  return reference;
+}
+
+static gdouble
+get_height (GtkWidget *text_view)
+{
+  GtkAdjustment *vadjustment;
+
+  vadjustment = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (text_view));
+
+  return gtk_adjustment_get_upper (vadjustment);
+}
+
+static gboolean
+wait_timeout (gpointer data)
+{
+  gboolean *timed_out = data;
+
+  *timed_out = TRUE;
+
+  return FALSE;
+}
+
+/* Offscreen lines are shaped by worker threads in the background,
+ * so we wait until both views agree on the height of their text
+ */
+static gboolean
+wait_for_same_height (GtkWidget *text_view,
+                      GtkWidget *reference)
+{
+  gboolean timed_out = FALSE;
+  guint id;
+
+  id = g_timeout_add (10000, wait_timeout, &timed_out);
+
+  while (!timed_out)
+    {
+      if (get_height (text_view) == get_height (reference))
+        {
+          gtk_test_widget_wait_for_draw (gtk_widget_get_toplevel (text_view));
+          gtk_test_widget_wait_for_draw (gtk_widget_get_toplevel (reference));
+
+          if (get_height (text_view) == get_height (reference))
+            break;
+        }
+
+      g_main_context_iteration (NULL, TRUE);
+    }
+
+  if (!timed_out)
+    g_source_remove (id);
+
+  return !timed_out;
+}
+
+/* Changes made while offscreen lines are being shaped must not be
+ * overwritten by the sizes computed for the old text
+ */
+static void
+test_async_validate (void)
+{
+  GtkWidget *text_view, *reference;
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end;
+  GString *text;
+  gdouble height;
+  gint i, j;
+
+  text = g_string_new (NULL);
+  for (i = 0; i < 3000; i++)
+    {
+      g_string_append_printf (text, "line %d:", i);
+      for (j = 0; j < i % 37; j++)
+        g_string_append (text, " some words");
+      g_string_append_c (text, '\n');
+    }
+
+  text_view = create_wrapped_text_view (text->str);
+  buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (text_view));
+
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 100);
+  gtk_text_buffer_get_iter_at_line (buffer, &end, 120);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 2500);
+  gtk_text_buffer_insert (buffer, &start, text->str + text->len / 2, 2000);
+
+  reference = create_reference_text_view (text_view);
+  g_assert (wait_for_same_height (text_view, reference));
+  height = get_height (text_view);
+  gtk_widget_destroy (gtk_widget_get_toplevel (reference));
+
+  /* a change to a line that was already shaped offscreen */
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 2900);
+  gtk_text_buffer_insert (buffer, &start, text->str + text->len / 2, 2000);
+
+  reference = create_reference_text_view (text_view);
+  g_assert (wait_for_same_height (text_view, reference));
+  g_assert_cmpfloat (get_height (text_view), >, height);
+  gtk_widget_destroy (gtk_widget_get_toplevel (reference));
+
+  gtk_widget_destroy (gtk_widget_get_toplevel (text_view));
+  g_string_free (text, TRUE);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/textview/display-cache", test_display_cache);
+  g_test_add_func ("/textview/async-validate", test_async_validate);
+
+  return g_test_run ();
+}
@@ -228,6 +228,47 @@ test_row_separator_height (void)
   gtk_widget_destroy (tree_view);
 }
 
+static gint
+get_text_cell_width (GtkCellRenderer *cell,
+                     GtkWidget       *widget,
+                     const gchar     *text)
+{
+  gint width;
+
+  g_object_set (cell, "text", text, NULL);
+  gtk_cell_renderer_get_preferred_width (cell, widget, NULL, &width);
+
+  return width;
+}
+
+/* Text cells cache their layouts per widget, changing the text or the
+ * font of the cell must still change its size
+ */
+static void
+test_text_cell_layout_cache (void)
+{
+  GtkWidget *tree_view;
+  GtkCellRenderer *cell;
+  gint short_width, long_width;
+
+  tree_view = gtk_tree_view_new ();
+  g_object_ref_sink (tree_view);
+  cell = gtk_cell_renderer_text_new ();
+  g_object_ref_sink (cell);
+
+  short_width = get_text_cell_width (cell, tree_view, "ab");
+  long_width = get_text_cell_width (cell, tree_view, "abababab");
+  g_assert_cmpint (long_width, >, short_width);
+
+  g_assert_cmpint (get_text_cell_width (cell, tree_view, "ab"), ==, short_width);
+
+  g_object_set (cell, "size-points", 40.0, NULL);
+  g_assert_cmpint (get_text_cell_width (cell, tree_view, "ab"), >, short_width);
+
+  g_object_unref (cell);
+  g_object_unref (tree_view);
+}
+
 int
 main (int    argc,
       char **argv)
@@ -240,6 +281,8 @@ main (int    argc,
                    test_select_collapsed_row);
   g_test_add_func ("/TreeView/sizing/row-separator-height",
                    test_row_separator_height);
+  g_test_add_func ("/TreeView/sizing/text-cell-layout-cache",
+                   test_text_cell_layout_cache);
 
   return g_test_run ();
 }
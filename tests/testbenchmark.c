@@ -0,0 +1,530 @@
+/* testbenchmark.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Runs a set of widget scenarios inside offscreen windows and prints
+ * one line of JSON per scenario, so that the results can be compared
+ * between revisions.  Nothing is shown on screen, so this runs just
+ * as well on a virtual X server or on the broadway backend.
+ *
+ * Usage: testbenchmark [SCENARIO...]
+ *
+ * The large-paint scenario is meant to be run once with
+ * GDK_RENDERING=tiled and once without, to compare the tiled
+ * repaint mode against the default one.
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <gtk/gtk.h>
+
+#define N_TREE_ROWS      1000000
+#define N_GRID_COLUMNS   100
+#define N_GRID_ROWS      100
+#define N_TEXT_LINES     100000
+#define N_SCROLL_STEPS   100
+#define N_THEME_SWITCHES 10
+#define N_ANIMATED       500
+#define N_ANIMATION_FRAMES 120
+#define N_LARGE_PAINT_FRAMES 60
+
+typedef struct
+{
+  const gchar *name;
+  GtkWidget *window;
+  GdkFrameClock *frame_clock;
+
+  gint64 start_time;
+  gsize start_allocations;
+  guint start_style_updates;
+
+  gint64 paint_start;
+  GArray *frame_times;
+} Benchmark;
+
+static gsize n_allocations = 0;
+static guint n_style_updates = 0;
+
+static gpointer
+counting_malloc (gsize n_bytes)
+{
+  n_allocations++;
+
+  return malloc (n_bytes);
+}
+
+static gpointer
+counting_realloc (gpointer mem,
+                  gsize    n_bytes)
+{
+  if (mem == NULL)
+    n_allocations++;
+
+  return realloc (mem, n_bytes);
+}
+
+static gpointer
+counting_calloc (gsize n_blocks,
+                 gsize n_block_bytes)
+{
+  n_allocations++;
+
+  return calloc (n_blocks, n_block_bytes);
+}
+
+static GMemVTable counting_vtable = {
+  counting_malloc,
+  counting_realloc,
+  free,
+  counting_calloc,
+  NULL,
+  NULL
+};
+
+static gboolean
+count_style_update (GSignalInvocationHint *ihint,
+                    guint                  n_param_values,
+                    const GValue          *param_values,
+                    gpointer               data)
+{
+  n_style_updates++;
+
+  return TRUE;
+}
+
+static void
+before_paint (GdkFrameClock *frame_clock,
+              Benchmark     *bench)
+{
+  bench->paint_start = g_get_monotonic_time ();
+}
+
+static void
+after_paint (GdkFrameClock *frame_clock,
+             Benchmark     *bench)
+{
+  gint64 elapsed;
+
+  elapsed = g_get_monotonic_time () - bench->paint_start;
+  g_array_append_val (bench->frame_times, elapsed);
+}
+
+static Benchmark *
+benchmark_begin (const gchar *name)
+{
+  Benchmark *bench;
+
+  bench = g_new0 (Benchmark, 1);
+  bench->name = name;
+  bench->frame_times = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+  bench->window = gtk_offscreen_window_new ();
+  gtk_widget_set_size_request (bench->window, 800, 600);
+
+  bench->start_time = g_get_monotonic_time ();
+  bench->start_allocations = n_allocations;
+  bench->start_style_updates = n_style_updates;
+
+  return bench;
+}
+
+/* waits until the window has been painted once more */
+static void
+benchmark_run_frame (Benchmark *bench)
+{
+  guint n_frames;
+
+  if (bench->frame_clock == NULL)
+    {
+      gtk_widget_show_all (bench->window);
+
+      bench->frame_clock = gtk_widget_get_frame_clock (bench->window);
+      g_signal_connect (bench->frame_clock, "before-paint",
+                        G_CALLBACK (before_paint), bench);
+      g_signal_connect (bench->frame_clock, "after-paint",
+                        G_CALLBACK (after_paint), bench);
+    }
+
+  n_frames = bench->frame_times->len;
+
+  gtk_widget_queue_draw (bench->window);
+
+  while (bench->frame_times->len == n_frames)
+    gtk_main_iteration ();
+}
+
+static void
+benchmark_end (Benchmark *bench)
+{
+  gint64 total, max;
+  guint i;
+
+  total = max = 0;
+  for (i = 0; i < bench->frame_times->len; i++)
+    {
+      gint64 frame_time = g_array_index (bench->frame_times, gint64, i);
+
+      total += frame_time;
+      max = MAX (max, frame_time);
+    }
+
+  g_print ("{ \"scenario\": \"%s\", "
+           "\"rendering\": \"%s\", "
+           "\"wall_ms\": %.3f, "
+           "\"allocations\": %" G_GSIZE_FORMAT ", "
+           "\"style_updates\": %u, "
+           "\"frames\": %u, "
+           "\"frame_ms_mean\": %.3f, "
+           "\"frame_ms_max\": %.3f }\n",
+           bench->name,
+           g_getenv ("GDK_RENDERING") ? g_getenv ("GDK_RENDERING") : "default",
+           (g_get_monotonic_time () - bench->start_time) / 1000.0,
+           n_allocations - bench->start_allocations,
+           n_style_updates - bench->start_style_updates,
+           bench->frame_times->len,
+           bench->frame_times->len ? total / 1000.0 / bench->frame_times->len : 0.0,
+           max / 1000.0);
+
+  if (bench->frame_clock)
+    {
+      g_signal_handlers_disconnect_by_func (bench->frame_clock, before_paint, bench);
+      g_signal_handlers_disconnect_by_func (bench->frame_clock, after_paint, bench);
+    }
+
+  gtk_widget_destroy (bench->window);
+  g_array_free (bench->frame_times, TRUE);
+  g_free (bench);
+}
+
+static void
+scroll_pages (Benchmark     *bench,
+              GtkAdjustment *adjustment)
+{
+  gint i;
+
+  for (i = 0; i < N_SCROLL_STEPS; i++)
+    {
+      gtk_adjustment_set_value (adjustment,
+                                gtk_adjustment_get_value (adjustment) +
+                                gtk_adjustment_get_page_size (adjustment));
+      benchmark_run_frame (bench);
+    }
+}
+
+static void
+benchmark_tree_view (void)
+{
+  Benchmark *bench;
+  GtkListStore *store;
+  GtkWidget *sw, *tree_view;
+  GtkTreeViewColumn *column;
+  gchar text[32];
+  guint i;
+
+  bench = benchmark_begin ("tree-view");
+
+  store = gtk_list_store_new (2, G_TYPE_UINT, G_TYPE_STRING);
+  for (i = 0; i < N_TREE_ROWS; i++)
+    {
+      g_snprintf (text, sizeof (text), "Row %u", i);
+      gtk_list_store_insert_with_values (store, NULL, -1,
+                                         0, i,
+                                         1, text,
+                                         -1);
+    }
+
+  tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+  g_object_unref (store);
+
+  column = gtk_tree_view_column_new_with_attributes ("Number",
+                                                     gtk_cell_renderer_text_new (),
+                                                     "text", 0,
+                                                     NULL);
+  gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+  gtk_tree_view_column_set_fixed_width (column, 200);
+  gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view), column);
+
+  column = gtk_tree_view_column_new_with_attributes ("Text",
+                                                     gtk_cell_renderer_text_new (),
+                                                     "text", 1,
+                                                     NULL);
+  gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+  gtk_tree_view_column_set_fixed_width (column, 400);
+  gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view), column);
+
+  gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW (tree_view), TRUE);
+
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (sw), tree_view);
+  gtk_container_add (GTK_CONTAINER (bench->window), sw);
+
+  benchmark_run_frame (bench);
+  scroll_pages (bench, gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (tree_view)));
+
+  benchmark_end (bench);
+}
+
+static void
+benchmark_grid (void)
+{
+  Benchmark *bench;
+  GtkWidget *sw, *grid;
+  GtkWidget **labels;
+  gchar text[32];
+  gint i, j;
+
+  bench = benchmark_begin ("grid");
+
+  labels = g_new (GtkWidget *, N_GRID_COLUMNS * N_GRID_ROWS);
+
+  grid = gtk_grid_new ();
+  for (i = 0; i < N_GRID_ROWS; i++)
+    for (j = 0; j < N_GRID_COLUMNS; j++)
+      {
+        g_snprintf (text, sizeof (text), "%d,%d", i, j);
+        labels[i * N_GRID_COLUMNS + j] = gtk_label_new (text);
+        gtk_grid_attach (GTK_GRID (grid), labels[i * N_GRID_COLUMNS + j], j, i, 1, 1);
+      }
+
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (sw), grid);
+  gtk_container_add (GTK_CONTAINER (bench->window), sw);
+
+  benchmark_run_frame (bench);
+
+  /* update a tenth of the labels per frame */
+  for (i = 0; i < 10; i++)
+    {
+      for (j = i; j < N_GRID_COLUMNS * N_GRID_ROWS; j += 10)
+        {
+          g_snprintf (text, sizeof (text), "%d", j * (i + 1));
+          gtk_label_set_text (GTK_LABEL (labels[j]), text);
+        }
+
+      benchmark_run_frame (bench);
+    }
+
+  g_free (labels);
+
+  benchmark_end (bench);
+}
+
+static void
+benchmark_text_view (void)
+{
+  Benchmark *bench;
+  GtkWidget *sw, *text_view;
+  GtkTextBuffer *buffer;
+  GString *text;
+  gint i;
+
+  bench = benchmark_begin ("text-view");
+
+  text = g_string_new (NULL);
+  for (i = 0; i < N_TEXT_LINES; i++)
+    g_string_append_printf (text,
+                            "Line %d: the quick brown fox jumps over the lazy dog\n",
+                            i);
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text->str, text->len);
+  g_string_free (text, TRUE);
+
+  text_view = gtk_text_view_new_with_buffer (buffer);
+  g_object_unref (buffer);
+
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (sw), text_view);
+  gtk_container_add (GTK_CONTAINER (bench->window), sw);
+
+  benchmark_run_frame (bench);
+  scroll_pages (bench, gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (text_view)));
+
+  benchmark_end (bench);
+}
+
+static void
+benchmark_theme_switch (void)
+{
+  Benchmark *bench;
+  GtkCssProvider *provider;
+  GtkWidget *sw, *grid;
+  GdkScreen *screen;
+  gint i;
+
+  bench = benchmark_begin ("theme-switch");
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider,
+                                   "* { padding: 4px; }\n"
+                                   "GtkButton { color: #204a87; border-width: 2px; }\n",
+                                   -1, NULL);
+
+  grid = gtk_grid_new ();
+  for (i = 0; i < 2000; i++)
+    gtk_grid_attach (GTK_GRID (grid), gtk_button_new_with_label ("Button"),
+                     i % 40, i / 40, 1, 1);
+
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (sw), grid);
+  gtk_container_add (GTK_CONTAINER (bench->window), sw);
+
+  benchmark_run_frame (bench);
+
+  screen = gtk_widget_get_screen (bench->window);
+  for (i = 0; i < N_THEME_SWITCHES; i++)
+    {
+      if (i % 2 == 0)
+        gtk_style_context_add_provider_for_screen (screen,
+                                                   GTK_STYLE_PROVIDER (provider),
+                                                   GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+      else
+        gtk_style_context_remove_provider_for_screen (screen,
+                                                      GTK_STYLE_PROVIDER (provider));
+
+      benchmark_run_frame (bench);
+    }
+
+  gtk_style_context_remove_provider_for_screen (screen, GTK_STYLE_PROVIDER (provider));
+  g_object_unref (provider);
+
+  benchmark_end (bench);
+}
+
+static void
+benchmark_css_animation (void)
+{
+  Benchmark *bench;
+  GtkCssProvider *provider;
+  GtkWidget *grid, *label;
+  gint i;
+
+  bench = benchmark_begin ("css-animation");
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider,
+                                   "@keyframes benchmark-pulse {\n"
+                                   "  from { color: #cc0000; }\n"
+                                   "  to { color: #3465a4; }\n"
+                                   "}\n"
+                                   ".benchmark-animated {\n"
+                                   "  animation: benchmark-pulse 1s infinite alternate;\n"
+                                   "}\n",
+                                   -1, NULL);
+
+  grid = gtk_grid_new ();
+  for (i = 0; i < N_ANIMATED; i++)
+    {
+      label = gtk_label_new ("Animated");
+      gtk_style_context_add_provider (gtk_widget_get_style_context (label),
+                                      GTK_STYLE_PROVIDER (provider),
+                                      GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+      gtk_style_context_add_class (gtk_widget_get_style_context (label),
+                                   "benchmark-animated");
+      gtk_grid_attach (GTK_GRID (grid), label, i % 20, i / 20, 1, 1);
+    }
+
+  gtk_container_add (GTK_CONTAINER (bench->window), grid);
+
+  for (i = 0; i < N_ANIMATION_FRAMES; i++)
+    benchmark_run_frame (bench);
+
+  g_object_unref (provider);
+
+  benchmark_end (bench);
+}
+
+/* full repaints of a 4K window, with some translucent windowless
+ * widgets so that the drawing uses groups
+ */
+static void
+benchmark_large_paint (void)
+{
+  Benchmark *bench;
+  GtkWidget *grid, *button;
+  gchar text[32];
+  gint i, j;
+
+  bench = benchmark_begin ("large-paint");
+  gtk_widget_set_size_request (bench->window, 3840, 2160);
+
+  grid = gtk_grid_new ();
+  gtk_grid_set_row_homogeneous (GTK_GRID (grid), TRUE);
+  gtk_grid_set_column_homogeneous (GTK_GRID (grid), TRUE);
+  for (i = 0; i < 40; i++)
+    for (j = 0; j < 20; j++)
+      {
+        g_snprintf (text, sizeof (text), "Button %d,%d", i, j);
+        button = gtk_button_new_with_label (text);
+        if ((i + j) % 4 == 0)
+          gtk_widget_set_opacity (button, 0.5);
+        gtk_grid_attach (GTK_GRID (grid), button, j, i, 1, 1);
+      }
+
+  gtk_container_add (GTK_CONTAINER (bench->window), grid);
+
+  for (i = 0; i < N_LARGE_PAINT_FRAMES; i++)
+    benchmark_run_frame (bench);
+
+  benchmark_end (bench);
+}
+
+static const struct {
+  const gchar *name;
+  void (* run) (void);
+} scenarios[] = {
+  { "tree-view", benchmark_tree_view },
+  { "grid", benchmark_grid },
+  { "text-view", benchmark_text_view },
+  { "theme-switch", benchmark_theme_switch },
+  { "css-animation", benchmark_css_animation },
+  { "large-paint", benchmark_large_paint }
+};
+
+int
+main (int argc, char **argv)
+{
+  guint i;
+  gint j;
+
+  /* count every allocation, including the ones from GSlice */
+  g_setenv ("G_SLICE", "always-malloc", TRUE);
+  g_mem_set_vtable (&counting_vtable);
+
+  gtk_init (&argc, &argv);
+
+  g_type_class_ref (GTK_TYPE_WIDGET);
+  g_signal_add_emission_hook (g_signal_lookup ("style-updated", GTK_TYPE_WIDGET), 0,
+                              count_style_update, NULL, NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (scenarios); i++)
+    {
+      gboolean selected = argc < 2;
+
+      for (j = 1; j < argc; j++)
+        {
+          if (strcmp (argv[j], scenarios[i].name) == 0)
+            selected = TRUE;
+        }
+
+      if (selected)
+        scenarios[i].run ();
+    }
+
+  return 0;
+}